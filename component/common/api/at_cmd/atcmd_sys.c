@@ -23,6 +23,10 @@
 #include "freertos_pmu.h"
 #endif
 
+#if defined(configUSE_HEAP_TRACE) && (configUSE_HEAP_TRACE == 1)
+#include "freertos_heap_rtk.h"
+#endif
+
 #if !defined(CONFIG_PLATFORM_8195BHP) && !defined(CONFIG_PLATFORM_8710C)
 extern u32 ConfigDebugErr;
 extern u32 ConfigDebugInfo;
@@ -3106,6 +3110,120 @@ exit:
 }
 #endif
 
+#if defined(configUSE_HEAP_TRACE) && (configUSE_HEAP_TRACE == 1)
+#define HEAP_TRACE_DUMP_MAGIC		0x31525448	// "HTR1"
+#define HEAP_TRACE_DUMP_HEADER		12			// words before the tag figures
+#define HEAP_TRACE_DUMP_LINE		8			// words per "HT" line
+
+static const char *heap_trace_tags[heapTAGS] = {"app", "lwip", "mbedtls", "matter", "bt", "wlan"};
+static u32 heap_trace_line[HEAP_TRACE_DUMP_LINE];
+static int heap_trace_words;
+
+static void heap_trace_put(u32 word)
+{
+	heap_trace_line[heap_trace_words++] = word;
+	if(heap_trace_words == HEAP_TRACE_DUMP_LINE){
+		AT_PRINTK("HT %08x %08x %08x %08x %08x %08x %08x %08x", heap_trace_line[0], heap_trace_line[1],
+			heap_trace_line[2], heap_trace_line[3], heap_trace_line[4], heap_trace_line[5], heap_trace_line[6],
+			heap_trace_line[7]);
+		heap_trace_words = 0;
+	}
+}
+
+/*
+ * The figures and the ring as "HT" lines of hex words for tools/heap/trace:
+ * the header (magic, header words, tags, words per record, records, events,
+ * tick, heap, free, minimum ever free, largest free block, fragmentation), five
+ * words per tag and five per record, the last line padded with zeros.
+ */
+static void heap_trace_dump(HeapTraceStats_t *stats)
+{
+	HeapTraceRecord_t record;
+	BaseType_t recording = xPortHeapTraceRecord(pdFALSE);
+	u32 first, event;
+	int i;
+
+	// the ring holds still while it is printed
+	vPortGetHeapTraceStats(stats);
+	first = (stats->ulEvents > configHEAP_TRACE_RECORDS) ? stats->ulEvents - configHEAP_TRACE_RECORDS : 0;
+	AT_PRINTK("[ATSH] dump of %d records", stats->ulEvents - first);
+
+	heap_trace_words = 0;
+	heap_trace_put(HEAP_TRACE_DUMP_MAGIC);
+	heap_trace_put(HEAP_TRACE_DUMP_HEADER);
+	heap_trace_put(heapTAGS);
+	heap_trace_put(sizeof(HeapTraceRecord_t) / sizeof(u32));
+	heap_trace_put(stats->ulEvents - first);
+	heap_trace_put(stats->ulEvents);
+	heap_trace_put(stats->ulTime);
+	heap_trace_put(stats->xHeapBytes);
+	heap_trace_put(stats->xFreeBytes);
+	heap_trace_put(stats->xMinimumEverFreeBytes);
+	heap_trace_put(stats->xLargestFreeBlock);
+	heap_trace_put(stats->ulFragmentation);
+	for(i = 0; i < heapTAGS; i++){
+		heap_trace_put(stats->xTags[i].xLiveBytes);
+		heap_trace_put(stats->xTags[i].xPeakBytes);
+		heap_trace_put(stats->xTags[i].xLiveBlocks);
+		heap_trace_put(stats->xTags[i].xAllocations);
+		heap_trace_put(stats->xTags[i].xFailures);
+	}
+	for(event = first; event < stats->ulEvents; event++){
+		if(xPortGetHeapTraceRecord(event, &record) == pdFALSE)
+			memset(&record, 0, sizeof(record));
+		heap_trace_put(record.ulTime);
+		heap_trace_put(record.ulAddress);
+		heap_trace_put(record.ulCaller);
+		heap_trace_put(record.ulInfo);
+		heap_trace_put(record.ulLifetime);
+	}
+	while(heap_trace_words != 0)
+		heap_trace_put(0);
+	AT_PRINTK("[ATSH] dump end");
+
+	xPortHeapTraceRecord(recording);
+}
+
+void fATSH(void *arg)
+{
+	int argc = 0;
+	char *argv[MAX_ARGC] = {0};
+	HeapTraceStats_t stats;
+	int i;
+
+	AT_PRINTK("[ATSH]: _AT_SYSTEM_HEAP_TRACE_");
+	if(arg){
+		argc = parse_param(arg, argv);
+		if(argc != 2){
+			AT_PRINTK("[ATSH] Usage: ATSH[=dump/clear/stop/start]");
+			return;
+		}
+	}
+
+	vPortGetHeapTraceStats(&stats);
+	if(argc == 0){
+		AT_PRINTK("[ATSH] heap %d, free %d, minimum ever free %d, largest free block %d, fragmentation %d.%d%%",
+			stats.xHeapBytes, stats.xFreeBytes, stats.xMinimumEverFreeBytes, stats.xLargestFreeBlock,
+			stats.ulFragmentation / 10, stats.ulFragmentation % 10);
+		for(i = 0; i < heapTAGS; i++)
+			AT_PRINTK("[ATSH] %s: live %d in %d blocks, peak %d, allocations %d, failed %d", heap_trace_tags[i],
+				stats.xTags[i].xLiveBytes, stats.xTags[i].xLiveBlocks, stats.xTags[i].xPeakBytes,
+				stats.xTags[i].xAllocations, stats.xTags[i].xFailures);
+		AT_PRINTK("[ATSH] %d events since the last clear, the ring keeps %d", stats.ulEvents, configHEAP_TRACE_RECORDS);
+	}else if(strcmp(argv[1], "dump") == 0){
+		heap_trace_dump(&stats);
+	}else if(strcmp(argv[1], "clear") == 0){
+		vPortHeapTraceClear();
+	}else if(strcmp(argv[1], "stop") == 0){
+		xPortHeapTraceRecord(pdFALSE);
+	}else if(strcmp(argv[1], "start") == 0){
+		xPortHeapTraceRecord(pdTRUE);
+	}else{
+		AT_PRINTK("[ATSH] Usage: ATSH[=dump/clear/stop/start]");
+	}
+}
+#endif
+
 log_item_t at_sys_items[] = {
 #ifndef CONFIG_INIC_NO_FLASH
 #if ATCMD_VER == ATVER_1
@@ -3173,6 +3291,9 @@ log_item_t at_sys_items[] = {
 #if defined(configUSE_WAKELOCK_PMU) && (configUSE_WAKELOCK_PMU == 1)
 	{"ATSL", fATSL,{NULL,NULL}},	 // wakelock test
 #endif
+#if defined(configUSE_HEAP_TRACE) && (configUSE_HEAP_TRACE == 1)
+	{"ATSH", fATSH,{NULL,NULL}},	 // heap trace
+#endif
 #endif
 };
 
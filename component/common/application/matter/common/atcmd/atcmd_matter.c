@@ -17,6 +17,25 @@ extern void amebaApplyUpdateCmdHandler();
 #endif
 #endif
 
+// Provided by matter_interaction.cpp in examples that use the uplink dispatcher
+__weak void matter_interaction_print_uplink_stats(void)
+{
+	printf("Uplink dispatcher not available\r\n");
+}
+
+__weak void matter_interaction_reset_uplink_stats(void)
+{
+}
+
+__weak void matter_interaction_print_lane_latency(void)
+{
+	printf("Event lanes not available\r\n");
+}
+
+__weak void matter_interaction_reset_lane_latency(void)
+{
+}
+
 // Queue for matter shell
 QueueHandle_t shell_queue;
 
@@ -73,6 +92,30 @@ void fATmattershell(void *arg)
     } 
 }
 
+void fATmatteruplinkstats(void *arg)
+{
+	if (arg != NULL && strcmp((char *) arg, "reset") == 0)
+	{
+		matter_interaction_reset_uplink_stats();
+		printf("Uplink dispatcher counters cleared\r\n");
+		return;
+	}
+
+	matter_interaction_print_uplink_stats();
+}
+
+void fATmatterlanelatency(void *arg)
+{
+	if (arg != NULL && strcmp((char *) arg, "reset") == 0)
+	{
+		matter_interaction_reset_lane_latency();
+		printf("Event lane latency histograms cleared\r\n");
+		return;
+	}
+
+	matter_interaction_print_lane_latency();
+}
+
 log_item_t at_matter_items[] = {
 #ifndef CONFIG_INIC_NO_FLASH
 #if ATCMD_VER == ATVER_1
@@ -80,6 +123,8 @@ log_item_t at_matter_items[] = {
     {"ATM%", fATchipapp1},
     {"ATM^", fATchipapp2},
     {"ATMS", fATmattershell},
+    {"ATMU", fATmatteruplinkstats},
+    {"ATML", fATmatterlanelatency},
 #endif // end of #if ATCMD_VER == ATVER_1
 #endif
 };
@@ -12,7 +12,12 @@
 #include "string.h"
 #include "stdbool.h"
 #include "dct.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
 #include "chip_porting.h"
+#include "matter_kvs_log.h"
+#include "sys_api.h"
 
 #if CONFIG_ENABLE_DCT_ENCRYPTION
 #include "mbedtls/aes.h"
@@ -37,6 +42,21 @@
 #define ENABLE_BACKUP           0
 #define ENABLE_WEAR_LEVELING    0
 
+#define PREF_FLUSH_HANDLER_NUM  4                 /*!< max number of registered write-behind flush handlers */
+
+#define DCT_REGION_1            0
+#define DCT_REGION_2            1
+
+#define KVS_DIR_SIZE            256               /*!< max number of keys tracked by the key directory */
+#define KVS_DIR_SLOTS           320               /*!< hash table slots of the key directory, kept 20% free for short probes */
+#define KVS_DIR_NEAR_FULL       224               /*!< from this many entries on, absent keys are no longer cached */
+#define KVS_LOC_ABSENT          0xFF              /*!< directory region value of a key known not to exist */
+#define KVS_LOC_EMPTY           0xFE              /*!< directory region value of an unused slot */
+
+static pref_flush_handler_t pref_flush_handlers[PREF_FLUSH_HANDLER_NUM] = {NULL};
+// set while the stored preferences are wiped (factory reset) so pending write-behind values do not bring keys back
+static bool pref_flush_suspended = false;
+
 #if CONFIG_ENABLE_DCT_ENCRYPTION
 #if defined(MBEDTLS_CIPHER_MODE_CTR)
 mbedtls_aes_context aes;
@@ -44,9 +64,6 @@ mbedtls_aes_context aes;
 // key length 32 bytes for 256 bit encrypting, it can be 16 or 24 bytes for 128 and 192 bits encrypting mode
 unsigned char key[] = {0xff, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
 
-#define DCT_REGION_1 0
-#define DCT_REGION_2 1
-
 int32_t dct_encrypt(unsigned char *input_to_encrypt, int input_len, unsigned char *encrypt_output)
 {
     size_t nc_off = 0;
@@ -116,601 +133,1265 @@ int32_t dct_get_encrypted_variable(dct_handle_t *dct_handle, char *variable_name
 #endif // MBEDTLS_CIPHER_MODE_CTR
 #endif
 
-s32 initPref(void)
+#define PREF_TXN_INIT_OPS       8                 /*!< initial capacity of a transaction's op list */
+
+/*                  Transactions                  */
+struct pref_txn_op
 {
-    s32 ret;
-    ret = dct_init(DCT_BEGIN_ADDR_MATTER, MODULE_NUM, VARIABLE_NAME_SIZE, VARIABLE_VALUE_SIZE, ENABLE_BACKUP, ENABLE_WEAR_LEVELING);
-    if (ret != DCT_SUCCESS)
-        printf("dct_init failed with error: %d\n", ret);
-    else
-        printf("dct_init success\n");
+    char key[VARIABLE_NAME_SIZE + 1];
+    u8 *value;                                    /*!< private copy of the value, NULL for a delete */
+    size_t byteCount;
+    u8 region;                                    /*!< where the key is stored now, KVS_LOC_ABSENT if nowhere */
+    u8 module;
+    bool unsure;                                  /*!< not found in the directory, being probed */
+    bool placed;                                  /*!< the value moves to the other region and its new copy is written */
+    bool done;
+};
+
+s32 beginPrefTxn(pref_txn_t *txn)
+{
+    txn->ops = NULL;
+    txn->count = 0;
+    txn->capacity = 0;
+    return DCT_SUCCESS;
+}
 
-    ret = dct_init2(DCT_BEGIN_ADDR_MATTER2, MODULE_NUM2, VARIABLE_NAME_SIZE2, VARIABLE_VALUE_SIZE2, ENABLE_BACKUP, ENABLE_WEAR_LEVELING);
-    if (ret != DCT_SUCCESS)
-        printf("dct_init2 failed with error: %d\n", ret);
-    else
-        printf("dct_init2 success\n");
+void abortPrefTxn(pref_txn_t *txn)
+{
+    for (size_t i=0; i<txn->count; i++)
+        free(txn->ops[i].value);
+    free(txn->ops);
+    beginPrefTxn(txn);
+}
 
-#if CONFIG_ENABLE_DCT_ENCRYPTION
-    // Initialize mbedtls aes context and set encryption key
-    mbedtls_aes_init(&aes);
-    if (mbedtls_aes_setkey_enc(&aes, key, 256) != 0)
+// a later change to the same key replaces the earlier one, only the last value is committed
+static s32 pref_txn_add(pref_txn_t *txn, const char *key, u8 *value, size_t byteCount)
+{
+    pref_txn_op_t *op = NULL;
+    u8 *copy = NULL;
+
+    if (strlen(key) > VARIABLE_NAME_SIZE)
+        return DCT_ERR_SIZE_OVER;
+
+    if (value != NULL)
     {
-        return DCT_ERROR;
+        copy = malloc(byteCount ? byteCount : 1);
+        if (copy == NULL)
+            return DCT_ERR_NO_MEMORY;
+        memcpy(copy, value, byteCount);
     }
-#endif
 
-    return ret;
+    for (size_t i=0; i<txn->count; i++)
+    {
+        if (strcmp(txn->ops[i].key, key) == 0)
+        {
+            op = &txn->ops[i];
+            free(op->value);
+            break;
+        }
+    }
+
+    if (op == NULL)
+    {
+        if (txn->count == txn->capacity)
+        {
+            size_t capacity = txn->capacity ? txn->capacity * 2 : PREF_TXN_INIT_OPS;
+            pref_txn_op_t *ops = realloc(txn->ops, capacity * sizeof(pref_txn_op_t));
+
+            if (ops == NULL)
+            {
+                free(copy);
+                return DCT_ERR_NO_MEMORY;
+            }
+            txn->ops = ops;
+            txn->capacity = capacity;
+        }
+        op = &txn->ops[txn->count++];
+        strcpy(op->key, key);
+    }
+
+    op->value = copy;
+    op->byteCount = byteCount;
+    op->unsure = false;
+    op->placed = false;
+    op->done = false;
+    return DCT_SUCCESS;
 }
 
-s32 deinitPref(void)
+s32 setPrefTxn(pref_txn_t *txn, const char *key, u8 *value, size_t byteCount)
 {
-    s32 ret;
-    ret = dct_format(DCT_BEGIN_ADDR_MATTER, MODULE_NUM, VARIABLE_NAME_SIZE, VARIABLE_VALUE_SIZE, ENABLE_BACKUP, ENABLE_WEAR_LEVELING);
-    if (ret != DCT_SUCCESS)
-        printf("dct_format failed with error: %d\n", ret);
-    else
-        printf("dct_format success\n");
+    return pref_txn_add(txn, key, (value != NULL) ? value : (u8 *)"", (value != NULL) ? byteCount : 0);
+}
 
-    ret = dct_format2(DCT_BEGIN_ADDR_MATTER2, MODULE_NUM2, VARIABLE_NAME_SIZE2, VARIABLE_VALUE_SIZE2, ENABLE_BACKUP, ENABLE_WEAR_LEVELING);
-    if (ret != DCT_SUCCESS)
-        printf("dct_format2 failed with error: %d\n", ret);
-    else
-        printf("dct_format2 success\n");
+s32 deletePrefTxn(pref_txn_t *txn, const char *key)
+{
+    return pref_txn_add(txn, key, NULL, 0);
+}
 
+#if CONFIG_ENABLE_MATTER_KVS_LOG
+/*                  Log-structured Backend                  */
 #if CONFIG_ENABLE_DCT_ENCRYPTION
-    // free aes context
-    mbedtls_aes_free(&aes);
+#error "CONFIG_ENABLE_DCT_ENCRYPTION is not supported by the log-structured KVS backend"
 #endif
 
-    return ret;
+s32 initPref(void)
+{
+    pref_flush_suspended = false;
+    return matter_kvs_log_init();
+}
+
+s32 deinitPref(void)
+{
+    pref_flush_suspended = true;
+    return matter_kvs_log_format();
 }
 
+// the log has no modules to register, clearing it means formatting
 s32 registerPref()
 {
-    s32 ret;
-    char ns[15];
+    return DCT_SUCCESS;
+}
 
-    for (size_t i=0; i<MODULE_NUM; i++)
-    {
-        snprintf(ns, 15, "matter_kvs1_%d", i+1); 
-        ret = dct_register_module(ns);
-        if (ret != DCT_SUCCESS)
-            goto exit;
-        else
-            printf("dct_register_module %s success\n", ns);
-    }
+s32 registerPref2()
+{
+    return DCT_SUCCESS;
+}
 
-exit:
-    if (ret != DCT_SUCCESS)
-        printf("DCT1 modules registration failed");
-    return ret;
+s32 clearPref()
+{
+    pref_flush_suspended = true;
+    return matter_kvs_log_format();
 }
 
-s32 registerPref2()
+s32 clearPref2()
 {
-    s32 ret;
-    char ns[15];
+    return DCT_SUCCESS;
+}
 
-    for (size_t i=0; i<MODULE_NUM2; i++)
-    {
-        snprintf(ns, 15, "matter_kvs2_%d", i+1); 
-        ret = dct_register_module2(ns);
-        if (ret != DCT_SUCCESS)
-            goto exit;
-        else
-            printf("dct_register_module2 %s success\n", ns);
-    }
+s32 deleteKey(const char *domain, const char *key)
+{
+    return matter_kvs_log_delete(key);
+}
 
-exit:
-    if (ret != DCT_SUCCESS)
-        printf("DCT2 modules registration failed");
-    return ret;
+bool checkExist(const char *domain, const char *key)
+{
+    return matter_kvs_log_exists(key);
 }
 
-s32 clearPref()
+s32 setPref_new(const char *domain, const char *key, u8 *value, size_t byteCount)
+{
+    return matter_kvs_log_set(key, value, byteCount);
+}
+
+s32 getPref_bool_new(const char *domain, const char *key, u8 *val)
+{
+    size_t len;
+
+    return matter_kvs_log_get(key, val, sizeof(u8), &len);
+}
+
+s32 getPref_u32_new(const char *domain, const char *key, u32 *val)
+{
+    size_t len;
+
+    return matter_kvs_log_get(key, (u8 *)val, sizeof(u32), &len);
+}
+
+s32 getPref_u64_new(const char *domain, const char *key, u64 *val)
+{
+    size_t len;
+
+    return matter_kvs_log_get(key, (u8 *)val, sizeof(u64), &len);
+}
+
+s32 getPref_str_new(const char *domain, const char *key, char * buf, size_t bufSize, size_t *outLen)
+{
+    return matter_kvs_log_get(key, (u8 *)buf, bufSize, outLen);
+}
+
+s32 getPref_bin_new(const char *domain, const char *key, u8 * buf, size_t bufSize, size_t *outLen)
+{
+    return matter_kvs_log_get(key, buf, bufSize, outLen);
+}
+
+// the whole transaction goes into one log batch, after a power loss either all of it is found or none
+s32 commitPrefTxn(pref_txn_t *txn)
 {
+    matter_kvs_log_op_t *ops;
     s32 ret;
-    char ns[15];
 
-    for (size_t i=0; i<MODULE_NUM; i++)
+    if (txn->count == 0)
     {
-        snprintf(ns, 15, "matter_kvs1_%d", i+1); 
-        ret = dct_unregister_module(ns);
-        if (ret != DCT_SUCCESS)
-            goto exit;
-        else
-            printf("dct_unregister_module %s success\n", ns);
+        abortPrefTxn(txn);
+        return DCT_SUCCESS;
     }
 
-exit:
-    if (ret != DCT_SUCCESS)
-        printf("DCT1 modules unregistration failed");
+    ops = malloc(txn->count * sizeof(matter_kvs_log_op_t));
+    if (ops == NULL)
+    {
+        abortPrefTxn(txn);
+        return DCT_ERR_NO_MEMORY;
+    }
+
+    for (size_t i=0; i<txn->count; i++)
+    {
+        ops[i].key = txn->ops[i].key;
+        ops[i].value = txn->ops[i].value;
+        ops[i].byteCount = txn->ops[i].byteCount;
+    }
+    ret = matter_kvs_log_commit(ops, txn->count);
+
+    free(ops);
+    abortPrefTxn(txn);
     return ret;
 }
 
-s32 clearPref2()
+#else
+/*                  Key Directory                  */
+/*
+   RAM-resident key directory: remembers the region/module holding each key, or that the key
+   does not exist, so KVS operations open a single module instead of scanning every module.
+   It is reset by initPref, filled the first time a key is looked up, and kept in sync by
+   setPref_new/deleteKey. Keys are identified by their 64-bit FNV-1a hash and found in an
+   open-addressing table with linear probing. A deleted key turns into an absent one. Absent
+   entries are tombstones: any other key may take one over on its probe sequence, a key that
+   exists evicts one when the table is full, and from KVS_DIR_NEAR_FULL entries on absent keys
+   are removed rather than cached. The directory is guarded by a mutex, not a critical section,
+   so KVS access does not hold off interrupts.
+
+   It also keeps the number of variables in every module, read from the handle whenever a
+   module is opened. Modules known to be empty are skipped when a key has to be searched for,
+   so the first write of a new key only opens the modules that hold variables.
+*/
+typedef struct
 {
-    s32 ret;
-    char ns[15];
+    u64 hash;
+    u8 region;                                    /*!< DCT_REGION_x, KVS_LOC_ABSENT if the key is known not to exist, KVS_LOC_EMPTY if unused */
+    u8 module;                                    /*!< 0-based module index within the region */
+} kvs_dir_entry_t;
+
+static kvs_dir_entry_t kvs_dir[KVS_DIR_SLOTS];
+static size_t kvs_dir_count = 0;
+static size_t kvs_dir_evict_next = 0;              /*!< where kvs_dir_evict looks for an absent entry next */
+static SemaphoreHandle_t kvs_dir_mutex = NULL;
+static s16 kvs_free1[MODULE_NUM];                 /*!< cached free variable slots per module, -1 if not queried yet */
+static s16 kvs_free2[MODULE_NUM2];
+static s16 kvs_used1[MODULE_NUM];                 /*!< cached used variable slots per module, -1 if not opened yet */
+static s16 kvs_used2[MODULE_NUM2];
+
+static u64 kvs_hash(const char *key)
+{
+    u64 hash = 0xcbf29ce484222325ULL;
 
-    for (size_t i=0; i<MODULE_NUM2; i++)
+    while (*key)
     {
-        snprintf(ns, 15, "matter_kvs2_%d", i+1); 
-        ret = dct_unregister_module2(ns);
-        if (ret != DCT_SUCCESS)
-            goto exit;
-        else
-            printf("dct_unregister_module2 %s success\n", ns);
+        hash ^= (u8)*key++;
+        hash *= 0x100000001b3ULL;
     }
+    return hash;
+}
 
-exit:
-    if (ret != DCT_SUCCESS)
-        printf("DCT2 modules unregistration failed");
-    return ret;
+// without the mutex the directory stays disabled, keys are then located by scanning
+static bool kvs_dir_lock(void)
+{
+    if (kvs_dir_mutex == NULL)
+    {
+        taskENTER_CRITICAL();
+        if (kvs_dir_mutex == NULL)
+            kvs_dir_mutex = xSemaphoreCreateMutex();
+        taskEXIT_CRITICAL();
+        if (kvs_dir_mutex == NULL)
+            return false;
+    }
+    xSemaphoreTake(kvs_dir_mutex, portMAX_DELAY);
+    return true;
 }
 
-s32 deleteKey(const char *domain, const char *key)
+static void kvs_dir_unlock(void)
 {
-    dct_handle_t handle;
-    s32 ret;
-    char ns[15];
+    xSemaphoreGive(kvs_dir_mutex);
+}
 
-    // Loop over DCT1 modules
+static void kvs_dir_reset(void)
+{
+    if (!kvs_dir_lock())
+        return;
+    kvs_dir_count = 0;
+    for (size_t i=0; i<KVS_DIR_SLOTS; i++)
+        kvs_dir[i].region = KVS_LOC_EMPTY;
     for (size_t i=0; i<MODULE_NUM; i++)
     {
-        snprintf(ns, 15, "matter_kvs1_%d", i+1); 
-        ret = dct_open_module(&handle, ns);
-        if (ret != DCT_SUCCESS)
-        {
-            printf("%s : dct_open_module(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
-            goto exit;
-        }
-        ret = dct_delete_variable(&handle, key);
-        dct_close_module(&handle);
-        if (ret == DCT_SUCCESS) // return success once deleted
-            return ret;
+        kvs_free1[i] = -1;
+        kvs_used1[i] = -1;
     }
-
-    // Loop over DCT2 modules
     for (size_t i=0; i<MODULE_NUM2; i++)
     {
-        snprintf(ns, 15, "matter_kvs2_%d", i+1); 
-        ret = dct_open_module2(&handle, ns);
-        if (ret != DCT_SUCCESS)
-        {
-            printf("%s : dct_open_module2(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
-            goto exit;
-        }
-        ret = dct_delete_variable2(&handle, key);
-        dct_close_module2(&handle);
-        if (ret == DCT_SUCCESS) // return success once deleted
-            return ret;
+        kvs_free2[i] = -1;
+        kvs_used2[i] = -1;
     }
-
-exit:
-    return ret;
+    kvs_dir_unlock();
 }
 
-bool checkExist(const char *domain, const char *key)
+// slot holding the hash, or the empty slot ending its probe sequence; the table is never full
+// tombstone, if not NULL, gets the first absent entry of another key on the way, or NULL
+static kvs_dir_entry_t *kvs_dir_probe(u64 hash, kvs_dir_entry_t **tombstone)
 {
-    dct_handle_t handle;
-    s32 ret;
-    uint16_t len = 0;
-    u8 *str = malloc(sizeof(u8) * VARIABLE_VALUE_SIZE2); // use the bigger buffer size
-    char ns[15];
+    size_t slot = (size_t)(hash % KVS_DIR_SLOTS);
 
-    // Loop over DCT1 modules
-    for (size_t i=0; i<MODULE_NUM; i++)
+    if (tombstone != NULL)
+        *tombstone = NULL;
+    while (kvs_dir[slot].region != KVS_LOC_EMPTY && kvs_dir[slot].hash != hash)
     {
-        snprintf(ns, 15, "matter_kvs1_%d", i+1); 
-        ret = dct_open_module(&handle, ns);
-        if (ret != DCT_SUCCESS)
-        {
-            printf("%s : dct_open_module(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
-            goto exit;
-        }
+        if (tombstone != NULL && *tombstone == NULL && kvs_dir[slot].region == KVS_LOC_ABSENT)
+            *tombstone = &kvs_dir[slot];
+        slot = (slot + 1 == KVS_DIR_SLOTS) ? 0 : slot + 1;
+    }
+    return &kvs_dir[slot];
+}
 
-        len = sizeof(u32);
-        ret = dct_get_variable_new(&handle, key, (char *)str, &len);
-        if(ret == DCT_SUCCESS)
-        {
-            printf("checkExist key=%s found.\n", key);
-            dct_close_module(&handle);
-            goto exit;
-        }
+// remove the entry and shift the rest of its cluster back, so no probe sequence is cut short
+static void kvs_dir_remove(kvs_dir_entry_t *entry)
+{
+    size_t hole = (size_t)(entry - kvs_dir);
+    size_t slot = hole;
 
-        len = sizeof(u64);
-        ret = dct_get_variable_new(&handle, key, (char *)str, &len);
-        if(ret == DCT_SUCCESS)
+    while (1)
+    {
+        slot = (slot + 1 == KVS_DIR_SLOTS) ? 0 : slot + 1;
+        if (kvs_dir[slot].region == KVS_LOC_EMPTY)
+            break;
+
+        // the entry may move back into the hole unless its home slot lies between the two
+        size_t home = (size_t)(kvs_dir[slot].hash % KVS_DIR_SLOTS);
+        bool between = (hole <= slot) ? (hole < home && home <= slot) : (hole < home || home <= slot);
+        if (!between)
         {
-            printf("checkExist key=%s found.\n", key);
-            dct_close_module(&handle);
-            goto exit;
+            kvs_dir[hole] = kvs_dir[slot];
+            hole = slot;
         }
-
-        dct_close_module(&handle);
     }
+    kvs_dir[hole].region = KVS_LOC_EMPTY;
+    kvs_dir_count--;
+}
 
-    // Loop over DCT2 modules
-    for (size_t i=0; i<MODULE_NUM2; i++)
+// remove one absent entry, taking them in turn around the table; false if there is none
+static bool kvs_dir_evict(void)
+{
+    for (size_t i=0; i<KVS_DIR_SLOTS; i++)
     {
-        snprintf(ns, 15, "matter_kvs2_%d", i+1); 
-        ret = dct_open_module2(&handle, ns);
-        if (ret != DCT_SUCCESS)
-        {
-            printf("%s : dct_open_module2(%s) failed with error : %d\n" ,__FUNCTION__, ns, ret);
-            goto exit;
-        }
+        kvs_dir_entry_t *entry = &kvs_dir[kvs_dir_evict_next];
 
-        len = VARIABLE_VALUE_SIZE2;
-        ret = dct_get_variable_new2(&handle, key, str, &len);
-        if(ret == DCT_SUCCESS)
+        kvs_dir_evict_next = (kvs_dir_evict_next + 1 == KVS_DIR_SLOTS) ? 0 : kvs_dir_evict_next + 1;
+        if (entry->region == KVS_LOC_ABSENT)
         {
-            printf("checkExist key=%s found.\n", key);
-            dct_close_module2(&handle);
-            goto exit;
+            kvs_dir_remove(entry);
+            return true;
         }
-
-        dct_close_module2(&handle);
     }
-
-exit:
-    free(str);
-    return (ret == DCT_SUCCESS) ? true : false;
+    return false;
 }
 
-s32 setPref_new(const char *domain, const char *key, u8 *value, size_t byteCount)
+static bool kvs_dir_lookup(u64 hash, u8 *region, u8 *module)
 {
-    dct_handle_t handle;
-    s32 ret;
-    char ns[15];
+    kvs_dir_entry_t *entry;
+    bool found = false;
 
-    if (byteCount <= 64)
+    if (!kvs_dir_lock())
+        return false;
+    entry = kvs_dir_probe(hash, NULL);
+    if (entry->region != KVS_LOC_EMPTY)
     {
-        // Loop over DCT1 modules
-        for (size_t i=0; i<MODULE_NUM; i++)
-        {
-            snprintf(ns, 15, "matter_kvs1_%d", i+1); 
-            ret = dct_open_module(&handle, ns);
-            if (ret != DCT_SUCCESS)
-            {
-                printf("%s : dct_open_module(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
-                goto exit;
-            }
+        *region = entry->region;
+        *module = entry->module;
+        found = true;
+    }
+    kvs_dir_unlock();
+    return found;
+}
 
-            if (dct_remain_variable(&handle) > 0)
-            {
-#if CONFIG_ENABLE_DCT_ENCRYPTION
-                ret = dct_set_encrypted_variable(&handle, key, value, byteCount, DCT_REGION_1);
-#else
-                ret = dct_set_variable_new(&handle, key, (char *)value, (uint16_t)byteCount);
-#endif
-                if (ret != DCT_SUCCESS)
-                {
-                    printf("%s : dct_set_variable(%s) failed with error: %d\n" ,__FUNCTION__, key, ret);
-                    dct_close_module(&handle);
-                    goto exit;
-                }
-                dct_close_module(&handle);
-                break;
-            }
-            dct_close_module(&handle);
-        }
+static void kvs_dir_update(u64 hash, u8 region, u8 module)
+{
+    kvs_dir_entry_t *entry;
+    kvs_dir_entry_t *tombstone;
+    bool near_full;
+
+    if (!kvs_dir_lock())
+        return;
+    entry = kvs_dir_probe(hash, &tombstone);
+    near_full = (kvs_dir_count >= KVS_DIR_NEAR_FULL);
+    if (region == KVS_LOC_ABSENT && near_full)
+    {
+        // negative results are only cached while there is room, a deleted key gives its slot back
+        if (entry->region != KVS_LOC_EMPTY)
+            kvs_dir_remove(entry);
+        entry = NULL;
     }
-    else
+    else if (entry->region == KVS_LOC_EMPTY && tombstone != NULL)
     {
-        // Loop over DCT2 modules
-        for (size_t i=0; i<MODULE_NUM2; i++)
+        entry = tombstone;
+    }
+    else if (entry->region == KVS_LOC_EMPTY)
+    {
+        // a key that exists is worth more than an absent one; untracked keys still work, they are just located by scanning
+        if (kvs_dir_count >= KVS_DIR_SIZE && (region == KVS_LOC_ABSENT || !kvs_dir_evict()))
+            entry = NULL;
+        else
         {
-            snprintf(ns, 15, "matter_kvs2_%d", i+1); 
-            ret = dct_open_module2(&handle, ns);
-            if (ret != DCT_SUCCESS)
-            {
-                printf("%s : dct_open_module2(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
-                goto exit;
-            }
+            entry = kvs_dir_probe(hash, NULL);
+            kvs_dir_count++;
+        }
+    }
+    if (entry != NULL)
+    {
+        entry->hash = hash;
+        entry->region = region;
+        entry->module = module;
+    }
+    kvs_dir_unlock();
+}
 
-            if (dct_remain_variable2(&handle) > 0)
-            {
+static inline size_t kvs_module_num(u8 region)
+{
+    return (region == DCT_REGION_1) ? MODULE_NUM : MODULE_NUM2;
+}
+
+static inline s16 *kvs_free_slots(u8 region, u8 module)
+{
+    return (region == DCT_REGION_1) ? &kvs_free1[module] : &kvs_free2[module];
+}
+
+static inline s16 *kvs_used_slots(u8 region, u8 module)
+{
+    return (region == DCT_REGION_1) ? &kvs_used1[module] : &kvs_used2[module];
+}
+
+// a variable was deleted from (delta 1) or added to (delta -1) the module
+static void kvs_free_adjust(u8 region, u8 module, s16 delta)
+{
+    s16 *free_slots = kvs_free_slots(region, module);
+    s16 *used_slots = kvs_used_slots(region, module);
+
+    if (!kvs_dir_lock())
+        return;
+    if (*free_slots >= 0)
+        *free_slots += delta;
+    if (*used_slots >= 0)
+        *used_slots -= delta;
+    kvs_dir_unlock();
+}
+
+// true if the module held no variable when it was last opened, and none was added since
+static bool kvs_module_empty(u8 region, u8 module)
+{
+    bool empty = false;
+
+    if (kvs_dir_lock())
+    {
+        empty = (*kvs_used_slots(region, module) == 0);
+        kvs_dir_unlock();
+    }
+    return empty;
+}
+
+static s32 kvs_open_module(dct_handle_t *handle, u8 region, u8 module)
+{
+    s32 ret;
+    char ns[15];
+
+    if (region == DCT_REGION_1)
+    {
+        snprintf(ns, 15, "matter_kvs1_%d", module+1);
+        ret = dct_open_module(handle, ns);
+    }
+    else
+    {
+        snprintf(ns, 15, "matter_kvs2_%d", module+1);
+        ret = dct_open_module2(handle, ns);
+    }
+
+    if (ret != DCT_SUCCESS)
+        printf("%s : dct_open_module(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
+    else if (kvs_dir_lock())
+    {
+        *kvs_used_slots(region, module) = (s16)handle->used_variable_num;
+        kvs_dir_unlock();
+    }
+    return ret;
+}
+
+static void kvs_close_module(dct_handle_t *handle, u8 region)
+{
+    if (region == DCT_REGION_1)
+        dct_close_module(handle);
+    else
+        dct_close_module2(handle);
+}
+
+static s32 kvs_read_variable(dct_handle_t *handle, u8 region, const char *key, char *buf, uint16_t *len, bool decrypt)
+{
+#if CONFIG_ENABLE_DCT_ENCRYPTION
+    if (decrypt)
+        return dct_get_encrypted_variable(handle, (char *)key, buf, len, region);
+#endif
+    if (region == DCT_REGION_1)
+        return dct_get_variable_new(handle, (char *)key, buf, len);
+    return dct_get_variable_new2(handle, (char *)key, buf, len);
+}
+
+static s32 kvs_set_variable(dct_handle_t *handle, u8 region, const char *key, u8 *value, size_t byteCount)
+{
 #if CONFIG_ENABLE_DCT_ENCRYPTION
-                ret = dct_set_encrypted_variable(&handle, key, value, byteCount, DCT_REGION_2);
+    return dct_set_encrypted_variable(handle, (char *)key, (char *)value, (uint16_t)byteCount, region);
 #else
-                ret = dct_set_variable_new2(&handle, key, (char *)value, (uint16_t)byteCount);
+    if (region == DCT_REGION_1)
+        return dct_set_variable_new(handle, (char *)key, (char *)value, (uint16_t)byteCount);
+    return dct_set_variable_new2(handle, (char *)key, (char *)value, (uint16_t)byteCount);
 #endif
-                if (ret != DCT_SUCCESS)
-                {
-                    printf("%s : dct_set_variable2(%s) failed with error: %d\n" ,__FUNCTION__, key, ret);
-                    dct_close_module2(&handle);
-                    goto exit;
-                }
-                dct_close_module2(&handle);
-                break;
+}
+
+static s16 kvs_remain_variable(dct_handle_t *handle, u8 region)
+{
+    if (region == DCT_REGION_1)
+        return (s16)dct_remain_variable(handle);
+    return (s16)dct_remain_variable2(handle);
+}
+
+static s32 kvs_delete_variable(dct_handle_t *handle, u8 region, const char *key)
+{
+    if (region == DCT_REGION_1)
+        return dct_delete_variable(handle, (char *)key);
+    return dct_delete_variable2(handle, (char *)key);
+}
+
+/*
+   Read a key through the directory. A directory hit opens exactly one module; a miss scans
+   DCT1 then DCT2 modules like before and records where the key was found (or that it is absent).
+*/
+static s32 kvs_get_variable(const char *key, char *buf, uint16_t *len, bool decrypt)
+{
+    dct_handle_t handle;
+    s32 ret;
+    u64 hash = kvs_hash(key);
+    uint16_t bufSize = *len;
+    bool absent = true;
+    u8 region, module;
+
+    if (kvs_dir_lookup(hash, &region, &module))
+    {
+        if (region == KVS_LOC_ABSENT)
+            return DCT_ERR_NOT_FIND;
+
+        ret = kvs_open_module(&handle, region, module);
+        if (ret != DCT_SUCCESS)
+            return ret;
+        ret = kvs_read_variable(&handle, region, key, buf, len, decrypt);
+        kvs_close_module(&handle, region);
+        if (ret != DCT_ERR_NOT_FIND)
+            return ret;
+        // stale entry or hash collision, fall back to scanning every module
+    }
+
+    ret = DCT_ERR_NOT_FIND;
+    for (region = DCT_REGION_1; region <= DCT_REGION_2; region++)
+    {
+        for (module = 0; module < kvs_module_num(region); module++)
+        {
+            if (kvs_module_empty(region, module))
+                continue;
+            ret = kvs_open_module(&handle, region, module);
+            if (ret != DCT_SUCCESS)
+                return ret;
+            *len = bufSize;
+            ret = kvs_read_variable(&handle, region, key, buf, len, decrypt);
+            kvs_close_module(&handle, region);
+            if (ret == DCT_SUCCESS)
+            {
+                kvs_dir_update(hash, region, module);
+                return ret;
             }
-            dct_close_module2(&handle);
+            if (ret != DCT_ERR_NOT_FIND)
+                absent = false;
         }
     }
 
-exit:
+    // only remember absence when no module reported anything but "not found"
+    if (absent)
+        kvs_dir_update(hash, KVS_LOC_ABSENT, 0);
     return ret;
 }
 
-s32 getPref_bool_new(const char *domain, const char *key, u8 *val)
+/*
+   Find where a key lives before writing it. On first contact since boot the modules are probed,
+   so an older copy gets replaced rather than shadowed by a new one in another module.
+*/
+static void kvs_locate(const char *key, u64 hash, u8 *region, u8 *module)
+{
+    if (!kvs_dir_lookup(hash, region, module))
+    {
+        uint16_t len = VARIABLE_VALUE_SIZE2;
+        u8 *str = malloc(sizeof(u8) * VARIABLE_VALUE_SIZE2);
+
+        if (str != NULL)
+        {
+            kvs_get_variable(key, (char *)str, &len, false);
+            free(str);
+        }
+        if (!kvs_dir_lookup(hash, region, module))
+            *region = KVS_LOC_ABSENT;
+    }
+}
+
+s32 initPref(void)
+{
+    s32 ret;
+
+    pref_flush_suspended = false;
+    kvs_dir_reset();
+
+    ret = dct_init(DCT_BEGIN_ADDR_MATTER, MODULE_NUM, VARIABLE_NAME_SIZE, VARIABLE_VALUE_SIZE, ENABLE_BACKUP, ENABLE_WEAR_LEVELING);
+    if (ret != DCT_SUCCESS)
+        printf("dct_init failed with error: %d\n", ret);
+    else
+        printf("dct_init success\n");
+
+    ret = dct_init2(DCT_BEGIN_ADDR_MATTER2, MODULE_NUM2, VARIABLE_NAME_SIZE2, VARIABLE_VALUE_SIZE2, ENABLE_BACKUP, ENABLE_WEAR_LEVELING);
+    if (ret != DCT_SUCCESS)
+        printf("dct_init2 failed with error: %d\n", ret);
+    else
+        printf("dct_init2 success\n");
+
+#if CONFIG_ENABLE_DCT_ENCRYPTION
+    // Initialize mbedtls aes context and set encryption key
+    mbedtls_aes_init(&aes);
+    if (mbedtls_aes_setkey_enc(&aes, key, 256) != 0)
+    {
+        return DCT_ERROR;
+    }
+#endif
+
+    return ret;
+}
+
+s32 deinitPref(void)
+{
+    s32 ret;
+
+    pref_flush_suspended = true;
+    ret = dct_format(DCT_BEGIN_ADDR_MATTER, MODULE_NUM, VARIABLE_NAME_SIZE, VARIABLE_VALUE_SIZE, ENABLE_BACKUP, ENABLE_WEAR_LEVELING);
+    if (ret != DCT_SUCCESS)
+        printf("dct_format failed with error: %d\n", ret);
+    else
+        printf("dct_format success\n");
+
+    ret = dct_format2(DCT_BEGIN_ADDR_MATTER2, MODULE_NUM2, VARIABLE_NAME_SIZE2, VARIABLE_VALUE_SIZE2, ENABLE_BACKUP, ENABLE_WEAR_LEVELING);
+    if (ret != DCT_SUCCESS)
+        printf("dct_format2 failed with error: %d\n", ret);
+    else
+        printf("dct_format2 success\n");
+
+    kvs_dir_reset();
+
+#if CONFIG_ENABLE_DCT_ENCRYPTION
+    // free aes context
+    mbedtls_aes_free(&aes);
+#endif
+
+    return ret;
+}
+
+s32 registerPref()
 {
-    dct_handle_t handle;
     s32 ret;
-    uint16_t len = sizeof(u8);
     char ns[15];
 
-    // Loop over DCT1 modules
     for (size_t i=0; i<MODULE_NUM; i++)
     {
         snprintf(ns, 15, "matter_kvs1_%d", i+1); 
-        ret = dct_open_module(&handle, ns);
+        ret = dct_register_module(ns);
         if (ret != DCT_SUCCESS)
-        {
-            printf("%s : dct_open_module(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
             goto exit;
-        }
-#if CONFIG_ENABLE_DCT_ENCRYPTION
-        ret = dct_get_encrypted_variable(&handle, key, (char *)val, &len, DCT_REGION_1);
-#else
-        ret = dct_get_variable_new(&handle, key, (char *)val, &len);
-#endif
-        dct_close_module(&handle);
-        if (ret == DCT_SUCCESS)
-        {
-            return ret;
-        }
+        else
+            printf("dct_register_module %s success\n", ns);
     }
 
-    // Loop over DCT2 modules
+exit:
+    if (ret != DCT_SUCCESS)
+        printf("DCT1 modules registration failed");
+    return ret;
+}
+
+s32 registerPref2()
+{
+    s32 ret;
+    char ns[15];
+
     for (size_t i=0; i<MODULE_NUM2; i++)
     {
         snprintf(ns, 15, "matter_kvs2_%d", i+1); 
-        ret = dct_open_module2(&handle, ns);
+        ret = dct_register_module2(ns);
         if (ret != DCT_SUCCESS)
-        {
-            printf("%s : dct_open_module2(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
             goto exit;
-        }
-#if CONFIG_ENABLE_DCT_ENCRYPTION
-        ret = dct_get_encrypted_variable(&handle, key, (char *)val, &len, DCT_REGION_2);
-#else
-        ret = dct_get_variable_new2(&handle, key, (char *)val, &len);
-#endif
-        dct_close_module2(&handle);
-        if (ret == DCT_SUCCESS)
-        {
-            return ret;
-        }
+        else
+            printf("dct_register_module2 %s success\n", ns);
     }
 
 exit:
+    if (ret != DCT_SUCCESS)
+        printf("DCT2 modules registration failed");
     return ret;
 }
 
-s32 getPref_u32_new(const char *domain, const char *key, u32 *val)
+s32 clearPref()
 {
-    dct_handle_t handle;
     s32 ret;
-    uint16_t len = sizeof(u32);
     char ns[15];
 
-    // Loop over DCT1 modules
+    pref_flush_suspended = true;
+    kvs_dir_reset();
+
     for (size_t i=0; i<MODULE_NUM; i++)
     {
         snprintf(ns, 15, "matter_kvs1_%d", i+1); 
-        ret = dct_open_module(&handle, ns);
+        ret = dct_unregister_module(ns);
         if (ret != DCT_SUCCESS)
-        {
-            printf("%s : dct_open_module(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
             goto exit;
-        }
-#if CONFIG_ENABLE_DCT_ENCRYPTION
-        ret = dct_get_encrypted_variable(&handle, key, (char *)val, &len, DCT_REGION_1);
-#else
-        ret = dct_get_variable_new(&handle, key, (char *)val, &len);
-#endif
-        dct_close_module(&handle);
-        if (ret == DCT_SUCCESS)
-        {
-            return ret;
-        }
+        else
+            printf("dct_unregister_module %s success\n", ns);
     }
 
-    // Loop over DCT2 modules
+exit:
+    if (ret != DCT_SUCCESS)
+        printf("DCT1 modules unregistration failed");
+    return ret;
+}
+
+s32 clearPref2()
+{
+    s32 ret;
+    char ns[15];
+
+    kvs_dir_reset();
+
     for (size_t i=0; i<MODULE_NUM2; i++)
     {
         snprintf(ns, 15, "matter_kvs2_%d", i+1); 
-        ret = dct_open_module2(&handle, ns);
+        ret = dct_unregister_module2(ns);
         if (ret != DCT_SUCCESS)
-        {
-            printf("%s : dct_open_module2(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
             goto exit;
-        }
-#if CONFIG_ENABLE_DCT_ENCRYPTION
-        ret = dct_get_encrypted_variable(&handle, key, (char *)val, &len, DCT_REGION_2);
-#else
-        ret = dct_get_variable_new2(&handle, key, (char *)val, &len);
-#endif
-        dct_close_module2(&handle);
-        if (ret == DCT_SUCCESS)
-        {
-            return ret;
-        }
+        else
+            printf("dct_unregister_module2 %s success\n", ns);
     }
 
 exit:
+    if (ret != DCT_SUCCESS)
+        printf("DCT2 modules unregistration failed");
     return ret;
 }
 
-s32 getPref_u64_new(const char *domain, const char *key, u64 *val)
+s32 deleteKey(const char *domain, const char *key)
 {
     dct_handle_t handle;
     s32 ret;
-    uint16_t len = sizeof(u64);
-    char ns[15];
+    u64 hash = kvs_hash(key);
+    u8 region, module;
 
-    // Loop over DCT1 modules
-    for (size_t i=0; i<MODULE_NUM; i++)
+    if (kvs_dir_lookup(hash, &region, &module))
     {
-        snprintf(ns, 15, "matter_kvs1_%d", i+1); 
-        ret = dct_open_module(&handle, ns);
+        if (region == KVS_LOC_ABSENT)
+            return DCT_ERR_NOT_FIND;
+
+        ret = kvs_open_module(&handle, region, module);
         if (ret != DCT_SUCCESS)
-        {
-            printf("%s : dct_open_module(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
-            goto exit;
-        }
-#if CONFIG_ENABLE_DCT_ENCRYPTION
-        ret = dct_get_encrypted_variable(&handle, key, (char *)val, &len, DCT_REGION_1);
-#else
-        ret = dct_get_variable_new(&handle, key, (char *)val, &len);
-#endif
-        dct_close_module(&handle);
+            return ret;
+        ret = kvs_delete_variable(&handle, region, key);
+        kvs_close_module(&handle, region);
         if (ret == DCT_SUCCESS)
         {
+            kvs_free_adjust(region, module, 1);
+            kvs_dir_update(hash, KVS_LOC_ABSENT, 0);
             return ret;
         }
+        // stale entry, fall back to scanning every module
     }
 
-    // Loop over DCT2 modules
-    for (size_t i=0; i<MODULE_NUM2; i++)
+    ret = DCT_ERR_NOT_FIND;
+    for (region = DCT_REGION_1; region <= DCT_REGION_2; region++)
     {
-        snprintf(ns, 15, "matter_kvs2_%d", i+1); 
-        ret = dct_open_module2(&handle, ns);
-        if (ret != DCT_SUCCESS)
+        for (module = 0; module < kvs_module_num(region); module++)
         {
-            printf("%s : dct_open_module2(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
-            goto exit;
-        }
-#if CONFIG_ENABLE_DCT_ENCRYPTION
-        ret = dct_get_encrypted_variable(&handle, key, (char *)val, &len, DCT_REGION_2);
-#else
-        ret = dct_get_variable_new2(&handle, key, (char *)val, &len);
-#endif
-        dct_close_module2(&handle);
-        if (ret == DCT_SUCCESS)
-        {
-            return ret;
+            if (kvs_module_empty(region, module))
+                continue;
+            ret = kvs_open_module(&handle, region, module);
+            if (ret != DCT_SUCCESS)
+                return ret;
+            ret = kvs_delete_variable(&handle, region, key);
+            kvs_close_module(&handle, region);
+            if (ret == DCT_SUCCESS) // return success once deleted
+            {
+                kvs_free_adjust(region, module, 1);
+                kvs_dir_update(hash, KVS_LOC_ABSENT, 0);
+                return ret;
+            }
         }
     }
 
-exit:
+    kvs_dir_update(hash, KVS_LOC_ABSENT, 0);
     return ret;
 }
 
-s32 getPref_str_new(const char *domain, const char *key, char * buf, size_t bufSize, size_t *outLen)
+bool checkExist(const char *domain, const char *key)
 {
-    dct_handle_t handle;
     s32 ret;
-    char ns[15];
+    uint16_t len = VARIABLE_VALUE_SIZE2; // use the bigger buffer size
+    u8 *str = malloc(sizeof(u8) * VARIABLE_VALUE_SIZE2);
 
-    // Loop over DCT1 modules
-    for (size_t i=0; i<MODULE_NUM; i++)
+    if (str == NULL)
+        return false;
+
+    // raw read, no need to decrypt just to test for presence
+    ret = kvs_get_variable(key, (char *)str, &len, false);
+    if (ret == DCT_SUCCESS)
+        printf("checkExist key=%s found.\n", key);
+
+    free(str);
+    return (ret == DCT_SUCCESS) ? true : false;
+}
+
+s32 setPref_new(const char *domain, const char *key, u8 *value, size_t byteCount)
+{
+    dct_handle_t handle;
+    s32 ret = DCT_ERR_NO_SPACE;
+    u64 hash = kvs_hash(key);
+    u8 target = (byteCount <= 64) ? DCT_REGION_1 : DCT_REGION_2;
+    u8 region, module;
+
+    kvs_locate(key, hash, &region, &module);
+    if (region != KVS_LOC_ABSENT)
     {
-        snprintf(ns, 15, "matter_kvs1_%d", i+1); 
-        ret = dct_open_module(&handle, ns);
-        if (ret != DCT_SUCCESS)
+        if (region == target)
         {
-            printf("%s : dct_open_module(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
-            goto exit;
+            // overwrite in place, the key keeps its slot
+            ret = kvs_open_module(&handle, region, module);
+            if (ret != DCT_SUCCESS)
+                return ret;
+            ret = kvs_set_variable(&handle, region, key, value, byteCount);
+            kvs_close_module(&handle, region);
+            if (ret != DCT_SUCCESS)
+                printf("%s : dct_set_variable(%s) failed with error: %d\n" ,__FUNCTION__, key, ret);
+            return ret;
         }
-#if CONFIG_ENABLE_DCT_ENCRYPTION
-        ret = dct_get_encrypted_variable(&handle, key, buf, &bufSize, DCT_REGION_1);
-#else
-        ret = dct_get_variable_new(&handle, key, buf, &bufSize);
-#endif
-        dct_close_module(&handle);
-        if (ret == DCT_SUCCESS)
+
+        // value moved to the other region, drop the old copy so reads cannot return it
+        if (kvs_open_module(&handle, region, module) == DCT_SUCCESS)
         {
-            *outLen = bufSize;
-            return ret;
+            if (kvs_delete_variable(&handle, region, key) == DCT_SUCCESS)
+                kvs_free_adjust(region, module, 1);
+            kvs_close_module(&handle, region);
         }
+        kvs_dir_update(hash, KVS_LOC_ABSENT, 0);
     }
 
-    // Loop over DCT2 modules
-    for (size_t i=0; i<MODULE_NUM2; i++)
+    // new key, store it in the first module of the target region with a free slot
+    for (module = 0; module < kvs_module_num(target); module++)
     {
-        snprintf(ns, 15, "matter_kvs2_%d", i+1); 
-        ret = dct_open_module2(&handle, ns);
+        s16 *free_slots = kvs_free_slots(target, module);
+
+        if (*free_slots == 0)
+            continue;
+
+        ret = kvs_open_module(&handle, target, module);
         if (ret != DCT_SUCCESS)
+            return ret;
+
+        if (*free_slots < 0)
+            *free_slots = kvs_remain_variable(&handle, target);
+
+        if (*free_slots > 0)
         {
-            printf("%s : dct_open_module2(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
-            goto exit;
-        }
-#if CONFIG_ENABLE_DCT_ENCRYPTION
-        ret = dct_get_encrypted_variable(&handle, key, buf, &bufSize, DCT_REGION_2);
-#else
-        ret = dct_get_variable_new2(&handle, key, buf, &bufSize);
-#endif
-        dct_close_module2(&handle);
-        if (ret == DCT_SUCCESS)
-        {
-            *outLen = bufSize;
+            ret = kvs_set_variable(&handle, target, key, value, byteCount);
+            if (ret != DCT_SUCCESS)
+            {
+                printf("%s : dct_set_variable(%s) failed with error: %d\n" ,__FUNCTION__, key, ret);
+                kvs_close_module(&handle, target);
+                return ret;
+            }
+            kvs_free_adjust(target, module, -1);
+            *free_slots = kvs_remain_variable(&handle, target);
+            kvs_close_module(&handle, target);
+            kvs_dir_update(hash, target, module);
             return ret;
         }
+        kvs_close_module(&handle, target);
     }
 
-exit:
+    printf("%s : no free slot for %s\n", __FUNCTION__, key);
+    return ret;
+}
+
+s32 getPref_bool_new(const char *domain, const char *key, u8 *val)
+{
+    uint16_t len = sizeof(u8);
+
+    return kvs_get_variable(key, (char *)val, &len, true);
+}
+
+s32 getPref_u32_new(const char *domain, const char *key, u32 *val)
+{
+    uint16_t len = sizeof(u32);
+
+    return kvs_get_variable(key, (char *)val, &len, true);
+}
+
+s32 getPref_u64_new(const char *domain, const char *key, u64 *val)
+{
+    uint16_t len = sizeof(u64);
+
+    return kvs_get_variable(key, (char *)val, &len, true);
+}
+
+s32 getPref_str_new(const char *domain, const char *key, char * buf, size_t bufSize, size_t *outLen)
+{
+    s32 ret;
+    uint16_t len = (bufSize > 0xFFFF) ? 0xFFFF : (uint16_t)bufSize;
+
+    ret = kvs_get_variable(key, buf, &len, true);
+    if (ret == DCT_SUCCESS)
+        *outLen = len;
     return ret;
 }
 
 s32 getPref_bin_new(const char *domain, const char *key, u8 * buf, size_t bufSize, size_t *outLen)
+{
+    s32 ret;
+    uint16_t len = (bufSize > 0xFFFF) ? 0xFFFF : (uint16_t)bufSize;
+
+    ret = kvs_get_variable(key, (char *)buf, &len, true);
+    if (ret == DCT_SUCCESS)
+        *outLen = len;
+    return ret;
+}
+
+static inline u8 kvs_txn_target(pref_txn_op_t *op)
+{
+    if (op->value == NULL)
+        return KVS_LOC_ABSENT;
+    return (op->byteCount <= 64) ? DCT_REGION_1 : DCT_REGION_2;
+}
+
+/*
+   Locate every key of a transaction the directory does not know yet in a single pass,
+   each module is opened once for the whole batch instead of once per key. A read error other
+   than "not found" aborts: the key might exist, a new copy could shadow it.
+*/
+static s32 kvs_txn_resolve(pref_txn_t *txn)
 {
     dct_handle_t handle;
     s32 ret;
-    char ns[15];
+    size_t pending = 0;
+    u8 *buf;
+    u8 region, module;
 
-    // Loop over DCT1 modules
-    for (size_t i=0; i<MODULE_NUM; i++)
+    for (size_t i=0; i<txn->count; i++)
     {
-        snprintf(ns, 15, "matter_kvs1_%d", i+1); 
-        ret = dct_open_module(&handle, ns);
-        if (ret != DCT_SUCCESS)
+        pref_txn_op_t *op = &txn->ops[i];
+
+        if (!kvs_dir_lookup(kvs_hash(op->key), &op->region, &op->module))
         {
-            printf("%s : dct_open_module(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
-            goto exit;
+            op->region = KVS_LOC_ABSENT;
+            op->unsure = true;
+            pending++;
         }
-#if CONFIG_ENABLE_DCT_ENCRYPTION
-        ret = dct_get_encrypted_variable(&handle, key, (char *)buf, &bufSize, DCT_REGION_1);
-#else
-        ret = dct_get_variable_new(&handle, key, (char *)buf, &bufSize);
-#endif
-        dct_close_module(&handle);
-        if (ret == DCT_SUCCESS)
+    }
+
+    if (pending == 0)
+        return DCT_SUCCESS;
+
+    buf = malloc(sizeof(u8) * VARIABLE_VALUE_SIZE2);
+    if (buf == NULL)
+        return DCT_ERR_NO_MEMORY;
+
+    // probed keys start out unsure and are known absent once every module answered "not found"
+    for (region = DCT_REGION_1; region <= DCT_REGION_2 && pending > 0; region++)
+    {
+        for (module = 0; module < kvs_module_num(region) && pending > 0; module++)
         {
-            *outLen = bufSize;
-            return ret;
+            if (kvs_module_empty(region, module))
+                continue;
+            ret = kvs_open_module(&handle, region, module);
+            if (ret != DCT_SUCCESS)
+            {
+                free(buf);
+                return ret;
+            }
+
+            for (size_t i=0; i<txn->count; i++)
+            {
+                pref_txn_op_t *op = &txn->ops[i];
+                uint16_t len = VARIABLE_VALUE_SIZE2;
+
+                if (!op->unsure || op->region != KVS_LOC_ABSENT)
+                    continue;
+
+                ret = kvs_read_variable(&handle, region, op->key, (char *)buf, &len, false);
+                if (ret == DCT_SUCCESS)
+                {
+                    op->region = region;
+                    op->module = module;
+                    op->unsure = false;
+                    kvs_dir_update(kvs_hash(op->key), region, module);
+                    pending--;
+                }
+                else if (ret != DCT_ERR_NOT_FIND)
+                {
+                    printf("%s : dct_get_variable(%s) failed with error: %d\n" ,__FUNCTION__, op->key, ret);
+                    kvs_close_module(&handle, region);
+                    free(buf);
+                    return ret;
+                }
+            }
+            kvs_close_module(&handle, region);
         }
     }
 
-    // Loop over DCT2 modules
-    for (size_t i=0; i<MODULE_NUM2; i++)
+    for (size_t i=0; i<txn->count; i++)
     {
-        snprintf(ns, 15, "matter_kvs2_%d", i+1); 
-        ret = dct_open_module2(&handle, ns);
-        if (ret != DCT_SUCCESS)
+        pref_txn_op_t *op = &txn->ops[i];
+
+        if (op->unsure)
+            kvs_dir_update(kvs_hash(op->key), KVS_LOC_ABSENT, 0);
+        op->unsure = false;
+    }
+
+    free(buf);
+    return DCT_SUCCESS;
+}
+
+/*
+   Apply a transaction module by module. Every touched module is opened once: deletes go first,
+   then in-place overwrites, then new keys fill its free slots. A value that moves to the other
+   region keeps its old copy until the new one is written, the old copies are deleted last.
+   DCT commits per module, so a power loss mid-commit can leave some modules updated and others
+   not; one between the two copies of a moved value leaves both, and a scan finds the DCT1 one.
+*/
+s32 commitPrefTxn(pref_txn_t *txn)
+{
+    dct_handle_t handle;
+    s32 ret, err;
+    size_t placing[2] = {0, 0};     /*!< values still waiting for a slot, per target region */
+    u8 region, module;
+
+    ret = kvs_txn_resolve(txn);
+    if (ret != DCT_SUCCESS)
+    {
+        abortPrefTxn(txn);
+        return ret;
+    }
+
+    for (size_t i=0; i<txn->count; i++)
+    {
+        pref_txn_op_t *op = &txn->ops[i];
+        u8 target = kvs_txn_target(op);
+
+        if (target == KVS_LOC_ABSENT)
+            op->done = (op->region == KVS_LOC_ABSENT);  // nothing to delete
+        else if (op->region != target)
+            placing[target]++;
+    }
+
+    for (region = DCT_REGION_1; region <= DCT_REGION_2; region++)
+    {
+        for (module = 0; module < kvs_module_num(region); module++)
         {
-            printf("%s : dct_open_module2(%s) failed with error: %d\n" ,__FUNCTION__, ns, ret);
-            goto exit;
+            s16 *free_slots = kvs_free_slots(region, module);
+            bool touched = false;
+
+            // old copies of moved values are not touched yet
+            for (size_t i=0; i<txn->count && !touched; i++)
+                touched = (txn->ops[i].region == region && txn->ops[i].module == module
+                           && (txn->ops[i].value == NULL || kvs_txn_target(&txn->ops[i]) == region));
+
+            if (!touched && (placing[region] == 0 || *free_slots == 0))
+                continue;
+
+            err = kvs_open_module(&handle, region, module);
+            if (err != DCT_SUCCESS)
+            {
+                if (ret == DCT_SUCCESS)
+                    ret = err;
+                continue;
+            }
+
+            for (size_t i=0; touched && i<txn->count; i++)
+            {
+                pref_txn_op_t *op = &txn->ops[i];
+                u64 hash = kvs_hash(op->key);
+
+                if (op->region != region || op->module != module || op->value != NULL)
+                    continue;
+
+                err = kvs_delete_variable(&handle, region, op->key);
+                if (err == DCT_SUCCESS)
+                    kvs_free_adjust(region, module, 1);
+                if (err == DCT_SUCCESS || err == DCT_ERR_NOT_FIND)
+                {
+                    op->region = KVS_LOC_ABSENT;
+                    kvs_dir_update(hash, KVS_LOC_ABSENT, 0);
+                }
+                else
+                {
+                    printf("%s : dct_delete_variable(%s) failed with error: %d\n" ,__FUNCTION__, op->key, err);
+                    if (ret == DCT_SUCCESS)
+                        ret = err;
+                }
+                op->done = true;
+            }
+
+            for (size_t i=0; touched && i<txn->count; i++)
+            {
+                pref_txn_op_t *op = &txn->ops[i];
+
+                if (op->region != region || op->module != module || kvs_txn_target(op) != region)
+                    continue;
+
+                err = kvs_set_variable(&handle, region, op->key, op->value, op->byteCount);
+                if (err != DCT_SUCCESS)
+                {
+                    printf("%s : dct_set_variable(%s) failed with error: %d\n" ,__FUNCTION__, op->key, err);
+                    if (ret == DCT_SUCCESS)
+                        ret = err;
+                }
+                op->done = true;
+            }
+
+            if (placing[region] > 0)
+            {
+                if (*free_slots < 0)
+                    *free_slots = kvs_remain_variable(&handle, region);
+
+                for (size_t i=0; i<txn->count && placing[region] > 0 && *free_slots > 0; i++)
+                {
+                    pref_txn_op_t *op = &txn->ops[i];
+
+                    if (op->done || kvs_txn_target(op) != region || op->region == region)
+                        continue;
+
+                    err = kvs_set_variable(&handle, region, op->key, op->value, op->byteCount);
+                    if (err == DCT_ERR_NO_SPACE)
+                        break;
+                    if (err == DCT_SUCCESS)
+                    {
+                        kvs_free_adjust(region, module, -1);
+                        kvs_dir_update(kvs_hash(op->key), region, module);
+                        op->placed = (op->region != KVS_LOC_ABSENT);
+                    }
+                    else
+                    {
+                        printf("%s : dct_set_variable(%s) failed with error: %d\n" ,__FUNCTION__, op->key, err);
+                        if (ret == DCT_SUCCESS)
+                            ret = err;
+                        (*free_slots)--;
+                    }
+                    op->done = true;
+                    placing[region]--;
+                }
+                *free_slots = kvs_remain_variable(&handle, region);
+            }
+            kvs_close_module(&handle, region);
         }
-#if CONFIG_ENABLE_DCT_ENCRYPTION
-        ret = dct_get_encrypted_variable(&handle, key, (char *)buf, &bufSize, DCT_REGION_2);
-#else
-        ret = dct_get_variable_new2(&handle, key, (char *)buf, &bufSize);
-#endif
-        dct_close_module2(&handle);
-        if (ret == DCT_SUCCESS)
+    }
+
+    // a moved value whose new copy could not be written keeps the old one
+    for (region = DCT_REGION_1; region <= DCT_REGION_2; region++)
+    {
+        for (module = 0; module < kvs_module_num(region); module++)
         {
-            *outLen = bufSize;
-            return ret;
+            bool moved = false;
+
+            for (size_t i=0; i<txn->count && !moved; i++)
+                moved = (txn->ops[i].placed && txn->ops[i].region == region && txn->ops[i].module == module);
+            if (!moved)
+                continue;
+
+            err = kvs_open_module(&handle, region, module);
+            if (err != DCT_SUCCESS)
+            {
+                if (ret == DCT_SUCCESS)
+                    ret = err;
+                continue;
+            }
+
+            for (size_t i=0; i<txn->count; i++)
+            {
+                pref_txn_op_t *op = &txn->ops[i];
+
+                if (!op->placed || op->region != region || op->module != module)
+                    continue;
+
+                err = kvs_delete_variable(&handle, region, op->key);
+                if (err == DCT_SUCCESS)
+                    kvs_free_adjust(region, module, 1);
+                else if (err != DCT_ERR_NOT_FIND)
+                {
+                    printf("%s : dct_delete_variable(%s) failed with error: %d\n" ,__FUNCTION__, op->key, err);
+                    if (ret == DCT_SUCCESS)
+                        ret = err;
+                }
+            }
+            kvs_close_module(&handle, region);
         }
     }
 
-exit:
+    for (size_t i=0; i<txn->count; i++)
+    {
+        if (!txn->ops[i].done)
+        {
+            printf("%s : no free slot for %s\n", __FUNCTION__, txn->ops[i].key);
+            if (ret == DCT_SUCCESS)
+                ret = DCT_ERR_NO_SPACE;
+        }
+    }
+
+    abortPrefTxn(txn);
     return ret;
 }
+#endif // CONFIG_ENABLE_MATTER_KVS_LOG
+
+s32 registerPrefFlushHandler(pref_flush_handler_t handler)
+{
+    for (size_t i=0; i<PREF_FLUSH_HANDLER_NUM; i++)
+    {
+        if (pref_flush_handlers[i] == handler)
+            return DCT_SUCCESS;
+
+        if (pref_flush_handlers[i] == NULL)
+        {
+            pref_flush_handlers[i] = handler;
+            return DCT_SUCCESS;
+        }
+    }
+
+    printf("%s : no free flush handler slot\n", __FUNCTION__);
+    return DCT_ERROR;
+}
+
+void flushPref(void)
+{
+    // Flash writes and the chip stack lock are not available from an interrupt, pending values are lost there
+    if (pref_flush_suspended || __get_IPSR() != 0)
+        return;
+
+    for (size_t i=0; i<PREF_FLUSH_HANDLER_NUM; i++)
+    {
+        if (pref_flush_handlers[i] != NULL)
+            pref_flush_handlers[i]();
+    }
+}
+
+// every software reset (sys_reset, ATSR, factory reset, OTA apply) commits pending write-behind values first
+void sys_reset_prepare(void)
+{
+    flushPref();
+}
 
 #ifdef __cplusplus
 }
@@ -27,6 +27,27 @@ s32 getPref_u64_new(const char *domain, const char *key, u64 *val);
 s32 getPref_str_new(const char *domain, const char *key, char * buf, size_t bufSize, size_t *outLen);
 s32 getPref_bin_new(const char *domain, const char *key, u8 * buf, size_t bufSize, size_t *outLen);
 
+// batched changes, grouped per storage module on commit; commit and abort release the transaction
+typedef struct pref_txn_op pref_txn_op_t;
+typedef struct
+{
+    pref_txn_op_t *ops;
+    size_t count;
+    size_t capacity;
+} pref_txn_t;
+
+s32 beginPrefTxn(pref_txn_t *txn);
+s32 setPrefTxn(pref_txn_t *txn, const char *key, u8 *value, size_t byteCount);
+s32 deletePrefTxn(pref_txn_t *txn, const char *key);
+s32 commitPrefTxn(pref_txn_t *txn);
+void abortPrefTxn(pref_txn_t *txn);
+
+// write-behind layers register here so pending writes are committed before reboot/OTA apply, sys_reset_prepare()
+// flushes them on every software reset; flushing is skipped after clearPref()/deinitPref() until initPref()
+typedef void (*pref_flush_handler_t)(void);
+s32 registerPrefFlushHandler(pref_flush_handler_t handler);
+void flushPref(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,1143 @@
+/**************************
+* Matter KVS Log Related
+**************************/
+#include "platform_opts.h"
+#include "platform/platform_stdlib.h"
+
+#if defined(CONFIG_ENABLE_MATTER_KVS_LOG) && CONFIG_ENABLE_MATTER_KVS_LOG
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "stddef.h"
+#include "string.h"
+#include "stdbool.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "flash_api.h"
+#include "device_lock.h"
+#include "dct.h"
+#include "matter_kvs_log.h"
+
+/*
+   Append-only key-value log over a flash partition.
+   Every set/delete appends a variable-length record (header + key + value, CRC protected) to the
+   head sector and a RAM index points each key at its newest record. Sectors are reclaimed oldest
+   first: the live records of the oldest sector are copied to the head and the sector is erased,
+   so erases rotate evenly over the whole partition.
+   At init the log is replayed in sector sequence order. A record failing its CRC is a write torn
+   by power loss; its still-erased skip field is programmed to step over the damaged bytes so the
+   rest of the sector stays usable.
+   matter_kvs_log_commit writes a batch between a begin and a commit marker record. Its records are
+   applied at replay only once the commit marker is found; a batch cut short by power loss is sealed
+   like a torn record, so it can never be applied later. Room for the whole batch is made before
+   the begin marker, no compaction copy ever lands inside a batch.
+   The default partition is the DCT2 + DCT1 range, the flash the DCT backend keeps its modules in,
+   and nothing is migrated between the two. Turning CONFIG_ENABLE_MATTER_KVS_LOG on starts from an
+   empty log that erases the DCT modules sector by sector, turning it off leaves the DCT backend no
+   valid module: the fabrics and every other key are lost either way and the device has to be
+   commissioned again. tools/matter/kvs_log runs the log on a simulated flash.
+*/
+#ifndef MATTER_KVS_LOG_BEGIN_ADDR
+#define MATTER_KVS_LOG_BEGIN_ADDR   DCT_BEGIN_ADDR2   /*!< 0x3E6000 ~ 0x3FB000 : 84K, DCT2 and DCT1 */
+#endif
+#ifndef MATTER_KVS_LOG_SECTOR_NUM
+#define MATTER_KVS_LOG_SECTOR_NUM   21
+#endif
+#define MATTER_KVS_LOG_SECTOR_SIZE  4096
+#define MATTER_KVS_LOG_MAX_KEYS     384               /*!< max number of keys held by the RAM index */
+#define MATTER_KVS_LOG_KEY_SIZE     32                /*!< max key length */
+#define MATTER_KVS_LOG_VALUE_SIZE   2048              /*!< max value length, a record never spans sectors */
+#define MATTER_KVS_LOG_RESERVED     1                 /*!< free sectors kept back for compaction */
+#define MATTER_KVS_LOG_GC_THRESHOLD 3                 /*!< compaction task runs at or below this many free sectors */
+#define MATTER_KVS_LOG_GC_STACK     1024
+#define MATTER_KVS_LOG_GC_PRIORITY  (tskIDLE_PRIORITY + 1)
+
+#define KVS_LOG_SECTOR_MAGIC        0x4C564B4D        /*!< "MKVL" */
+#define KVS_LOG_RECORD_MAGIC        0x5652
+#define KVS_LOG_SEQ_UNASSIGNED      0xFFFFFFFF
+#define KVS_LOG_FLAG_DELETE         0x01
+#define KVS_LOG_FLAG_BATCH          0x02              /*!< written between a begin and a commit marker */
+#define KVS_LOG_FLAG_BEGIN          0x04              /*!< marker opening a batch */
+#define KVS_LOG_FLAG_COMMIT         0x08              /*!< marker closing a batch */
+#define KVS_LOG_ALIGN(x)            (((x) + 3) & ~3)
+#define KVS_LOG_CHUNK_SIZE          64
+
+typedef struct
+{
+    u32 magic;
+    u32 erase_count;
+    u32 crc;                                      /*!< over magic and erase_count */
+    u32 seq;                                      /*!< programmed when the sector becomes the log head */
+} kvs_log_sector_hdr_t;
+
+typedef struct
+{
+    u16 magic;
+    u8 key_len;
+    u8 flags;
+    u16 value_len;
+    u16 skip;                                     /*!< left erased; set to the span in words when the record is torn */
+    u32 crc;                                      /*!< over key_len, flags, value_len, key and value */
+} kvs_log_record_hdr_t;
+
+#define KVS_LOG_SECTOR_DATA         (MATTER_KVS_LOG_SECTOR_SIZE - sizeof(kvs_log_sector_hdr_t))
+#define KVS_LOG_RECORD_SIZE(k, v)   KVS_LOG_ALIGN(sizeof(kvs_log_record_hdr_t) + (k) + (v))
+#define KVS_LOG_SKIP_ERASED         0xFFFF
+#define KVS_LOG_SKIP_BYTES(skip)    ((skip) ? (u32)(skip) * 4 : 4)
+#define KVS_LOG_MARKER_SIZE         KVS_LOG_RECORD_SIZE(1, 0)
+
+enum
+{
+    KVS_LOG_SECTOR_BLANK = 0,                     /*!< no valid header, erased before use */
+    KVS_LOG_SECTOR_FREE,                          /*!< erased, header prepared */
+    KVS_LOG_SECTOR_USED,                          /*!< part of the log */
+};
+
+typedef struct
+{
+    u32 seq;
+    u32 erase_count;
+    u16 write_offset;                             /*!< end of valid records */
+    u16 live_bytes;                               /*!< bytes of records still referenced by the index */
+    u8 state;
+} kvs_log_sector_t;
+
+typedef struct
+{
+    u32 hash;
+    u16 sector;
+    u16 offset;
+    u16 value_len;
+    u8 key_len;
+} kvs_log_index_t;
+
+static flash_t kvs_log_flash;
+static SemaphoreHandle_t kvs_log_mutex = NULL;
+static TaskHandle_t kvs_log_gc_task = NULL;
+static kvs_log_sector_t kvs_log_sectors[MATTER_KVS_LOG_SECTOR_NUM];
+static kvs_log_index_t kvs_log_index[MATTER_KVS_LOG_MAX_KEYS];
+static size_t kvs_log_index_count = 0;
+static s16 kvs_log_head = -1;                     /*!< sector receiving appends, -1 if none */
+static u32 kvs_log_next_seq = 0;
+static matter_kvs_log_stats_t kvs_log_stats;
+static const char kvs_log_marker_key[1] = {0};    /*!< key of the batch markers, no C string key can match it */
+
+// replay only: the batch whose commit marker has not been seen yet
+static struct
+{
+    bool open;
+    u16 sector;
+    u16 offset;
+} kvs_log_batch;
+
+/*                  Flash Access                  */
+static inline u32 kvs_log_addr(u16 sector, u16 offset)
+{
+    return MATTER_KVS_LOG_BEGIN_ADDR + (u32)sector * MATTER_KVS_LOG_SECTOR_SIZE + offset;
+}
+
+static void kvs_log_flash_read(u32 addr, void *buf, u32 len)
+{
+    device_mutex_lock(RT_DEV_LOCK_FLASH);
+    flash_stream_read(&kvs_log_flash, addr, len, (u8 *)buf);
+    device_mutex_unlock(RT_DEV_LOCK_FLASH);
+}
+
+static void kvs_log_flash_write(u32 addr, const void *buf, u32 len)
+{
+    if (len == 0)
+        return;
+
+    device_mutex_lock(RT_DEV_LOCK_FLASH);
+    flash_stream_write(&kvs_log_flash, addr, len, (u8 *)buf);
+    device_mutex_unlock(RT_DEV_LOCK_FLASH);
+    kvs_log_stats.bytes_written += len;
+}
+
+static void kvs_log_flash_erase(u16 sector)
+{
+    device_mutex_lock(RT_DEV_LOCK_FLASH);
+    flash_erase_sector(&kvs_log_flash, kvs_log_addr(sector, 0));
+    device_mutex_unlock(RT_DEV_LOCK_FLASH);
+    kvs_log_stats.erases++;
+}
+
+static u32 kvs_log_crc32(u32 crc, const u8 *data, size_t len)
+{
+    static const u32 table[16] =
+    {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    crc = ~crc;
+    while (len--)
+    {
+        crc = table[(crc ^ *data) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (*data >> 4)) & 0x0F] ^ (crc >> 4);
+        data++;
+    }
+    return ~crc;
+}
+
+static u32 kvs_log_crc32_flash(u32 crc, u32 addr, u32 len)
+{
+    u8 chunk[KVS_LOG_CHUNK_SIZE];
+
+    while (len > 0)
+    {
+        u32 n = (len > sizeof(chunk)) ? sizeof(chunk) : len;
+
+        kvs_log_flash_read(addr, chunk, n);
+        crc = kvs_log_crc32(crc, chunk, n);
+        addr += n;
+        len -= n;
+    }
+    return crc;
+}
+
+static u32 kvs_log_hash(const char *key, size_t key_len)
+{
+    u32 hash = 0x811C9DC5;
+
+    while (key_len--)
+    {
+        hash ^= (u8)*key++;
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+/*                  Index                  */
+static int kvs_log_index_find(const char *key, size_t key_len, u32 hash)
+{
+    char stored[MATTER_KVS_LOG_KEY_SIZE];
+
+    for (size_t i=0; i<kvs_log_index_count; i++)
+    {
+        kvs_log_index_t *entry = &kvs_log_index[i];
+
+        if (entry->hash != hash || entry->key_len != key_len)
+            continue;
+
+        // hashes may collide, confirm against the key stored in flash
+        kvs_log_flash_read(kvs_log_addr(entry->sector, entry->offset + sizeof(kvs_log_record_hdr_t)), stored, key_len);
+        if (memcmp(stored, key, key_len) == 0)
+            return (int)i;
+    }
+    return -1;
+}
+
+static int kvs_log_index_find_record(u16 sector, u16 offset)
+{
+    for (size_t i=0; i<kvs_log_index_count; i++)
+    {
+        if (kvs_log_index[i].sector == sector && kvs_log_index[i].offset == offset)
+            return (int)i;
+    }
+    return -1;
+}
+
+static void kvs_log_index_release(int idx)
+{
+    kvs_log_index_t *entry = &kvs_log_index[idx];
+
+    kvs_log_sectors[entry->sector].live_bytes -= KVS_LOG_RECORD_SIZE(entry->key_len, entry->value_len);
+}
+
+static void kvs_log_index_remove(int idx)
+{
+    kvs_log_index_release(idx);
+    kvs_log_index[idx] = kvs_log_index[--kvs_log_index_count];
+}
+
+// Point key at a new record, returns false if the index is full
+static bool kvs_log_index_store(int idx, u32 hash, u8 key_len, u16 value_len, u16 sector, u16 offset)
+{
+    kvs_log_index_t *entry;
+
+    if (idx >= 0)
+    {
+        kvs_log_index_release(idx);
+        entry = &kvs_log_index[idx];
+    }
+    else if (kvs_log_index_count < MATTER_KVS_LOG_MAX_KEYS)
+    {
+        entry = &kvs_log_index[kvs_log_index_count++];
+    }
+    else
+    {
+        return false;
+    }
+
+    entry->hash = hash;
+    entry->key_len = key_len;
+    entry->value_len = value_len;
+    entry->sector = sector;
+    entry->offset = offset;
+    kvs_log_sectors[sector].live_bytes += KVS_LOG_RECORD_SIZE(key_len, value_len);
+    return true;
+}
+
+/*                  Sectors                  */
+static size_t kvs_log_free_count(void)
+{
+    size_t count = 0;
+
+    for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM; i++)
+    {
+        if (kvs_log_sectors[i].state != KVS_LOG_SECTOR_USED)
+            count++;
+    }
+    return count;
+}
+
+// Bytes compaction could give back, the head excluded
+static u32 kvs_log_garbage(void)
+{
+    u32 garbage = 0;
+
+    for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM; i++)
+    {
+        if (kvs_log_sectors[i].state == KVS_LOG_SECTOR_USED && (s16)i != kvs_log_head)
+            garbage += KVS_LOG_SECTOR_DATA - kvs_log_sectors[i].live_bytes;
+    }
+    return garbage;
+}
+
+static void kvs_log_prepare_sector(u16 sector)
+{
+    kvs_log_sector_t *s = &kvs_log_sectors[sector];
+    kvs_log_sector_hdr_t hdr;
+
+    kvs_log_flash_erase(sector);
+    s->erase_count++;
+
+    hdr.magic = KVS_LOG_SECTOR_MAGIC;
+    hdr.erase_count = s->erase_count;
+    hdr.crc = kvs_log_crc32(0, (u8 *)&hdr, offsetof(kvs_log_sector_hdr_t, crc));
+    kvs_log_flash_write(kvs_log_addr(sector, 0), &hdr, offsetof(kvs_log_sector_hdr_t, seq));
+
+    s->seq = KVS_LOG_SEQ_UNASSIGNED;
+    s->state = KVS_LOG_SECTOR_FREE;
+    s->write_offset = sizeof(kvs_log_sector_hdr_t);
+    s->live_bytes = 0;
+}
+
+// Move the head to the least-worn free sector; only compaction may take the reserved sectors
+static s32 kvs_log_open_head(bool compacting)
+{
+    s16 best = -1;
+    u32 seq;
+
+    for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM; i++)
+    {
+        if (kvs_log_sectors[i].state == KVS_LOG_SECTOR_USED)
+            continue;
+        if (best < 0 || kvs_log_sectors[i].erase_count < kvs_log_sectors[best].erase_count)
+            best = (s16)i;
+    }
+
+    if (best < 0 || (!compacting && kvs_log_free_count() <= MATTER_KVS_LOG_RESERVED))
+        return DCT_ERR_NO_SPACE;
+
+    if (kvs_log_sectors[best].state == KVS_LOG_SECTOR_BLANK)
+        kvs_log_prepare_sector(best);
+
+    seq = kvs_log_next_seq++;
+    kvs_log_flash_write(kvs_log_addr(best, offsetof(kvs_log_sector_hdr_t, seq)), &seq, sizeof(seq));
+    kvs_log_sectors[best].seq = seq;
+    kvs_log_sectors[best].state = KVS_LOG_SECTOR_USED;
+    kvs_log_head = best;
+    return DCT_SUCCESS;
+}
+
+// Claim size bytes at the head of the log
+static s32 kvs_log_reserve(u16 size, bool compacting, u16 *sector, u16 *offset)
+{
+    kvs_log_sector_t *head = (kvs_log_head >= 0) ? &kvs_log_sectors[kvs_log_head] : NULL;
+
+    if (head == NULL || head->write_offset + size > MATTER_KVS_LOG_SECTOR_SIZE)
+    {
+        s32 ret = kvs_log_open_head(compacting);
+        if (ret != DCT_SUCCESS)
+            return ret;
+        head = &kvs_log_sectors[kvs_log_head];
+    }
+
+    *sector = (u16)kvs_log_head;
+    *offset = head->write_offset;
+    head->write_offset += size;
+    return DCT_SUCCESS;
+}
+
+// Copy the live records of the oldest sector to the head and erase it
+static s32 kvs_log_collect(void)
+{
+    s16 victim = -1;
+    u32 offset = sizeof(kvs_log_sector_hdr_t);
+    u8 chunk[KVS_LOG_CHUNK_SIZE];
+
+    for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM; i++)
+    {
+        if (kvs_log_sectors[i].state != KVS_LOG_SECTOR_USED || (s16)i == kvs_log_head)
+            continue;
+        if (victim < 0 || kvs_log_sectors[i].seq < kvs_log_sectors[victim].seq)
+            victim = (s16)i;
+    }
+
+    if (victim < 0)
+        return DCT_ERR_NO_SPACE;
+
+    while (offset + sizeof(kvs_log_record_hdr_t) <= kvs_log_sectors[victim].write_offset)
+    {
+        kvs_log_record_hdr_t rec;
+        int idx;
+        u16 size, dst_sector, dst_offset;
+
+        kvs_log_flash_read(kvs_log_addr(victim, offset), &rec, sizeof(rec));
+        if (rec.skip != KVS_LOG_SKIP_ERASED)
+        {
+            offset += KVS_LOG_SKIP_BYTES(rec.skip);
+            continue;
+        }
+        size = KVS_LOG_RECORD_SIZE(rec.key_len, rec.value_len);
+
+        // tombstones are dropped, nothing older than the oldest sector is left for them to hide
+        idx = kvs_log_index_find_record(victim, offset);
+        if (idx >= 0)
+        {
+            s32 ret = kvs_log_reserve(size, true, &dst_sector, &dst_offset);
+            if (ret != DCT_SUCCESS)
+                return ret;
+
+            for (u16 copied = 0; copied < size; copied += KVS_LOG_CHUNK_SIZE)
+            {
+                u16 n = (size - copied > KVS_LOG_CHUNK_SIZE) ? KVS_LOG_CHUNK_SIZE : size - copied;
+
+                kvs_log_flash_read(kvs_log_addr(victim, offset + copied), chunk, n);
+                kvs_log_flash_write(kvs_log_addr(dst_sector, dst_offset + copied), chunk, n);
+            }
+
+            kvs_log_index_store(idx, kvs_log_index[idx].hash, kvs_log_index[idx].key_len, kvs_log_index[idx].value_len, dst_sector, dst_offset);
+            kvs_log_stats.gc_bytes += size;
+        }
+        offset += size;
+    }
+
+    // the copies are in place before the only other copy goes away
+    kvs_log_prepare_sector(victim);
+    kvs_log_stats.gc_runs++;
+    return DCT_SUCCESS;
+}
+
+static void kvs_log_gc_thread(void *param)
+{
+    (void) param;
+
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // one sector per lock hold so foreground reads and writes interleave
+        for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM; i++)
+        {
+            bool done;
+
+            xSemaphoreTake(kvs_log_mutex, portMAX_DELAY);
+            done = kvs_log_free_count() > MATTER_KVS_LOG_GC_THRESHOLD
+                || kvs_log_garbage() < KVS_LOG_SECTOR_DATA
+                || kvs_log_collect() != DCT_SUCCESS;
+            xSemaphoreGive(kvs_log_mutex);
+
+            if (done)
+                break;
+        }
+    }
+}
+
+static void kvs_log_kick_gc(void)
+{
+    if (kvs_log_gc_task != NULL && kvs_log_free_count() <= MATTER_KVS_LOG_GC_THRESHOLD)
+        xTaskNotifyGive(kvs_log_gc_task);
+}
+
+/*                  Records                  */
+static void kvs_log_program(u16 sector, u16 offset, const char *key, u8 key_len, const u8 *value, u16 value_len, u8 flags)
+{
+    kvs_log_record_hdr_t rec;
+    u32 addr = kvs_log_addr(sector, offset);
+
+    rec.magic = KVS_LOG_RECORD_MAGIC;
+    rec.key_len = key_len;
+    rec.flags = flags;
+    rec.value_len = value_len;
+    rec.skip = KVS_LOG_SKIP_ERASED;
+    rec.crc = kvs_log_crc32(0, &rec.key_len, offsetof(kvs_log_record_hdr_t, skip) - offsetof(kvs_log_record_hdr_t, key_len));
+    rec.crc = kvs_log_crc32(rec.crc, (const u8 *)key, key_len);
+    rec.crc = kvs_log_crc32(rec.crc, value, value_len);
+
+    // header first, a write torn anywhere after it fails the CRC at replay
+    kvs_log_flash_write(addr, &rec, sizeof(rec));
+    kvs_log_flash_write(addr + sizeof(rec), key, key_len);
+    kvs_log_flash_write(addr + sizeof(rec) + key_len, value, value_len);
+}
+
+// a power cut during compaction can leave the reserve short, refill it before the head is used up
+static void kvs_log_refill_reserve(void)
+{
+    for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM && kvs_log_free_count() < MATTER_KVS_LOG_RESERVED; i++)
+    {
+        if (kvs_log_collect() != DCT_SUCCESS)
+            break;
+    }
+}
+
+static s32 kvs_log_append(const char *key, u8 key_len, const u8 *value, u16 value_len, u8 flags, u16 *sector, u16 *offset)
+{
+    u16 size = KVS_LOG_RECORD_SIZE(key_len, value_len);
+    s32 ret;
+
+    kvs_log_refill_reserve();
+
+    // out of space: compact in the foreground, bounded in case everything is live
+    ret = kvs_log_reserve(size, false, sector, offset);
+    for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM && ret == DCT_ERR_NO_SPACE; i++)
+    {
+        if (kvs_log_collect() != DCT_SUCCESS)
+            break;
+        ret = kvs_log_reserve(size, false, sector, offset);
+    }
+    if (ret != DCT_SUCCESS)
+        return ret;
+
+    kvs_log_program(*sector, *offset, key, key_len, value, value_len, flags);
+    kvs_log_stats.writes++;
+    return DCT_SUCCESS;
+}
+
+static bool kvs_log_value_equals(int idx, const u8 *value, size_t byteCount)
+{
+    kvs_log_index_t *entry = &kvs_log_index[idx];
+    u32 addr = kvs_log_addr(entry->sector, entry->offset + sizeof(kvs_log_record_hdr_t) + entry->key_len);
+    u8 chunk[KVS_LOG_CHUNK_SIZE];
+
+    if (entry->value_len != byteCount)
+        return false;
+
+    for (size_t pos = 0; pos < byteCount; pos += KVS_LOG_CHUNK_SIZE)
+    {
+        size_t n = (byteCount - pos > KVS_LOG_CHUNK_SIZE) ? KVS_LOG_CHUNK_SIZE : byteCount - pos;
+
+        kvs_log_flash_read(addr + pos, chunk, n);
+        if (memcmp(chunk, value + pos, n) != 0)
+            return false;
+    }
+    return true;
+}
+
+// Step over a torn record: everything from offset to the last programmed byte becomes a skip span
+static u16 kvs_log_seal_torn(u16 sector, u32 offset)
+{
+    u8 chunk[KVS_LOG_CHUNK_SIZE];
+    u32 end = offset + sizeof(kvs_log_record_hdr_t);
+    u16 skip;
+
+    for (u32 pos = MATTER_KVS_LOG_SECTOR_SIZE; pos > end; pos -= KVS_LOG_CHUNK_SIZE)
+    {
+        u32 n;
+
+        kvs_log_flash_read(kvs_log_addr(sector, pos - KVS_LOG_CHUNK_SIZE), chunk, KVS_LOG_CHUNK_SIZE);
+        for (n = KVS_LOG_CHUNK_SIZE; n > 0 && chunk[n - 1] == 0xFF; n--);
+        if (n > 0)
+        {
+            if (pos - KVS_LOG_CHUNK_SIZE + n > end)
+                end = pos - KVS_LOG_CHUNK_SIZE + n;
+            break;
+        }
+    }
+
+    skip = (u16)((KVS_LOG_ALIGN(end) - offset) / 4);
+    kvs_log_flash_write(kvs_log_addr(sector, offset + offsetof(kvs_log_record_hdr_t, skip)), &skip, sizeof(skip));
+    printf("%s : torn record in sector %d at 0x%x, skipping %d bytes\n", __FUNCTION__, (int)sector, (unsigned int)offset, skip * 4);
+    return skip;
+}
+
+// Point the index at a replayed record, or drop the key for a delete
+static void kvs_log_replay_record(u16 sector, u32 offset, const kvs_log_record_hdr_t *rec)
+{
+    char key[MATTER_KVS_LOG_KEY_SIZE];
+    u32 hash;
+    int idx;
+
+    kvs_log_flash_read(kvs_log_addr(sector, offset + sizeof(*rec)), key, rec->key_len);
+    hash = kvs_log_hash(key, rec->key_len);
+    idx = kvs_log_index_find(key, rec->key_len, hash);
+    if (rec->flags & KVS_LOG_FLAG_DELETE)
+    {
+        if (idx >= 0)
+            kvs_log_index_remove(idx);
+    }
+    else if (!kvs_log_index_store(idx, hash, rec->key_len, rec->value_len, sector, offset))
+    {
+        printf("%s : index full, dropping %.*s\n", __FUNCTION__, rec->key_len, key);
+    }
+}
+
+// The sector appended to after this one, -1 if it is the head
+static s16 kvs_log_next_sector(u16 sector)
+{
+    s16 next = -1;
+
+    for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM; i++)
+    {
+        if (kvs_log_sectors[i].state != KVS_LOG_SECTOR_USED || kvs_log_sectors[i].seq <= kvs_log_sectors[sector].seq)
+            continue;
+        if (next < 0 || kvs_log_sectors[i].seq < kvs_log_sectors[next].seq)
+            next = (s16)i;
+    }
+    return next;
+}
+
+/*
+   Close the open batch at the given record. A committed batch has its records applied in log
+   order; one that was never committed is sealed, its begin marker included, so it is skipped for
+   good and cannot be taken for committed once compaction has dropped its begin marker.
+*/
+static void kvs_log_batch_close(u16 end_sector, u32 end_offset, bool committed)
+{
+    s16 sector = (s16)kvs_log_batch.sector;
+    u32 offset = kvs_log_batch.offset;
+
+    while (sector >= 0 && !(sector == end_sector && offset >= end_offset))
+    {
+        kvs_log_record_hdr_t rec;
+        u16 size;
+
+        // sectors before the end one were replayed up to their write offset
+        if (sector != end_sector && offset + sizeof(rec) > kvs_log_sectors[sector].write_offset)
+        {
+            sector = kvs_log_next_sector(sector);
+            offset = sizeof(kvs_log_sector_hdr_t);
+            continue;
+        }
+
+        kvs_log_flash_read(kvs_log_addr(sector, offset), &rec, sizeof(rec));
+        if (rec.skip != KVS_LOG_SKIP_ERASED)
+        {
+            offset += KVS_LOG_SKIP_BYTES(rec.skip);
+            continue;
+        }
+
+        size = KVS_LOG_RECORD_SIZE(rec.key_len, rec.value_len);
+        if (committed && (rec.flags & KVS_LOG_FLAG_BATCH))
+        {
+            kvs_log_replay_record(sector, offset, &rec);
+        }
+        else if (!committed)
+        {
+            u16 skip = size / 4;
+            kvs_log_flash_write(kvs_log_addr(sector, offset + offsetof(kvs_log_record_hdr_t, skip)), &skip, sizeof(skip));
+        }
+        offset += size;
+    }
+
+    if (!committed)
+        printf("%s : dropped a batch that was not committed\n", __FUNCTION__);
+    kvs_log_batch.open = false;
+}
+
+// Replay one sector into the index and find where appends resume
+static void kvs_log_replay_sector(u16 sector)
+{
+    static const kvs_log_record_hdr_t erased = {0xFFFF, 0xFF, 0xFF, 0xFFFF, 0xFFFF, 0xFFFFFFFF};
+    u32 offset = sizeof(kvs_log_sector_hdr_t);
+
+    while (offset + sizeof(kvs_log_record_hdr_t) <= MATTER_KVS_LOG_SECTOR_SIZE)
+    {
+        kvs_log_record_hdr_t rec;
+        u32 addr = kvs_log_addr(sector, offset);
+        u16 size;
+
+        kvs_log_flash_read(addr, &rec, sizeof(rec));
+        if (memcmp(&rec, &erased, sizeof(rec)) == 0)
+            break; // end of log in this sector
+
+        if (rec.skip != KVS_LOG_SKIP_ERASED)
+        {
+            offset += KVS_LOG_SKIP_BYTES(rec.skip);
+            continue;
+        }
+
+        size = KVS_LOG_RECORD_SIZE(rec.key_len, rec.value_len);
+        if (rec.magic != KVS_LOG_RECORD_MAGIC || rec.key_len == 0 || rec.key_len > MATTER_KVS_LOG_KEY_SIZE
+            || rec.value_len > MATTER_KVS_LOG_VALUE_SIZE || offset + size > MATTER_KVS_LOG_SECTOR_SIZE
+            || rec.crc != kvs_log_crc32_flash(kvs_log_crc32(0, &rec.key_len, offsetof(kvs_log_record_hdr_t, skip) - offsetof(kvs_log_record_hdr_t, key_len)),
+                                              addr + sizeof(rec), rec.key_len + rec.value_len))
+        {
+            u16 skip = kvs_log_seal_torn(sector, offset);
+
+            offset += KVS_LOG_SKIP_BYTES(skip);
+            continue;
+        }
+
+        // batch records wait for their commit marker; any other record after an open batch means it was cut short
+        if (kvs_log_batch.open && !(rec.flags & (KVS_LOG_FLAG_BATCH | KVS_LOG_FLAG_COMMIT)))
+            kvs_log_batch_close(sector, offset, false);
+
+        if (rec.flags & KVS_LOG_FLAG_BEGIN)
+        {
+            kvs_log_batch.open = true;
+            kvs_log_batch.sector = sector;
+            kvs_log_batch.offset = (u16)offset;
+        }
+        else if (rec.flags & KVS_LOG_FLAG_COMMIT)
+        {
+            if (kvs_log_batch.open)
+                kvs_log_batch_close(sector, offset, true);
+        }
+        else if (!kvs_log_batch.open)
+        {
+            // batch records whose begin marker was compacted away belong to a committed batch
+            kvs_log_replay_record(sector, offset, &rec);
+        }
+        offset += size;
+    }
+
+    // a partially programmed skip field may point past the end, the sector is full then
+    kvs_log_sectors[sector].write_offset = (offset > MATTER_KVS_LOG_SECTOR_SIZE) ? MATTER_KVS_LOG_SECTOR_SIZE : offset;
+}
+
+static void kvs_log_create_mutex(void)
+{
+    taskENTER_CRITICAL();
+    if (kvs_log_mutex == NULL)
+        kvs_log_mutex = xSemaphoreCreateMutex();
+    taskEXIT_CRITICAL();
+}
+
+/*                  API                  */
+s32 matter_kvs_log_init(void)
+{
+    u32 max_erase_count = 0;
+    bool replayed[MATTER_KVS_LOG_SECTOR_NUM] = {false};
+
+    kvs_log_create_mutex();
+    if (kvs_log_mutex == NULL)
+        return DCT_ERR_NO_MEMORY;
+
+    xSemaphoreTake(kvs_log_mutex, portMAX_DELAY);
+
+    memset(kvs_log_sectors, 0, sizeof(kvs_log_sectors));
+    kvs_log_index_count = 0;
+    kvs_log_head = -1;
+    kvs_log_next_seq = 0;
+    kvs_log_batch.open = false;
+
+    for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM; i++)
+    {
+        kvs_log_sector_t *s = &kvs_log_sectors[i];
+        kvs_log_sector_hdr_t hdr;
+
+        kvs_log_flash_read(kvs_log_addr(i, 0), &hdr, sizeof(hdr));
+        if (hdr.magic != KVS_LOG_SECTOR_MAGIC || hdr.crc != kvs_log_crc32(0, (u8 *)&hdr, offsetof(kvs_log_sector_hdr_t, crc)))
+        {
+            s->state = KVS_LOG_SECTOR_BLANK;
+            continue;
+        }
+
+        s->erase_count = hdr.erase_count;
+        s->write_offset = sizeof(kvs_log_sector_hdr_t);
+        if (hdr.erase_count > max_erase_count)
+            max_erase_count = hdr.erase_count;
+
+        if (hdr.seq == KVS_LOG_SEQ_UNASSIGNED)
+        {
+            s->state = KVS_LOG_SECTOR_FREE;
+            s->seq = KVS_LOG_SEQ_UNASSIGNED;
+        }
+        else
+        {
+            s->state = KVS_LOG_SECTOR_USED;
+            s->seq = hdr.seq;
+            if (hdr.seq >= kvs_log_next_seq)
+                kvs_log_next_seq = hdr.seq + 1;
+        }
+    }
+
+    // the erase count of a blank sector was lost with its header, assume the worst seen
+    for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM; i++)
+    {
+        if (kvs_log_sectors[i].state == KVS_LOG_SECTOR_BLANK)
+            kvs_log_sectors[i].erase_count = max_erase_count;
+    }
+
+    // replay oldest to newest, later records win
+    for (;;)
+    {
+        s16 next = -1;
+
+        for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM; i++)
+        {
+            if (kvs_log_sectors[i].state != KVS_LOG_SECTOR_USED || replayed[i])
+                continue;
+            if (next < 0 || kvs_log_sectors[i].seq < kvs_log_sectors[next].seq)
+                next = (s16)i;
+        }
+        if (next < 0)
+            break;
+
+        replayed[next] = true;
+        kvs_log_replay_sector(next);
+        kvs_log_head = next;
+    }
+
+    // the power went before the last batch was committed
+    if (kvs_log_batch.open)
+        kvs_log_batch_close(kvs_log_head, kvs_log_sectors[kvs_log_head].write_offset, false);
+
+    printf("%s : %d keys, %d free sectors\n", __FUNCTION__, (int)kvs_log_index_count, (int)kvs_log_free_count());
+    xSemaphoreGive(kvs_log_mutex);
+
+    if (kvs_log_gc_task == NULL)
+    {
+        if (xTaskCreate(kvs_log_gc_thread, "matter_kvs_gc", MATTER_KVS_LOG_GC_STACK, NULL, MATTER_KVS_LOG_GC_PRIORITY, &kvs_log_gc_task) != pdPASS)
+            printf("%s : xTaskCreate(matter_kvs_gc) failed\n", __FUNCTION__);
+    }
+    kvs_log_kick_gc();
+    return DCT_SUCCESS;
+}
+
+s32 matter_kvs_log_format(void)
+{
+    kvs_log_create_mutex();
+    if (kvs_log_mutex == NULL)
+        return DCT_ERR_NO_MEMORY;
+
+    xSemaphoreTake(kvs_log_mutex, portMAX_DELAY);
+    for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM; i++)
+        kvs_log_prepare_sector(i);
+    kvs_log_index_count = 0;
+    kvs_log_head = -1;
+    kvs_log_next_seq = 0;
+    xSemaphoreGive(kvs_log_mutex);
+
+    return DCT_SUCCESS;
+}
+
+s32 matter_kvs_log_set(const char *key, const u8 *value, size_t byteCount)
+{
+    size_t key_len = strlen(key);
+    u32 hash = kvs_log_hash(key, key_len);
+    u16 sector, offset;
+    s32 ret;
+    int idx;
+
+    if (key_len == 0 || key_len > MATTER_KVS_LOG_KEY_SIZE || byteCount > MATTER_KVS_LOG_VALUE_SIZE)
+        return DCT_ERR_SIZE_OVER;
+    if (kvs_log_mutex == NULL)
+        return DCT_ERR_INVALID;
+
+    xSemaphoreTake(kvs_log_mutex, portMAX_DELAY);
+
+    idx = kvs_log_index_find(key, key_len, hash);
+    if (idx >= 0 && kvs_log_value_equals(idx, value, byteCount))
+    {
+        kvs_log_stats.skipped++;
+        ret = DCT_SUCCESS;
+        goto exit;
+    }
+    if (idx < 0 && kvs_log_index_count >= MATTER_KVS_LOG_MAX_KEYS)
+    {
+        ret = DCT_ERR_NO_MEMORY;
+        goto exit;
+    }
+
+    ret = kvs_log_append(key, (u8)key_len, value, (u16)byteCount, 0, &sector, &offset);
+    if (ret != DCT_SUCCESS)
+    {
+        printf("%s : append(%s) failed with error: %d\n", __FUNCTION__, key, ret);
+        goto exit;
+    }
+
+    // compaction inside append may have moved the old record, look it up again
+    kvs_log_index_store(kvs_log_index_find(key, key_len, hash), hash, (u8)key_len, (u16)byteCount, sector, offset);
+
+exit:
+    xSemaphoreGive(kvs_log_mutex);
+    kvs_log_kick_gc();
+    return ret;
+}
+
+s32 matter_kvs_log_get(const char *key, u8 *buf, size_t bufSize, size_t *outLen)
+{
+    size_t key_len = strlen(key);
+    s32 ret = DCT_SUCCESS;
+    int idx;
+
+    if (kvs_log_mutex == NULL)
+        return DCT_ERR_INVALID;
+
+    xSemaphoreTake(kvs_log_mutex, portMAX_DELAY);
+
+    idx = kvs_log_index_find(key, key_len, kvs_log_hash(key, key_len));
+    if (idx < 0)
+    {
+        ret = DCT_ERR_NOT_FIND;
+    }
+    else if (kvs_log_index[idx].value_len > bufSize)
+    {
+        ret = DCT_ERR_SIZE_OVER;
+    }
+    else
+    {
+        kvs_log_index_t *entry = &kvs_log_index[idx];
+
+        kvs_log_flash_read(kvs_log_addr(entry->sector, entry->offset + sizeof(kvs_log_record_hdr_t) + entry->key_len), buf, entry->value_len);
+        *outLen = entry->value_len;
+    }
+
+    xSemaphoreGive(kvs_log_mutex);
+    return ret;
+}
+
+s32 matter_kvs_log_delete(const char *key)
+{
+    size_t key_len = strlen(key);
+    u32 hash = kvs_log_hash(key, key_len);
+    u16 sector, offset;
+    s32 ret;
+    int idx;
+
+    if (kvs_log_mutex == NULL)
+        return DCT_ERR_INVALID;
+
+    xSemaphoreTake(kvs_log_mutex, portMAX_DELAY);
+
+    idx = kvs_log_index_find(key, key_len, hash);
+    if (idx < 0)
+    {
+        ret = DCT_ERR_NOT_FIND;
+        goto exit;
+    }
+
+    ret = kvs_log_append(key, (u8)key_len, NULL, 0, KVS_LOG_FLAG_DELETE, &sector, &offset);
+    if (ret != DCT_SUCCESS)
+    {
+        printf("%s : append(%s) failed with error: %d\n", __FUNCTION__, key, ret);
+        goto exit;
+    }
+
+    // compaction inside append may have moved the old record, look it up again
+    idx = kvs_log_index_find(key, key_len, hash);
+    if (idx >= 0)
+        kvs_log_index_remove(idx);
+
+exit:
+    xSemaphoreGive(kvs_log_mutex);
+    kvs_log_kick_gc();
+    return ret;
+}
+
+// Record sizes of a batch in write order; 0 marks a change that writes nothing
+typedef struct
+{
+    u16 size;
+    u16 sector;
+    u16 offset;
+} kvs_log_batch_slot_t;
+
+// true if the records fit in the head and the free sectors left outside the reserve, without compaction
+static bool kvs_log_batch_fits(const kvs_log_batch_slot_t *slots, size_t count)
+{
+    kvs_log_sector_t *head = (kvs_log_head >= 0) ? &kvs_log_sectors[kvs_log_head] : NULL;
+    u32 room = (head != NULL) ? MATTER_KVS_LOG_SECTOR_SIZE - head->write_offset : 0;
+    size_t free_count = kvs_log_free_count();
+    size_t spare = (free_count > MATTER_KVS_LOG_RESERVED) ? free_count - MATTER_KVS_LOG_RESERVED : 0;
+
+    for (size_t i=0; i<count + 2; i++)
+    {
+        u16 size = (i < count) ? slots[i].size : KVS_LOG_MARKER_SIZE;
+
+        if (size == 0)
+            continue;
+        if (size > room)
+        {
+            if (spare == 0)
+                return false;
+            spare--;
+            room = KVS_LOG_SECTOR_DATA;
+        }
+        room -= size;
+    }
+    return true;
+}
+
+/*
+   Apply several changes at once: after a power loss either all of them are found or none. A
+   single change is appended like matter_kvs_log_set does, more go between batch markers.
+*/
+s32 matter_kvs_log_commit(const matter_kvs_log_op_t *ops, size_t count)
+{
+    kvs_log_batch_slot_t *slots;
+    size_t needed = 0, new_keys = 0;
+    u16 sector, offset;
+    s32 ret = DCT_SUCCESS;
+    u8 flags;
+
+    for (size_t i=0; i<count; i++)
+    {
+        size_t key_len = strlen(ops[i].key);
+
+        if (key_len == 0 || key_len > MATTER_KVS_LOG_KEY_SIZE || ops[i].byteCount > MATTER_KVS_LOG_VALUE_SIZE)
+            return DCT_ERR_SIZE_OVER;
+    }
+    if (kvs_log_mutex == NULL)
+        return DCT_ERR_INVALID;
+    if (count == 0)
+        return DCT_SUCCESS;
+
+    slots = malloc(count * sizeof(kvs_log_batch_slot_t));
+    if (slots == NULL)
+        return DCT_ERR_NO_MEMORY;
+
+    xSemaphoreTake(kvs_log_mutex, portMAX_DELAY);
+
+    // unchanged values and deletes of missing keys write nothing
+    for (size_t i=0; i<count; i++)
+    {
+        size_t key_len = strlen(ops[i].key);
+        int idx = kvs_log_index_find(ops[i].key, key_len, kvs_log_hash(ops[i].key, key_len));
+
+        slots[i].size = 0;
+        if (ops[i].value == NULL)
+        {
+            if (idx >= 0)
+                slots[i].size = KVS_LOG_RECORD_SIZE(key_len, 0);
+        }
+        else if (idx >= 0 && kvs_log_value_equals(idx, ops[i].value, ops[i].byteCount))
+        {
+            kvs_log_stats.skipped++;
+        }
+        else
+        {
+            slots[i].size = KVS_LOG_RECORD_SIZE(key_len, ops[i].byteCount);
+            new_keys += (idx < 0);
+        }
+        needed += (slots[i].size != 0);
+    }
+
+    if (needed == 0)
+        goto exit;
+    if (kvs_log_index_count + new_keys > MATTER_KVS_LOG_MAX_KEYS)
+    {
+        ret = DCT_ERR_NO_MEMORY;
+        goto exit;
+    }
+
+    if (needed == 1)
+    {
+        for (size_t i=0; i<count; i++)
+        {
+            if (slots[i].size == 0)
+                continue;
+            ret = (ops[i].value != NULL) ? kvs_log_append(ops[i].key, (u8)strlen(ops[i].key), ops[i].value, (u16)ops[i].byteCount, 0, &slots[i].sector, &slots[i].offset)
+                                         : kvs_log_append(ops[i].key, (u8)strlen(ops[i].key), NULL, 0, KVS_LOG_FLAG_DELETE, &slots[i].sector, &slots[i].offset);
+        }
+    }
+    else
+    {
+        // compaction moves records around, it is done with before the begin marker
+        kvs_log_refill_reserve();
+        for (size_t i=0; i<MATTER_KVS_LOG_SECTOR_NUM && !kvs_log_batch_fits(slots, count); i++)
+        {
+            if (kvs_log_collect() != DCT_SUCCESS)
+                break;
+        }
+        if (!kvs_log_batch_fits(slots, count))
+        {
+            ret = DCT_ERR_NO_SPACE;
+            goto exit;
+        }
+
+        kvs_log_reserve(KVS_LOG_MARKER_SIZE, false, &sector, &offset);
+        kvs_log_program(sector, offset, kvs_log_marker_key, 1, NULL, 0, KVS_LOG_FLAG_BEGIN);
+        for (size_t i=0; i<count; i++)
+        {
+            if (slots[i].size == 0)
+                continue;
+            flags = KVS_LOG_FLAG_BATCH | ((ops[i].value == NULL) ? KVS_LOG_FLAG_DELETE : 0);
+            kvs_log_reserve(slots[i].size, false, &slots[i].sector, &slots[i].offset);
+            kvs_log_program(slots[i].sector, slots[i].offset, ops[i].key, (u8)strlen(ops[i].key), ops[i].value,
+                            (ops[i].value != NULL) ? (u16)ops[i].byteCount : 0, flags);
+            kvs_log_stats.writes++;
+        }
+        kvs_log_reserve(KVS_LOG_MARKER_SIZE, false, &sector, &offset);
+        kvs_log_program(sector, offset, kvs_log_marker_key, 1, NULL, 0, KVS_LOG_FLAG_COMMIT);
+    }
+
+    if (ret != DCT_SUCCESS)
+    {
+        printf("%s : append failed with error: %d\n", __FUNCTION__, ret);
+        goto exit;
+    }
+
+    // compaction inside a single append may have moved the old record, look every key up again
+    for (size_t i=0; i<count; i++)
+    {
+        size_t key_len = strlen(ops[i].key);
+        u32 hash = kvs_log_hash(ops[i].key, key_len);
+        int idx;
+
+        if (slots[i].size == 0)
+            continue;
+        idx = kvs_log_index_find(ops[i].key, key_len, hash);
+        if (ops[i].value != NULL)
+            kvs_log_index_store(idx, hash, (u8)key_len, (u16)ops[i].byteCount, slots[i].sector, slots[i].offset);
+        else if (idx >= 0)
+            kvs_log_index_remove(idx);
+    }
+
+exit:
+    xSemaphoreGive(kvs_log_mutex);
+    free(slots);
+    kvs_log_kick_gc();
+    return ret;
+}
+
+bool matter_kvs_log_exists(const char *key)
+{
+    size_t key_len = strlen(key);
+    bool found;
+
+    if (kvs_log_mutex == NULL)
+        return false;
+
+    xSemaphoreTake(kvs_log_mutex, portMAX_DELAY);
+    found = kvs_log_index_find(key, key_len, kvs_log_hash(key, key_len)) >= 0;
+    xSemaphoreGive(kvs_log_mutex);
+    return found;
+}
+
+void matter_kvs_log_get_stats(matter_kvs_log_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = kvs_log_stats;
+    taskEXIT_CRITICAL();
+}
+
+void matter_kvs_log_reset_stats(void)
+{
+    taskENTER_CRITICAL();
+    memset(&kvs_log_stats, 0, sizeof(kvs_log_stats));
+    taskEXIT_CRITICAL();
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_ENABLE_MATTER_KVS_LOG */
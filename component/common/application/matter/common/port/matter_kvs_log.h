@@ -0,0 +1,41 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Log-structured KVS backend, enabled with CONFIG_ENABLE_MATTER_KVS_LOG
+// It takes over the DCT1 + DCT2 flash, switching backends loses the stored keys
+// Return values follow the DCT error codes so callers can keep mapping them with kDctError
+typedef struct
+{
+    u32 writes;          // set/delete calls that appended a record
+    u32 skipped;         // set calls that matched the stored value and wrote nothing
+    u32 bytes_written;   // bytes programmed, compaction copies and sector headers included
+    u32 erases;          // sector erases
+    u32 gc_runs;         // sectors reclaimed by compaction
+    u32 gc_bytes;        // live record bytes moved by compaction
+} matter_kvs_log_stats_t;
+
+// One change of a batch, value NULL deletes the key
+typedef struct
+{
+    const char *key;
+    const u8 *value;
+    size_t byteCount;
+} matter_kvs_log_op_t;
+
+s32 matter_kvs_log_init(void);
+s32 matter_kvs_log_format(void);
+s32 matter_kvs_log_set(const char *key, const u8 *value, size_t byteCount);
+s32 matter_kvs_log_get(const char *key, u8 *buf, size_t bufSize, size_t *outLen);
+s32 matter_kvs_log_delete(const char *key);
+s32 matter_kvs_log_commit(const matter_kvs_log_op_t *ops, size_t count);
+bool matter_kvs_log_exists(const char *key);
+void matter_kvs_log_get_stats(matter_kvs_log_stats_t *stats);
+void matter_kvs_log_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,12 +12,40 @@ extern "C" {
 #include "flash_api.h"
 #include "sys_api.h"
 #include "device_lock.h"
+#include "dct.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
 #include "ota_8710c.h"
 #include "chip_porting.h"
+#include "matter_ota_delta.h"
+#include "matter_ota_lz.h"
+#include "mbedtls/sha256.h"
 
 #define MATTER_OTA_HEADER_SIZE 32
 #define MATTER_OTA_SECTOR_SIZE 4096
 #define MATTER_OTA_FIRMWARE_LENGTH   0x1AC000
+#define MATTER_OTA_BUFFER_NUM  2    /*!< sector buffers, BDX fills one while the flash task programs the others */
+#define MATTER_OTA_DIGEST_SIZE 32
+#define MATTER_OTA_CHECKPOINT_KEY      "ota/resume"
+#define MATTER_OTA_CHECKPOINT_MAGIC    0x4F544152  /*!< "RATO" */
+
+// Matter OTA image header digest types computed with SHA-256, the truncated ones keep the leading bytes
+#define MATTER_OTA_DIGEST_SHA256       1
+#define MATTER_OTA_DIGEST_SHA256_32    6
+
+/*
+   BDX blocks are copied into sector buffers on the Matter thread. Full buffers are queued to the
+   matter_ota_writer task which erases and programs the sector, then hands the buffer back through
+   the free queue. Reception only waits for flash when every buffer is still queued for writing.
+*/
+typedef struct
+{
+    uint8_t data[MATTER_OTA_SECTOR_SIZE];
+    uint32_t sector;                    // address of the sector this buffer is written to
+    uint16_t offset;                    // first byte programmed, header space is left erased in the first sector
+    uint16_t size;                      // bytes buffered after offset
+} matter_ota_buffer_t;
 
 static flash_t matter_ota_flash;
 bool matter_ota_first_sector_written = false;
@@ -26,8 +54,68 @@ uint32_t matter_ota_new_firmware_addr;
 
 uint8_t matter_ota_header[MATTER_OTA_HEADER_SIZE];
 uint8_t matter_ota_header_size = 0; // variable to track size of ota header
-uint8_t matter_ota_buffer[MATTER_OTA_SECTOR_SIZE]; // 4KB buffer to be written to one sector
-uint16_t matter_ota_buffer_size = 0; // variable to track size of buffer
+
+static matter_ota_buffer_t *matter_ota_buffers = NULL;
+static matter_ota_buffer_t *matter_ota_fill = NULL;     // buffer receiving BDX data, NULL until the next block arrives
+static QueueHandle_t matter_ota_free_queue = NULL;
+static QueueHandle_t matter_ota_write_queue = NULL;
+static TaskHandle_t matter_ota_writer_handle = NULL;
+static volatile bool matter_ota_write_failed = false;
+static uint32_t matter_ota_start_tick;
+static matter_ota_stats_t matter_ota_stats;
+
+/*
+   The image digest is computed by the flash task as sectors go out, so verifying the image
+   needs no read-back. Size and digest of the payload come from the Matter image header, which
+   the requestor glue forwards through matter_ota_set_image_info; a download without them fails.
+   A delta or compressed payload is hashed apart as it arrives, its own header then gives the
+   digest of the image it rebuilds.
+*/
+static mbedtls_sha256_context matter_ota_sha256;
+static bool matter_ota_header_hashed = false;
+static uint8_t matter_ota_digest[MATTER_OTA_DIGEST_SIZE];
+static uint8_t matter_ota_expected_digest[MATTER_OTA_DIGEST_SIZE];
+static uint8_t matter_ota_expected_digest_len = 0;     // payload digest from the image header, 0 until it is forwarded
+static uint32_t matter_ota_expected_size = 0;          // 0 if the payload size is unknown
+static bool matter_ota_image_rejected = false;
+
+static mbedtls_sha256_context matter_ota_payload_sha256;
+static bool matter_ota_payload_hashing = false;        // set while a delta or compressed payload is hashed
+static uint8_t matter_ota_rebuilt_digest[MATTER_OTA_DIGEST_SIZE];
+static bool matter_ota_rebuilt_digest_set = false;     // digest of the rebuilt image from the decoder header
+
+/*
+   Resume checkpoint of a plain image, stored in the KVS by the flash task after every committed
+   sector. A committed sector is final, so the checkpoint only records how far the partition is
+   written and the digest state at that point. A later download of the same image, same size and
+   header digest, picks it up in matter_ota_set_image_info: the bytes on flash already are skipped
+   by the transfer, see matter_ota_resume_skip. Delta and compressed payloads are not resumed,
+   their decoder state is not kept.
+*/
+typedef struct
+{
+    uint32_t magic;
+    uint32_t firmware_addr;             // OTA slot the sectors were written to
+    uint32_t offset;                    // payload bytes on flash, header included, always sector aligned
+    uint32_t expected_size;
+    uint8_t expected_digest_len;
+    uint8_t expected_digest[MATTER_OTA_DIGEST_SIZE];
+    uint8_t header[MATTER_OTA_HEADER_SIZE];
+    mbedtls_sha256_context sha256;
+} matter_ota_checkpoint_t;
+
+static matter_ota_checkpoint_t matter_ota_checkpoint;  // flash task only
+static volatile bool matter_ota_checkpointing = false; // set for a plain image with a verified digest
+static uint32_t matter_ota_resume_offset = 0;          // payload bytes on flash when the download resumed
+static uint32_t matter_ota_received = 0;               // payload bytes received or skipped
+
+// set while a delta payload is rebuilt against the running image, see matter_ota_delta.c
+static matter_ota_delta_t *matter_ota_delta = NULL;
+// the running image a delta payload applies to is checked by the flash task between sectors
+static matter_ota_delta_base_t matter_ota_delta_base;
+static volatile int8_t matter_ota_delta_base_result = 1;   // 0 while the check runs, -1 once it failed
+// set while a compressed payload is decompressed, see matter_ota_lz.c
+static matter_ota_lz_t *matter_ota_lz = NULL;
 
 uint8_t matter_ota_get_total_header_size()
 {
@@ -36,134 +124,705 @@ uint8_t matter_ota_get_total_header_size()
 
 uint8_t matter_ota_get_current_header_size()
 {
-    return matter_ota_header_size;
+    // the leading bytes of a delta or compressed payload were taken as header, the image header is restored later
+    return (matter_ota_delta != NULL || matter_ota_lz != NULL) ? MATTER_OTA_HEADER_SIZE : matter_ota_header_size;
+}
+
+static void matter_ota_free_decoders()
+{
+    if (matter_ota_lz != NULL)
+        vPortFree(matter_ota_lz);
+    if (matter_ota_delta != NULL)
+        vPortFree(matter_ota_delta);
+    matter_ota_lz = NULL;
+    matter_ota_delta = NULL;
+}
+
+static void matter_ota_save_checkpoint(uint32_t offset)
+{
+    matter_ota_checkpoint_t *checkpoint = &matter_ota_checkpoint;
+
+    checkpoint->magic = MATTER_OTA_CHECKPOINT_MAGIC;
+    checkpoint->firmware_addr = matter_ota_new_firmware_addr;
+    checkpoint->offset = offset;
+    checkpoint->expected_size = matter_ota_expected_size;
+    checkpoint->expected_digest_len = matter_ota_expected_digest_len;
+    memcpy(checkpoint->expected_digest, matter_ota_expected_digest, MATTER_OTA_DIGEST_SIZE);
+    memcpy(checkpoint->header, matter_ota_header, MATTER_OTA_HEADER_SIZE);
+    memcpy(&checkpoint->sha256, &matter_ota_sha256, sizeof(matter_ota_sha256));
+
+    // on failure the previous checkpoint stays, it points at sectors that are still on flash
+    if (setPref_new(MATTER_OTA_CHECKPOINT_KEY, MATTER_OTA_CHECKPOINT_KEY, (uint8_t *) checkpoint, sizeof(matter_ota_checkpoint_t)) != DCT_SUCCESS)
+        printf("[%s] Failed to store OTA checkpoint\r\n", __FUNCTION__);
+}
+
+static void matter_ota_clear_checkpoint()
+{
+    matter_ota_checkpointing = false;
+    deleteKey(MATTER_OTA_CHECKPOINT_KEY, MATTER_OTA_CHECKPOINT_KEY);
+}
+
+static void matter_ota_writer_task(void *pvParameters)
+{
+    matter_ota_buffer_t *buffer;
+    uint32_t start, erased;
+
+    for (;;)
+    {
+        // a window of the running image is checked whenever no sector is waiting
+        if (xQueueReceive(matter_ota_write_queue, &buffer, (matter_ota_delta_base_result == 0) ? 0 : portMAX_DELAY) != pdTRUE)
+        {
+            if (matter_ota_delta_base_result == 0)
+                matter_ota_delta_base_result = matter_ota_delta_base_step(&matter_ota_delta_base);
+            continue;
+        }
+        if (buffer == NULL)
+            continue; // wakeup for the check
+
+        device_mutex_lock(RT_DEV_LOCK_FLASH);
+        start = xTaskGetTickCount();
+        flash_erase_sector(&matter_ota_flash, buffer->sector);
+        erased = xTaskGetTickCount();
+        if (flash_burst_write(&matter_ota_flash, buffer->sector + buffer->offset, buffer->size, buffer->data + buffer->offset) < 0)
+            matter_ota_write_failed = true;
+        device_mutex_unlock(RT_DEV_LOCK_FLASH);
+
+        // the header is hashed ahead of the first sector, it is programmed last by matter_ota_update_signature
+        if (!matter_ota_header_hashed)
+        {
+            mbedtls_sha256_update_ret(&matter_ota_sha256, matter_ota_header, matter_ota_header_size);
+            matter_ota_header_hashed = true;
+        }
+        mbedtls_sha256_update_ret(&matter_ota_sha256, buffer->data + buffer->offset, buffer->size);
+
+        // only the last sector is partial, a download cannot resume inside it
+        if (matter_ota_checkpointing && !matter_ota_write_failed && buffer->offset + buffer->size == MATTER_OTA_SECTOR_SIZE)
+            matter_ota_save_checkpoint(buffer->sector + MATTER_OTA_SECTOR_SIZE - matter_ota_new_firmware_addr);
+
+        matter_ota_stats.erase_ms += (erased - start) * portTICK_PERIOD_MS;
+        matter_ota_stats.program_ms += (xTaskGetTickCount() - erased) * portTICK_PERIOD_MS;
+        matter_ota_stats.sectors++;
+
+        xQueueSend(matter_ota_free_queue, &buffer, portMAX_DELAY);
+    }
+}
+
+// wait for queued sectors to reach flash and take every buffer back, the partial one is dropped
+static void matter_ota_writer_release()
+{
+    matter_ota_buffer_t *buffer;
+
+    if (matter_ota_buffers == NULL)
+        return;
+
+    if (matter_ota_fill != NULL)
+        xQueueSend(matter_ota_free_queue, &matter_ota_fill, portMAX_DELAY);
+    matter_ota_fill = NULL;
+
+    for (size_t i=0; i<MATTER_OTA_BUFFER_NUM; i++)
+        xQueueReceive(matter_ota_free_queue, &buffer, portMAX_DELAY);
+
+    vPortFree(matter_ota_buffers);
+    matter_ota_buffers = NULL;
+}
+
+static bool matter_ota_writer_init()
+{
+    matter_ota_writer_release();
+
+    if (matter_ota_free_queue == NULL)
+        matter_ota_free_queue = xQueueCreate(MATTER_OTA_BUFFER_NUM, sizeof(matter_ota_buffer_t *));
+    if (matter_ota_write_queue == NULL)
+        matter_ota_write_queue = xQueueCreate(MATTER_OTA_BUFFER_NUM, sizeof(matter_ota_buffer_t *));
+    if (matter_ota_free_queue == NULL || matter_ota_write_queue == NULL)
+    {
+        printf("[%s] Failed to create OTA writer queues\r\n", __FUNCTION__);
+        return false;
+    }
+
+    if (matter_ota_writer_handle == NULL)
+    {
+        if (xTaskCreate(matter_ota_writer_task, "matter_ota_writer", 1024, NULL, tskIDLE_PRIORITY + 1, &matter_ota_writer_handle) != pdPASS)
+        {
+            printf("[%s] Failed to create matter_ota_writer_task\r\n", __FUNCTION__);
+            matter_ota_writer_handle = NULL;
+            return false;
+        }
+    }
+
+    matter_ota_buffers = (matter_ota_buffer_t *) pvPortMalloc(MATTER_OTA_BUFFER_NUM * sizeof(matter_ota_buffer_t));
+    if (matter_ota_buffers == NULL)
+    {
+        printf("[%s] Failed to allocate OTA sector buffers\r\n", __FUNCTION__);
+        return false;
+    }
+
+    for (size_t i=0; i<MATTER_OTA_BUFFER_NUM; i++)
+    {
+        matter_ota_buffer_t *buffer = &matter_ota_buffers[i];
+        xQueueSend(matter_ota_free_queue, &buffer, 0);
+    }
+    return true;
+}
+
+static matter_ota_buffer_t *matter_ota_next_buffer()
+{
+    matter_ota_buffer_t *buffer;
+    uint32_t start;
+
+    if (xQueueReceive(matter_ota_free_queue, &buffer, 0) != pdTRUE)
+    {
+        // every buffer is still waiting for flash
+        start = xTaskGetTickCount();
+        xQueueReceive(matter_ota_free_queue, &buffer, portMAX_DELAY);
+        matter_ota_stats.stall_ms += (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+        matter_ota_stats.stalls++;
+    }
+
+    buffer->sector = matter_ota_flash_sector_base;
+    buffer->offset = matter_ota_first_sector_written ? 0 : matter_ota_header_size; // leave first 32-bytes for header
+    buffer->size = 0;
+    return buffer;
+}
+
+static void matter_ota_submit_buffer()
+{
+    xQueueSend(matter_ota_write_queue, &matter_ota_fill, portMAX_DELAY);
+    matter_ota_fill = NULL;
+    matter_ota_first_sector_written = true;
+    matter_ota_flash_sector_base += MATTER_OTA_SECTOR_SIZE; // point to next sector
 }
 
 void matter_ota_prepare_partition()
 {
-    // reset header and data buffer
-    memset(matter_ota_buffer, 0, sizeof(matter_ota_buffer));
+    matter_ota_free_decoders();
+    if (matter_ota_payload_hashing)
+        mbedtls_sha256_free(&matter_ota_payload_sha256);
+
+    // reset header and data buffers
     memset(matter_ota_header, 0, sizeof(matter_ota_header));
+    memset(&matter_ota_stats, 0, sizeof(matter_ota_stats));
     matter_ota_header_size = 0;
-    matter_ota_buffer_size = 0;
+    matter_ota_first_sector_written = false;
+    matter_ota_header_hashed = false;
+    matter_ota_expected_digest_len = 0;
+    matter_ota_expected_size = 0;
+    matter_ota_image_rejected = false;
+    matter_ota_payload_hashing = false;
+    matter_ota_rebuilt_digest_set = false;
+    matter_ota_delta_base_result = 1;
+    matter_ota_checkpointing = false;
+    matter_ota_resume_offset = 0;
+    matter_ota_received = 0;
+    mbedtls_sha256_init(&matter_ota_sha256);
+    mbedtls_sha256_starts_ret(&matter_ota_sha256, 0);
+    matter_ota_write_failed = !matter_ota_writer_init();
+    matter_ota_start_tick = xTaskGetTickCount();
     matter_ota_new_firmware_addr = sys_update_ota_prepare_addr();
     matter_ota_flash_sector_base = matter_ota_new_firmware_addr; // Note that the new fw address must be multiples of 4KB
 }
 
-int8_t matter_ota_store_header(uint8_t *data, uint32_t size)
+/*
+   Continue from the checkpoint of an interrupted download of the same image. Sectors are only
+   erased right before they are programmed and the header is programmed last, so whatever the
+   interrupted download committed is still on flash. Without a matching checkpoint this download
+   is checkpointed itself, its first sector replaces any other checkpoint.
+*/
+static void matter_ota_resume()
 {
-    // check if overflow
-    if (size + matter_ota_header_size > MATTER_OTA_HEADER_SIZE)
+    matter_ota_checkpoint_t *checkpoint;
+    size_t len = 0;
+
+    // nothing of this download may have reached the writer yet
+    if (matter_ota_buffers == NULL || matter_ota_header_size > 0 || matter_ota_stats.bytes > 0)
+        return;
+
+    matter_ota_checkpointing = true;
+
+    checkpoint = (matter_ota_checkpoint_t *) pvPortMalloc(sizeof(matter_ota_checkpoint_t));
+    if (checkpoint == NULL)
+        return;
+
+    if (getPref_bin_new(MATTER_OTA_CHECKPOINT_KEY, MATTER_OTA_CHECKPOINT_KEY, (uint8_t *) checkpoint, sizeof(matter_ota_checkpoint_t), &len) == DCT_SUCCESS &&
+        len == sizeof(matter_ota_checkpoint_t) && checkpoint->magic == MATTER_OTA_CHECKPOINT_MAGIC &&
+        checkpoint->firmware_addr == matter_ota_new_firmware_addr && checkpoint->expected_size == matter_ota_expected_size &&
+        checkpoint->expected_digest_len == matter_ota_expected_digest_len &&
+        memcmp(checkpoint->expected_digest, matter_ota_expected_digest, matter_ota_expected_digest_len) == 0 &&
+        checkpoint->offset > 0 && checkpoint->offset % MATTER_OTA_SECTOR_SIZE == 0 &&
+        (matter_ota_expected_size == 0 || checkpoint->offset < matter_ota_expected_size))
+    {
+        memcpy(matter_ota_header, checkpoint->header, MATTER_OTA_HEADER_SIZE);
+        matter_ota_header_size = MATTER_OTA_HEADER_SIZE;
+        matter_ota_header_hashed = true;
+        matter_ota_first_sector_written = true;
+        memcpy(&matter_ota_sha256, &checkpoint->sha256, sizeof(matter_ota_sha256));
+        matter_ota_flash_sector_base = matter_ota_new_firmware_addr + checkpoint->offset;
+        matter_ota_stats.bytes = checkpoint->offset - MATTER_OTA_HEADER_SIZE;
+        matter_ota_stats.resumed_bytes = matter_ota_stats.bytes;
+        matter_ota_resume_offset = checkpoint->offset;
+        printf("Resuming OTA at offset %d\r\n", checkpoint->offset);
+    }
+
+    vPortFree(checkpoint);
+}
+
+uint32_t matter_ota_resume_skip()
+{
+    uint32_t skip = 0;
+
+    if (matter_ota_received < matter_ota_resume_offset && !matter_ota_image_rejected)
+    {
+        skip = matter_ota_resume_offset - matter_ota_received;
+        matter_ota_received = matter_ota_resume_offset;
+    }
+    return skip;
+}
+
+int8_t matter_ota_set_image_info(uint32_t payloadSize, uint8_t digestType, const uint8_t *digest, size_t digestLen)
+{
+    if (payloadSize > MATTER_OTA_FIRMWARE_LENGTH || (payloadSize > 0 && payloadSize <= MATTER_OTA_HEADER_SIZE))
+    {
+        printf("[%s] Payload size %d does not fit the OTA partition\r\n", __FUNCTION__, payloadSize);
+        matter_ota_image_rejected = true;
         return -1;
+    }
 
+    matter_ota_expected_size = payloadSize;
+
+    if (digestType >= MATTER_OTA_DIGEST_SHA256 && digestType <= MATTER_OTA_DIGEST_SHA256_32 &&
+        digestLen > 0 && digestLen <= MATTER_OTA_DIGEST_SIZE)
+    {
+        memcpy(matter_ota_expected_digest, digest, digestLen);
+        matter_ota_expected_digest_len = digestLen;
+    }
+    else
+    {
+        // the image could not be verified, so it is never taken
+        printf("[%s] Digest type %d is not verified on device\r\n", __FUNCTION__, digestType);
+        matter_ota_image_rejected = true;
+        return -1;
+    }
+
+    matter_ota_resume();
+    return 1;
+}
+
+// runs before anything is erased, a header that can never become a valid signature fails the first block
+static bool matter_ota_check_header()
+{
+    bool erased = true, zero = true;
+
+    for (size_t i=0; i<MATTER_OTA_HEADER_SIZE; i++)
+    {
+        erased &= (matter_ota_header[i] == 0xFF);
+        zero &= (matter_ota_header[i] == 0x00);
+    }
+
+    if (erased || zero)
+    {
+        printf("[%s] OTA image has no firmware signature\r\n", __FUNCTION__);
+        return false;
+    }
+    return true;
+}
+
+// image header bytes, the rebuilt ones of a delta payload included
+static int8_t matter_ota_write_header(const uint8_t *data, uint32_t size)
+{
     memcpy(&(matter_ota_header[matter_ota_header_size]), data, size);
     matter_ota_header_size += size;
 
+    if (matter_ota_header_size == MATTER_OTA_HEADER_SIZE && !matter_ota_check_header())
+    {
+        matter_ota_image_rejected = true;
+        return -1;
+    }
+
     return 1;
 }
 
-int8_t matter_ota_flash_burst_write(uint8_t *data, uint32_t size)
+static int8_t matter_ota_write_data(const uint8_t *data, uint32_t size)
 {
-    if (size == 0)
+    if (matter_ota_expected_size > 0 && matter_ota_header_size + matter_ota_stats.bytes + size > matter_ota_expected_size)
     {
-        return 1; // don't waste time, just return success
+        printf("[%s] OTA image is larger than its header announced\r\n", __FUNCTION__);
+        matter_ota_image_rejected = true;
+        return -1;
     }
 
-    bool overflow = false;
-    uint32_t sectorBase = matter_ota_flash_sector_base;
-    uint32_t writeLength = MATTER_OTA_SECTOR_SIZE;
-    int16_t bufferRemainSize = (int16_t) (MATTER_OTA_SECTOR_SIZE - matter_ota_buffer_size);
+    matter_ota_stats.bytes += size;
 
-    if (!matter_ota_first_sector_written)
+    // a block may span any number of sectors
+    while (size > 0)
     {
-        sectorBase += matter_ota_header_size; // leave first 32-bytes for header
-        writeLength -= matter_ota_header_size;
-        bufferRemainSize -= matter_ota_header_size;
+        if (matter_ota_fill == NULL)
+            matter_ota_fill = matter_ota_next_buffer();
+
+        uint32_t used = matter_ota_fill->offset + matter_ota_fill->size;
+        uint32_t copy = MATTER_OTA_SECTOR_SIZE - used;
+
+        if (copy > size)
+            copy = size;
+
+        memcpy(matter_ota_fill->data + used, data, copy);
+        matter_ota_fill->size += copy;
+        data += copy;
+        size -= copy;
+
+        if (used + copy == MATTER_OTA_SECTOR_SIZE)
+            matter_ota_submit_buffer(); // buffer is full, hand it to the flash task
     }
 
-    if (bufferRemainSize >= size)
+    return 1;
+}
+
+// sink of the delta decoder
+static int8_t matter_ota_write_image(const uint8_t *data, uint32_t size)
+{
+    if (matter_ota_header_size < MATTER_OTA_HEADER_SIZE)
     {
-        memcpy(matter_ota_buffer + matter_ota_buffer_size, data, size);
-        matter_ota_buffer_size += size;
+        uint32_t len = MATTER_OTA_HEADER_SIZE - matter_ota_header_size;
+
+        if (len > size)
+            len = size;
+        if (matter_ota_write_header(data, len) < 0)
+            return -1;
+        data += len;
+        size -= len;
     }
-    else
+
+    return (size > 0) ? matter_ota_write_data(data, size) : 1;
+}
+
+static int8_t matter_ota_delta_header(const matter_ota_delta_header_t *header)
+{
+    if (header->new_size <= MATTER_OTA_HEADER_SIZE || header->new_size > MATTER_OTA_FIRMWARE_LENGTH)
     {
-        memcpy(matter_ota_buffer + matter_ota_buffer_size, data, bufferRemainSize);
-        matter_ota_buffer_size += bufferRemainSize;
-        overflow = true;
-        size -= bufferRemainSize;
+        printf("[%s] Rebuilt image size %d does not fit the OTA partition\r\n", __FUNCTION__, header->new_size);
+        return -1;
     }
 
-    if (matter_ota_buffer_size == writeLength)
+    // from here on the size check applies to the rebuilt image, the payload keeps its own digest
+    matter_ota_expected_size = header->new_size;
+    memcpy(matter_ota_rebuilt_digest, header->new_digest, MATTER_OTA_DIGEST_SIZE);
+    matter_ota_rebuilt_digest_set = true;
+
+    // the patch only applies to the image it was created against, the flash task checks it while the payload streams in
+    matter_ota_delta_base_init(&matter_ota_delta_base, sys_update_ota_get_curr_fw_addr(), header);
+    matter_ota_delta_base_result = 0;
+    if (matter_ota_write_queue != NULL)
     {
-        // buffer is full, time to erase sector and write buffer data to flash
-        device_mutex_lock(RT_DEV_LOCK_FLASH);
-        flash_erase_sector(&matter_ota_flash, matter_ota_flash_sector_base);
-        flash_burst_write(&matter_ota_flash, sectorBase, writeLength, matter_ota_buffer);
-        device_mutex_unlock(RT_DEV_LOCK_FLASH);
+        matter_ota_buffer_t *wakeup = NULL;
+        xQueueSend(matter_ota_write_queue, &wakeup, 0);
+    }
+    return 1;
+}
 
-        if (!matter_ota_first_sector_written)
-        {
-            matter_ota_first_sector_written = true;
-        }
+static bool matter_ota_delta_base_failed()
+{
+    if (matter_ota_delta_base_result >= 0)
+        return false;
+
+    printf("[%s] Delta payload was not created against the running image\r\n", __FUNCTION__);
+    matter_ota_image_rejected = true;
+    return true;
+}
+
+// the leading bytes were the payload header of a decoder, hand them to it
+static void matter_ota_take_payload_header(uint8_t *payload)
+{
+    memcpy(payload, matter_ota_header, MATTER_OTA_HEADER_SIZE);
+    memset(matter_ota_header, 0, sizeof(matter_ota_header));
+    matter_ota_header_size = 0;
+
+    // the image header digest covers the payload as downloaded, a delta inside a compressed payload is hashed already
+    if (!matter_ota_payload_hashing)
+    {
+        mbedtls_sha256_init(&matter_ota_payload_sha256);
+        mbedtls_sha256_starts_ret(&matter_ota_payload_sha256, 0);
+        mbedtls_sha256_update_ret(&matter_ota_payload_sha256, payload, MATTER_OTA_HEADER_SIZE);
+        matter_ota_payload_hashing = true;
+    }
+}
+
+static int8_t matter_ota_start_delta()
+{
+    uint8_t payload[MATTER_OTA_HEADER_SIZE];
+
+    matter_ota_delta = (matter_ota_delta_t *) pvPortMalloc(sizeof(matter_ota_delta_t));
+    if (matter_ota_delta == NULL)
+    {
+        printf("[%s] Failed to allocate the delta decoder\r\n", __FUNCTION__);
+        return -1;
+    }
+
+    printf("Rebuilding OTA image from a delta payload\r\n");
+    if (matter_ota_lz == NULL)
+        matter_ota_clear_checkpoint(); // its sectors overwrite the ones a checkpoint points at
+
+    matter_ota_take_payload_header(payload);
+    matter_ota_delta_init(matter_ota_delta, sys_update_ota_get_curr_fw_addr(), matter_ota_write_image, matter_ota_delta_header);
+    if (matter_ota_lz == NULL)
+        matter_ota_stats.payload_bytes = MATTER_OTA_HEADER_SIZE;
+    return matter_ota_delta_feed(matter_ota_delta, payload, MATTER_OTA_HEADER_SIZE);
+}
+
+// the first payload bytes are complete, they either start a delta payload or are the image header
+static int8_t matter_ota_header_done()
+{
+    if (matter_ota_delta_detect(matter_ota_header, MATTER_OTA_HEADER_SIZE))
+        return matter_ota_start_delta();
+
+    if (!matter_ota_check_header())
+    {
+        matter_ota_image_rejected = true;
+        return -1;
+    }
+    return 1;
+}
+
+// payload as downloaded or as decompressed: a delta payload or the image itself
+static int8_t matter_ota_write_payload(const uint8_t *data, uint32_t size)
+{
+    if (matter_ota_delta == NULL && matter_ota_header_size < MATTER_OTA_HEADER_SIZE)
+    {
+        uint32_t len = MATTER_OTA_HEADER_SIZE - matter_ota_header_size;
+
+        if (len > size)
+            len = size;
+        memcpy(&(matter_ota_header[matter_ota_header_size]), data, len);
+        matter_ota_header_size += len;
+        data += len;
+        size -= len;
+
+        if (matter_ota_header_size == MATTER_OTA_HEADER_SIZE && matter_ota_header_done() < 0)
+            return -1;
+    }
+
+    if (size == 0)
+        return 1;
+    if (matter_ota_delta != NULL)
+        return matter_ota_delta_feed(matter_ota_delta, data, size);
+    return matter_ota_write_data(data, size);
+}
+
+static int8_t matter_ota_lz_header(const matter_ota_lz_header_t *header)
+{
+    if (header->size <= MATTER_OTA_HEADER_SIZE || header->size > MATTER_OTA_FIRMWARE_LENGTH)
+    {
+        printf("[%s] Uncompressed size %d does not fit the OTA partition\r\n", __FUNCTION__, header->size);
+        return -1;
+    }
+
+    // checks apply to the uncompressed content, a delta payload inside replaces them with its rebuilt image
+    matter_ota_expected_size = header->size;
+    memcpy(matter_ota_rebuilt_digest, header->digest, MATTER_OTA_DIGEST_SIZE);
+    matter_ota_rebuilt_digest_set = true;
+    return 1;
+}
+
+static int8_t matter_ota_start_lz()
+{
+    uint8_t payload[MATTER_OTA_HEADER_SIZE];
+
+    matter_ota_lz = (matter_ota_lz_t *) pvPortMalloc(sizeof(matter_ota_lz_t));
+    if (matter_ota_lz == NULL)
+    {
+        printf("[%s] Failed to allocate the decompressor\r\n", __FUNCTION__);
+        return -1;
+    }
+
+    printf("Decompressing OTA payload\r\n");
+    matter_ota_clear_checkpoint(); // its sectors overwrite the ones a checkpoint points at
 
-        matter_ota_flash_sector_base += MATTER_OTA_SECTOR_SIZE; // point to next sector
-        memset(matter_ota_buffer, 0, sizeof(matter_ota_buffer)); // clear buffer after writing
-        matter_ota_buffer_size = 0;
+    matter_ota_take_payload_header(payload);
+    matter_ota_lz_init(matter_ota_lz, matter_ota_write_payload, matter_ota_lz_header);
+    matter_ota_stats.payload_bytes = MATTER_OTA_HEADER_SIZE;
+    return matter_ota_lz_feed(matter_ota_lz, payload, MATTER_OTA_HEADER_SIZE);
+}
+
+int8_t matter_ota_store_header(uint8_t *data, uint32_t size)
+{
+    // check if overflow
+    if (matter_ota_delta != NULL || matter_ota_lz != NULL || size + matter_ota_header_size > MATTER_OTA_HEADER_SIZE)
+        return -1;
+
+    matter_ota_received += size;
+    memcpy(&(matter_ota_header[matter_ota_header_size]), data, size);
+    matter_ota_header_size += size;
+
+    if (matter_ota_header_size < MATTER_OTA_HEADER_SIZE)
+        return 1;
+
+    if (matter_ota_lz_detect(matter_ota_header, MATTER_OTA_HEADER_SIZE))
+        return matter_ota_start_lz();
+    return matter_ota_header_done();
+}
+
+int8_t matter_ota_flash_burst_write(uint8_t *data, uint32_t size)
+{
+    int8_t ret;
+
+    if (matter_ota_buffers == NULL || matter_ota_write_failed || matter_ota_image_rejected || matter_ota_delta_base_failed())
+        return -1;
+
+    // a resumed download drops what is on flash already, when the transfer could not skip it
+    if (matter_ota_received < matter_ota_resume_offset)
+    {
+        uint32_t drop = matter_ota_resume_offset - matter_ota_received;
+
+        if (drop > size)
+            drop = size;
+        matter_ota_received += drop;
+        data += drop;
+        size -= drop;
+        if (size == 0)
+            return 1;
     }
+    matter_ota_received += size;
+
+    if (matter_ota_payload_hashing)
+        mbedtls_sha256_update_ret(&matter_ota_payload_sha256, data, size);
 
-    if (overflow) // write remaining data into the newly cleared buffer
+    if (matter_ota_lz != NULL)
     {
-        // TODO: what if it overflows twice?
-        memcpy(matter_ota_buffer + matter_ota_buffer_size, data + bufferRemainSize, size);
-        matter_ota_buffer_size += size;
+        matter_ota_stats.payload_bytes += size;
+        ret = matter_ota_lz_feed(matter_ota_lz, data, size);
+    }
+    else
+    {
+        if (matter_ota_delta != NULL)
+            matter_ota_stats.payload_bytes += size;
+        ret = matter_ota_write_payload(data, size);
     }
 
+    if (ret < 0)
+    {
+        matter_ota_image_rejected = true;
+        return -1;
+    }
     return 1;
 }
 
 int8_t matter_ota_flush_last()
 {
-    if (matter_ota_buffer_size > 0)
+    uint8_t payload_digest[MATTER_OTA_DIGEST_SIZE];
+
+    if (matter_ota_buffers == NULL)
+        return -1;
+
+    // the decoders flush their last bytes and check the payload ended where its header said
+    if (matter_ota_lz != NULL && matter_ota_lz_finish(matter_ota_lz) < 0)
+        matter_ota_image_rejected = true;
+    if (matter_ota_delta != NULL && matter_ota_delta_finish(matter_ota_delta) < 0)
+        matter_ota_image_rejected = true;
+    matter_ota_free_decoders();
+
+    if (matter_ota_fill != NULL && matter_ota_fill->size > 0)
+        matter_ota_submit_buffer();
+    matter_ota_writer_release();
+
+    // whatever is left of the check of the running image, usually nothing by now
+    while (matter_ota_delta_base_result == 0 && matter_ota_writer_handle != NULL)
+        vTaskDelay(1);
+    if (!matter_ota_image_rejected)
+        matter_ota_delta_base_failed();
+
+    matter_ota_stats.elapsed_ms = (xTaskGetTickCount() - matter_ota_start_tick) * portTICK_PERIOD_MS;
+    printf("OTA image written: %d bytes, %d sectors in %d ms (%d B/s), erase %d ms, program %d ms, stalled %d ms (%d times)\r\n",
+           matter_ota_stats.bytes, matter_ota_stats.sectors, matter_ota_stats.elapsed_ms,
+           matter_ota_stats.elapsed_ms ? (uint32_t) ((uint64_t) (matter_ota_stats.bytes - matter_ota_stats.resumed_bytes) * 1000 / matter_ota_stats.elapsed_ms) : 0,
+           matter_ota_stats.erase_ms, matter_ota_stats.program_ms, matter_ota_stats.stall_ms, matter_ota_stats.stalls);
+    if (matter_ota_stats.payload_bytes > 0)
+        printf("OTA image restored from a %d byte payload\r\n", matter_ota_stats.payload_bytes);
+    if (matter_ota_stats.resumed_bytes > 0)
+        printf("OTA download resumed, %d bytes were on flash already\r\n", matter_ota_stats.resumed_bytes);
+
+    if (!matter_ota_header_hashed)
+        mbedtls_sha256_update_ret(&matter_ota_sha256, matter_ota_header, matter_ota_header_size);
+    mbedtls_sha256_finish_ret(&matter_ota_sha256, matter_ota_digest);
+    mbedtls_sha256_free(&matter_ota_sha256);
+
+    // a plain image is its own payload
+    memcpy(payload_digest, matter_ota_digest, MATTER_OTA_DIGEST_SIZE);
+    if (matter_ota_payload_hashing)
     {
-        device_mutex_lock(RT_DEV_LOCK_FLASH);
-        flash_erase_sector(&matter_ota_flash, matter_ota_flash_sector_base);
-        flash_burst_write(&matter_ota_flash, matter_ota_flash_sector_base, matter_ota_buffer_size, matter_ota_buffer);
-        device_mutex_unlock(RT_DEV_LOCK_FLASH);
+        mbedtls_sha256_finish_ret(&matter_ota_payload_sha256, payload_digest);
+        mbedtls_sha256_free(&matter_ota_payload_sha256);
+        matter_ota_payload_hashing = false;
+    }
 
-        matter_ota_flash_sector_base += MATTER_OTA_SECTOR_SIZE; // point to next sector
-        memset(matter_ota_buffer, 0, sizeof(matter_ota_buffer)); // clear buffer after writing
-        matter_ota_buffer_size = 0;
+    if (matter_ota_expected_size > 0 && matter_ota_header_size + matter_ota_stats.bytes != matter_ota_expected_size)
+    {
+        printf("[%s] OTA image is truncated\r\n", __FUNCTION__);
+        matter_ota_image_rejected = true;
+    }
+    if (matter_ota_expected_digest_len == 0)
+    {
+        printf("[%s] OTA image header digest was not forwarded, the image cannot be verified\r\n", __FUNCTION__);
+        matter_ota_image_rejected = true;
+    }
+    else if (memcmp(payload_digest, matter_ota_expected_digest, matter_ota_expected_digest_len) != 0)
+    {
+        printf("[%s] OTA payload digest mismatch\r\n", __FUNCTION__);
+        matter_ota_image_rejected = true;
+    }
+    // the decoder header came with the payload, it is trusted once the payload digest matched
+    if (matter_ota_rebuilt_digest_set && memcmp(matter_ota_digest, matter_ota_rebuilt_digest, MATTER_OTA_DIGEST_SIZE) != 0)
+    {
+        printf("[%s] Rebuilt OTA image digest mismatch\r\n", __FUNCTION__);
+        matter_ota_image_rejected = true;
     }
 
+    // a failed image is downloaded from the start next time
+    if (matter_ota_write_failed || matter_ota_image_rejected)
+    {
+        matter_ota_clear_checkpoint();
+        return -1;
+    }
     return 1;
 }
 
+void matter_ota_get_digest(uint8_t *digest)
+{
+    memcpy(digest, matter_ota_digest, MATTER_OTA_DIGEST_SIZE);
+}
+
+void matter_ota_get_stats(matter_ota_stats_t *stats)
+{
+    *stats = matter_ota_stats;
+}
+
 int8_t matter_ota_update_signature()
 {
-    return (update_ota_signature(matter_ota_header, matter_ota_new_firmware_addr) == 0);
+    // never mark an image bootable once it failed verification
+    if (matter_ota_write_failed || matter_ota_image_rejected)
+        return 0;
+
+    if (update_ota_signature(matter_ota_header, matter_ota_new_firmware_addr) != 0)
+        return 0;
+
+    matter_ota_clear_checkpoint();
+    return 1;
 }
 
 void matter_ota_platform_reset()
 {
-    ota_platform_reset();
+    ota_platform_reset(); // sys_reset_prepare() commits pending write-behind attribute values first
 }
 
 static void matter_ota_abort_task(void *pvParameters)
 {
-    uint32_t newFWBlkSize = (MATTER_OTA_FIRMWARE_LENGTH - 1) / MATTER_OTA_SECTOR_SIZE + 1;
     printf("Cleaning up aborted OTA\r\n");
-    printf("Erasing %d sectors\r\n", newFWBlkSize);
 
-    if (matter_ota_new_firmware_addr != 0)
-    {
-        device_mutex_lock(RT_DEV_LOCK_FLASH);
-        for (size_t i=0; i<newFWBlkSize; i++)
-        {
-            flash_erase_sector(&matter_ota_flash, matter_ota_new_firmware_addr + (i * MATTER_OTA_SECTOR_SIZE));
-        }
-        device_mutex_unlock(RT_DEV_LOCK_FLASH);
-    }
+    matter_ota_writer_release(); // let queued sectors finish before the buffers go
+
+    matter_ota_free_decoders();
+
+    // nothing is erased here, the header is written last so a partial image never boots; the
+    // committed sectors and their checkpoint stay for a resume unless the image was bad
+    if (matter_ota_write_failed || matter_ota_image_rejected)
+        matter_ota_clear_checkpoint();
 
     vTaskDelete(NULL);
 }
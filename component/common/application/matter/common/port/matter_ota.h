@@ -2,12 +2,32 @@
 extern "C" {
 #endif
 
+typedef struct
+{
+    uint32_t bytes;         // image bytes after the header
+    uint32_t sectors;       // sectors erased and programmed by the flash task
+    uint32_t elapsed_ms;    // from matter_ota_prepare_partition to matter_ota_flush_last
+    uint32_t erase_ms;      // flash task time spent erasing
+    uint32_t program_ms;    // flash task time spent programming
+    uint32_t stall_ms;      // time BDX reception waited for a free sector buffer
+    uint32_t stalls;
+    uint32_t payload_bytes; // compressed or delta payload bytes received, 0 for a plain image
+    uint32_t resumed_bytes; // image bytes on flash already when an interrupted download resumed
+} matter_ota_stats_t;
+
 uint8_t matter_ota_get_total_header_size();
 uint8_t matter_ota_get_current_header_size();
 void matter_ota_prepare_partition();
+// required, called after matter_ota_prepare_partition with the payload size and digest from the Matter image header;
+// without a SHA-256 digest matter_ota_flush_last fails the download
+int8_t matter_ota_set_image_info(uint32_t payloadSize, uint8_t digestType, const uint8_t *digest, size_t digestLen);
+// payload bytes a resumed download has on flash already, the downloader skips them in the transfer; 0 once skipped
+uint32_t matter_ota_resume_skip();
 int8_t matter_ota_store_header(uint8_t *data, uint32_t size);
 int8_t matter_ota_flash_burst_write(uint8_t *data, uint32_t size);
 int8_t matter_ota_flush_last();
+void matter_ota_get_stats(matter_ota_stats_t *stats);
+void matter_ota_get_digest(uint8_t *digest);
 int8_t matter_ota_update_signature();
 void matter_ota_platform_reset();
 void matter_ota_create_abort_task();
@@ -0,0 +1,362 @@
+/**************************
+* Matter OTA Delta Related
+**************************/
+#include "platform_opts.h"
+#include "platform/platform_stdlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdbool.h"
+#include "flash_api.h"
+#include "device_lock.h"
+#include "matter_ota_delta.h"
+
+/*
+   Streaming decoder for delta payloads. The payload is a list of ops rebuilding the new image
+   from the running one: DIFF copies old bytes adding a diff (zero runs are not transmitted),
+   INSERT carries new bytes. Blocks may end anywhere, the decoder keeps its position in an op
+   across calls. RAM use is the context only: one window of the old image and one output chunk.
+   The CRC of the whole running image takes too long for the Matter thread, the caller checks
+   it a window at a time with matter_ota_delta_base_step while the payload streams in.
+*/
+#define DELTA_OP_END            0x00
+#define DELTA_OP_DIFF           0x01
+#define DELTA_OP_INSERT         0x02
+
+enum
+{
+    DELTA_STATE_HEADER = 0,
+    DELTA_STATE_OP,
+    DELTA_STATE_DIFF_LEN,
+    DELTA_STATE_DIFF_SEEK,
+    DELTA_STATE_DIFF_ZEROS,
+    DELTA_STATE_DIFF_LITERALS,
+    DELTA_STATE_DIFF_DATA,
+    DELTA_STATE_INSERT_LEN,
+    DELTA_STATE_INSERT_DATA,
+    DELTA_STATE_END,
+    DELTA_STATE_ERROR,
+};
+
+static flash_t matter_ota_delta_flash;
+
+static uint32_t matter_ota_delta_crc32(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+    static const uint32_t table[16] =
+    {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+
+    crc = ~crc;
+    while (len--)
+    {
+        crc = table[(crc ^ *data) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (*data >> 4)) & 0x0F] ^ (crc >> 4);
+        data++;
+    }
+    return ~crc;
+}
+
+static uint32_t matter_ota_delta_get_u32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+// make old_pos readable from the window, returns how many old bytes are available there
+static uint32_t matter_ota_delta_window(matter_ota_delta_t *delta)
+{
+    if (delta->old_pos < delta->window_pos || delta->old_pos >= delta->window_pos + delta->window_len)
+    {
+        uint32_t len = delta->header.old_size - delta->old_pos;
+
+        if (len > MATTER_OTA_DELTA_WINDOW)
+            len = MATTER_OTA_DELTA_WINDOW;
+
+        device_mutex_lock(RT_DEV_LOCK_FLASH);
+        flash_stream_read(&matter_ota_delta_flash, delta->old_addr + delta->old_pos, len, delta->window);
+        device_mutex_unlock(RT_DEV_LOCK_FLASH);
+        delta->window_pos = delta->old_pos;
+        delta->window_len = len;
+    }
+    return delta->window_pos + delta->window_len - delta->old_pos;
+}
+
+static int8_t matter_ota_delta_flush(matter_ota_delta_t *delta)
+{
+    int8_t ret = 1;
+
+    if (delta->out_len > 0)
+        ret = delta->sink(delta->out, delta->out_len);
+    delta->out_len = 0;
+    return ret;
+}
+
+static int8_t matter_ota_delta_emit(matter_ota_delta_t *delta, uint8_t byte)
+{
+    delta->out[delta->out_len++] = byte;
+    delta->new_len++;
+    if (delta->out_len == MATTER_OTA_DELTA_OUT_SIZE)
+        return matter_ota_delta_flush(delta);
+    return 1;
+}
+
+// a zero run of a DIFF is a plain copy of the old image
+static int8_t matter_ota_delta_copy(matter_ota_delta_t *delta, uint32_t len)
+{
+    while (len > 0)
+    {
+        uint32_t avail = matter_ota_delta_window(delta);
+        uint32_t room = MATTER_OTA_DELTA_OUT_SIZE - delta->out_len;
+        uint32_t n = len;
+
+        if (n > avail)
+            n = avail;
+        if (n > room)
+            n = room;
+
+        memcpy(delta->out + delta->out_len, delta->window + (delta->old_pos - delta->window_pos), n);
+        delta->out_len += n;
+        delta->new_len += n;
+        delta->old_pos += n;
+        len -= n;
+
+        if (delta->out_len == MATTER_OTA_DELTA_OUT_SIZE && matter_ota_delta_flush(delta) < 0)
+            return -1;
+    }
+    return 1;
+}
+
+static int8_t matter_ota_delta_check_header(matter_ota_delta_t *delta)
+{
+    uint8_t *raw = delta->raw;
+
+    if (memcmp(raw, MATTER_OTA_DELTA_MAGIC, 4) != 0 || raw[4] != 1)
+    {
+        printf("[%s] Unsupported delta payload\r\n", __FUNCTION__);
+        return -1;
+    }
+
+    delta->header.old_size = matter_ota_delta_get_u32(raw + 8);
+    delta->header.new_size = matter_ota_delta_get_u32(raw + 12);
+    delta->header.old_crc = matter_ota_delta_get_u32(raw + 16);
+    memcpy(delta->header.new_digest, raw + 32, sizeof(delta->header.new_digest));
+
+    return delta->header_cb ? delta->header_cb(&delta->header) : 1;
+}
+
+// LEB128, returns 1 once the value is complete
+static int8_t matter_ota_delta_varint(matter_ota_delta_t *delta, uint8_t byte)
+{
+    if (delta->shift > 28)
+        return -1;
+
+    delta->value |= (uint32_t) (byte & 0x7F) << delta->shift;
+    delta->shift += 7;
+    if (byte & 0x80)
+        return 0;
+
+    delta->shift = 0;
+    return 1;
+}
+
+bool matter_ota_delta_detect(const uint8_t *data, uint32_t size)
+{
+    return size >= 4 && memcmp(data, MATTER_OTA_DELTA_MAGIC, 4) == 0;
+}
+
+void matter_ota_delta_init(matter_ota_delta_t *delta, uint32_t old_addr, matter_ota_delta_sink_t sink, matter_ota_delta_header_cb_t header_cb)
+{
+    memset(delta, 0, sizeof(matter_ota_delta_t));
+    delta->state = DELTA_STATE_HEADER;
+    delta->old_addr = old_addr;
+    delta->sink = sink;
+    delta->header_cb = header_cb;
+}
+
+int8_t matter_ota_delta_feed(matter_ota_delta_t *delta, const uint8_t *data, uint32_t size)
+{
+    int8_t ret;
+
+    while (size > 0 && delta->state != DELTA_STATE_ERROR)
+    {
+        uint8_t byte = *data;
+        uint32_t used = 1;
+
+        switch (delta->state)
+        {
+        case DELTA_STATE_HEADER:
+            used = MATTER_OTA_DELTA_HEADER_SIZE - delta->header_len;
+            if (used > size)
+                used = size;
+            memcpy(delta->raw + delta->header_len, data, used);
+            delta->header_len += used;
+            if (delta->header_len == MATTER_OTA_DELTA_HEADER_SIZE)
+                delta->state = (matter_ota_delta_check_header(delta) < 0) ? DELTA_STATE_ERROR : DELTA_STATE_OP;
+            break;
+
+        case DELTA_STATE_OP:
+            delta->value = 0;
+            if (byte == DELTA_OP_DIFF)
+                delta->state = DELTA_STATE_DIFF_LEN;
+            else if (byte == DELTA_OP_INSERT)
+                delta->state = DELTA_STATE_INSERT_LEN;
+            else if (byte == DELTA_OP_END)
+                delta->state = (matter_ota_delta_flush(delta) < 0) ? DELTA_STATE_ERROR : DELTA_STATE_END;
+            else
+                delta->state = DELTA_STATE_ERROR;
+            break;
+
+        case DELTA_STATE_DIFF_LEN:
+        case DELTA_STATE_INSERT_LEN:
+            ret = matter_ota_delta_varint(delta, byte);
+            if (ret < 0 || (ret > 0 && delta->new_len + delta->value > delta->header.new_size))
+                delta->state = DELTA_STATE_ERROR;
+            else if (ret > 0)
+            {
+                delta->remain = delta->value;
+                delta->value = 0;
+                if (delta->state == DELTA_STATE_DIFF_LEN)
+                    delta->state = DELTA_STATE_DIFF_SEEK;
+                else
+                    delta->state = (delta->remain > 0) ? DELTA_STATE_INSERT_DATA : DELTA_STATE_OP;
+            }
+            break;
+
+        case DELTA_STATE_DIFF_SEEK:
+            ret = matter_ota_delta_varint(delta, byte);
+            if (ret < 0)
+                delta->state = DELTA_STATE_ERROR;
+            else if (ret > 0)
+            {
+                // zigzag, relative to the end of the previous DIFF
+                int32_t seek = (delta->value & 1) ? -(int32_t) ((delta->value >> 1) + 1) : (int32_t) (delta->value >> 1);
+
+                delta->value = 0;
+                if ((seek < 0 && (uint32_t) -seek > delta->old_pos) ||
+                    delta->old_pos + seek + delta->remain > delta->header.old_size)
+                    delta->state = DELTA_STATE_ERROR;
+                else
+                {
+                    delta->old_pos += seek;
+                    delta->state = (delta->remain > 0) ? DELTA_STATE_DIFF_ZEROS : DELTA_STATE_OP;
+                }
+            }
+            break;
+
+        case DELTA_STATE_DIFF_ZEROS:
+            ret = matter_ota_delta_varint(delta, byte);
+            if (ret < 0 || (ret > 0 && delta->value > delta->remain))
+                delta->state = DELTA_STATE_ERROR;
+            else if (ret > 0)
+            {
+                if (matter_ota_delta_copy(delta, delta->value) < 0)
+                    delta->state = DELTA_STATE_ERROR;
+                else
+                {
+                    delta->remain -= delta->value;
+                    delta->state = (delta->remain > 0) ? DELTA_STATE_DIFF_LITERALS : DELTA_STATE_OP;
+                }
+                delta->value = 0;
+            }
+            break;
+
+        case DELTA_STATE_DIFF_LITERALS:
+            ret = matter_ota_delta_varint(delta, byte);
+            if (ret < 0 || (ret > 0 && (delta->value == 0 || delta->value > delta->remain)))
+                delta->state = DELTA_STATE_ERROR;
+            else if (ret > 0)
+            {
+                delta->run = delta->value;
+                delta->value = 0;
+                delta->state = DELTA_STATE_DIFF_DATA;
+            }
+            break;
+
+        case DELTA_STATE_DIFF_DATA:
+            matter_ota_delta_window(delta);
+            if (matter_ota_delta_emit(delta, delta->window[delta->old_pos - delta->window_pos] + byte) < 0)
+            {
+                delta->state = DELTA_STATE_ERROR;
+                break;
+            }
+            delta->old_pos++;
+            delta->remain--;
+            if (--delta->run == 0)
+                delta->state = (delta->remain > 0) ? DELTA_STATE_DIFF_ZEROS : DELTA_STATE_OP;
+            break;
+
+        case DELTA_STATE_INSERT_DATA:
+            if (matter_ota_delta_emit(delta, byte) < 0)
+            {
+                delta->state = DELTA_STATE_ERROR;
+                break;
+            }
+            if (--delta->remain == 0)
+                delta->state = DELTA_STATE_OP;
+            break;
+
+        default:
+            // nothing may follow END
+            delta->state = DELTA_STATE_ERROR;
+            break;
+        }
+
+        data += used;
+        size -= used;
+    }
+
+    if (delta->state == DELTA_STATE_ERROR)
+    {
+        printf("[%s] Malformed delta payload at image offset %d\r\n", __FUNCTION__, delta->new_len);
+        return -1;
+    }
+    return 1;
+}
+
+int8_t matter_ota_delta_finish(matter_ota_delta_t *delta)
+{
+    if (delta->state != DELTA_STATE_END || delta->new_len != delta->header.new_size)
+    {
+        printf("[%s] Delta payload is incomplete\r\n", __FUNCTION__);
+        return -1;
+    }
+    return 1;
+}
+
+void matter_ota_delta_base_init(matter_ota_delta_base_t *base, uint32_t old_addr, const matter_ota_delta_header_t *header)
+{
+    base->addr = old_addr;
+    base->size = header->old_size;
+    base->pos = 0;
+    base->crc = 0;
+    base->expected = header->old_crc;
+}
+
+int8_t matter_ota_delta_base_step(matter_ota_delta_base_t *base)
+{
+    uint8_t window[MATTER_OTA_DELTA_WINDOW];
+    uint32_t len = base->size - base->pos;
+
+    if (len > MATTER_OTA_DELTA_WINDOW)
+        len = MATTER_OTA_DELTA_WINDOW;
+
+    if (len > 0)
+    {
+        device_mutex_lock(RT_DEV_LOCK_FLASH);
+        flash_stream_read(&matter_ota_delta_flash, base->addr + base->pos, len, window);
+        device_mutex_unlock(RT_DEV_LOCK_FLASH);
+        base->crc = matter_ota_delta_crc32(base->crc, window, len);
+        base->pos += len;
+    }
+
+    if (base->pos < base->size)
+        return 0;
+    return (base->crc == base->expected) ? 1 : -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,68 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Delta OTA payloads, created with tools/matter/ota/ota_delta_tool.py
+#define MATTER_OTA_DELTA_MAGIC          "RDLT"
+#define MATTER_OTA_DELTA_HEADER_SIZE    64
+#define MATTER_OTA_DELTA_WINDOW         256     // old image bytes read from flash at once
+#define MATTER_OTA_DELTA_OUT_SIZE       256     // rebuilt bytes handed to the sink at once
+
+typedef struct
+{
+    uint32_t old_size;
+    uint32_t new_size;
+    uint32_t old_crc;
+    uint8_t new_digest[32];
+} matter_ota_delta_header_t;
+
+// sink receives the rebuilt image in order, header_cb runs once before the first rebuilt byte
+typedef int8_t (*matter_ota_delta_sink_t)(const uint8_t *data, uint32_t size);
+typedef int8_t (*matter_ota_delta_header_cb_t)(const matter_ota_delta_header_t *header);
+
+typedef struct
+{
+    uint8_t state;
+    uint8_t shift;                      // varint decoding
+    uint32_t value;
+    uint32_t remain;                    // bytes left in the current op
+    uint32_t run;                       // bytes left in the current literal run of a DIFF
+    uint32_t old_addr;                  // running image in flash
+    uint32_t old_pos;                   // old image cursor
+    uint32_t window_pos;
+    uint16_t window_len;
+    uint16_t out_len;
+    uint16_t header_len;
+    uint32_t new_len;                   // rebuilt bytes so far
+    matter_ota_delta_header_t header;
+    matter_ota_delta_sink_t sink;
+    matter_ota_delta_header_cb_t header_cb;
+    uint8_t raw[MATTER_OTA_DELTA_HEADER_SIZE];
+    uint8_t window[MATTER_OTA_DELTA_WINDOW];
+    uint8_t out[MATTER_OTA_DELTA_OUT_SIZE];
+} matter_ota_delta_t;
+
+// CRC check of the running image the payload was created against, run a step at a time by the caller
+typedef struct
+{
+    uint32_t addr;
+    uint32_t size;
+    uint32_t pos;
+    uint32_t crc;
+    uint32_t expected;
+} matter_ota_delta_base_t;
+
+bool matter_ota_delta_detect(const uint8_t *data, uint32_t size);
+void matter_ota_delta_init(matter_ota_delta_t *delta, uint32_t old_addr, matter_ota_delta_sink_t sink, matter_ota_delta_header_cb_t header_cb);
+int8_t matter_ota_delta_feed(matter_ota_delta_t *delta, const uint8_t *data, uint32_t size);
+int8_t matter_ota_delta_finish(matter_ota_delta_t *delta);
+void matter_ota_delta_base_init(matter_ota_delta_base_t *base, uint32_t old_addr, const matter_ota_delta_header_t *header);
+// checks up to MATTER_OTA_DELTA_WINDOW more bytes, returns 0 while bytes are left, 1 on a match, -1 on a mismatch
+int8_t matter_ota_delta_base_step(matter_ota_delta_base_t *base);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,219 @@
+/**************************
+* Matter OTA Compression Related
+**************************/
+#ifndef MATTER_OTA_LZ_HOST
+#include "platform_opts.h"
+#include "platform/platform_stdlib.h"
+#else
+#include <stdio.h>
+#include <string.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdbool.h"
+#include "matter_ota_lz.h"
+
+/*
+   Streaming LZSS decoder. Tokens come in groups of eight behind a flag byte, LSB first: a clear
+   bit is one literal byte, a set bit a two byte match of 12 bit distance - 1 and 4 bit length - 3,
+   length 18 taking one more byte. Matches only reach back MATTER_OTA_LZ_WINDOW bytes, so the
+   window doubles as output buffer and RAM use is the context only.
+   Build with MATTER_OTA_LZ_HOST to benchmark on a Linux host, see ota_lz_bench.c.
+*/
+#define LZ_MATCH_MIN            3
+#define LZ_MATCH_EXT            18      // length nibble 0xF, one extra length byte follows
+
+enum
+{
+    LZ_STATE_HEADER = 0,
+    LZ_STATE_FLAGS,
+    LZ_STATE_TOKEN,
+    LZ_STATE_MATCH,
+    LZ_STATE_MATCH_EXT,
+    LZ_STATE_END,
+    LZ_STATE_ERROR,
+};
+
+static uint32_t matter_ota_lz_get_u32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static int8_t matter_ota_lz_flush(matter_ota_lz_t *lz)
+{
+    int8_t ret = 1;
+
+    if (lz->pos > lz->flushed)
+        ret = lz->sink(lz->window + lz->flushed, lz->pos - lz->flushed);
+    lz->flushed = lz->pos;
+    return ret;
+}
+
+static int8_t matter_ota_lz_emit(matter_ota_lz_t *lz, uint8_t byte)
+{
+    lz->window[lz->pos++] = byte;
+    lz->out_len++;
+    if (lz->pos == MATTER_OTA_LZ_WINDOW)
+    {
+        int8_t ret = matter_ota_lz_flush(lz);
+
+        lz->pos = 0;
+        lz->flushed = 0;
+        return ret;
+    }
+    return 1;
+}
+
+static int8_t matter_ota_lz_copy(matter_ota_lz_t *lz)
+{
+    // distances past the start of the content or lengths past its end are corrupt input
+    if (lz->dist > lz->out_len || lz->len > lz->header.size - lz->out_len)
+        return -1;
+
+    while (lz->len > 0)
+    {
+        if (matter_ota_lz_emit(lz, lz->window[(lz->pos - lz->dist) & (MATTER_OTA_LZ_WINDOW - 1)]) < 0)
+            return -1;
+        lz->len--;
+    }
+    return 1;
+}
+
+// next token of the group, or END once the announced size is reached
+static uint8_t matter_ota_lz_next(matter_ota_lz_t *lz)
+{
+    if (lz->out_len == lz->header.size)
+        return (matter_ota_lz_flush(lz) < 0) ? LZ_STATE_ERROR : LZ_STATE_END;
+
+    lz->flags >>= 1;
+    return (--lz->flag_count == 0) ? LZ_STATE_FLAGS : LZ_STATE_TOKEN;
+}
+
+static int8_t matter_ota_lz_check_header(matter_ota_lz_t *lz)
+{
+    uint8_t *raw = lz->raw;
+
+    if (memcmp(raw, MATTER_OTA_LZ_MAGIC, 4) != 0 || raw[4] != 1 ||
+        raw[5] != MATTER_OTA_LZ_METHOD_LZSS || raw[6] != MATTER_OTA_LZ_WINDOW_BITS)
+    {
+        printf("[%s] Unsupported compressed payload\r\n", __FUNCTION__);
+        return -1;
+    }
+
+    lz->header.method = raw[5];
+    lz->header.window_bits = raw[6];
+    lz->header.size = matter_ota_lz_get_u32(raw + 8);
+    lz->header.stream_size = matter_ota_lz_get_u32(raw + 12);
+    memcpy(lz->header.digest, raw + 32, sizeof(lz->header.digest));
+
+    if (lz->header.size == 0)
+        return -1;
+
+    return lz->header_cb ? lz->header_cb(&lz->header) : 1;
+}
+
+bool matter_ota_lz_detect(const uint8_t *data, uint32_t size)
+{
+    return size >= 4 && memcmp(data, MATTER_OTA_LZ_MAGIC, 4) == 0;
+}
+
+void matter_ota_lz_init(matter_ota_lz_t *lz, matter_ota_lz_sink_t sink, matter_ota_lz_header_cb_t header_cb)
+{
+    memset(lz, 0, sizeof(matter_ota_lz_t));
+    lz->state = LZ_STATE_HEADER;
+    lz->sink = sink;
+    lz->header_cb = header_cb;
+}
+
+int8_t matter_ota_lz_feed(matter_ota_lz_t *lz, const uint8_t *data, uint32_t size)
+{
+    while (size > 0 && lz->state != LZ_STATE_ERROR)
+    {
+        uint8_t state = lz->state;
+        uint8_t byte = *data;
+        uint32_t used = 1;
+
+        switch (state)
+        {
+        case LZ_STATE_HEADER:
+            used = MATTER_OTA_LZ_HEADER_SIZE - lz->header_len;
+            if (used > size)
+                used = size;
+            memcpy(lz->raw + lz->header_len, data, used);
+            lz->header_len += used;
+            if (lz->header_len == MATTER_OTA_LZ_HEADER_SIZE)
+                lz->state = (matter_ota_lz_check_header(lz) < 0) ? LZ_STATE_ERROR : LZ_STATE_FLAGS;
+            break;
+
+        case LZ_STATE_FLAGS:
+            lz->flags = byte;
+            lz->flag_count = 8;
+            lz->state = LZ_STATE_TOKEN;
+            break;
+
+        case LZ_STATE_TOKEN:
+            if (lz->flags & 1)
+            {
+                lz->token = byte;
+                lz->state = LZ_STATE_MATCH;
+            }
+            else if (matter_ota_lz_emit(lz, byte) < 0)
+                lz->state = LZ_STATE_ERROR;
+            else
+                lz->state = matter_ota_lz_next(lz);
+            break;
+
+        case LZ_STATE_MATCH:
+            lz->dist = (lz->token | ((uint16_t) (byte & 0x0F) << 8)) + 1;
+            lz->len = (byte >> 4) + LZ_MATCH_MIN;
+            if (lz->len == LZ_MATCH_EXT)
+                lz->state = LZ_STATE_MATCH_EXT;
+            else
+                lz->state = (matter_ota_lz_copy(lz) < 0) ? LZ_STATE_ERROR : matter_ota_lz_next(lz);
+            break;
+
+        case LZ_STATE_MATCH_EXT:
+            lz->len += byte;
+            lz->state = (matter_ota_lz_copy(lz) < 0) ? LZ_STATE_ERROR : matter_ota_lz_next(lz);
+            break;
+
+        default:
+            // nothing may follow the last token
+            lz->state = LZ_STATE_ERROR;
+            break;
+        }
+
+        if (state != LZ_STATE_HEADER)
+            lz->in_len += used;
+        data += used;
+        size -= used;
+    }
+
+    // hand over what this block produced, the sink keeps pace with the download
+    if (lz->state != LZ_STATE_ERROR && matter_ota_lz_flush(lz) < 0)
+        lz->state = LZ_STATE_ERROR;
+
+    if (lz->state == LZ_STATE_ERROR)
+    {
+        printf("[%s] Malformed compressed payload at offset %d\r\n", __FUNCTION__, lz->in_len);
+        return -1;
+    }
+    return 1;
+}
+
+int8_t matter_ota_lz_finish(matter_ota_lz_t *lz)
+{
+    if (lz->state != LZ_STATE_END || lz->out_len != lz->header.size || lz->in_len != lz->header.stream_size)
+    {
+        printf("[%s] Compressed payload is incomplete\r\n", __FUNCTION__);
+        return -1;
+    }
+    return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Compressed OTA payloads, created with tools/matter/ota/ota_compress_tool.py
+#define MATTER_OTA_LZ_MAGIC             "RLZS"
+#define MATTER_OTA_LZ_HEADER_SIZE       64
+#define MATTER_OTA_LZ_METHOD_LZSS       1
+#define MATTER_OTA_LZ_WINDOW_BITS       12
+#define MATTER_OTA_LZ_WINDOW            (1 << MATTER_OTA_LZ_WINDOW_BITS)    // history kept in RAM, also the output chunk
+
+typedef struct
+{
+    uint8_t method;
+    uint8_t window_bits;
+    uint32_t size;                      // uncompressed size
+    uint32_t stream_size;               // compressed bytes after the header
+    uint8_t digest[32];                 // SHA-256 of the uncompressed content
+} matter_ota_lz_header_t;
+
+// sink receives the uncompressed content in order, header_cb runs once before the first uncompressed byte
+typedef int8_t (*matter_ota_lz_sink_t)(const uint8_t *data, uint32_t size);
+typedef int8_t (*matter_ota_lz_header_cb_t)(const matter_ota_lz_header_t *header);
+
+typedef struct
+{
+    uint8_t state;
+    uint8_t flags;                      // literal/match bits of the current group
+    uint8_t flag_count;
+    uint8_t token;                      // first byte of a match
+    uint16_t header_len;
+    uint16_t pos;                       // next window byte to write
+    uint16_t flushed;                   // window bytes before pos already given to the sink
+    uint16_t dist;
+    uint16_t len;
+    uint32_t in_len;                    // compressed bytes after the header so far
+    uint32_t out_len;                   // uncompressed bytes so far
+    matter_ota_lz_header_t header;
+    matter_ota_lz_sink_t sink;
+    matter_ota_lz_header_cb_t header_cb;
+    uint8_t raw[MATTER_OTA_LZ_HEADER_SIZE];
+    uint8_t window[MATTER_OTA_LZ_WINDOW];
+} matter_ota_lz_t;
+
+bool matter_ota_lz_detect(const uint8_t *data, uint32_t size);
+void matter_ota_lz_init(matter_ota_lz_t *lz, matter_ota_lz_sink_t sink, matter_ota_lz_header_cb_t header_cb);
+int8_t matter_ota_lz_feed(matter_ota_lz_t *lz, const uint8_t *data, uint32_t size);
+int8_t matter_ota_lz_finish(matter_ota_lz_t *lz);
+
+#ifdef __cplusplus
+}
+#endif
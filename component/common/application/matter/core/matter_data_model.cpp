@@ -5,6 +5,7 @@
 #include <app/util/attribute-storage.h>
 #include "matter_data_model.h"
 #include <platform/Ameba/AmebaUtils.h>
+#include <platform/CHIPDeviceLayer.h>
 #include <protocols/interaction_model/StatusCode.h>
 
 using namespace ::chip;
@@ -18,9 +19,13 @@ Status emberAfExternalAttributeReadCallback(EndpointId endpoint_id, ClusterId cl
                                                    uint16_t max_read_length)
 {
     Node & node = Node::getInstance();
-    Endpoint *endpoint = node.getEndpoint(endpoint_id);
-    Cluster *cluster = endpoint->getCluster(cluster_id);
-    Attribute *attribute = cluster->getAttribute(matter_attribute->attributeId);
+    Attribute *attribute = node.getAttribute(endpoint_id, cluster_id, matter_attribute->attributeId);
+
+    if (attribute == NULL)
+    {
+        ChipLogError(DeviceLayer, "[%s] Attribute 0x%08x from Cluster 0x%08x in Endpoint 0x%04x not found", __FUNCTION__, matter_attribute->attributeId, cluster_id, endpoint_id);
+        return Status::UnsupportedAttribute;
+    }
 
     if (attribute->getAttributeSize() > max_read_length)
     {
@@ -36,16 +41,172 @@ Status emberAfExternalAttributeReadCallback(EndpointId endpoint_id, ClusterId cl
 Status emberAfExternalAttributeWriteCallback(EndpointId endpoint_id, ClusterId cluster_id, const EmberAfAttributeMetadata *matter_attribute, uint8_t *buffer)
 {
     Node &node = Node::getInstance();
-    Endpoint *endpoint = node.getEndpoint(endpoint_id);
-    Cluster *cluster = endpoint->getCluster(cluster_id);
-    Attribute *attribute = cluster->getAttribute(matter_attribute->attributeId);
+    Attribute *attribute = node.getAttribute(endpoint_id, cluster_id, matter_attribute->attributeId);
+
+    if (attribute == NULL)
+    {
+        ChipLogError(DeviceLayer, "[%s] Attribute 0x%08x from Cluster 0x%08x in Endpoint 0x%04x not found", __FUNCTION__, matter_attribute->attributeId, cluster_id, endpoint_id);
+        return Status::UnsupportedAttribute;
+    }
 
     attribute->setValue(buffer);
 
     return Status::Success;
 }
 
+/*                  Attribute Arena                  */
+AttributeArena::~AttributeArena()
+{
+    while (head != nullptr)
+    {
+        Block *next = head->next;
+        free(head);
+        head = next;
+    }
+}
+
+uint8_t *AttributeArena::allocate(size_t size)
+{
+    if (size == 0)
+    {
+        return nullptr;
+    }
+
+    // Large values get a dedicated block so they do not waste the tail of the current one
+    if (size > kBlockSize / 2)
+    {
+        Block *block = (Block*) malloc(sizeof(Block) + size);
+        if (block == nullptr)
+        {
+            return nullptr;
+        }
+        block->capacity = size;
+        block->used = size;
+        if (head != nullptr)
+        {
+            block->next = head->next;
+            head->next = block;
+        }
+        else
+        {
+            block->next = nullptr;
+            head = block;
+        }
+        return (uint8_t*) (block + 1);
+    }
+
+    if (head == nullptr || (head->capacity - head->used) < size)
+    {
+        Block *block = (Block*) malloc(sizeof(Block) + kBlockSize);
+        if (block == nullptr)
+        {
+            return nullptr;
+        }
+        block->capacity = kBlockSize;
+        block->used = 0;
+        block->next = head;
+        head = block;
+    }
+
+    uint8_t *ptr = (uint8_t*) (head + 1) + head->used;
+    head->used += size;
+    return ptr;
+}
+
+size_t AttributeArena::getUsedSize() const
+{
+    size_t size = 0;
+    for (Block *block = head; block != nullptr; block = block->next)
+    {
+        size += block->used;
+    }
+    return size;
+}
+
+size_t AttributeArena::getAllocatedSize() const
+{
+    size_t size = 0;
+    for (Block *block = head; block != nullptr; block = block->next)
+    {
+        size += sizeof(Block) + block->capacity;
+    }
+    return size;
+}
+
 /*                  Attributes                  */
+Attribute::Attribute(const Attribute & other) :
+    attributeId(other.attributeId),
+    attributeSize(other.attributeSize),
+    attributeType(other.attributeType),
+    attributeMask(other.attributeMask),
+    parentClusterId(other.parentClusterId),
+    parentEndpointId(other.parentEndpointId),
+    ownsString(false),
+    pendingWrite(kNoPendingWrite),
+    defaultValue(other.defaultValue),
+    value(other.value)
+{
+    // The copy never shares the string, arena backed or not, the source endpoint may be removed first. It
+    // lives on the heap until bindArena moves it into the arena of its own endpoint.
+    if (!hasStringValue() || other.value.string == nullptr)
+    {
+        return;
+    }
+
+    value.string = (uint8_t*) malloc(attributeSize);
+    if (value.string == nullptr)
+    {
+        ChipLogError(DeviceLayer, "Failed to allocate %d bytes for attributeId: %d", attributeSize, attributeId);
+        return;
+    }
+    memcpy(value.string, other.value.string, attributeSize);
+    ownsString = true;
+}
+
+Attribute::Attribute(Attribute && other) noexcept :
+    attributeId(other.attributeId),
+    attributeSize(other.attributeSize),
+    attributeType(other.attributeType),
+    attributeMask(other.attributeMask),
+    parentClusterId(other.parentClusterId),
+    parentEndpointId(other.parentEndpointId),
+    ownsString(other.ownsString),
+    pendingWrite(other.pendingWrite),
+    defaultValue(other.defaultValue),
+    value(other.value)
+{
+    other.ownsString = false;
+    other.pendingWrite = kNoPendingWrite;
+}
+
+Attribute &Attribute::operator=(Attribute other) noexcept
+{
+    std::swap(attributeId, other.attributeId);
+    std::swap(attributeSize, other.attributeSize);
+    std::swap(attributeType, other.attributeType);
+    std::swap(attributeMask, other.attributeMask);
+    std::swap(parentClusterId, other.parentClusterId);
+    std::swap(parentEndpointId, other.parentEndpointId);
+    // Bit-fields cannot be bound to std::swap
+    uint16_t otherOwnsString = other.ownsString;
+    uint16_t otherPendingWrite = other.pendingWrite;
+    other.ownsString = ownsString;
+    other.pendingWrite = pendingWrite;
+    ownsString = otherOwnsString;
+    pendingWrite = otherPendingWrite;
+    std::swap(defaultValue, other.defaultValue);
+    std::swap(value, other.value);
+    return *this;
+}
+
+Attribute::~Attribute()
+{
+    if (ownsString)
+    {
+        free(value.string);
+    }
+}
+
 chip::AttributeId Attribute::getAttributeId() const
 {
     return attributeId;
@@ -162,42 +323,139 @@ EmberAfAttributeType Attribute::getAttributeBaseType() const
     }
 }
 
+bool Attribute::hasStringValue() const
+{
+    switch (getAttributeBaseType())
+    {
+    case ZCL_OCTET_STRING_ATTRIBUTE_TYPE:
+    case ZCL_CHAR_STRING_ATTRIBUTE_TYPE:
+    case ZCL_LONG_CHAR_STRING_ATTRIBUTE_TYPE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t Attribute::getValueSize() const
+{
+    switch (getAttributeBaseType())
+    {
+    case ZCL_INT8U_ATTRIBUTE_TYPE:
+    case ZCL_BOOLEAN_ATTRIBUTE_TYPE:
+    case ZCL_INT8S_ATTRIBUTE_TYPE:
+        return sizeof(uint8_t);
+    case ZCL_INT16U_ATTRIBUTE_TYPE:
+    case ZCL_INT16S_ATTRIBUTE_TYPE:
+        return sizeof(uint16_t);
+    case ZCL_INT32U_ATTRIBUTE_TYPE:
+    case ZCL_INT32S_ATTRIBUTE_TYPE:
+        return sizeof(uint32_t);
+    case ZCL_INT64U_ATTRIBUTE_TYPE:
+    case ZCL_INT64S_ATTRIBUTE_TYPE:
+        return sizeof(uint64_t);
+    case ZCL_SINGLE_ATTRIBUTE_TYPE:
+        return sizeof(float);
+    case ZCL_OCTET_STRING_ATTRIBUTE_TYPE:
+    case ZCL_CHAR_STRING_ATTRIBUTE_TYPE:
+    case ZCL_LONG_CHAR_STRING_ATTRIBUTE_TYPE:
+        return (value.string != nullptr) ? attributeSize : 0;
+    default:
+        return 0;
+    }
+}
+
+void Attribute::allocateString(AttributeArena *arena)
+{
+    value.string = nullptr;
+    ownsString = false;
+
+    if (attributeSize == 0)
+    {
+        return;
+    }
+
+    if (arena != nullptr)
+    {
+        value.string = arena->allocate(attributeSize);
+    }
+
+    if (value.string == nullptr)
+    {
+        value.string = (uint8_t*) malloc(attributeSize);
+        ownsString = (value.string != nullptr);
+    }
+
+    if (value.string == nullptr)
+    {
+        ChipLogError(DeviceLayer, "Failed to allocate %d bytes for attributeId: %d", attributeSize, attributeId);
+    }
+}
+
+size_t Attribute::getHeapSize() const
+{
+    // Strings not taken from an endpoint arena live on the heap
+    return ownsString ? attributeSize : 0;
+}
+
+void Attribute::bindArena(AttributeArena *arena)
+{
+    // Move a heap owned string into the endpoint arena
+    if (!ownsString || arena == nullptr)
+    {
+        return;
+    }
+
+    uint8_t *string = arena->allocate(attributeSize);
+    if (string == nullptr)
+    {
+        return;
+    }
+
+    memcpy(string, value.string, attributeSize);
+    free(value.string);
+    value.string = string;
+    ownsString = false;
+}
+
 void Attribute::getValue(uint8_t *buffer) const
 {
     switch(getAttributeBaseType())
     {
     case ZCL_INT8U_ATTRIBUTE_TYPE:
     case ZCL_BOOLEAN_ATTRIBUTE_TYPE:
-        memcpy(buffer, &(std::get<uint8_t>(value)), sizeof(uint8_t));
+        memcpy(buffer, value.scalar, sizeof(uint8_t));
         break;
     case ZCL_INT16U_ATTRIBUTE_TYPE:
-        memcpy(buffer, &(std::get<uint16_t>(value)), sizeof(uint16_t));
+        memcpy(buffer, value.scalar, sizeof(uint16_t));
         break;
     case ZCL_INT32U_ATTRIBUTE_TYPE:
-        memcpy(buffer, &(std::get<uint32_t>(value)), sizeof(uint32_t));
+        memcpy(buffer, value.scalar, sizeof(uint32_t));
         break;
     case ZCL_INT64U_ATTRIBUTE_TYPE:
-        memcpy(buffer, &(std::get<uint64_t>(value)), sizeof(uint64_t));
+        memcpy(buffer, value.scalar, sizeof(uint64_t));
         break;
     case ZCL_INT8S_ATTRIBUTE_TYPE:
-        memcpy(buffer, &(std::get<int8_t>(value)), sizeof(int8_t));
+        memcpy(buffer, value.scalar, sizeof(int8_t));
         break;
     case ZCL_INT16S_ATTRIBUTE_TYPE:
-        memcpy(buffer, &(std::get<int16_t>(value)), sizeof(int16_t));
+        memcpy(buffer, value.scalar, sizeof(int16_t));
         break;
     case ZCL_INT32S_ATTRIBUTE_TYPE:
-        memcpy(buffer, &(std::get<int32_t>(value)), sizeof(int32_t));
+        memcpy(buffer, value.scalar, sizeof(int32_t));
         break;
     case ZCL_INT64S_ATTRIBUTE_TYPE:
-        memcpy(buffer, &(std::get<int64_t>(value)), sizeof(int64_t));
+        memcpy(buffer, value.scalar, sizeof(int64_t));
         break;
     case ZCL_SINGLE_ATTRIBUTE_TYPE:
-        memcpy(buffer, &(std::get<float>(value)), sizeof(float));
+        memcpy(buffer, value.scalar, sizeof(float));
         break;
     case ZCL_OCTET_STRING_ATTRIBUTE_TYPE:
     case ZCL_CHAR_STRING_ATTRIBUTE_TYPE:
     case ZCL_LONG_CHAR_STRING_ATTRIBUTE_TYPE:
-        memcpy(buffer, valueBuffer, attributeSize);
+        if (value.string != nullptr)
+        {
+            memcpy(buffer, value.string, attributeSize);
+        }
         break;
     case ZCL_ARRAY_ATTRIBUTE_TYPE:
     case ZCL_STRUCT_ATTRIBUTE_TYPE:
@@ -216,62 +474,65 @@ void Attribute::setValue(uint8_t *buffer)
     case ZCL_BOOLEAN_ATTRIBUTE_TYPE:
         uint8_t value_uint8_t;
         memcpy(&value_uint8_t, buffer, sizeof(uint8_t));
-        value = value_uint8_t;
+        memcpy(value.scalar, &value_uint8_t, sizeof(uint8_t));
         persistValue(&value_uint8_t, sizeof(uint8_t));
         break;
     case ZCL_INT16U_ATTRIBUTE_TYPE:
         uint16_t value_uint16_t;
         memcpy(&value_uint16_t, buffer, sizeof(uint16_t));
-        value = value_uint16_t;
+        memcpy(value.scalar, &value_uint16_t, sizeof(uint16_t));
         persistValue((uint8_t*) &value_uint16_t, sizeof(uint16_t));
         break;
     case ZCL_INT32U_ATTRIBUTE_TYPE:
         uint32_t value_uint32_t;
         memcpy(&value_uint32_t, buffer, sizeof(uint32_t));
-        value = value_uint32_t;
+        memcpy(value.scalar, &value_uint32_t, sizeof(uint32_t));
         persistValue((uint8_t*) &value_uint32_t, sizeof(uint32_t));
         break;
     case ZCL_INT64U_ATTRIBUTE_TYPE:
         uint64_t value_uint64_t;
         memcpy(&value_uint64_t, buffer, sizeof(uint64_t));
-        value = value_uint64_t;
+        memcpy(value.scalar, &value_uint64_t, sizeof(uint64_t));
         persistValue((uint8_t*) &value_uint64_t, sizeof(uint64_t));
         break;
     case ZCL_INT8S_ATTRIBUTE_TYPE:
         int8_t value_int8_t;
         memcpy(&value_int8_t, buffer, sizeof(int8_t));
-        value = value_int8_t;
+        memcpy(value.scalar, &value_int8_t, sizeof(int8_t));
         persistValue((uint8_t*) &value_int8_t, sizeof(int8_t));
         break;
     case ZCL_INT16S_ATTRIBUTE_TYPE:
         int16_t value_int16_t;
         memcpy(&value_int16_t, buffer, sizeof(int16_t));
-        value = value_int16_t;
+        memcpy(value.scalar, &value_int16_t, sizeof(int16_t));
         persistValue((uint8_t*) &value_int16_t, sizeof(int16_t));
         break;
     case ZCL_INT32S_ATTRIBUTE_TYPE:
         int32_t value_int32_t;
         memcpy(&value_int32_t, buffer, sizeof(int32_t));
-        value = value_int32_t;
+        memcpy(value.scalar, &value_int32_t, sizeof(int32_t));
         persistValue((uint8_t*) &value_int32_t, sizeof(int32_t));
         break;
     case ZCL_INT64S_ATTRIBUTE_TYPE:
         int64_t value_int64_t;
         memcpy(&value_int64_t, buffer, sizeof(int64_t));
-        value = value_int64_t;
+        memcpy(value.scalar, &value_int64_t, sizeof(int64_t));
         persistValue((uint8_t*) &value_int64_t, sizeof(int64_t));
         break;
     case ZCL_SINGLE_ATTRIBUTE_TYPE:
         float value_float;
         memcpy(&value_float, buffer, sizeof(float));
-        value = value_float;
+        memcpy(value.scalar, &value_float, sizeof(float));
         persistValue((uint8_t*) &value_float, sizeof(float));
         break;
     case ZCL_OCTET_STRING_ATTRIBUTE_TYPE:
     case ZCL_CHAR_STRING_ATTRIBUTE_TYPE:
     case ZCL_LONG_CHAR_STRING_ATTRIBUTE_TYPE:
-        memcpy(valueBuffer, buffer, attributeSize);
-        persistValue(valueBuffer, attributeSize);
+        if (value.string != nullptr)
+        {
+            memcpy(value.string, buffer, attributeSize);
+            persistValue(value.string, attributeSize);
+        }
         break;
     case ZCL_ARRAY_ATTRIBUTE_TYPE:
     case ZCL_STRUCT_ATTRIBUTE_TYPE:
@@ -286,12 +547,24 @@ void Attribute::persistValue(uint8_t *buffer, size_t size)
     // Only store if value is set to be stored in NVS (represented by ATTRIBUTE_MASK_TOKENIZE flag)
     if (getAttributeMask() & ATTRIBUTE_MASK_TOKENIZE)
     {
-        char key[64];
-        sprintf(key, "g/a/%x/%x/%x", parentEndpointId, parentClusterId, attributeId); // g/a/endpoint_id/cluster_id/attribute_id
-        setPref_new(key, key, buffer, size);
+        // Attributes owned by the Node are written behind, the queue reads the latest value back when committing
+        if (Node::getInstance().getAttribute(parentEndpointId, parentClusterId, attributeId) == this)
+        {
+            AttributePersistenceQueue::getInstance().markDirty(*this);
+            return;
+        }
+
+        storeValue(buffer, size);
     }
 }
 
+CHIP_ERROR Attribute::storeValue(uint8_t *buffer, size_t size) const
+{
+    char key[64];
+    sprintf(key, "g/a/%x/%x/%x", parentEndpointId, parentClusterId, attributeId); // g/a/endpoint_id/cluster_id/attribute_id
+    return AmebaUtils::MapError(setPref_new(key, key, buffer, size), AmebaErrorType::kDctError);
+}
+
 CHIP_ERROR Attribute::retrieveValue(uint8_t *buffer, size_t size)
 {
     int32_t error = -1;
@@ -308,31 +581,385 @@ CHIP_ERROR Attribute::retrieveValue(uint8_t *buffer, size_t size)
     return AmebaUtils::MapError(getPref_bin_new(key, key, buffer, size, &len), AmebaErrorType::kDctError);
 }
 
+/*                  Attribute Persistence Queue                  */
+AttributePersistenceQueue &AttributePersistenceQueue::getInstance()
+{
+    static AttributePersistenceQueue instance;
+    return instance;
+}
+
+AttributePersistenceQueue::AttributePersistenceQueue()
+{
+    // Make sure pending values reach flash before reboot/OTA apply
+    registerPrefFlushHandler(onFlushRequest);
+}
+
+void AttributePersistenceQueue::setDebounceInterval(uint32_t newDebounceMs)
+{
+    debounceMs = newDebounceMs;
+}
+
+void AttributePersistenceQueue::setMaxDelay(uint32_t newMaxDelayMs)
+{
+    maxDelayMs = newMaxDelayMs;
+}
+
+void AttributePersistenceQueue::setFlushInterval(uint32_t newFlushIntervalMs)
+{
+    flushIntervalMs = newFlushIntervalMs;
+}
+
+void AttributePersistenceQueue::markDirty(Attribute &attribute)
+{
+    uint64_t now = chip::System::SystemClock().GetMonotonicMilliseconds64().count();
+    chip::EndpointId endpointId = attribute.getParentEndpointId();
+    chip::ClusterId clusterId = attribute.getParentClusterId();
+    chip::AttributeId attributeId = attribute.getAttributeId();
+
+    stats.writesRequested++;
+
+    // The attribute remembers the slot of its pending write, the path check catches a slot it kept by copy
+    if (attribute.pendingWrite < pending.size())
+    {
+        PendingWrite &write = pending[attribute.pendingWrite];
+        if (write.endpointId == endpointId && write.clusterId == clusterId && write.attributeId == attributeId)
+        {
+            write.lastChangeMs = now;
+            stats.writesCoalesced++;
+            return;
+        }
+    }
+
+    attribute.pendingWrite = (pending.size() < Attribute::kNoPendingWrite) ? pending.size() : Attribute::kNoPendingWrite;
+    pending.push_back(PendingWrite{endpointId, clusterId, attributeId, now, now, false, false});
+    scheduleTimer();
+}
+
+void AttributePersistenceQueue::cancelEndpoint(chip::EndpointId endpointId)
+{
+    for (PendingWrite &write : pending)
+    {
+        if (write.endpointId == endpointId)
+        {
+            write.released = true;
+        }
+    }
+    releaseWrites();
+}
+
+void AttributePersistenceQueue::flush()
+{
+    commit(true);
+}
+
+size_t AttributePersistenceQueue::getPendingCount() const
+{
+    return pending.size();
+}
+
+const AttributePersistenceQueue::Stats &AttributePersistenceQueue::getStats() const
+{
+    return stats;
+}
+
+void AttributePersistenceQueue::commit(bool force)
+{
+    uint64_t now = chip::System::SystemClock().GetMonotonicMilliseconds64().count();
+    Node &node = Node::getInstance();
+    uint8_t buffer[ATTRIBUTE_LARGEST];
+    char key[64];
+    size_t committed = 0;
+    pref_txn_t txn;
+
+    // Due values are written in one transaction, attributes sharing a DCT module cost a single module update
+    beginPrefTxn(&txn);
+
+    for (PendingWrite &write : pending)
+    {
+        bool due = force || (now - write.lastChangeMs >= debounceMs) || (now - write.firstChangeMs >= maxDelayMs);
+        if (!due)
+        {
+            continue;
+        }
+
+        // The attribute may have been removed while its write was pending
+        Attribute *attribute = node.getAttribute(write.endpointId, write.clusterId, write.attributeId);
+        if (attribute == NULL || attribute->getValueSize() > sizeof(buffer))
+        {
+            write.released = true;
+            continue;
+        }
+
+        attribute->getValue(buffer);
+        sprintf(key, "g/a/%x/%x/%x", write.endpointId, write.clusterId, write.attributeId); // g/a/endpoint_id/cluster_id/attribute_id
+        if (AmebaUtils::MapError(setPrefTxn(&txn, key, buffer, attribute->getValueSize()), AmebaErrorType::kDctError) != CHIP_NO_ERROR)
+        {
+            // Stays queued, the next flush tries again
+            stats.flashWriteErrors++;
+            continue;
+        }
+        write.staged = true;
+        committed++;
+    }
+
+    if (committed == 0)
+    {
+        abortPrefTxn(&txn);
+        releaseWrites();
+        return;
+    }
+
+    // Staged values leave the queue only once they are on flash, a failed commit keeps them for the next flush
+    bool written = (AmebaUtils::MapError(commitPrefTxn(&txn), AmebaErrorType::kDctError) == CHIP_NO_ERROR);
+    for (PendingWrite &write : pending)
+    {
+        write.released = write.released || (written && write.staged);
+        write.staged = false;
+    }
+    releaseWrites();
+
+    if (!written)
+    {
+        stats.flashWriteErrors++;
+        ChipLogError(DeviceLayer, "Failed to commit %d attribute values, %d still pending", (int) committed, (int) pending.size());
+        return;
+    }
+
+    stats.flashWrites += committed;
+    ChipLogDetail(DeviceLayer, "Committed %d attribute values, %d still pending", (int) committed, (int) pending.size());
+}
+
+void AttributePersistenceQueue::releaseWrites()
+{
+    Node &node = Node::getInstance();
+    size_t kept = 0;
+
+    // Compacts the queue and moves the slot each remaining attribute keeps along with its write
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        Attribute *attribute = node.getAttribute(pending[i].endpointId, pending[i].clusterId, pending[i].attributeId);
+        if (pending[i].released)
+        {
+            if (attribute != NULL)
+            {
+                attribute->pendingWrite = Attribute::kNoPendingWrite;
+            }
+            continue;
+        }
+
+        if (attribute != NULL && kept != i)
+        {
+            attribute->pendingWrite = (kept < Attribute::kNoPendingWrite) ? kept : Attribute::kNoPendingWrite;
+        }
+        pending[kept++] = pending[i];
+    }
+    pending.resize(kept);
+}
+
+void AttributePersistenceQueue::scheduleTimer()
+{
+    if (timerArmed || pending.empty())
+    {
+        return;
+    }
+
+    if (chip::DeviceLayer::SystemLayer().StartTimer(chip::System::Clock::Milliseconds32(flushIntervalMs), onTimer, this) == CHIP_NO_ERROR)
+    {
+        timerArmed = true;
+    }
+}
+
+void AttributePersistenceQueue::onTimer(chip::System::Layer *layer, void *context)
+{
+    AttributePersistenceQueue *queue = static_cast<AttributePersistenceQueue *>(context);
+    queue->timerArmed = false;
+    queue->commit(false);
+    queue->scheduleTimer();
+}
+
+void AttributePersistenceQueue::onFlushRequest(void)
+{
+    AttributePersistenceQueue &queue = getInstance();
+
+    if (queue.pending.empty())
+    {
+        return;
+    }
+
+    // Reboots are requested from any task, possibly one that already holds the chip stack lock, so it is
+    // never waited for. Before the stack is up nothing else touches the queue. Otherwise the flush still
+    // runs when the lock is busy, losing the pending values on reboot is worse than racing their owner.
+    bool locked = false;
+    if (chip::DeviceLayer::SystemLayer().IsInitialized())
+    {
+        locked = chip::DeviceLayer::PlatformMgr().TryLockChipStack();
+    }
+    queue.flush();
+    if (locked)
+    {
+        chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+    }
+}
+
 /*                  Events                  */
 chip::EventId Event::getEventId() const
 {
     return eventId;
 }
 
-chip::ClusterId Event::getParentClusterId() const
+chip::ClusterId Event::getParentClusterId() const
+{
+    return parentClusterId;
+}
+
+/*                  Commands                  */
+chip::CommandId Command::getCommandId() const
+{
+    return commandId;
+}
+
+chip::ClusterId Command::getParentClusterId() const
+{
+    return parentClusterId;
+}
+
+uint8_t Command::getFlag() const
+{
+    return commandFlag;
+}
+
+/*                  Attribute Index                  */
+size_t AttributeIndex::hash(chip::EndpointId endpointId, chip::ClusterId clusterId, chip::AttributeId attributeId)
+{
+    // Each part gets its own multiplier and the result is mixed down to the low bits the table uses,
+    // so consecutive endpoint ids of the same attribute do not land in neighbouring slots
+    uint32_t h = (clusterId * 0x9E3779B1u) ^ (attributeId * 0x85EBCA77u) ^ (endpointId * 0xC2B2AE3Du);
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 13;
+    return h;
+}
+
+AttributeIndex::Entry *AttributeIndex::lookup(chip::EndpointId endpointId, chip::ClusterId clusterId, chip::AttributeId attributeId) const
+{
+    if (entries.empty())
+    {
+        return NULL;
+    }
+
+    size_t mask = entries.size() - 1;
+    size_t pos = hash(endpointId, clusterId, attributeId) & mask;
+    Entry *firstDeleted = NULL;
+
+    // Linear probing, stops at the first empty slot
+    for (size_t i=0; i<entries.size(); i++)
+    {
+        Entry *entry = const_cast<Entry *>(&entries[pos]);
+        if (entry->state == kEntryEmpty)
+        {
+            return (firstDeleted != NULL) ? firstDeleted : entry;
+        }
+        if (entry->state == kEntryDeleted)
+        {
+            if (firstDeleted == NULL)
+            {
+                firstDeleted = entry;
+            }
+        }
+        else if (entry->endpointId == endpointId && entry->clusterId == clusterId && entry->attributeId == attributeId)
+        {
+            return entry;
+        }
+        pos = (pos + 1) & mask;
+    }
+
+    return firstDeleted;
+}
+
+void AttributeIndex::resize(size_t capacity)
+{
+    std::vector<Entry> oldEntries;
+    oldEntries.swap(entries);
+    entries.assign(capacity, Entry{0, 0, 0, kEntryEmpty, NULL});
+    count = 0;
+    deleted = 0;
+
+    for (const Entry &entry : oldEntries)
+    {
+        if (entry.state == kEntryUsed)
+        {
+            Entry *slot = lookup(entry.endpointId, entry.clusterId, entry.attributeId);
+            *slot = entry;
+            count++;
+        }
+    }
+}
+
+Attribute *AttributeIndex::find(chip::EndpointId endpointId, chip::ClusterId clusterId, chip::AttributeId attributeId) const
+{
+    Entry *entry = lookup(endpointId, clusterId, attributeId);
+    if (entry == NULL || entry->state != kEntryUsed)
+    {
+        return NULL;
+    }
+
+    return entry->attribute;
+}
+
+void AttributeIndex::insert(Attribute *attribute)
 {
-    return parentClusterId;
+    // Keep load factor (including deleted slots) below 3/4
+    if (entries.empty())
+    {
+        resize(kInitialCapacity);
+    }
+    else if ((count + deleted + 1) * 4 > entries.size() * 3)
+    {
+        resize(((count + 1) * 4 > entries.size() * 2) ? entries.size() * 2 : entries.size());
+    }
+
+    chip::EndpointId endpointId = attribute->getParentEndpointId();
+    chip::ClusterId clusterId = attribute->getParentClusterId();
+    chip::AttributeId attributeId = attribute->getAttributeId();
+
+    Entry *entry = lookup(endpointId, clusterId, attributeId);
+    if (entry->state != kEntryUsed)
+    {
+        if (entry->state == kEntryDeleted)
+        {
+            deleted--;
+        }
+        entry->endpointId = endpointId;
+        entry->clusterId = clusterId;
+        entry->attributeId = attributeId;
+        entry->state = kEntryUsed;
+        count++;
+    }
+    entry->attribute = attribute;
 }
 
-/*                  Commands                  */
-chip::CommandId Command::getCommandId() const
+void AttributeIndex::remove(chip::EndpointId endpointId, chip::ClusterId clusterId, chip::AttributeId attributeId)
 {
-    return commandId;
+    Entry *entry = lookup(endpointId, clusterId, attributeId);
+    if (entry == NULL || entry->state != kEntryUsed)
+    {
+        return;
+    }
+
+    entry->state = kEntryDeleted;
+    entry->attribute = NULL;
+    count--;
+    deleted++;
 }
 
-chip::ClusterId Command::getParentClusterId() const
+size_t AttributeIndex::getCount() const
 {
-    return parentClusterId;
+    return count;
 }
 
-uint8_t Command::getFlag() const
+size_t AttributeIndex::getMemoryUsage() const
 {
-    return commandFlag;
+    return sizeof(AttributeIndex) + entries.capacity() * sizeof(Entry);
 }
 
 /*                  Cluster                  */
@@ -405,8 +1032,16 @@ Command *Cluster::getGeneratedCommand(chip::CommandId commandId)
 
 void Cluster::addAttribute(AttributeConfig attributeConfig)
 {
-    Attribute attribute(clusterId, parentEndpointId, attributeConfig);
-    addAttribute(attribute);
+    // Check if attribute already exist
+    if (getAttribute(attributeConfig.attributeId) != NULL)
+    {
+        return;
+    }
+
+    // Construct in place so string values are allocated once, from the endpoint arena if attached
+    const Attribute *previousData = attributes.data();
+    attributes.emplace_back(clusterId, parentEndpointId, attributeConfig, attributeArena);
+    indexAddedAttribute(previousData);
 }
 
 void Cluster::addAttribute(const Attribute &attribute)
@@ -417,7 +1052,10 @@ void Cluster::addAttribute(const Attribute &attribute)
         return;
     }
 
+    const Attribute *previousData = attributes.data();
     attributes.push_back(attribute);
+    attributes.back().bindArena(attributeArena);
+    indexAddedAttribute(previousData);
 }
 
 void Cluster::removeAttribute(chip::AttributeId attributeId)
@@ -429,7 +1067,14 @@ void Cluster::removeAttribute(chip::AttributeId attributeId)
 
     if (it != attributes.end())
     {
+        if (attributeIndex != nullptr)
+        {
+            attributeIndex->remove(parentEndpointId, clusterId, attributeId);
+        }
         attributes.erase(it);
+
+        // erase shifts the following attributes, refresh the whole cluster
+        indexAttributes();
     }
 }
 
@@ -539,6 +1184,60 @@ void Cluster::removeFunction()
     // not implemented
 }
 
+size_t Cluster::getMemoryUsage() const
+{
+    // Heap used by the cluster's vectors, string values are accounted for by the endpoint arena
+    return attributes.capacity() * sizeof(Attribute) +
+           events.capacity() * sizeof(Event) +
+           acceptedCommands.capacity() * sizeof(Command) +
+           generatedCommands.capacity() * sizeof(Command) +
+           functions.capacity() * sizeof(EmberAfGenericClusterFunction);
+}
+
+void Cluster::indexAttributes()
+{
+    if (attributeIndex == nullptr)
+    {
+        return;
+    }
+
+    for (Attribute &attribute : attributes)
+    {
+        attributeIndex->insert(&attribute);
+    }
+}
+
+void Cluster::indexAddedAttribute(const Attribute *previousData)
+{
+    if (attributeIndex == nullptr)
+    {
+        return;
+    }
+
+    // If the vector grew, every attribute of this cluster has moved
+    if (attributes.data() != previousData)
+    {
+        indexAttributes();
+    }
+    else
+    {
+        attributeIndex->insert(&attributes.back());
+    }
+}
+
+void Cluster::unindexAttributes()
+{
+    if (attributeIndex == nullptr)
+    {
+        return;
+    }
+
+    for (const Attribute &attribute : attributes)
+    {
+        attributeIndex->remove(parentEndpointId, clusterId, attribute.getAttributeId());
+    }
+}
+
 /*                  Endpoint                  */
 chip::EndpointId Endpoint::getEndpointId() const
 {
@@ -558,36 +1257,56 @@ Cluster *Endpoint::getCluster(chip::ClusterId clusterId)
     return NULL;
 }
 
-void Endpoint::addCluster(ClusterConfig &clusterConfig)
+// Shared by ClusterConfig (heap vectors) and StaticClusterConfig (constant tables)
+template <typename Config>
+void Endpoint::buildCluster(const Config &clusterConfig)
 {
-    Cluster cluster(endpointId, clusterConfig);
+    // Check if cluster already exist
+    if (getCluster(clusterConfig.clusterId) != NULL)
+    {
+        return;
+    }
+
+    // Build the cluster in place, attributes then take their storage directly from the endpoint arena
+    clusters.emplace_back(endpointId, clusterConfig);
+    Cluster &cluster = clusters.back();
+    cluster.attributeIndex = attributeIndex;
+    cluster.attributeArena = attributeArena;
+
+    cluster.attributes.reserve(clusterConfig.attributeConfigs.size());
     for (const AttributeConfig &attributeConfig : clusterConfig.attributeConfigs)
     {
-        Attribute attribute(cluster.getClusterId(), endpointId, attributeConfig);
-        cluster.addAttribute(attribute);
+        cluster.addAttribute(attributeConfig);
     }
     for (const EventConfig & eventConfig : clusterConfig.eventConfigs)
     {
-        Event event(cluster.getClusterId(), endpointId, eventConfig);
-        cluster.addEvent(event);
+        cluster.addEvent(eventConfig);
     }
     for (const CommandConfig &commandConfig : clusterConfig.commandConfigs)
     {
-        Command command(cluster.getClusterId(), endpointId, commandConfig);
-        if (command.getFlag() & COMMAND_MASK_ACCEPTED)
+        if (commandConfig.mask & COMMAND_MASK_ACCEPTED)
         {
-            cluster.addAcceptedCommand(command);
+            cluster.addAcceptedCommand(commandConfig);
         }
-        if (command.getFlag() & COMMAND_MASK_GENERATED)
+        if (commandConfig.mask & COMMAND_MASK_GENERATED)
         {
-            cluster.addGeneratedCommand(command);
+            cluster.addGeneratedCommand(commandConfig);
         }
     }
     for (const EmberAfGenericClusterFunction &functionConfig : clusterConfig.functionConfigs)
     {
         cluster.addFunction(functionConfig);
     }
-    addCluster(cluster);
+}
+
+void Endpoint::addCluster(const ClusterConfig &clusterConfig)
+{
+    buildCluster(clusterConfig);
+}
+
+void Endpoint::addCluster(const StaticClusterConfig &clusterConfig)
+{
+    buildCluster(clusterConfig);
 }
 
 void Endpoint::addCluster(const Cluster &cluster)
@@ -599,6 +1318,15 @@ void Endpoint::addCluster(const Cluster &cluster)
     }
 
     clusters.push_back(cluster);
+
+    Cluster &addedCluster = clusters.back();
+    addedCluster.attributeIndex = attributeIndex;
+    addedCluster.attributeArena = attributeArena;
+    for (Attribute &attribute : addedCluster.attributes)
+    {
+        attribute.bindArena(attributeArena);
+    }
+    addedCluster.indexAttributes();
 }
 
 void Endpoint::removeCluster(chip::ClusterId clusterId)
@@ -611,6 +1339,7 @@ void Endpoint::removeCluster(chip::ClusterId clusterId)
 
     if (it != clusters.end())
     {
+        it->unindexAttributes();
         clusters.erase(it);
     }
 }
@@ -625,7 +1354,71 @@ void Endpoint::setParentEndpointId(chip::EndpointId newParentEndpointId)
     parentEndpointId = newParentEndpointId;
 }
 
+size_t Endpoint::getAttributeCount() const
+{
+    size_t count = 0;
+    for (const Cluster &cluster : clusters)
+    {
+        count += cluster.attributes.size();
+    }
+    return count;
+}
+
+size_t Endpoint::getArenaSize() const
+{
+    return (attributeArena != nullptr) ? attributeArena->getAllocatedSize() : 0;
+}
+
+size_t Endpoint::getMemoryUsage() const
+{
+    size_t size = clusters.capacity() * sizeof(Cluster) + getArenaSize() + metadataBlockSize;
+    for (const Cluster &cluster : clusters)
+    {
+        size += cluster.getMemoryUsage();
+        for (const Attribute &attribute : cluster.attributes)
+        {
+            size += attribute.getHeapSize();
+        }
+    }
+    return size;
+}
+
+void Endpoint::unindexClusters()
+{
+    for (Cluster &cluster : clusters)
+    {
+        cluster.unindexAttributes();
+    }
+}
+
+static size_t alignMetadataOffset(size_t offset, size_t alignment)
+{
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+// Preset tables already end their command lists with kInvalidCommandId, other lists get the terminator appended
+static bool commandListTerminated(const std::vector<Command> &commands)
+{
+    return !commands.empty() && commands.back().getCommandId() == 0xFFFFFFFF /* chip::kInvalidCommandId */;
+}
+
+static size_t commandListLength(const std::vector<Command> &commands)
+{
+    if (commands.empty())
+    {
+        return 0;
+    }
+    return commands.size() + (commandListTerminated(commands) ? 0 : 1);
+}
+
 void Endpoint::enableEndpoint()
+{
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    registerEndpoint();
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+}
+
+void Endpoint::registerEndpoint()
 {
     if (enabled)
     {
@@ -633,118 +1426,130 @@ void Endpoint::enableEndpoint()
         return;
     }
 
-    dataVersion = (chip::DataVersion*) calloc(clusters.size(), sizeof(chip::DataVersion));
+    // First pass: count table entries so everything fits in one allocation
+    // Non-empty command lists are terminated by a single kInvalidCommandId, as expected by the Matter stack
+    size_t attributeCount = 0;
+    size_t functionCount = 0;
+    size_t acceptedCommandCount = 0;
+    size_t generatedCommandCount = 0;
+    size_t eventCount = 0;
 
-    EmberAfEndpointType *endpointType = nullptr;
-    EmberAfCluster *clusterType = nullptr;
-    EmberAfAttributeMetadata *attributeType = nullptr;
-    EmberAfGenericClusterFunction *functionType = nullptr;
-    chip::CommandId *acceptedCommandType = nullptr;
-    chip::CommandId *generatedCommandType = nullptr;
-    chip::EventId *eventType = nullptr;
+    for (const Cluster &cluster : clusters)
+    {
+        attributeCount += cluster.attributes.size();
+        functionCount += cluster.functions.size();
+        acceptedCommandCount += commandListLength(cluster.acceptedCommands);
+        generatedCommandCount += commandListLength(cluster.generatedCommands);
+        eventCount += cluster.events.size();
+    }
 
-    // Setup cluster type
-    if (clusters.size() > 0)
+    size_t endpointOffset = 0;
+    size_t clusterOffset = alignMetadataOffset(endpointOffset + sizeof(EmberAfEndpointType), alignof(EmberAfCluster));
+    size_t attributeOffset = alignMetadataOffset(clusterOffset + clusters.size() * sizeof(EmberAfCluster), alignof(EmberAfAttributeMetadata));
+    size_t functionOffset = alignMetadataOffset(attributeOffset + attributeCount * sizeof(EmberAfAttributeMetadata), alignof(EmberAfGenericClusterFunction));
+    size_t dataVersionOffset = alignMetadataOffset(functionOffset + functionCount * sizeof(EmberAfGenericClusterFunction), alignof(chip::DataVersion));
+    size_t acceptedCommandOffset = alignMetadataOffset(dataVersionOffset + clusters.size() * sizeof(chip::DataVersion), alignof(chip::CommandId));
+    size_t generatedCommandOffset = acceptedCommandOffset + acceptedCommandCount * sizeof(chip::CommandId);
+    size_t eventOffset = alignMetadataOffset(generatedCommandOffset + generatedCommandCount * sizeof(chip::CommandId), alignof(chip::EventId));
+    size_t blockSize = eventOffset + eventCount * sizeof(chip::EventId);
+
+    uint8_t *block = (uint8_t*) calloc(1, blockSize);
+    if (block == nullptr)
     {
-        clusterType = (EmberAfCluster*) calloc(clusters.size(), sizeof(EmberAfCluster));
-        clusterCollector.push_back(clusterType);
+        ChipLogError(DeviceLayer, "Failed to allocate %d bytes of metadata for endpoint %d", (int) blockSize, endpointId);
+        return;
     }
 
+    EmberAfEndpointType *endpointType = (EmberAfEndpointType*) (block + endpointOffset);
+    EmberAfCluster *clusterType = (EmberAfCluster*) (block + clusterOffset);
+    EmberAfAttributeMetadata *attributeType = (EmberAfAttributeMetadata*) (block + attributeOffset);
+    EmberAfGenericClusterFunction *functionType = (EmberAfGenericClusterFunction*) (block + functionOffset);
+    chip::DataVersion *dataVersionType = (chip::DataVersion*) (block + dataVersionOffset);
+    chip::CommandId *acceptedCommandType = (chip::CommandId*) (block + acceptedCommandOffset);
+    chip::CommandId *generatedCommandType = (chip::CommandId*) (block + generatedCommandOffset);
+    chip::EventId *eventType = (chip::EventId*) (block + eventOffset);
+
+    // Second pass: fill the tables in place, straight from the clusters
     for (size_t i=0; i<clusters.size(); i++)
     {
-        Cluster cluster = clusters[i];
+        const Cluster &cluster = clusters[i];
 
-        // Setup attributes
-        if (cluster.attributes.size() > 0)
-        {
-            attributeType = (EmberAfAttributeMetadata*) calloc(cluster.attributes.size(), sizeof(EmberAfAttributeMetadata));
-            attributeCollector.push_back(attributeType);
-        }
+        clusterType[i].clusterId = cluster.getClusterId();
+        clusterType[i].attributeCount = cluster.attributes.size();
+        clusterType[i].clusterSize = 0;   // default value
+        clusterType[i].mask = cluster.getClusterMask();
+        clusterType[i].eventCount = cluster.events.size();
+        clusterType[i].attributes = cluster.attributes.empty() ? nullptr : attributeType;
+        clusterType[i].functions = cluster.functions.empty() ? nullptr : functionType;
+        clusterType[i].acceptedCommandList = cluster.acceptedCommands.empty() ? nullptr : acceptedCommandType;
+        clusterType[i].generatedCommandList = cluster.generatedCommands.empty() ? nullptr : generatedCommandType;
+        clusterType[i].eventList = cluster.events.empty() ? nullptr : eventType;
 
-        for (size_t j=0; j<cluster.attributes.size(); j++)
+        // Setup attributes
+        for (const Attribute &attribute : cluster.attributes)
         {
-            attributeType[j].defaultValue = cluster.attributes[j].getAttributeDefaultValue(); 
-            attributeType[j].attributeId = cluster.attributes[j].getAttributeId();
-            attributeType[j].size = cluster.attributes[j].getAttributeSize();
-            attributeType[j].attributeType = cluster.attributes[j].getAttributeType();
-            attributeType[j].mask = cluster.attributes[j].getAttributeMask();
+            attributeType->defaultValue = attribute.getAttributeDefaultValue();
+            attributeType->attributeId = attribute.getAttributeId();
+            attributeType->size = attribute.getAttributeSize();
+            attributeType->attributeType = attribute.getAttributeType();
+            attributeType->mask = attribute.getAttributeMask();
+            attributeType++;
         }
 
         // Setup cluster functions
-        if (cluster.functions.size() > 0)
-        {
-            functionType = (EmberAfGenericClusterFunction*) calloc(cluster.functions.size(), sizeof(EmberAfGenericClusterFunction));
-            functionCollector.push_back(functionType);
-        }
-
-        for (size_t j=0; j<cluster.functions.size(); j++)
+        for (const EmberAfGenericClusterFunction &function : cluster.functions)
         {
-            functionType[j] = cluster.functions[j];
+            *functionType++ = function;
         }
 
         // Setup accepted commands
-        if (cluster.acceptedCommands.size() > 0)
-        {
-            acceptedCommandType = (chip::CommandId*) calloc(cluster.acceptedCommands.size(), sizeof(chip::CommandId));
-            acceptedCommandCollector.push_back(acceptedCommandType);
-        }
-
-        for (size_t j=0; j<cluster.acceptedCommands.size(); j++)
+        if (!cluster.acceptedCommands.empty())
         {
-            acceptedCommandType[j] = cluster.acceptedCommands[j].getCommandId();
+            for (const Command &command : cluster.acceptedCommands)
+            {
+                *acceptedCommandType++ = command.getCommandId();
+            }
+            if (!commandListTerminated(cluster.acceptedCommands))
+            {
+                *acceptedCommandType++ = 0xFFFFFFFF /* chip::kInvalidCommandId */;
+            }
         }
 
         // Setup generated commands
-        if (cluster.generatedCommands.size() > 0)
-        {
-            generatedCommandType = (chip::CommandId*) calloc(cluster.generatedCommands.size(), sizeof(chip::CommandId));
-            generatedCommandCollector.push_back(generatedCommandType);
-        }
-
-        for (size_t j=0; j<cluster.generatedCommands.size(); j++)
+        if (!cluster.generatedCommands.empty())
         {
-            generatedCommandType[j] = cluster.generatedCommands[j].getCommandId();
+            for (const Command &command : cluster.generatedCommands)
+            {
+                *generatedCommandType++ = command.getCommandId();
+            }
+            if (!commandListTerminated(cluster.generatedCommands))
+            {
+                *generatedCommandType++ = 0xFFFFFFFF /* chip::kInvalidCommandId */;
+            }
         }
 
         // Setup events
-        if (cluster.events.size() > 0)
+        for (const Event &event : cluster.events)
         {
-            eventType = (chip::EventId*) calloc(cluster.events.size(), sizeof(chip::EventId));
-            eventCollector.push_back(eventType);
+            *eventType++ = event.getEventId();
         }
-
-        for (size_t j=0; j<cluster.events.size(); j++)
-        {
-            eventType[j] = cluster.events[j].getEventId();
-        }
-
-        clusterType[i].clusterId = cluster.getClusterId();    
-        clusterType[i].attributeCount = cluster.attributes.size();
-        clusterType[i].clusterSize = 0;   // default value
-        clusterType[i].mask = cluster.getClusterMask();
-        clusterType[i].eventCount = cluster.events.size();
-        clusterType[i].attributes = attributeType;
-        clusterType[i].functions = functionType;
-        clusterType[i].acceptedCommandList = acceptedCommandType;
-        clusterType[i].generatedCommandList = generatedCommandType;
-        clusterType[i].eventList = eventType;
     }
 
     // Setup endpoint type
-    endpointType = (EmberAfEndpointType*) calloc(1, sizeof(EmberAfEndpointType));
     endpointType->clusterCount = clusters.size();
     endpointType->endpointSize = 0;   // set to 0 as default
-    endpointType->cluster = clusterType;
+    endpointType->cluster = clusters.empty() ? nullptr : clusterType;
 
-    // Register endpoint as dynamic endpoint in matter stack
-    chip::DeviceLayer::PlatformMgr().LockChipStack();
-    ChipError status = emberAfSetDynamicEndpoint(endpointIndex, endpointId, endpointType, chip::Span<chip::DataVersion>(dataVersion, clusters.size()), deviceTypeList, parentEndpointId);
-    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+    // Register endpoint as dynamic endpoint in matter stack, the caller holds the chip stack lock
+    ChipError status = emberAfSetDynamicEndpoint(endpointIndex, endpointId, endpointType, chip::Span<chip::DataVersion>(dataVersionType, clusters.size()), deviceTypeList, parentEndpointId);
 
     if (status == CHIP_NO_ERROR)
     {
         ChipLogProgress(DeviceLayer, "Set dynamic endpoint %d success", endpointId);
+        metadataBlock = block;
+        metadataBlockSize = blockSize;
         endpointMetadata = endpointType;
+        dataVersion = dataVersionType;
         enabled = true;
         return;
     }
@@ -754,109 +1559,69 @@ void Endpoint::enableEndpoint()
     }
 
     // free allocated memory if error
-    for (EmberAfCluster *cls : clusterCollector)
-    {
-        free(cls);
-    }
-
-    for (EmberAfAttributeMetadata *att : attributeCollector)
-    {
-        free(att);
-    }
-
-    for (EmberAfGenericClusterFunction *fun : functionCollector)
-    {
-        free(fun);
-    }
-
-    for (chip::CommandId *acmd : acceptedCommandCollector)
-    {
-        free(acmd);
-    }
+    free(block);
+}
 
-    for (chip::CommandId *gcmd : generatedCommandCollector)
-    {
-        free(gcmd);
-    }
+void Endpoint::disableEndpoint()
+{
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    bool unregistered = unregisterEndpoint();
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
 
-    for (chip::EventId *evt : eventCollector)
+    if (unregistered)
     {
-        free(evt);
+        clearPersistentData();
     }
-
-    free(dataVersion);
-    free(endpointType);
 }
 
-void Endpoint::disableEndpoint()
+bool Endpoint::unregisterEndpoint()
 {
-    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    // The caller holds the chip stack lock
     int endpointIndex = emberAfGetDynamicIndexFromEndpoint(endpointId);
-    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
 
     if (endpointIndex == 0xFFFF)
     {
         ChipLogError(DeviceLayer, "Could not find endpoint index");
-        return;
+        return false;
     }
 
     // clear dynamic endpoint on matter stack
-    chip::DeviceLayer::PlatformMgr().LockChipStack();
     emberAfClearDynamicEndpoint(endpointIndex);
-    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
 
     enabled = false;
 
     // free allocated memory
-    for (EmberAfCluster *cls : clusterCollector)
-    {
-        free(cls);
-    }
-
-    for (EmberAfAttributeMetadata *att : attributeCollector)
-    {
-        free(att);
-    }
-
-    for (EmberAfGenericClusterFunction *fun : functionCollector)
-    {
-        free(fun);
-    }
-
-    for (chip::CommandId *acmd : acceptedCommandCollector)
-    {
-        free(acmd);
-    }
-
-    for (chip::CommandId *gcmd : generatedCommandCollector)
-    {
-        free(gcmd);
-    }
+    free(metadataBlock);
+    metadataBlock = nullptr;
+    metadataBlockSize = 0;
+    endpointMetadata = nullptr;
+    dataVersion = nullptr;
 
-    for (chip::EventId *evt : eventCollector)
-    {
-        free(evt);
-    }
+    return true;
+}
 
-    free(dataVersion);
-    free(endpointMetadata);
+void Endpoint::clearPersistentData()
+{
+    // Drop writes still queued for this endpoint, its persistent data is cleared below
+    AttributePersistenceQueue::getInstance().cancelEndpoint(endpointId);
 
     char key[64];
+    pref_txn_t txn;
 
-    // Clear persistent data on this endpoint
-    for (size_t i=0; i<clusters.size(); i++)
+    // Clear persistent data on this endpoint, batched so each DCT module is updated once
+    beginPrefTxn(&txn);
+    for (const Cluster &cluster : clusters)
     {
-        Cluster cluster = clusters[i];
-        for (size_t j=0; j<cluster.attributes.size(); j++)
+        for (const Attribute &attribute : cluster.attributes)
         {
-            Attribute attribute = cluster.attributes[j];
-            if (cluster.attributes[j].getAttributeMask() & ATTRIBUTE_MASK_TOKENIZE)
+            if (attribute.getAttributeMask() & ATTRIBUTE_MASK_TOKENIZE)
             {
                 sprintf(key, "g/a/%x/%x/%x", attribute.getParentEndpointId(), attribute.getParentClusterId(), attribute.getAttributeId());
-                deleteKey(key, key);
+                deletePrefTxn(&txn, key);
             }
         }
     }
+    commitPrefTxn(&txn);
     ChipLogProgress(DeviceLayer, "Successfully disabled dynamic endpoint %d", endpointId);
 }
 
@@ -881,58 +1646,56 @@ Endpoint *Node::getEndpoint(chip::EndpointId endpointId)
     return NULL;
 }
 
+Attribute *Node::getAttribute(chip::EndpointId endpointId, chip::ClusterId clusterId, chip::AttributeId attributeId) const
+{
+    return attributeIndex.find(endpointId, clusterId, attributeId);
+}
+
+const AttributeIndex &Node::getAttributeIndex() const
+{
+    return attributeIndex;
+}
+
 chip::EndpointId Node::getNextEndpointId() const
 {
     return nextEndpointId;
 }
 
-chip::EndpointId Node::addEndpoint(const EndpointConfig &endpointConfig, Span<const EmberAfDeviceType> deviceTypeList)
+template <typename Config>
+chip::EndpointId Node::buildEndpoint(const Config &endpointConfig, Span<const EmberAfDeviceType> deviceTypeList)
 {
-    Endpoint endpoint(this, nextEndpointId, endpointCount, deviceTypeList);
+    // Build the endpoint in place so that the attribute index points at its final storage
+    endpoints.emplace_back(this, nextEndpointId, endpointCount, deviceTypeList);
+    Endpoint &endpoint = endpoints.back();
+    endpoint.attributeIndex = &attributeIndex;
+    endpoint.attributeArena = new AttributeArena();
+
     // Set parentEndpointId based on the previous endpoint's endpointId
-    if (!endpoints.empty())
+    if (endpoints.size() > 1)
     {
-        endpoint.setParentEndpointId(endpoints.back().getEndpointId());
+        endpoint.setParentEndpointId(endpoints[endpoints.size() - 2].getEndpointId());
     }
 
-    for (const ClusterConfig &clusterConfig : endpointConfig.clusterConfigs)
+    for (const auto &clusterConfig : endpointConfig.clusterConfigs)
     {
-        Cluster cluster(endpoint.getEndpointId(), clusterConfig);
-        for (const AttributeConfig &attributeConfig : clusterConfig.attributeConfigs)
-        {
-            Attribute attribute(cluster.getClusterId(), endpoint.getEndpointId(), attributeConfig);
-            cluster.addAttribute(attribute);
-        }
-        for (const EventConfig &eventConfig : clusterConfig.eventConfigs)
-        {
-            Event event(cluster.getClusterId(), endpoint.getEndpointId(), eventConfig);
-            cluster.addEvent(event);
-        }
-        for (const CommandConfig &commandConfig : clusterConfig.commandConfigs)
-        {
-            Command command(cluster.getClusterId(), endpoint.getEndpointId(), commandConfig);
-            if (command.getFlag() & COMMAND_MASK_ACCEPTED)
-            {
-                cluster.addAcceptedCommand(command);
-            }
-            if (command.getFlag() & COMMAND_MASK_GENERATED)
-            {
-                cluster.addGeneratedCommand(command);
-            }
-        }
-        for (const EmberAfGenericClusterFunction &functionConfig : clusterConfig.functionConfigs)
-        {
-            cluster.addFunction(functionConfig);
-        }
-        endpoint.addCluster(cluster);
+        endpoint.addCluster(clusterConfig);
     }
-    endpoints.push_back(endpoint);
     endpointCount++;
     nextEndpointId++;
 
     return endpoint.getEndpointId();
 }
 
+chip::EndpointId Node::addEndpoint(const EndpointConfig &endpointConfig, Span<const EmberAfDeviceType> deviceTypeList)
+{
+    return buildEndpoint(endpointConfig, deviceTypeList);
+}
+
+chip::EndpointId Node::addEndpoint(const StaticEndpointConfig &endpointConfig, Span<const EmberAfDeviceType> deviceTypeList)
+{
+    return buildEndpoint(endpointConfig, deviceTypeList);
+}
+
 void Node::removeEndpoint(chip::EndpointId endpointId)
 {
     auto it = std::find_if(endpoints.begin(), endpoints.end(), [&](const Endpoint &endpoint)
@@ -944,6 +1707,7 @@ void Node::removeEndpoint(chip::EndpointId endpointId)
     {
         // Get the index of the endpoint in the vector
         int index = std::distance(endpoints.begin(), it);
+        AttributeArena *arena = it->attributeArena;
 
         if (it->enabled)
         {
@@ -951,8 +1715,11 @@ void Node::removeEndpoint(chip::EndpointId endpointId)
             return;
         }
 
-        // Remove the endpoint from the vector
+        // Drop its attributes from the index, then remove the endpoint from the vector
+        // The arena is released last since the endpoint's attributes still point into it
+        it->unindexClusters();
         endpoints.erase(it);
+        delete arena;
 
         // Update the parentEndpointId of subsequent endpoints
         for (int i = index; i < endpoints.size(); ++i)
@@ -973,8 +1740,68 @@ void Node::removeEndpoint(chip::EndpointId endpointId)
 
 void Node::enableAllEndpoints()
 {
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
     for (Endpoint &endpoint: endpoints)
     {
-        endpoint.enableEndpoint();
+        endpoint.registerEndpoint();
+    }
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+}
+
+void Node::enableEndpoints(const std::vector<chip::EndpointId> &endpointIds)
+{
+    // Register all endpoints with the chip stack locked once, so the stack sees (and reports) a single composition change
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    for (chip::EndpointId endpointId : endpointIds)
+    {
+        Endpoint *endpoint = getEndpoint(endpointId);
+        if (endpoint != NULL)
+        {
+            endpoint->registerEndpoint();
+        }
+    }
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+}
+
+void Node::disableEndpoints(const std::vector<chip::EndpointId> &endpointIds)
+{
+    std::vector<Endpoint *> unregistered;
+    unregistered.reserve(endpointIds.size());
+
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    for (chip::EndpointId endpointId : endpointIds)
+    {
+        Endpoint *endpoint = getEndpoint(endpointId);
+        if (endpoint != NULL && endpoint->unregisterEndpoint())
+        {
+            unregistered.push_back(endpoint);
+        }
+    }
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+
+    // Flash access happens outside the chip stack lock
+    for (Endpoint *endpoint : unregistered)
+    {
+        endpoint->clearPersistentData();
+    }
+}
+
+void Node::printMemoryUsage() const
+{
+    size_t total = sizeof(Node) + endpoints.capacity() * sizeof(Endpoint) + attributeIndex.getMemoryUsage();
+    size_t fixedTotal = total;
+
+    for (const Endpoint &endpoint : endpoints)
+    {
+        size_t usage = endpoint.getMemoryUsage();
+        // Estimate for the previous layout: every attribute embedded a std::variant and an ATTRIBUTE_LARGEST buffer
+        size_t fixedUsage = usage - endpoint.getArenaSize() + endpoint.getAttributeCount() * (ATTRIBUTE_LARGEST + sizeof(uint64_t));
+
+        ChipLogProgress(DeviceLayer, "Endpoint %d: %d attributes, %d bytes (string arena %d bytes), fixed buffer layout %d bytes",
+                        endpoint.getEndpointId(), (int) endpoint.getAttributeCount(), (int) usage, (int) endpoint.getArenaSize(), (int) fixedUsage);
+        total += usage;
+        fixedTotal += fixedUsage;
     }
+
+    ChipLogProgress(DeviceLayer, "Data model heap usage: %d bytes, fixed buffer layout %d bytes", (int) total, (int) fixedTotal);
 }
@@ -2,10 +2,10 @@
 
 #include "af-types.h"
 #include "endpoint_config.h"
-#include <variant>
 #include <vector>
 #include <app-common/zap-generated/attribute-type.h>
 #include <app/util/attribute-metadata.h>
+#include <system/SystemLayer.h>
 
 using namespace ::chip;
 
@@ -15,9 +15,8 @@ class Cluster;
 class Attribute;
 class Command;
 class Event;
-
-// Use variant to represent the different data types supported
-typedef std::variant<uint8_t, uint8_t*, int8_t, uint16_t, int16_t, uint32_t, int32_t, uint64_t, int64_t, float> AttributeValue;
+class AttributeIndex;
+class AttributeArena;
 
 // Configurations
 struct AttributeConfig
@@ -27,20 +26,20 @@ struct AttributeConfig
     EmberAfDefaultOrMinMaxAttributeValue value; /* use ZAP_EMPTY(), ZAP_SIMPLE(), etc */
     std::uint16_t size;
     std::uint8_t mask = 0; /* attribute flag */
-    AttributeConfig(uint32_t attributeId, uint8_t dataType, EmberAfDefaultOrMinMaxAttributeValue value, uint16_t size, uint8_t mask) : attributeId(attributeId), dataType(dataType), value(value), size(size), mask(mask) {}
+    constexpr AttributeConfig(uint32_t attributeId, uint8_t dataType, EmberAfDefaultOrMinMaxAttributeValue value, uint16_t size, uint8_t mask) : attributeId(attributeId), dataType(dataType), value(value), size(size), mask(mask) {}
 };
 
 struct EventConfig
 {
     std::uint32_t eventId;
-    EventConfig(uint32_t eventId) : eventId(eventId) {}
+    constexpr EventConfig(uint32_t eventId) : eventId(eventId) {}
 };
 
 struct CommandConfig
 {
     std::uint32_t commandId;
     std::uint8_t mask = 0; /* command flag */
-    CommandConfig(uint32_t commandId, uint8_t mask) : commandId(commandId), mask(mask) {}
+    constexpr CommandConfig(uint32_t commandId, uint8_t mask) : commandId(commandId), mask(mask) {}
 };
 
 struct ClusterConfig
@@ -60,132 +59,155 @@ public:
     std::vector<ClusterConfig> clusterConfigs;
 };
 
+// Static configurations
+// Read-only counterparts of ClusterConfig/EndpointConfig. They only reference constant arrays, so a preset
+// declared constexpr is placed in flash and adding it to the Node only allocates the attribute values.
+struct StaticClusterConfig
+{
+    std::uint32_t clusterId;
+    Span<const AttributeConfig> attributeConfigs;
+    Span<const EventConfig> eventConfigs;
+    Span<const CommandConfig> commandConfigs;
+    Span<const EmberAfGenericClusterFunction> functionConfigs;
+    std::uint8_t mask; /* cluster flag */
+};
+
+struct StaticEndpointConfig
+{
+    Span<const StaticClusterConfig> clusterConfigs;
+};
+
+// Use configTable(array) to reference a constant array from a static configuration
+template <typename T, size_t N>
+constexpr Span<const T> configTable(const T (&table)[N])
+{
+    return Span<const T>(table, N);
+}
+
+// Attribute arena
+// Bump allocator that backs the string/octet string values of all attributes on an endpoint.
+// Memory is only returned when the arena (i.e. the endpoint) is destroyed.
+class AttributeArena
+{
+public:
+    AttributeArena() {}
+    AttributeArena(const AttributeArena &) = delete;
+    AttributeArena &operator=(const AttributeArena &) = delete;
+    ~AttributeArena();
+    uint8_t *allocate(size_t size);
+    size_t getUsedSize() const;
+    size_t getAllocatedSize() const;
+
+private:
+    struct Block
+    {
+        Block *next;
+        uint16_t capacity;
+        uint16_t used;
+    };
+
+    static constexpr size_t kBlockSize = 256;
+
+    Block *head = nullptr;
+};
+
 // Attribute class
 class Attribute
 {
 public:
-    Attribute(chip::ClusterId clusterId, chip::EndpointId endpointId, AttributeConfig attributeConfig) : 
+    friend class AttributePersistenceQueue;
+
+    Attribute(chip::ClusterId clusterId, chip::EndpointId endpointId, const AttributeConfig &attributeConfig, AttributeArena *arena = nullptr) :
         attributeId(attributeConfig.attributeId),
         attributeSize(attributeConfig.size),
         attributeType(attributeConfig.dataType),
         attributeMask(attributeConfig.mask),
         parentClusterId(clusterId),
         parentEndpointId(endpointId),
+        ownsString(false),
+        pendingWrite(kNoPendingWrite),
         defaultValue(attributeConfig.value)
     {
         // Retrieve value from NVS if available, else
         // assign value to be of base type with default value from config
+        // Scalars are kept inline in value.scalar, strings are allocated to exactly attributeSize
+        memset(&value, 0, sizeof(value));
         switch(getAttributeBaseType())
         {
         case ZCL_INT8U_ATTRIBUTE_TYPE:
         case ZCL_BOOLEAN_ATTRIBUTE_TYPE:
-            uint8_t value_uint8_t;
-            if (retrieveValue(&value_uint8_t, sizeof(uint8_t)) == CHIP_NO_ERROR)
+            if (retrieveValue(value.scalar, sizeof(uint8_t)) != CHIP_NO_ERROR)
             {
-                value = value_uint8_t;
-            }
-            else
-            {
-                value = uint8_t(attributeConfig.value.defaultValue);
+                uint8_t value_uint8_t = uint8_t(attributeConfig.value.defaultValue);
+                memcpy(value.scalar, &value_uint8_t, sizeof(uint8_t));
             }
             break;
         case ZCL_INT16U_ATTRIBUTE_TYPE:
-            uint16_t value_uint16_t;
-            if (retrieveValue((uint8_t*) &value_uint16_t, sizeof(uint16_t)) == CHIP_NO_ERROR)
-            {
-                value = value_uint16_t;
-            }
-            else
+            if (retrieveValue(value.scalar, sizeof(uint16_t)) != CHIP_NO_ERROR)
             {
-                value = uint16_t(attributeConfig.value.defaultValue);
+                uint16_t value_uint16_t = uint16_t(attributeConfig.value.defaultValue);
+                memcpy(value.scalar, &value_uint16_t, sizeof(uint16_t));
             }
             break;
         case ZCL_INT32U_ATTRIBUTE_TYPE:
-            uint32_t value_uint32_t;
-            if (retrieveValue((uint8_t*) &value_uint32_t, sizeof(uint32_t)) == CHIP_NO_ERROR)
-            {
-                value = value_uint32_t;
-            }
-            else
+            if (retrieveValue(value.scalar, sizeof(uint32_t)) != CHIP_NO_ERROR)
             {
-                value = uint32_t(attributeConfig.value.defaultValue);
+                uint32_t value_uint32_t = uint32_t(attributeConfig.value.defaultValue);
+                memcpy(value.scalar, &value_uint32_t, sizeof(uint32_t));
             }
             break;
         case ZCL_INT64U_ATTRIBUTE_TYPE:
-            uint64_t value_uint64_t;
-            if (retrieveValue((uint8_t*) &value_uint64_t, sizeof(uint64_t)) == CHIP_NO_ERROR)
+            if (retrieveValue(value.scalar, sizeof(uint64_t)) != CHIP_NO_ERROR)
             {
-                value = value_uint64_t;
-            }
-            else
-            {
-                value = uint64_t(attributeConfig.value.defaultValue);
+                uint64_t value_uint64_t = uint64_t(attributeConfig.value.defaultValue);
+                memcpy(value.scalar, &value_uint64_t, sizeof(uint64_t));
             }
             break;
         case ZCL_INT8S_ATTRIBUTE_TYPE:
-            int8_t value_int8_t;
-            if (retrieveValue((uint8_t*) &value_int8_t, sizeof(int8_t)) == CHIP_NO_ERROR)
+            if (retrieveValue(value.scalar, sizeof(int8_t)) != CHIP_NO_ERROR)
             {
-                value = value_int8_t;
-            }
-            else
-            {
-                value = int8_t(attributeConfig.value.defaultValue);
+                int8_t value_int8_t = int8_t(attributeConfig.value.defaultValue);
+                memcpy(value.scalar, &value_int8_t, sizeof(int8_t));
             }
             break;
         case ZCL_INT16S_ATTRIBUTE_TYPE:
-            int16_t value_int16_t;
-            if (retrieveValue((uint8_t*) &value_int16_t, sizeof(int16_t)) == CHIP_NO_ERROR)
-            {
-                value = value_int16_t;
-            }
-            else
+            if (retrieveValue(value.scalar, sizeof(int16_t)) != CHIP_NO_ERROR)
             {
-                value = int16_t(attributeConfig.value.defaultValue);
+                int16_t value_int16_t = int16_t(attributeConfig.value.defaultValue);
+                memcpy(value.scalar, &value_int16_t, sizeof(int16_t));
             }
             break;
         case ZCL_INT32S_ATTRIBUTE_TYPE:
-            int32_t value_int32_t;
-            if (retrieveValue((uint8_t*) &value_int32_t, sizeof(int32_t)) == CHIP_NO_ERROR)
-            {
-                value = value_int32_t;
-            }
-            else
+            if (retrieveValue(value.scalar, sizeof(int32_t)) != CHIP_NO_ERROR)
             {
-                value = int32_t(attributeConfig.value.defaultValue);
+                int32_t value_int32_t = int32_t(attributeConfig.value.defaultValue);
+                memcpy(value.scalar, &value_int32_t, sizeof(int32_t));
             }
             break;
         case ZCL_INT64S_ATTRIBUTE_TYPE:
-            int64_t value_int64_t;
-            if (retrieveValue((uint8_t*) &value_int64_t, sizeof(int64_t)) == CHIP_NO_ERROR)
-            {
-                value = value_int64_t;
-            }
-            else
+            if (retrieveValue(value.scalar, sizeof(int64_t)) != CHIP_NO_ERROR)
             {
-                value = int64_t(attributeConfig.value.defaultValue);
+                int64_t value_int64_t = int64_t(attributeConfig.value.defaultValue);
+                memcpy(value.scalar, &value_int64_t, sizeof(int64_t));
             }
             break;
         case ZCL_SINGLE_ATTRIBUTE_TYPE:
-            float value_float;
-            if (retrieveValue((uint8_t*) &value_float, sizeof(float)) == CHIP_NO_ERROR)
+            if (retrieveValue(value.scalar, sizeof(float)) != CHIP_NO_ERROR)
             {
-                value = value_float;
-            }
-            else
-            {
-                value = float(attributeConfig.value.defaultValue);
+                float value_float = float(attributeConfig.value.defaultValue);
+                memcpy(value.scalar, &value_float, sizeof(float));
             }
             break;
         case ZCL_OCTET_STRING_ATTRIBUTE_TYPE:
         case ZCL_CHAR_STRING_ATTRIBUTE_TYPE:
         case ZCL_LONG_CHAR_STRING_ATTRIBUTE_TYPE:
-            if (retrieveValue(valueBuffer, attributeSize) != CHIP_NO_ERROR)
+            allocateString(arena);
+            if (value.string != nullptr && retrieveValue(value.string, attributeSize) != CHIP_NO_ERROR)
             {
-                memset(valueBuffer, 0, ATTRIBUTE_LARGEST);
+                memset(value.string, 0, attributeSize);
                 if (attributeConfig.value.ptrToDefaultValue != nullptr)
                 {
-                    memcpy(valueBuffer, attributeConfig.value.ptrToDefaultValue, attributeSize);
+                    memcpy(value.string, attributeConfig.value.ptrToDefaultValue, attributeSize);
                 }
             }
             break;
@@ -198,31 +220,11 @@ public:
         }
     }
 
-    // Copy constructor to perform a deep copy of string values
-    Attribute(const Attribute & other) :
-        attributeId(other.attributeId),
-        attributeSize(other.attributeSize),
-        attributeType(other.attributeType),
-        attributeMask(other.attributeMask),
-        parentClusterId(other.parentClusterId),
-        parentEndpointId(other.parentEndpointId),
-        defaultValue(other.defaultValue),
-        value(other.value)
-    {
-        switch (getAttributeBaseType())
-        {
-        case ZCL_OCTET_STRING_ATTRIBUTE_TYPE:
-        case ZCL_CHAR_STRING_ATTRIBUTE_TYPE:
-        case ZCL_LONG_CHAR_STRING_ATTRIBUTE_TYPE:
-            if (other.valueBuffer != nullptr)
-            {
-                memcpy(valueBuffer, other.valueBuffer, other.attributeSize);
-            }
-            break;
-        default:
-            break;
-        }
-    }
+    // Strings are deep copied to the heap, arena backed ones too, bindArena then moves them into the new endpoint arena
+    Attribute(const Attribute & other);
+    Attribute(Attribute && other) noexcept;
+    Attribute &operator=(Attribute other) noexcept;
+    ~Attribute();
 
     chip::AttributeId getAttributeId() const;
     chip::ClusterId getParentClusterId() const;
@@ -232,21 +234,92 @@ public:
     EmberAfAttributeMask getAttributeMask() const;
     EmberAfDefaultOrMinMaxAttributeValue getAttributeDefaultValue() const;
     EmberAfAttributeType getAttributeBaseType() const;
+    bool hasStringValue() const;
+    size_t getValueSize() const;
     void getValue(uint8_t *buffer) const;
     void setValue(uint8_t *buffer);
     void persistValue(uint8_t *buffer, size_t size);
+    CHIP_ERROR storeValue(uint8_t *buffer, size_t size) const;
     CHIP_ERROR retrieveValue(uint8_t *buffer, size_t size);
+    void bindArena(AttributeArena *arena);
+    size_t getHeapSize() const;
 
 private:
+    static constexpr uint16_t kNoPendingWrite = 0x7FFF;
+
+    void allocateString(AttributeArena *arena);
+
     chip::AttributeId attributeId;
     uint16_t attributeSize;
     EmberAfAttributeType attributeType;
     EmberAfAttributeMask attributeMask;
     chip::ClusterId parentClusterId;
     chip::EndpointId parentEndpointId;
+    uint16_t ownsString : 1;    // string storage is on the heap rather than in an endpoint arena
+    uint16_t pendingWrite : 15; // slot in the persistence queue, kNoPendingWrite while nothing is pending
     EmberAfDefaultOrMinMaxAttributeValue defaultValue;
-    AttributeValue value;
-    uint8_t valueBuffer[ATTRIBUTE_LARGEST];
+    union
+    {
+        uint8_t scalar[sizeof(uint64_t)];
+        uint8_t *string;
+    } value;
+};
+
+// Attribute persistence queue
+// Write-behind queue for ATTRIBUTE_MASK_TOKENIZE attributes owned by the Node. Attribute::setValue only marks the
+// attribute dirty, the latest value is written to DCT once it has not changed for the debounce interval, or once
+// it has been pending for the max delay. Level/color transitions therefore cost one flash write per attribute.
+// Must be used from the Matter thread (or with the chip stack locked), like the external attribute callbacks.
+class AttributePersistenceQueue
+{
+public:
+    struct Stats
+    {
+        uint32_t writesRequested = 0;   // persistValue calls for queued attributes
+        uint32_t writesCoalesced = 0;   // requests merged into an already pending write
+        uint32_t flashWrites = 0;       // values written through a KVS transaction
+        uint32_t flashWriteErrors = 0;  // values that could not be staged, plus failed commits
+    };
+
+    static constexpr uint32_t kDefaultDebounceMs = 5000;
+    static constexpr uint32_t kDefaultMaxDelayMs = 30000;
+    static constexpr uint32_t kDefaultFlushIntervalMs = 1000;
+
+    static AttributePersistenceQueue &getInstance();
+    void setDebounceInterval(uint32_t debounceMs);
+    void setMaxDelay(uint32_t maxDelayMs);
+    void setFlushInterval(uint32_t flushIntervalMs);
+    void markDirty(Attribute &attribute);
+    void cancelEndpoint(chip::EndpointId endpointId);
+    void flush();
+    size_t getPendingCount() const;
+    const Stats &getStats() const;
+
+private:
+    struct PendingWrite
+    {
+        chip::EndpointId endpointId;
+        chip::ClusterId clusterId;
+        chip::AttributeId attributeId;
+        uint64_t firstChangeMs;
+        uint64_t lastChangeMs;
+        bool staged;    // set in the open transaction
+        bool released;  // written or dropped, removed by releaseWrites
+    };
+
+    AttributePersistenceQueue();
+    static void onTimer(chip::System::Layer *layer, void *context);
+    static void onFlushRequest(void);
+    void commit(bool force);
+    void releaseWrites();
+    void scheduleTimer();
+
+    std::vector<PendingWrite> pending;
+    Stats stats;
+    uint32_t debounceMs = kDefaultDebounceMs;
+    uint32_t maxDelayMs = kDefaultMaxDelayMs;
+    uint32_t flushIntervalMs = kDefaultFlushIntervalMs;
+    bool timerArmed = false;
 };
 
 // Event class
@@ -294,13 +367,57 @@ private:
     chip::EndpointId parentEndpointId;
 };
 
+// Attribute index
+// Open-addressing hash table keyed on (endpoint, cluster, attribute), kept up to date by Node/Endpoint/Cluster
+// so that the external attribute read/write callbacks do not need to walk the data model
+class AttributeIndex
+{
+public:
+    Attribute *find(chip::EndpointId endpointId, chip::ClusterId clusterId, chip::AttributeId attributeId) const;
+    void insert(Attribute *attribute);
+    void remove(chip::EndpointId endpointId, chip::ClusterId clusterId, chip::AttributeId attributeId);
+    size_t getCount() const;
+    size_t getMemoryUsage() const;
+
+private:
+    enum EntryState : uint8_t
+    {
+        kEntryEmpty = 0,
+        kEntryUsed,
+        kEntryDeleted,
+    };
+
+    struct Entry
+    {
+        chip::ClusterId clusterId;
+        chip::AttributeId attributeId;
+        chip::EndpointId endpointId;
+        uint8_t state;
+        Attribute *attribute;
+    };
+
+    static constexpr size_t kInitialCapacity = 16; // must be a power of 2
+
+    static size_t hash(chip::EndpointId endpointId, chip::ClusterId clusterId, chip::AttributeId attributeId);
+    Entry *lookup(chip::EndpointId endpointId, chip::ClusterId clusterId, chip::AttributeId attributeId) const;
+    void resize(size_t capacity);
+
+    std::vector<Entry> entries;
+    size_t count = 0;
+    size_t deleted = 0;
+};
+
 // Cluster class
 class Cluster
 {
 public:
     friend class Endpoint;
 
-    Cluster(chip::EndpointId endpointId, ClusterConfig clusterConfig) :
+    Cluster(chip::EndpointId endpointId, const ClusterConfig &clusterConfig) :
+        clusterId(clusterConfig.clusterId),
+        clusterMask(clusterConfig.mask),
+        parentEndpointId(endpointId) {}
+    Cluster(chip::EndpointId endpointId, const StaticClusterConfig &clusterConfig) :
         clusterId(clusterConfig.clusterId),
         clusterMask(clusterConfig.mask),
         parentEndpointId(endpointId) {}
@@ -330,11 +447,18 @@ public:
     void removeGeneratedCommand(chip::CommandId commandId);
     void addFunction(const EmberAfGenericClusterFunction function);
     void removeFunction();
+    size_t getMemoryUsage() const;
 
 private:
+    void indexAttributes();
+    void indexAddedAttribute(const Attribute *previousData);
+    void unindexAttributes();
+
     chip::ClusterId clusterId;
     EmberAfClusterMask clusterMask;
     chip::EndpointId parentEndpointId;
+    AttributeIndex *attributeIndex = nullptr;   // set once the cluster is part of a Node
+    AttributeArena *attributeArena = nullptr;   // set once the cluster is part of a Node
     std::vector<Attribute> attributes;
     std::vector<Event> events;
     std::vector<Command> acceptedCommands;
@@ -356,33 +480,43 @@ public:
         deviceTypeList(deviceTypeList) {}
     chip::EndpointId getEndpointId() const;
     Cluster *getCluster(chip::ClusterId clusterId);
-    void addCluster(ClusterConfig & clusterConfig);
+    void addCluster(const ClusterConfig & clusterConfig);
+    void addCluster(const StaticClusterConfig & clusterConfig);
     void addCluster(const Cluster& cluster);
     void removeCluster(chip::ClusterId clusterId);
     chip::EndpointId getParentEndpointId() const;   // This returns the endpointId of the previous endpoint, not to be confused with Cluster::getParentEndpointId
     void setParentEndpointId(chip::EndpointId parentEndpointId);
     void enableEndpoint();
     void disableEndpoint();
+    size_t getAttributeCount() const;
+    size_t getArenaSize() const;
+    size_t getMemoryUsage() const;
 
 private:
+    template <typename Config>
+    void buildCluster(const Config &clusterConfig);
+    void registerEndpoint();
+    bool unregisterEndpoint();
+    void clearPersistentData();
+    void unindexClusters();
+
     chip::EndpointId endpointId;
     uint16_t endpointIndex;
     chip::EndpointId parentEndpointId;
     Node* parentNode;
     chip::DataVersion *dataVersion = nullptr;
     Span<const EmberAfDeviceType> deviceTypeList;
-    EmberAfEndpointType *endpointMetadata;
+    AttributeIndex *attributeIndex = nullptr;   // set once the endpoint is part of a Node
+    AttributeArena *attributeArena = nullptr;   // owned by Node, freed in Node::removeEndpoint
+    EmberAfEndpointType *endpointMetadata = nullptr;
     std::vector<Cluster> clusters;
     bool enabled = false;
 
-    // Metadata collectors
-    // Store dynamic allocated objects here when endpoint is enabled, then delete it when disabled
-    std::vector<EmberAfCluster*> clusterCollector;
-    std::vector<EmberAfAttributeMetadata*> attributeCollector;
-    std::vector<EmberAfGenericClusterFunction*> functionCollector;
-    std::vector<chip::CommandId*> acceptedCommandCollector;
-    std::vector<chip::CommandId*> generatedCommandCollector;
-    std::vector<chip::EventId*> eventCollector;
+    // Metadata block
+    // All Ember metadata tables (endpoint type, clusters, attributes, functions, commands, events and data versions)
+    // are laid out in this single allocation when the endpoint is enabled, and freed as a unit when disabled
+    uint8_t *metadataBlock = nullptr;
+    size_t metadataBlockSize = 0;
 };
 
 // Node class
@@ -391,14 +525,23 @@ class Node
 public:
     static Node& getInstance();
     Endpoint *getEndpoint(chip::EndpointId endpointId);
+    Attribute *getAttribute(chip::EndpointId endpointId, chip::ClusterId clusterId, chip::AttributeId attributeId) const;
+    const AttributeIndex &getAttributeIndex() const;
     chip::EndpointId getNextEndpointId() const;
     chip::EndpointId addEndpoint(const EndpointConfig& endpointConfig, Span<const EmberAfDeviceType> deviceTypeList);
+    chip::EndpointId addEndpoint(const StaticEndpointConfig& endpointConfig, Span<const EmberAfDeviceType> deviceTypeList);
     void removeEndpoint(chip::EndpointId endpointId);
     void enableAllEndpoints();
+    void enableEndpoints(const std::vector<chip::EndpointId> &endpointIds);
+    void disableEndpoints(const std::vector<chip::EndpointId> &endpointIds);
+    void printMemoryUsage() const;
 
 private:
     Node() {} /* singleton instance */
+    template <typename Config>
+    chip::EndpointId buildEndpoint(const Config &endpointConfig, Span<const EmberAfDeviceType> deviceTypeList);
     chip::EndpointId endpointCount = 0;
     chip::EndpointId nextEndpointId = 0;
     std::vector<Endpoint> endpoints;
+    AttributeIndex attributeIndex;
 };
@@ -1,6 +1,35 @@
 #pragma once
 
 namespace Presets {
+
+// Static presets: constant tables placed in flash, pass them directly to Node::addEndpoint.
+// The functions in Clusters/Endpoints below build the equivalent runtime configurations from these tables.
+namespace Tables {
+
+extern const StaticClusterConfig matter_cluster_descriptor_server;
+extern const StaticClusterConfig matter_cluster_acl_server;
+extern const StaticClusterConfig matter_cluster_basic_information_server;
+extern const StaticClusterConfig matter_cluster_ota_requestor_server;
+extern const StaticClusterConfig matter_cluster_general_commissioning_server;
+extern const StaticClusterConfig matter_cluster_network_commissioning_server;
+extern const StaticClusterConfig matter_cluster_general_diagnostics_server;
+extern const StaticClusterConfig matter_cluster_software_diagnostics_server;
+extern const StaticClusterConfig matter_cluster_wifi_diagnostics_server;
+extern const StaticClusterConfig matter_cluster_administrator_commissioning_server;
+extern const StaticClusterConfig matter_cluster_operational_credentials_server;
+extern const StaticClusterConfig matter_cluster_group_key_management_server;
+extern const StaticClusterConfig matter_cluster_identify_server;
+extern const StaticClusterConfig matter_cluster_groups_server;
+extern const StaticClusterConfig matter_cluster_scenes_server;
+extern const StaticClusterConfig matter_cluster_onoff_server;
+extern const StaticClusterConfig matter_cluster_level_control_server;
+
+extern const StaticEndpointConfig matter_root_node_preset;
+extern const StaticEndpointConfig matter_dimmable_light_preset;
+extern const StaticEndpointConfig matter_aggregator_preset;
+
+} // Tables
+
 namespace Clusters {
 
 void matter_cluster_descriptor_server(ClusterConfig *clusterConfig);
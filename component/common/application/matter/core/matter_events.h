@@ -2,10 +2,35 @@
 
 #include <platform/CHIPDeviceLayer.h>
 #include <app/ConcreteAttributePath.h>
+#include <app-common/zap-generated/ids/Clusters.h>
 
 struct AppEvent;
 typedef void (*EventHandler)(AppEvent *);
 
+// Event payload pool
+// String and octet string values do not fit in AppEvent::value, they are copied into a fixed-block pool and the
+// event only carries a handle to them. The payload stays valid until the event handler returns, copy it if needed.
+typedef uint16_t AppEventPayloadHandle;
+
+#define APP_EVENT_PAYLOAD_INVALID       (0xFFFF)
+#define APP_EVENT_PAYLOAD_BLOCK_SIZE    (32)
+#define APP_EVENT_PAYLOAD_BLOCK_NUM     (32)
+
+AppEventPayloadHandle AppEventPayloadAlloc(const void * data, uint16_t size);
+const uint8_t * AppEventPayloadGet(AppEventPayloadHandle handle, uint16_t * size);
+void AppEventPayloadFree(AppEventPayloadHandle handle);
+
+// Executor lanes, each lane has its own queue and a task of its own priority (see matter_interaction.cpp)
+// The lane only depends on the event type and the cluster, so the events of one attribute path always go through
+// the same lane and are handled in the order they were made.
+enum AppEventLane
+{
+    kEventLane_Realtime = 0,    /* actuators that the user is waiting on: on/off, level, color, identify */
+    kEventLane_Normal,
+    kEventLane_Background,      /* slow handlers, e.g. mode changes that are persisted to flash */
+    kEventLane_Count,
+};
+
 struct AppEvent
 {
     enum AppEventTypes
@@ -38,7 +63,36 @@ struct AppEvent
        int16_t _i16;
        int32_t _i32;
        int64_t _i64;
-       char _str[256];
     } value;
+    AppEventPayloadHandle payload = APP_EVENT_PAYLOAD_INVALID; /* string/octet string value, see AppEventPayloadGet */
     EventHandler mHandler;
+    uint32_t postedTick; /* set when the event is queued, used for the lane latency histograms */
 };
+
+// Lane assignment per event type, uplink events are assigned by the cluster of the changed attribute
+inline AppEventLane GetAppEventLane(const AppEvent & aEvent)
+{
+    switch (aEvent.Type)
+    {
+    case AppEvent::kEventType_Uplink:
+        switch (aEvent.path.mClusterId)
+        {
+        case chip::app::Clusters::OnOff::Id:
+        case chip::app::Clusters::LevelControl::Id:
+        case chip::app::Clusters::ColorControl::Id:
+        case chip::app::Clusters::Identify::Id:
+            return kEventLane_Realtime;
+        default:
+            return kEventLane_Normal;
+        }
+    case AppEvent::kEventType_Downlink_OnOff:
+    case AppEvent::kEventType_Downlink_Identify:
+        return kEventLane_Realtime;
+    case AppEvent::kEventType_Downlink_LW_Mode:
+    case AppEvent::kEventType_Downlink_DW_Mode:
+    case AppEvent::kEventType_Downlink_Refrigerator_Mode:
+        return kEventLane_Background;
+    default:
+        return kEventLane_Normal;
+    }
+}
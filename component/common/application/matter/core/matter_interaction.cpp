@@ -10,31 +10,135 @@
 using namespace ::chip;
 using namespace ::chip::app;
 
-QueueHandle_t UplinkEventQueue;
-QueueHandle_t DownlinkEventQueue;
-TaskHandle_t UplinkTaskHandle;
-TaskHandle_t DownlinkTaskHandle;
+// Events only hold scalars and a payload handle, so each lane queue stays small
+#define MATTER_EVENT_QUEUE_LENGTH   (16)
 
-void PostDownlinkEvent(const AppEvent * aEvent)
+// Number of distinct attribute paths that can wait for the uplink task at the same time
+#define MATTER_UPLINK_PENDING_NUM   (16)
+
+// Executor lanes: task priority and stack size (in words) of each lane
+#define MATTER_LANE_REALTIME_PRIORITY       (3)
+#define MATTER_LANE_NORMAL_PRIORITY         (2)
+#define MATTER_LANE_BACKGROUND_PRIORITY     (1)
+#define MATTER_LANE_STACK_SIZE              (1024)
+
+static uint8_t payloadBlocks[APP_EVENT_PAYLOAD_BLOCK_NUM * APP_EVENT_PAYLOAD_BLOCK_SIZE];
+static uint8_t payloadBlockRun[APP_EVENT_PAYLOAD_BLOCK_NUM];   // number of blocks of the payload starting here, 0 if not a payload start
+static uint16_t payloadSize[APP_EVENT_PAYLOAD_BLOCK_NUM];
+static bool payloadBlockUsed[APP_EVENT_PAYLOAD_BLOCK_NUM];
+
+AppEventPayloadHandle AppEventPayloadAlloc(const void * data, uint16_t size)
 {
-    if (DownlinkEventQueue != NULL)
+    uint16_t blocks = (size + APP_EVENT_PAYLOAD_BLOCK_SIZE - 1) / APP_EVENT_PAYLOAD_BLOCK_SIZE;
+    AppEventPayloadHandle handle = APP_EVENT_PAYLOAD_INVALID;
+
+    if (blocks == 0 || blocks > APP_EVENT_PAYLOAD_BLOCK_NUM)
     {
-        BaseType_t status;
+        return APP_EVENT_PAYLOAD_INVALID;
+    }
 
-        // Event is posted in ISR, use ISR api
-        BaseType_t higherPrioTaskWoken = pdFALSE;
-        status                         = xQueueSendFromISR(DownlinkEventQueue, aEvent, &higherPrioTaskWoken);
+    // First fit on a run of contiguous free blocks
+    taskENTER_CRITICAL();
+    uint16_t run = 0;
+    for (uint16_t i = 0; i < APP_EVENT_PAYLOAD_BLOCK_NUM; i++)
+    {
+        run = payloadBlockUsed[i] ? 0 : run + 1;
+        if (run == blocks)
+        {
+            handle = i + 1 - blocks;
+            for (uint16_t j = handle; j <= i; j++)
+            {
+                payloadBlockUsed[j] = true;
+            }
+            payloadBlockRun[handle] = blocks;
+            payloadSize[handle] = size;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
 
-        if (!status)
-            ChipLogError(DeviceLayer, "Failed to post downlink event to downlink event queue with");
+    if (handle != APP_EVENT_PAYLOAD_INVALID)
+    {
+        memcpy(&payloadBlocks[handle * APP_EVENT_PAYLOAD_BLOCK_SIZE], data, size);
     }
-    else
+
+    return handle;
+}
+
+const uint8_t * AppEventPayloadGet(AppEventPayloadHandle handle, uint16_t * size)
+{
+    if (handle >= APP_EVENT_PAYLOAD_BLOCK_NUM || payloadBlockRun[handle] == 0)
     {
-        ChipLogError(DeviceLayer, "Downlink Event Queue is NULL should never happen");
+        return NULL;
+    }
+
+    if (size != NULL)
+    {
+        *size = payloadSize[handle];
+    }
+    return &payloadBlocks[handle * APP_EVENT_PAYLOAD_BLOCK_SIZE];
+}
+
+void AppEventPayloadFree(AppEventPayloadHandle handle)
+{
+    if (handle >= APP_EVENT_PAYLOAD_BLOCK_NUM)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    for (uint16_t i = 0; i < payloadBlockRun[handle]; i++)
+    {
+        payloadBlockUsed[handle + i] = false;
+    }
+    payloadBlockRun[handle] = 0;
+    payloadSize[handle] = 0;
+    taskEXIT_CRITICAL();
+}
+
+/*                  Executor                  */
+// Uplink and downlink events share the executor: every lane has its own queue and task, so a slow handler
+// (e.g. one that writes flash) only delays the events of its own lane. The realtime lane preempts the others,
+// its handlers wait for the chip stack lock no longer than a lower lane holds it. See GetAppEventLane for the
+// assignment.
+struct EventLane
+{
+    const char * name;
+    UBaseType_t priority;
+    QueueHandle_t queue;
+    TaskHandle_t task;
+    AppEventLatencyHistogram latency;
+};
+
+static EventLane eventLanes[kEventLane_Count] = {
+    { "Realtime", MATTER_LANE_REALTIME_PRIORITY },
+    { "Normal", MATTER_LANE_NORMAL_PRIORITY },
+    { "Background", MATTER_LANE_BACKGROUND_PRIORITY },
+};
+
+// Upper bounds of the latency histogram buckets in ms, the last bucket counts everything above
+static const uint32_t latencyBucketLimits[APP_EVENT_LATENCY_BUCKET_NUM - 1] = { 1, 2, 5, 10, 20, 50, 100, 200, 500 };
+
+static void RecordEventLatency(EventLane * lane, const AppEvent * aEvent)
+{
+    uint32_t latency = (uint32_t) ((xTaskGetTickCount() - aEvent->postedTick) * portTICK_PERIOD_MS);
+    size_t bucket = 0;
+
+    while (bucket < APP_EVENT_LATENCY_BUCKET_NUM - 1 && latency >= latencyBucketLimits[bucket])
+    {
+        bucket++;
     }
+
+    taskENTER_CRITICAL();
+    lane->latency.buckets[bucket]++;
+    if (latency > lane->latency.maxMs)
+    {
+        lane->latency.maxMs = latency;
+    }
+    taskEXIT_CRITICAL();
 }
 
-void DispatchDownlinkEvent(AppEvent * aEvent)
+static void DispatchEvent(AppEvent * aEvent)
 {
     if (aEvent->mHandler)
     {
@@ -42,103 +146,338 @@ void DispatchDownlinkEvent(AppEvent * aEvent)
     }
     else
     {
-        ChipLogError(DeviceLayer, "Downlink event received with no handler. Dropping event.");
+        ChipLogError(DeviceLayer, "Event received with no handler. Dropping event.");
     }
+
+    AppEventPayloadFree(aEvent->payload);
 }
 
-void DownlinkTask(void * pvParameter)
+static void DispatchPendingUplinkEvents(AppEventLane lane);
+static void UplinkFlushHandler(AppEvent * aEvent);
+
+void EventLaneTask(void * pvParameter)
 {
+    EventLane * lane = (EventLane *) pvParameter;
+    AppEventLane laneId = (AppEventLane) (lane - eventLanes);
     AppEvent event;
 
-    ChipLogProgress(DeviceLayer, "Downlink Task started");
+    ChipLogProgress(DeviceLayer, "%s event lane started", lane->name);
 
-    // Loop here and keep listening on the queue for Downlink (Firmware application to matter)
+    // Loop here and keep listening on the lane queue for Uplink (matter to Firmware application) and Downlink (Firmware application to matter)
     while (true)
     {
-        BaseType_t eventReceived = xQueueReceive(DownlinkEventQueue, &event, portMAX_DELAY);
+        BaseType_t eventReceived = xQueueReceive(lane->queue, &event, portMAX_DELAY);
         while (eventReceived == pdTRUE)
         {
-            DispatchDownlinkEvent(&event);
-            eventReceived = xQueueReceive(DownlinkEventQueue, &event, 0); // return immediately if the queue is empty
+            // Pending attribute changes are recorded individually when the flush event drains them
+            if (event.mHandler != UplinkFlushHandler)
+            {
+                RecordEventLatency(lane, &event);
+            }
+            DispatchEvent(&event);
+            eventReceived = xQueueReceive(lane->queue, &event, 0); // return immediately if the queue is empty
         }
+
+        // Pick up changes whose flush event could not be queued
+        DispatchPendingUplinkEvents(laneId);
     }
 }
 
-CHIP_ERROR matter_interaction_start_downlink()
+static CHIP_ERROR StartEventLanes()
 {
-    DownlinkEventQueue = xQueueCreate(10, sizeof(AppEvent));
-    if (DownlinkEventQueue == NULL)
+    for (EventLane &lane : eventLanes)
     {
-        ChipLogError(DeviceLayer, "Failed to allocate downlink event queue");
-        return CHIP_ERROR_NO_MEMORY;
+        if (lane.queue != NULL)
+        {
+            continue;   // already started by the other direction
+        }
+
+        lane.queue = xQueueCreate(MATTER_EVENT_QUEUE_LENGTH, sizeof(AppEvent));
+        if (lane.queue == NULL)
+        {
+            ChipLogError(DeviceLayer, "Failed to allocate %s event lane queue", lane.name);
+            return CHIP_ERROR_NO_MEMORY;
+        }
+
+        if (xTaskCreate(EventLaneTask, lane.name, MATTER_LANE_STACK_SIZE, &lane, lane.priority, &lane.task) != pdPASS)
+        {
+            ChipLogError(DeviceLayer, "Failed to start %s event lane task", lane.name);
+            vQueueDelete(lane.queue);
+            lane.queue = NULL;
+            return CHIP_ERROR_NO_MEMORY;
+        }
     }
 
-    // Start Downlink task.
-    BaseType_t xReturned;
-    xReturned = xTaskCreate(DownlinkTask, "Downlink", 1024, NULL, 1, &DownlinkTaskHandle);
+    return CHIP_NO_ERROR;
+}
 
-    return (xReturned == pdPASS) ? CHIP_NO_ERROR : CHIP_ERROR_NO_MEMORY;
+void GetAppEventLatency(AppEventLane lane, AppEventLatencyHistogram * histogram)
+{
+    taskENTER_CRITICAL();
+    *histogram = eventLanes[lane].latency;
+    taskEXIT_CRITICAL();
 }
 
-void PostUplinkEvent(const AppEvent * aEvent)
+extern "C" void matter_interaction_print_lane_latency(void)
 {
-    if (UplinkEventQueue != NULL)
+    for (size_t i = 0; i < kEventLane_Count; i++)
     {
-        BaseType_t status;
-        status = xQueueSend(UplinkEventQueue, aEvent, 1);
+        AppEventLatencyHistogram histogram;
+        GetAppEventLatency((AppEventLane) i, &histogram);
 
-        if (!status)
-            ChipLogError(DeviceLayer, "Failed to post uplink event to uplink event queue");
+        printf("%s lane latency (max %lu ms):", eventLanes[i].name, (unsigned long) histogram.maxMs);
+        for (size_t bucket = 0; bucket < APP_EVENT_LATENCY_BUCKET_NUM; bucket++)
+        {
+            if (bucket < APP_EVENT_LATENCY_BUCKET_NUM - 1)
+            {
+                printf(" <%lu:%lu", (unsigned long) latencyBucketLimits[bucket], (unsigned long) histogram.buckets[bucket]);
+            }
+            else
+            {
+                printf(" >=%lu:%lu", (unsigned long) latencyBucketLimits[bucket - 1], (unsigned long) histogram.buckets[bucket]);
+            }
+        }
+        printf("\r\n");
     }
-    else
+}
+
+extern "C" void matter_interaction_reset_lane_latency(void)
+{
+    taskENTER_CRITICAL();
+    for (EventLane &lane : eventLanes)
     {
-        ChipLogError(DeviceLayer, "Uplink Event Queue is NULL should never happen");
+        memset(&lane.latency, 0, sizeof(lane.latency));
     }
+    taskEXIT_CRITICAL();
 }
 
-void DispatchUplinkEvent(AppEvent * aEvent)
+void PostDownlinkEvent(const AppEvent * aEvent)
 {
-    if (aEvent->mHandler)
+    QueueHandle_t queue = eventLanes[GetAppEventLane(*aEvent)].queue;
+
+    if (queue != NULL)
     {
-        aEvent->mHandler(aEvent);
+        BaseType_t status;
+        AppEvent event = *aEvent;
+
+        // Event is posted in ISR, use ISR api
+        BaseType_t higherPrioTaskWoken = pdFALSE;
+        event.postedTick               = xTaskGetTickCountFromISR();
+        status                         = xQueueSendFromISR(queue, &event, &higherPrioTaskWoken);
+
+        if (!status)
+        {
+            ChipLogError(DeviceLayer, "Failed to post downlink event to downlink event queue with");
+            AppEventPayloadFree(aEvent->payload);
+        }
     }
     else
     {
-        ChipLogError(DeviceLayer, "Uplink event received with no handler. Dropping event.");
+        ChipLogError(DeviceLayer, "Downlink Event Queue is NULL should never happen");
+    }
+}
+
+CHIP_ERROR matter_interaction_start_downlink()
+{
+    return StartEventLanes();
+}
+
+static bool PostUplinkEvent(const AppEvent * aEvent, TickType_t timeout)
+{
+    QueueHandle_t queue = eventLanes[GetAppEventLane(*aEvent)].queue;
+
+    if (queue != NULL)
+    {
+        AppEvent event = *aEvent;
+        event.postedTick = xTaskGetTickCount();
+
+        return xQueueSend(queue, &event, timeout) == pdTRUE;
     }
+
+    ChipLogError(DeviceLayer, "Uplink Event Queue is NULL should never happen");
+    return false;
 }
 
-void UplinkTask(void * pvParameter)
+/*                  Uplink dispatcher                  */
+// Attribute changes are not queued one by one: the latest value of each ConcreteAttributePath is kept in a pending
+// table and the lane task delivers its pending entries as one batch. A burst of changes on the same path (e.g. level
+// transitions) therefore costs one handler call and can never overflow the lane queue or lose the final value.
+// A batch is delivered in the order of the latest change of each path.
+struct UplinkPendingEntry
 {
+    bool used;
+    uint32_t sequence;  /* order of the latest change */
     AppEvent event;
+};
 
-    ChipLogProgress(DeviceLayer, "Uplink Task started");
+static UplinkPendingEntry uplinkPending[MATTER_UPLINK_PENDING_NUM];
+static uint32_t uplinkSequence;
+static bool uplinkFlushPosted[kEventLane_Count];
+static UplinkDispatchStats uplinkStats;
 
-    // Loop here and keep listening on the queue for Uplink (matter to Firmware application)
-    while (true)
+static void DispatchPendingUplinkEvents(AppEventLane lane)
+{
+    AppEvent event;
+    uint32_t delivered = 0;
+
+    taskENTER_CRITICAL();
+    uplinkFlushPosted[lane] = false;
+    taskEXIT_CRITICAL();
+
+    // Oldest first, at most one table's worth so that a steady stream of changes cannot keep the lane here
+    for (size_t n = 0; n < MATTER_UPLINK_PENDING_NUM; n++)
     {
-        BaseType_t eventReceived = xQueueReceive(UplinkEventQueue, &event, portMAX_DELAY);
-        while (eventReceived == pdTRUE)
+        UplinkPendingEntry * oldest = NULL;
+
+        taskENTER_CRITICAL();
+        for (size_t i = 0; i < MATTER_UPLINK_PENDING_NUM; i++)
+        {
+            if (uplinkPending[i].used && GetAppEventLane(uplinkPending[i].event) == lane &&
+                (oldest == NULL || (int32_t) (uplinkPending[i].sequence - oldest->sequence) < 0))
+            {
+                oldest = &uplinkPending[i];
+            }
+        }
+        if (oldest != NULL)
         {
-            DispatchUplinkEvent(&event);
-            eventReceived = xQueueReceive(UplinkEventQueue, &event, 0); // return immediately if the queue is empty
+            event = oldest->event;
+            oldest->used = false;
         }
+        taskEXIT_CRITICAL();
+
+        if (oldest == NULL)
+        {
+            break;
+        }
+
+        RecordEventLatency(&eventLanes[lane], &event);
+        DispatchEvent(&event);
+        delivered++;
+    }
+
+    if (delivered > 0)
+    {
+        taskENTER_CRITICAL();
+        uplinkStats.batches++;
+        uplinkStats.delivered += delivered;
+        taskEXIT_CRITICAL();
     }
 }
 
-CHIP_ERROR matter_interaction_start_uplink()
+static void UplinkFlushHandler(AppEvent * aEvent)
 {
-    UplinkEventQueue = xQueueCreate(10, sizeof(AppEvent));
-    if (UplinkEventQueue == NULL)
+    DispatchPendingUplinkEvents(GetAppEventLane(*aEvent));
+}
+
+static void PostPendingUplinkEvent(const AppEvent * aEvent)
+{
+    AppEventLane lane = GetAppEventLane(*aEvent);
+    bool stored = false;
+    bool postFlush = false;
+    AppEventPayloadHandle replacedPayload = APP_EVENT_PAYLOAD_INVALID;
+
+    taskENTER_CRITICAL();
+    uplinkStats.posted++;
+
+    // Replace the pending value of the same path, else take a free slot
+    UplinkPendingEntry * freeEntry = NULL;
+    for (size_t i = 0; i < MATTER_UPLINK_PENDING_NUM; i++)
     {
-        ChipLogError(DeviceLayer, "Failed to allocate uplink event queue");
-        return CHIP_ERROR_NO_MEMORY;
+        if (uplinkPending[i].used)
+        {
+            if (uplinkPending[i].event.path == aEvent->path)
+            {
+                // Latency is measured from the first change that is still pending
+                uint32_t postedTick = uplinkPending[i].event.postedTick;
+                replacedPayload = uplinkPending[i].event.payload;
+                uplinkPending[i].event = *aEvent;
+                uplinkPending[i].event.postedTick = postedTick;
+                uplinkPending[i].sequence = ++uplinkSequence;
+                uplinkStats.coalesced++;
+                stored = true;
+                break;
+            }
+        }
+        else if (freeEntry == NULL)
+        {
+            freeEntry = &uplinkPending[i];
+        }
+    }
+    if (!stored && freeEntry != NULL)
+    {
+        freeEntry->event = *aEvent;
+        freeEntry->event.postedTick = xTaskGetTickCount();
+        freeEntry->sequence = ++uplinkSequence;
+        freeEntry->used = true;
+        stored = true;
+    }
+    if (!stored)
+    {
+        uplinkStats.dropped++;
+    }
+    else if (!uplinkFlushPosted[lane])
+    {
+        uplinkFlushPosted[lane] = true;
+        postFlush = true;
     }
+    taskEXIT_CRITICAL();
 
-    // Start Uplink task.
-    BaseType_t xReturned;
-    xReturned = xTaskCreate(UplinkTask, "Uplink", 1024, NULL, 1, &UplinkTaskHandle);
-    return (xReturned == pdPASS) ? CHIP_NO_ERROR : CHIP_ERROR_NO_MEMORY;
+    AppEventPayloadFree(replacedPayload);
+
+    if (!stored)
+    {
+        ChipLogError(DeviceLayer, "Uplink pending table full, dropping attribute change");
+        AppEventPayloadFree(aEvent->payload);
+        return;
+    }
+
+    // One flush event per batch, if the queue is full the lane task drains the table once it has emptied the queue
+    if (postFlush)
+    {
+        AppEvent flush_event;
+        flush_event.Type = AppEvent::kEventType_Uplink;
+        flush_event.path = aEvent->path;
+        flush_event.mHandler = UplinkFlushHandler;
+
+        if (!PostUplinkEvent(&flush_event, 0))
+        {
+            taskENTER_CRITICAL();
+            uplinkFlushPosted[lane] = false;
+            uplinkStats.overflow++;
+            taskEXIT_CRITICAL();
+        }
+    }
+}
+
+void GetUplinkDispatchStats(UplinkDispatchStats * stats)
+{
+    taskENTER_CRITICAL();
+    *stats = uplinkStats;
+    taskEXIT_CRITICAL();
+}
+
+extern "C" void matter_interaction_print_uplink_stats(void)
+{
+    UplinkDispatchStats stats;
+    GetUplinkDispatchStats(&stats);
+
+    printf("Uplink attribute changes: %lu\r\n", (unsigned long) stats.posted);
+    printf("Coalesced: %lu\r\n", (unsigned long) stats.coalesced);
+    printf("Dropped (pending table full): %lu\r\n", (unsigned long) stats.dropped);
+    printf("Queue overflow: %lu\r\n", (unsigned long) stats.overflow);
+    printf("Batches: %lu, delivered: %lu\r\n", (unsigned long) stats.batches, (unsigned long) stats.delivered);
+}
+
+extern "C" void matter_interaction_reset_uplink_stats(void)
+{
+    taskENTER_CRITICAL();
+    memset(&uplinkStats, 0, sizeof(uplinkStats));
+    taskEXIT_CRITICAL();
+}
+
+CHIP_ERROR matter_interaction_start_uplink()
+{
+    return StartEventLanes();
 }
 
 void MatterPostAttributeChangeCallback(const chip::app::ConcreteAttributePath & path, uint8_t type, uint16_t size, uint8_t * value)
@@ -163,16 +502,16 @@ void MatterPostAttributeChangeCallback(const chip::app::ConcreteAttributePath &
     {
         memcpy(&uplink_event.value._u64, value, size);
     }
-    else if (size <= 256) // TODO: check max attribute length
-    {
-        memcpy(&uplink_event.value._str, value, size);
-    }
     else
     {
-        ChipLogError(DeviceLayer, "Data size is too large to put into the event, please increase the value buffer size");
-        return;
+        uplink_event.payload = AppEventPayloadAlloc(value, size);
+        if (uplink_event.payload == APP_EVENT_PAYLOAD_INVALID)
+        {
+            ChipLogError(DeviceLayer, "No room in the event payload pool for %u bytes, please increase APP_EVENT_PAYLOAD_BLOCK_NUM", size);
+            return;
+        }
     }
 
     uplink_event.mHandler = matter_driver_uplink_update_handler;
-    PostUplinkEvent(&uplink_event);
+    PostPendingUplinkEvent(&uplink_event);
 }
@@ -4,6 +4,27 @@
 #include "matter_events.h"
 #include <platform/CHIPDeviceLayer.h>
 
+struct UplinkDispatchStats
+{
+    uint32_t posted;    /* attribute changes received from the stack */
+    uint32_t coalesced; /* changes that replaced a pending value of the same path */
+    uint32_t dropped;   /* changes lost because the pending table was full */
+    uint32_t overflow;  /* flush events that did not fit in the lane queue */
+    uint32_t batches;
+    uint32_t delivered;
+};
+
+#define APP_EVENT_LATENCY_BUCKET_NUM    (10)
+
+// Time from posting an event to dispatching it, bucketed by 1/2/5/10/20/50/100/200/500 ms
+struct AppEventLatencyHistogram
+{
+    uint32_t buckets[APP_EVENT_LATENCY_BUCKET_NUM];
+    uint32_t maxMs;
+};
+
 void PostDownlinkEvent(const AppEvent * aEvent);
+void GetAppEventLatency(AppEventLane lane, AppEventLatencyHistogram * histogram);
+void GetUplinkDispatchStats(UplinkDispatchStats * stats);
 CHIP_ERROR matter_interaction_start_downlink(void);
 CHIP_ERROR matter_interaction_start_uplink(void);
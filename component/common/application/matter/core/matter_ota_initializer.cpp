@@ -3,17 +3,77 @@
 #include <app/clusters/ota-requestor/BDXDownloader.h>
 #include <app/clusters/ota-requestor/DefaultOTARequestor.h>
 #include <app/clusters/ota-requestor/DefaultOTARequestorDriver.h>
+#include <lib/core/OTAImageHeader.h>
 #include <platform/Ameba/AmebaOTAImageProcessor.h>
+#include <chip_porting.h>
 
 using namespace chip;
 using namespace chip::DeviceLayer;
 
 namespace {
+
+// Forwards the payload size and digest of the Matter image header to matter_ota.c, which fails the
+// download without them and resumes an interrupted download of the same image with them. The header
+// is decoded from a copy of the blocks, they reach the Ameba processor unchanged.
+class MatterOTAImageProcessor : public AmebaOTAImageProcessor
+{
+public:
+    CHIP_ERROR PrepareDownload() override
+    {
+        mHeaderParser.Clear();
+        mHeaderParser.Init();
+        return AmebaOTAImageProcessor::PrepareDownload();
+    }
+
+    CHIP_ERROR ProcessBlock(ByteSpan & block) override
+    {
+        if (mHeaderParser.IsInitialized())
+        {
+            OTAImageHeader header;
+            ByteSpan buffer = block;
+            CHIP_ERROR err  = mHeaderParser.AccumulateAndDecode(buffer, header);
+
+            if (err == CHIP_NO_ERROR)
+            {
+                // the digest points into the parser buffer, forward it before the parser is cleared
+                if (matter_ota_set_image_info(static_cast<uint32_t>(header.mPayloadSize), static_cast<uint8_t>(header.mImageDigestType),
+                                              header.mImageDigest.data(), header.mImageDigest.size()) < 0)
+                    err = CHIP_ERROR_INVALID_FILE_IDENTIFIER;
+                mHeaderParser.Clear();
+            }
+            else if (err == CHIP_ERROR_BUFFER_TOO_SMALL)
+            {
+                err = CHIP_NO_ERROR;
+            }
+            ReturnErrorOnFailure(err);
+        }
+        return AmebaOTAImageProcessor::ProcessBlock(block);
+    }
+
+private:
+    OTAImageHeaderParser mHeaderParser;
+};
+
+// A download that resumes from a checkpoint of matter_ota.c asks the provider to skip the bytes already on flash,
+// the Ameba processor fetches every next block through this downloader.
+class MatterBDXDownloader : public BDXDownloader
+{
+public:
+    CHIP_ERROR FetchNextData() override
+    {
+        uint32_t skip = matter_ota_resume_skip();
+
+        if (skip > 0)
+            return SkipData(skip);
+        return BDXDownloader::FetchNextData();
+    }
+};
+
 DefaultOTARequestor gRequestorCore;
 DefaultOTARequestorStorage gRequestorStorage;
 DefaultOTARequestorDriver gRequestorUser;
-BDXDownloader gDownloader;
-AmebaOTAImageProcessor gImageProcessor;
+MatterBDXDownloader gDownloader;
+MatterOTAImageProcessor gImageProcessor;
 } // namespace
 
 void matter_ota_initializer()
@@ -41,31 +41,77 @@ void MatterBridge::Init(Node& mNode)
         node->removeEndpoint(1);
     }
 
-    EndpointConfig rootNodeEndpointConfig;
-    EndpointConfig aggregatorEndpointConfig;
-
-    Presets::Endpoints::matter_root_node_preset(&rootNodeEndpointConfig);
-    Presets::Endpoints::matter_aggregator_preset(&aggregatorEndpointConfig);
-
     // Initialization for Bridge: Root Node on ep0 and Aggregator on ep1
-    node->addEndpoint(rootNodeEndpointConfig, Span<const EmberAfDeviceType>(gRootNodeDeviceTypes));
-    node->addEndpoint(aggregatorEndpointConfig, Span<const EmberAfDeviceType>(gAggregatorDeviceTypes));
+    node->addEndpoint(Presets::Tables::matter_root_node_preset, Span<const EmberAfDeviceType>(gRootNodeDeviceTypes));
+    node->addEndpoint(Presets::Tables::matter_aggregator_preset, Span<const EmberAfDeviceType>(gAggregatorDeviceTypes));
 
     // Enable endpoints
     node->enableAllEndpoints();
 }
 
-void MatterBridge::addBridgedEndpoint(EndpointConfig bridgedConfig, Span<const EmberAfDeviceType> bridgedDeviceType)
+chip::EndpointId MatterBridge::addBridgedEndpoint(EndpointConfig bridgedConfig, Span<const EmberAfDeviceType> bridgedDeviceType)
 {
-    node->addEndpoint(bridgedConfig, bridgedDeviceType);
-    node->enableAllEndpoints();
+    chip::EndpointId endpointId = node->addEndpoint(bridgedConfig, bridgedDeviceType);
+
+    // Only the new endpoint needs registering, the others are already enabled
+    node->enableEndpoints(std::vector<chip::EndpointId>{ endpointId });
+
+    return endpointId;
+}
+
+chip::EndpointId MatterBridge::addBridgedEndpoint(const StaticEndpointConfig &bridgedConfig, Span<const EmberAfDeviceType> bridgedDeviceType)
+{
+    chip::EndpointId endpointId = node->addEndpoint(bridgedConfig, bridgedDeviceType);
+
+    node->enableEndpoints(std::vector<chip::EndpointId>{ endpointId });
+
+    return endpointId;
 }
 
 void MatterBridge::removeBridgedEndpoint(chip::EndpointId endpointID)
 {
-    Endpoint *ep = node->getEndpoint(endpointID);
-    ep->disableEndpoint();
-    node->removeEndpoint(endpointID);
+    removeBridgedEndpoints(std::vector<chip::EndpointId>{ endpointID });
+}
+
+std::vector<chip::EndpointId> MatterBridge::addBridgedEndpoints(const std::vector<BridgedEndpointConfig> &bridgedConfigs)
+{
+    std::vector<chip::EndpointId> endpointIDs;
+    endpointIDs.reserve(bridgedConfigs.size());
+
+    // Build all endpoints first, then register them with the stack in one go
+    for (const BridgedEndpointConfig &bridgedConfig : bridgedConfigs)
+    {
+        endpointIDs.push_back(node->addEndpoint(bridgedConfig.endpointConfig, bridgedConfig.deviceTypeList));
+    }
+
+    node->enableEndpoints(endpointIDs);
+
+    ChipLogProgress(DeviceLayer, "Added %u bridged endpoints", (unsigned) endpointIDs.size());
+
+    return endpointIDs;
+}
+
+void MatterBridge::removeBridgedEndpoints(const std::vector<chip::EndpointId> &endpointIDs)
+{
+    std::vector<chip::EndpointId> existingIDs;
+    existingIDs.reserve(endpointIDs.size());
+
+    for (chip::EndpointId endpointID : endpointIDs)
+    {
+        if (node->getEndpoint(endpointID) == NULL)
+        {
+            ChipLogError(DeviceLayer, "Bridged endpoint %d not found", endpointID);
+            continue;
+        }
+        existingIDs.push_back(endpointID);
+    }
+
+    node->disableEndpoints(existingIDs);
+
+    for (chip::EndpointId endpointID : existingIDs)
+    {
+        node->removeEndpoint(endpointID);
+    }
 }
 
 MatterBridgeDevice::MatterBridgeDevice(const char * szDeviceName, const char * szLocation)
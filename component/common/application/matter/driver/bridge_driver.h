@@ -26,10 +26,21 @@ public:
         uint8_t endpointId; // do we need to store this? can just create a new one on reboot
         char address[BRIDGE_DEVICE_ADDRESS_LENGTH];
     };
+    struct BridgedEndpointConfig
+    {
+        EndpointConfig endpointConfig;
+        Span<const EmberAfDeviceType> deviceTypeList;
+    };
     void Init(Node& node);
-    void addBridgedEndpoint(EndpointConfig bridgedConfig, Span<const EmberAfDeviceType> bridgedDeviceType);
+    chip::EndpointId addBridgedEndpoint(EndpointConfig bridgedConfig, Span<const EmberAfDeviceType> bridgedDeviceType);
+    chip::EndpointId addBridgedEndpoint(const StaticEndpointConfig &bridgedConfig, Span<const EmberAfDeviceType> bridgedDeviceType);
     void removeBridgedEndpoint(chip::EndpointId endpointID);
 
+    // Batched provisioning: the whole set is registered (or cleared) under a single chip stack lock,
+    // so only the new endpoints are touched and controllers see one PartsList change
+    std::vector<chip::EndpointId> addBridgedEndpoints(const std::vector<BridgedEndpointConfig> &bridgedConfigs);
+    void removeBridgedEndpoints(const std::vector<chip::EndpointId> &endpointIDs);
+
 private:
     Node* node;
     std::vector<EndpointInfo> endpointInfoList;
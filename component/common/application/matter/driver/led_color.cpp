@@ -0,0 +1,204 @@
+#include "led_color.h"
+
+// Level [0, 254] to duty, precomputed so no conversion divides or touches floats
+static const uint32_t kLevelDuty[255] =
+{
+#if MATTER_LED_GAMMA_CORRECTION
+    // round(65536 * (level / 254) ^ 2.2), raised where needed so every level is one step above the previous
+    0, 1, 2, 4, 7, 12, 17, 24, 33, 42, 53, 66,
+    79, 95, 112, 130, 150, 171, 194, 218, 244, 272, 301, 332,
+    365, 399, 435, 473, 512, 554, 596, 641, 687, 735, 785, 837,
+    891, 946, 1003, 1062, 1123, 1186, 1250, 1317, 1385, 1455, 1527, 1601,
+    1677, 1755, 1835, 1916, 2000, 2086, 2173, 2263, 2354, 2448, 2543, 2641,
+    2740, 2842, 2945, 3051, 3158, 3268, 3379, 3493, 3609, 3727, 3846, 3968,
+    4092, 4218, 4347, 4477, 4609, 4744, 4880, 5019, 5160, 5303, 5448, 5595,
+    5745, 5896, 6050, 6206, 6364, 6524, 6686, 6851, 7017, 7186, 7357, 7531,
+    7706, 7884, 8064, 8246, 8430, 8617, 8806, 8997, 9190, 9386, 9583, 9783,
+    9986, 10190, 10397, 10606, 10817, 11031, 11247, 11465, 11686, 11908, 12134, 12361,
+    12591, 12823, 13057, 13293, 13532, 13774, 14017, 14263, 14511, 14762, 15015, 15270,
+    15528, 15788, 16050, 16315, 16582, 16851, 17123, 17397, 17674, 17953, 18234, 18518,
+    18804, 19092, 19383, 19676, 19972, 20270, 20571, 20873, 21179, 21487, 21797, 22109,
+    22424, 22742, 23062, 23384, 23709, 24036, 24366, 24698, 25032, 25369, 25709, 26051,
+    26395, 26742, 27092, 27443, 27798, 28154, 28514, 28875, 29240, 29606, 29976, 30347,
+    30722, 31098, 31478, 31859, 32244, 32630, 33020, 33412, 33806, 34203, 34602, 35004,
+    35409, 35816, 36225, 36637, 37052, 37469, 37889, 38311, 38736, 39163, 39593, 40026,
+    40461, 40898, 41338, 41781, 42227, 42674, 43125, 43578, 44034, 44492, 44953, 45416,
+    45882, 46351, 46822, 47296, 47772, 48251, 48733, 49217, 49704, 50193, 50686, 51180,
+    51678, 52178, 52680, 53185, 53693, 54204, 54717, 55233, 55751, 56272, 56796, 57322,
+    57851, 58383, 58917, 59454, 59993, 60536, 61081, 61628, 62178, 62731, 63287, 63845,
+    64406, 64970, 65536,
+#else
+    // (level * 65536 + 127) / 254
+    0, 258, 516, 774, 1032, 1290, 1548, 1806, 2064, 2322, 2580, 2838,
+    3096, 3354, 3612, 3870, 4128, 4386, 4644, 4902, 5160, 5418, 5676, 5934,
+    6192, 6450, 6708, 6966, 7224, 7482, 7740, 7998, 8257, 8515, 8773, 9031,
+    9289, 9547, 9805, 10063, 10321, 10579, 10837, 11095, 11353, 11611, 11869, 12127,
+    12385, 12643, 12901, 13159, 13417, 13675, 13933, 14191, 14449, 14707, 14965, 15223,
+    15481, 15739, 15997, 16255, 16513, 16771, 17029, 17287, 17545, 17803, 18061, 18319,
+    18577, 18835, 19093, 19351, 19609, 19867, 20125, 20383, 20641, 20899, 21157, 21415,
+    21673, 21931, 22189, 22447, 22705, 22963, 23221, 23479, 23737, 23995, 24253, 24511,
+    24770, 25028, 25286, 25544, 25802, 26060, 26318, 26576, 26834, 27092, 27350, 27608,
+    27866, 28124, 28382, 28640, 28898, 29156, 29414, 29672, 29930, 30188, 30446, 30704,
+    30962, 31220, 31478, 31736, 31994, 32252, 32510, 32768, 33026, 33284, 33542, 33800,
+    34058, 34316, 34574, 34832, 35090, 35348, 35606, 35864, 36122, 36380, 36638, 36896,
+    37154, 37412, 37670, 37928, 38186, 38444, 38702, 38960, 39218, 39476, 39734, 39992,
+    40250, 40508, 40766, 41025, 41283, 41541, 41799, 42057, 42315, 42573, 42831, 43089,
+    43347, 43605, 43863, 44121, 44379, 44637, 44895, 45153, 45411, 45669, 45927, 46185,
+    46443, 46701, 46959, 47217, 47475, 47733, 47991, 48249, 48507, 48765, 49023, 49281,
+    49539, 49797, 50055, 50313, 50571, 50829, 51087, 51345, 51603, 51861, 52119, 52377,
+    52635, 52893, 53151, 53409, 53667, 53925, 54183, 54441, 54699, 54957, 55215, 55473,
+    55731, 55989, 56247, 56505, 56763, 57021, 57279, 57538, 57796, 58054, 58312, 58570,
+    58828, 59086, 59344, 59602, 59860, 60118, 60376, 60634, 60892, 61150, 61408, 61666,
+    61924, 62182, 62440, 62698, 62956, 63214, 63472, 63730, 63988, 64246, 64504, 64762,
+    65020, 65278, 65536,
+#endif
+};
+
+// White mix of RGBCW LEDs: color temperature and the share of cool white at it
+static const struct
+{
+    uint16_t colortemp;
+    uint32_t cool;
+} kWhiteMix[11] =
+{
+    {2708, 0},
+    {2891, 6554},
+    {3110, 13107},
+    {3364, 19661},
+    {3656, 26214},
+    {3992, 32768},
+    {4376, 39322},
+    {4809, 45875},
+    {5304, 52429},
+    {5853, 58982},
+    {6471, 65536},
+};
+
+void MatterLEDColor::SetColor(uint8_t hue, uint8_t saturation)
+{
+    if (hue > 254)
+        hue = 254;
+    if (saturation > 254)
+        saturation = 254;
+
+    // six sectors of the hue circle, in each one channel ramps while the others stay at 0 or full
+    uint32_t position = hue * 6;
+    uint32_t sector   = position / 254;
+    uint32_t ramp     = ((position - sector * 254) * kDutyMax + 127) / 254;
+
+    switch (sector)
+    {
+    case 0:
+        mRed = kDutyMax;
+        mGreen = ramp;
+        mBlue = 0;
+        break;
+    case 1:
+        mRed = kDutyMax - ramp;
+        mGreen = kDutyMax;
+        mBlue = 0;
+        break;
+    case 2:
+        mRed = 0;
+        mGreen = kDutyMax;
+        mBlue = ramp;
+        break;
+    case 3:
+        mRed = 0;
+        mGreen = kDutyMax - ramp;
+        mBlue = kDutyMax;
+        break;
+    case 4:
+        mRed = ramp;
+        mGreen = 0;
+        mBlue = kDutyMax;
+        break;
+    case 5:
+        mRed = kDutyMax;
+        mGreen = 0;
+        mBlue = kDutyMax - ramp;
+        break;
+    default:
+        // hue 254 closes the circle at red
+        mRed = kDutyMax;
+        mGreen = 0;
+        mBlue = 0;
+        break;
+    }
+
+    mSaturation = (saturation * kDutyMax + 127) / 254;
+}
+
+void MatterLEDColor::SetColorTemp(uint16_t colortemp)
+{
+    uint8_t i = 0;
+
+    if (colortemp <= kWhiteMix[0].colortemp)
+    {
+        mCoolWeight = kWhiteMix[0].cool;
+        return;
+    }
+
+    while (i < 10 && colortemp >= kWhiteMix[i + 1].colortemp)
+        i++;
+
+    if (i == 10)
+    {
+        mCoolWeight = kWhiteMix[10].cool;
+        return;
+    }
+
+    mCoolWeight = kWhiteMix[i].cool + (kWhiteMix[i + 1].cool - kWhiteMix[i].cool) * (colortemp - kWhiteMix[i].colortemp) /
+        (kWhiteMix[i + 1].colortemp - kWhiteMix[i].colortemp);
+}
+
+void MatterLEDColor::Convert(uint8_t level, bool white, MatterLEDChannels & channels) const
+{
+    ConvertDuty(LevelDuty(level), white, channels);
+}
+
+void MatterLEDColor::ConvertDuty(uint32_t value, bool white, MatterLEDChannels & channels) const
+{
+    // the weakest channel of a color, it is what desaturation adds to all three
+    uint32_t base  = value - (uint32_t) (((uint64_t) value * mSaturation) >> 16);
+    uint32_t span  = value - base;
+
+    channels.red   = base + (uint32_t) (((uint64_t) span * mRed) >> 16);
+    channels.green = base + (uint32_t) (((uint64_t) span * mGreen) >> 16);
+    channels.blue  = base + (uint32_t) (((uint64_t) span * mBlue) >> 16);
+
+    if (!white)
+    {
+        channels.cwhite = 0;
+        channels.wwhite = 0;
+        return;
+    }
+
+    // white LEDs take over the common part of the three color channels
+    channels.red -= base;
+    channels.green -= base;
+    channels.blue -= base;
+    channels.cwhite = (uint32_t) (((uint64_t) base * mCoolWeight) >> 16);
+    channels.wwhite = base - channels.cwhite;
+}
+
+uint32_t MatterLEDColor::LevelDuty(uint8_t level)
+{
+    return kLevelDuty[(level > 254) ? 254 : level];
+}
+
+uint32_t MatterLEDColor::LevelDutyFine(uint32_t level_q8)
+{
+    uint32_t level = level_q8 >> 8;
+    uint32_t frac  = level_q8 & 0xFF;
+
+    if (level >= 254)
+        return kLevelDuty[254];
+
+    return kLevelDuty[level] + (((kLevelDuty[level + 1] - kLevelDuty[level]) * frac + 128) >> 8);
+}
+
+uint32_t MatterLEDColor::PulseWidth(uint32_t duty, uint32_t period_us)
+{
+    return (uint32_t) (((uint64_t) duty * period_us + (kDutyMax >> 1)) >> 16);
+}
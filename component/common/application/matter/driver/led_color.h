@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+// Set to 1 to map levels through a 2.2 gamma curve instead of linearly
+#ifndef MATTER_LED_GAMMA_CORRECTION
+#define MATTER_LED_GAMMA_CORRECTION 0
+#endif
+
+// Channel duties in Q16, 0 is off and kDutyMax fully on
+struct MatterLEDChannels
+{
+    uint32_t red;
+    uint32_t green;
+    uint32_t blue;
+    uint32_t cwhite;
+    uint32_t wwhite;
+};
+
+// Integer only color pipeline of MatterLED, every build gives bit-identical output for the same input
+class MatterLEDColor
+{
+public:
+    static const uint32_t kDutyMax = 65536;
+
+    void SetColor(uint8_t hue, uint8_t saturation);     // Matter units [0, 254]
+    void SetColorTemp(uint16_t colortemp);               // Kelvin, interpolated between the white mix table rows
+    void Convert(uint8_t level, bool white, MatterLEDChannels & channels) const;
+    void ConvertDuty(uint32_t value, bool white, MatterLEDChannels & channels) const;    // value is a duty from LevelDuty*
+    static uint32_t LevelDuty(uint8_t level);
+    static uint32_t LevelDutyFine(uint32_t level_q8);    // level in 1/256 steps, interpolated between table entries
+    static uint32_t PulseWidth(uint32_t duty, uint32_t period_us);
+
+private:
+    uint32_t mRed = kDutyMax;       // channel weights of the hue at full saturation
+    uint32_t mGreen = 0;
+    uint32_t mBlue = 0;
+    uint32_t mSaturation = 0;
+    uint32_t mCoolWeight = 0;       // share of white given to the cool white channel
+};
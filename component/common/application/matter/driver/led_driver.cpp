@@ -1,6 +1,5 @@
 #include "led_driver.h"
 #include <support/logging/CHIPLogging.h>
-#include <algorithm>
 
 // normal LED
 void MatterLED::Init(PinName pin)
@@ -8,7 +7,7 @@ void MatterLED::Init(PinName pin)
     mPwm_obj                        = (pwmout_t*) pvPortMalloc(sizeof(pwmout_t));
 
     pwmout_init(mPwm_obj, pin);
-    pwmout_period_us(mPwm_obj, 20000); //pwm period = 20ms
+    pwmout_period_us(mPwm_obj, kPwmPeriodUs); //pwm period = 20ms
     pwmout_start(mPwm_obj);
 
     mRgb                            = false;
@@ -16,6 +15,8 @@ void MatterLED::Init(PinName pin)
     mBrightness                     = 254;
     mHue                            = 0;
     mSaturation                     = 0;
+    mLock                           = xSemaphoreCreateMutex();
+    InitTransition();
 }
 
 // RGB LED
@@ -26,15 +27,15 @@ void MatterLED::Init(PinName redpin, PinName greenpin, PinName bluepin)
     mPwm_blue                       = (pwmout_t*) pvPortMalloc(sizeof(pwmout_t));
 
     pwmout_init(mPwm_red, redpin);
-    pwmout_period_us(mPwm_red, 20000); //pwm period = 20ms
+    pwmout_period_us(mPwm_red, kPwmPeriodUs); //pwm period = 20ms
     pwmout_start(mPwm_red);
 
     pwmout_init(mPwm_green, bluepin);
-    pwmout_period_us(mPwm_green, 20000); //pwm period = 20ms
+    pwmout_period_us(mPwm_green, kPwmPeriodUs); //pwm period = 20ms
     pwmout_start(mPwm_green);
 
     pwmout_init(mPwm_blue, greenpin);
-    pwmout_period_us(mPwm_blue, 20000); //pwm period = 20ms
+    pwmout_period_us(mPwm_blue, kPwmPeriodUs); //pwm period = 20ms
     pwmout_start(mPwm_blue);
 
     mRgb                            = true;
@@ -43,6 +44,8 @@ void MatterLED::Init(PinName redpin, PinName greenpin, PinName bluepin)
     mBrightness                     = 254;
     mHue                            = 0;
     mSaturation                     = 0;
+    mLock                           = xSemaphoreCreateMutex();
+    InitTransition();
 }
 
 // RGBCW LED
@@ -55,23 +58,23 @@ void MatterLED::Init(PinName redpin, PinName greenpin, PinName bluepin, PinName
     mPwm_wwhite                     = (pwmout_t*) pvPortMalloc(sizeof(pwmout_t));
 
     pwmout_init(mPwm_red, redpin);
-    pwmout_period_us(mPwm_red, 20000); //pwm period = 20ms
+    pwmout_period_us(mPwm_red, kPwmPeriodUs); //pwm period = 20ms
     pwmout_start(mPwm_red);
 
     pwmout_init(mPwm_green, bluepin);
-    pwmout_period_us(mPwm_green, 20000); //pwm period = 20ms
+    pwmout_period_us(mPwm_green, kPwmPeriodUs); //pwm period = 20ms
     pwmout_start(mPwm_green);
 
     pwmout_init(mPwm_blue, greenpin);
-    pwmout_period_us(mPwm_blue, 20000); //pwm period = 20ms
+    pwmout_period_us(mPwm_blue, kPwmPeriodUs); //pwm period = 20ms
     pwmout_start(mPwm_blue);
 
     pwmout_init(mPwm_cwhite, cwhitepin);
-    pwmout_period_us(mPwm_cwhite, 20000); //pwm period = 20ms
+    pwmout_period_us(mPwm_cwhite, kPwmPeriodUs); //pwm period = 20ms
     pwmout_start(mPwm_cwhite);
 
     pwmout_init(mPwm_wwhite, wwhitepin);
-    pwmout_period_us(mPwm_wwhite, 20000); //pwm period = 20ms
+    pwmout_period_us(mPwm_wwhite, kPwmPeriodUs); //pwm period = 20ms
     pwmout_start(mPwm_wwhite);
 
     mRgb                            = true;
@@ -80,10 +83,26 @@ void MatterLED::Init(PinName redpin, PinName greenpin, PinName bluepin, PinName
     mBrightness                     = 254;
     mHue                            = 0;
     mSaturation                     = 0;
+    mLock                           = xSemaphoreCreateMutex();
+    InitTransition();
 }
 
 void MatterLED::deInit(void)
 {
+    if (mTransitionTask != NULL)
+    {
+        Lock();
+        mTransition.active = false;
+        vTaskDelete(mTransitionTask);
+        mTransitionTask = NULL;
+        Unlock();
+    }
+    if (mLock != NULL)
+    {
+        vSemaphoreDelete(mLock);
+        mLock = NULL;
+    }
+
     if (mRgb)
     {
         vPortFree(mPwm_red);
@@ -128,100 +147,72 @@ void MatterLED::Toggle()
 
 void MatterLED::SetBrightness(uint8_t brightness)
 {
+    Lock();
+    FinishTransition();
     mBrightness = brightness;
+    mFrame.level = brightness << 8;
 
     DoSet();
+    Unlock();
 }
 
 void MatterLED::DoSet()
 {
-    uint8_t brightness = mState ? mBrightness : 0;
+    uint32_t value = mState ? MatterLEDColor::LevelDutyFine(mFrame.level) : 0;
 
     if (!mRgb)
     {
-        float duty_cycle = (float) (brightness) / 254;
-        pwmout_write(mPwm_obj, duty_cycle);
+        WritePulse(mPwm_obj, mPulse[0], value);
     }
     else
     {
-        uint8_t red, green, blue, coolwhite, warmwhite;
-        float duty_red, duty_green, duty_blue, duty_cwhite, duty_wwhite;
-        // uint8_t brightness = mState ? mBrightness : 0;
+        MatterLEDChannels channels;
 
-        HSB2rgb(mHue, mSaturation, brightness, red, green, blue);
+        // every channel is computed before the first one changes, then all are written back to back
+        mColor.ConvertDuty(value, mRgbw, channels);
 
         if (mRgbw)
         {
-            simpleRGB2RGBW(red, green, blue, coolwhite, warmwhite);
-            duty_cwhite = static_cast<float> (coolwhite) / 254.0;
-            duty_wwhite = static_cast<float> (warmwhite) / 254.0;
+            WritePulse(mPwm_cwhite, mPulse[3], channels.cwhite);
+            WritePulse(mPwm_wwhite, mPulse[4], channels.wwhite);
         }
 
-        duty_red = static_cast<float>(red) / 254.0;
-        duty_green = static_cast<float>(green) / 254.0;
-        duty_blue = static_cast<float>(blue) / 254.0;
+        WritePulse(mPwm_red, mPulse[0], channels.red);
+        WritePulse(mPwm_blue, mPulse[2], channels.blue);
+        WritePulse(mPwm_green, mPulse[1], channels.green);
+    }
+}
 
-        // ChipLogProgress(DeviceLayer, "brightness: %d", brightness);
-        // ChipLogProgress(DeviceLayer, "red: %d, red_duty: %f", red, duty_red);
-        // ChipLogProgress(DeviceLayer, "green: %d, green_duty: %f", green, duty_green);
-        // ChipLogProgress(DeviceLayer, "blue: %d, blue_duty: %f", blue, duty_blue);
+// channels whose pulse width did not change are left alone
+void MatterLED::WritePulse(pwmout_t *pwm, uint32_t & pulse, uint32_t duty)
+{
+    uint32_t width = MatterLEDColor::PulseWidth(duty, kPwmPeriodUs);
 
-        if (mRgbw)
-        {
-            // ChipLogProgress(DeviceLayer, "cwhite: %d, cwhite_duty: %f", coolwhite, duty_cwhite);
-            // ChipLogProgress(DeviceLayer, "wwhite: %d, wwhite_duty: %f", warmwhite, duty_wwhite);
-            pwmout_write(mPwm_cwhite, duty_cwhite);
-            pwmout_write(mPwm_wwhite, duty_wwhite);
-        }
+    if (width == pulse)
+        return;
 
-        pwmout_write(mPwm_red, duty_red);
-        pwmout_write(mPwm_blue, duty_blue);
-        pwmout_write(mPwm_green, duty_green);
-    
-    }
+    pulse = width;
+    pwmout_pulsewidth_us(pwm, width);
 }
 
-// Below functions are WIP
 void MatterLED::SetColor(uint8_t Hue, uint8_t Saturation)
 {
+    Lock();
+    FinishTransition();
+    mHue        = Hue;
+    mSaturation = Saturation;
+    mFrame.hue        = Hue;
+    mFrame.saturation = Saturation;
+    mColor.SetColor(Hue, Saturation);
+
     if (mRgb)
     {
-        uint8_t red, green, blue, coolwhite, warmwhite;
-        float duty_red, duty_green, duty_blue, duty_cwhite, duty_wwhite;
-        uint8_t brightness = mState ? mBrightness : 0;
-        mHue               = static_cast<uint16_t>(Hue) * 360 / 254;        // mHue [0, 360]
-        mSaturation        = static_cast<uint16_t>(Saturation) * 100 / 254; // mSaturation [0 , 100]
-
-        HSB2rgb(mHue, mSaturation, brightness, red, green, blue);
-
-        if (mRgbw)
-        {
-            simpleRGB2RGBW(red, green, blue, coolwhite, warmwhite);
-            duty_cwhite = static_cast<float> (coolwhite) / 254.0;
-            duty_wwhite = static_cast<float> (warmwhite) / 254.0;
-        }
-
-        duty_red = static_cast<float>(red) / 254.0;
-        duty_green = static_cast<float>(green) / 254.0;
-        duty_blue = static_cast<float>(blue) / 254.0;
-
-        ChipLogProgress(DeviceLayer, "brightness: %d", brightness);
-        ChipLogProgress(DeviceLayer, "red: %d, red_duty: %f", red, duty_red);
-        ChipLogProgress(DeviceLayer, "green: %d, green_duty: %f", green, duty_green);
-        ChipLogProgress(DeviceLayer, "blue: %d, blue_duty: %f", blue, duty_blue);
-
-        if (mRgbw)
-        {
-            ChipLogProgress(DeviceLayer, "cwhite: %d, cwhite_duty: %f", coolwhite, duty_cwhite);
-            ChipLogProgress(DeviceLayer, "wwhite: %d, wwhite_duty: %f\r\n", warmwhite, duty_wwhite);
-            pwmout_write(mPwm_cwhite, duty_cwhite);
-            pwmout_write(mPwm_wwhite, duty_wwhite);
-        }
-
-        pwmout_write(mPwm_red, duty_red);
-        pwmout_write(mPwm_blue, duty_blue);
-        pwmout_write(mPwm_green, duty_green);
+        DoSet();
+        ChipLogDetail(DeviceLayer, "LED hue %d saturation %d level %d: pulse r %d g %d b %d cw %d ww %d us", mHue, mSaturation,
+                      mState ? mBrightness : 0, static_cast<int>(mPulse[0]), static_cast<int>(mPulse[1]), static_cast<int>(mPulse[2]),
+                      mRgbw ? static_cast<int>(mPulse[3]) : 0, mRgbw ? static_cast<int>(mPulse[4]) : 0);
     }
+    Unlock();
 }
 
 void MatterLED::SetColorTemp(uint16_t colortemp)
@@ -232,78 +223,246 @@ void MatterLED::SetColorTemp(uint16_t colortemp)
     else
         mColorTemp = 0;
 #endif
+    Lock();
+    FinishTransition();
     mColorTemp = colortemp;
+    mFrame.colortemp = colortemp;
+    mColor.SetColorTemp(mColorTemp);
     ChipLogProgress(DeviceLayer, "Color Temperature changed to %d", mColorTemp);
     // SetBrightness(mBrightness);
     DoSet();
+    Unlock();
 }
 
-void MatterLED::HSB2rgb(uint16_t Hue, uint8_t Saturation, uint8_t brightness, uint8_t & red, uint8_t & green, uint8_t & blue)
+// progress and result in Q16, 65536 is the end of the transition
+static uint32_t matter_led_ease(MatterLEDEasing easing, uint32_t t)
 {
-    uint16_t i       = Hue / 60;
-    uint16_t rgb_max = brightness;
-    uint16_t rgb_min = rgb_max * (100 - Saturation) / 100;
-    uint16_t diff    = Hue % 60;
-    uint16_t rgb_adj = (rgb_max - rgb_min) * diff / 60;
+    uint32_t u = 65536 - t;
 
-    switch (i)
+    switch (easing)
     {
-    case 0:
-        red   = rgb_max;
-        green = rgb_min + rgb_adj;
-        blue  = rgb_min;
-        break;
-    case 1:
-        red   = rgb_max - rgb_adj;
-        green = rgb_max;
-        blue  = rgb_min;
-        break;
-    case 2:
-        red   = rgb_min;
-        green = rgb_max;
-        blue  = rgb_min + rgb_adj;
-        break;
-    case 3:
-        red   = rgb_min;
-        green = rgb_max - rgb_adj;
-        blue  = rgb_max;
-        break;
-    case 4:
-        red   = rgb_min + rgb_adj;
-        green = rgb_min;
-        blue  = rgb_max;
-        break;
+    case MATTER_LED_EASE_IN:
+        return (uint32_t) (((uint64_t) t * t) >> 16);
+    case MATTER_LED_EASE_OUT:
+        return 65536 - (uint32_t) (((uint64_t) u * u) >> 16);
+    case MATTER_LED_EASE_IN_OUT:
+        // smoothstep, 3t^2 - 2t^3
+        return (uint32_t) (((uint64_t) t * t * (3 * 65536 - 2 * t)) >> 32);
     default:
-        red   = rgb_max;
-        green = rgb_min;
-        blue  = rgb_max - rgb_adj;
-        break;
+        return t;
     }
 }
 
-void MatterLED:: simpleRGB2RGBW(uint8_t & red, uint8_t & green, uint8_t & blue, uint8_t & cwhite, uint8_t & wwhite)
+static int32_t matter_led_lerp(int32_t from, int32_t to, uint32_t progress)
+{
+    return from + (int32_t) (((int64_t) (to - from) * progress) >> 16);
+}
+
+void MatterLED::Lock(void)
 {
-    uint8_t white = std::min({red, green, blue});    
+    if (mLock != NULL)
+        xSemaphoreTake(mLock, portMAX_DELAY);
+}
 
-    // Original color channel minus the contribution of white channel
-    red -= white;
-    green -= white;
-    blue -= white;
+void MatterLED::Unlock(void)
+{
+    if (mLock != NULL)
+        xSemaphoreGive(mLock);
+}
 
-    uint16_t colortemp;
-    uint8_t i = 0;
+// the task is created with the LED, before any caller can start a transition
+void MatterLED::InitTransition(void)
+{
+    if (mLock == NULL || mTransitionTask != NULL)
+        return;
 
-    while(i < 11)
+    if (xTaskCreate(TransitionTask, "matter_led_transition", 1024, this, tskIDLE_PRIORITY + 1, &mTransitionTask) != pdPASS)
     {
-        colortemp = WhitePercentage[i][0];
-        if (mColorTemp < colortemp)
-            break;
-        i++;
+        ChipLogError(DeviceLayer, "Failed to create LED transition task, transitions jump to their target");
+        mTransitionTask = NULL;
     }
+}
 
-    if (i != 0)
-        i -= 1;
+void MatterLED::StartTransition(const MatterLEDTarget & target, uint32_t duration_ms, MatterLEDEasing easing,
+                                MatterLEDTransitionCallback callback, void * context)
+{
+    int16_t delta;
+
+    if (mLock == NULL)
+        return;
+
+    Lock();
+    if (mTransitionTask == NULL)
+        duration_ms = 0;
+
+    // fields still moving in a running transition carry on from where they are, over the new duration
+    mTransition.mask = target.mask | (mTransition.active ? mTransition.mask : 0);
+    mTransition.level = mFrame.level;
+    mTransition.hue = mFrame.hue;
+    mTransition.saturation = mFrame.saturation;
+    mTransition.colortemp = mFrame.colortemp;
+
+    if (target.mask & MatterLEDTarget::kLevel)
+        mBrightness = target.level;
+    if (target.mask & MatterLEDTarget::kHue)
+        mHue = target.hue;
+    if (target.mask & MatterLEDTarget::kSaturation)
+        mSaturation = target.saturation;
+    if (target.mask & MatterLEDTarget::kColorTemp)
+        mColorTemp = target.colortemp;
+
+    // hue 254 is hue 0 again
+    delta = (int16_t) (mHue % 254) - (int16_t) (mFrame.hue % 254);
+    if (delta > 127)
+        delta -= 254;
+    else if (delta < -127)
+        delta += 254;
+    mTransition.hueDelta = delta;
+
+    mTransition.easing = easing;
+    mTransition.callback = callback;
+    mTransition.context = context;
+    mTransition.duration = duration_ms;
+    mTransition.start = xTaskGetTickCount();
+    mTransition.active = true;
+    Unlock();
+
+    if (mTransitionTask != NULL)
+        xTaskNotifyGive(mTransitionTask);
+    else
+        TransitionFrame();
+}
+
+// the output stays where the transition got to, and becomes the state reported
+void MatterLED::StopTransition(void)
+{
+    Lock();
+    if (mTransition.active)
+    {
+        mTransition.active = false;
+        mFrame.level = (mFrame.level + 128) & ~0xFFu;
+        mBrightness = mFrame.level >> 8;
+        mHue = mFrame.hue;
+        mSaturation = mFrame.saturation;
+        if (mTransition.mask & MatterLEDTarget::kColorTemp)
+            mColorTemp = mFrame.colortemp;
+        DoSet();
+    }
+    Unlock();
+}
 
-    cwhite = white * WhitePercentage[i][1] / 100;
-    wwhite = white * WhitePercentage[i][2] / 100;
+bool MatterLED::IsTransitioning(void)
+{
+    return mTransition.active;
+}
+
+void MatterLED::GlideBrightness(uint8_t brightness)
+{
+    TickType_t now = xTaskGetTickCount();
+    uint32_t since = (now - mGlideTick) * portTICK_PERIOD_MS;
+    MatterLEDTarget target = { MatterLEDTarget::kLevel, brightness, 0, 0, 0 };
+
+    mGlideTick = now;
+    if (since >= kGlideMaxMs)
+    {
+        mGlideMs = 0;
+        SetBrightness(brightness);
+        return;
+    }
+
+    // steps of one transition come at a steady pace, the glide ends when the next step should land rather than
+    // stretching the last gap, a late or early step only nudges the pace
+    mGlideMs = mGlideMs ? (3 * mGlideMs + since) / 4 : since;
+    StartTransition(target, mGlideMs, MATTER_LED_EASE_LINEAR);
+}
+
+// jumps a running transition to its target, the caller holds the lock and writes the output
+void MatterLED::FinishTransition(void)
+{
+    if (!mTransition.active)
+        return;
+
+    mTransition.active = false;
+    if (mTransition.mask & MatterLEDTarget::kLevel)
+        mFrame.level = mBrightness << 8;
+    if (mTransition.mask & (MatterLEDTarget::kHue | MatterLEDTarget::kSaturation))
+    {
+        mFrame.hue = mHue;
+        mFrame.saturation = mSaturation;
+        mColor.SetColor(mHue, mSaturation);
+    }
+    if (mTransition.mask & MatterLEDTarget::kColorTemp)
+    {
+        mFrame.colortemp = mColorTemp;
+        mColor.SetColorTemp(mColorTemp);
+    }
+}
+
+// writes one frame, returns false once the transition has ended
+bool MatterLED::TransitionFrame(void)
+{
+    MatterLEDTransitionCallback callback = NULL;
+    void * context = NULL;
+    uint32_t elapsed;
+    uint32_t progress;
+    int32_t hue;
+
+    Lock();
+    if (!mTransition.active)
+    {
+        Unlock();
+        return false;
+    }
+
+    elapsed = (xTaskGetTickCount() - mTransition.start) * portTICK_PERIOD_MS;
+    if (elapsed >= mTransition.duration)
+    {
+        callback = mTransition.callback;
+        context = mTransition.context;
+        FinishTransition();
+    }
+    else
+    {
+        progress = matter_led_ease(mTransition.easing, (uint32_t) (((uint64_t) elapsed << 16) / mTransition.duration));
+
+        if (mTransition.mask & MatterLEDTarget::kLevel)
+            mFrame.level = matter_led_lerp(mTransition.level, mBrightness << 8, progress);
+        if (mTransition.mask & (MatterLEDTarget::kHue | MatterLEDTarget::kSaturation))
+        {
+            hue = matter_led_lerp(mTransition.hue % 254, (mTransition.hue % 254) + mTransition.hueDelta, progress);
+            mFrame.hue = (hue + 254) % 254;
+            mFrame.saturation = matter_led_lerp(mTransition.saturation, mSaturation, progress);
+            mColor.SetColor(mFrame.hue, mFrame.saturation);
+        }
+        if (mTransition.mask & MatterLEDTarget::kColorTemp)
+        {
+            mFrame.colortemp = matter_led_lerp(mTransition.colortemp, mColorTemp, progress);
+            mColor.SetColorTemp(mFrame.colortemp);
+        }
+    }
+
+    DoSet();
+    Unlock();
+
+    // a transition replaced or ended by a setter before its end never reports
+    if (callback != NULL)
+        callback(*this, context);
+
+    return mTransition.active;
+}
+
+void MatterLED::TransitionTask(void *param)
+{
+    MatterLED *led = static_cast<MatterLED *>(param);
+    TickType_t wake;
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // frames are paced from when they were due, a late frame does not push back the ones after it
+        wake = xTaskGetTickCount();
+        while (led->TransitionFrame())
+            vTaskDelayUntil(&wake, pdMS_TO_TICKS(kFrameMs));
+    }
 }
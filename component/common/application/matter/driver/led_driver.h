@@ -2,6 +2,39 @@
 
 #include <platform_stdlib.h>
 #include "pwmout_api.h"
+#include "led_color.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+class MatterLED;
+
+// Easing curves of a MatterLED transition
+enum MatterLEDEasing
+{
+    MATTER_LED_EASE_LINEAR = 0,
+    MATTER_LED_EASE_IN,         // starts slow
+    MATTER_LED_EASE_OUT,        // ends slow
+    MATTER_LED_EASE_IN_OUT,     // starts and ends slow
+};
+
+// Target of a MatterLED transition, fields not set in mask keep their current value
+struct MatterLEDTarget
+{
+    static const uint8_t kLevel      = 0x01;
+    static const uint8_t kHue        = 0x02;
+    static const uint8_t kSaturation = 0x04;
+    static const uint8_t kColorTemp  = 0x08;
+
+    uint8_t mask;
+    uint8_t level;          // [0, 254]
+    uint8_t hue;            // [0, 254]
+    uint8_t saturation;     // [0, 254]
+    uint16_t colortemp;     // Kelvin
+};
+
+// Called once a transition has reached its target, from the transition task
+typedef void (*MatterLEDTransitionCallback)(MatterLED & led, void * context);
 
 class MatterLED
 {
@@ -17,11 +50,19 @@ public:
     void SetBrightness(uint8_t brightness);
     void SetColor(uint8_t Hue, uint8_t Saturation);
     void SetColorTemp(uint16_t colortemp);
-    void HSB2rgb(uint16_t Hue, uint8_t Saturation, uint8_t brightness, uint8_t & red, uint8_t & green, uint8_t & blue);
-    void simpleRGB2RGBW(uint8_t & red, uint8_t & green, uint8_t & blue, uint8_t & cwhite, uint8_t & wwhite);
+    // Fades to target over duration_ms, one frame per PWM period. A new transition starts from wherever the running one
+    // is, SetBrightness, SetColor and SetColorTemp end it at its target. mBrightness, mHue, mSaturation and mColorTemp
+    // hold the target while the output moves, and callback is only called with the final state.
+    void StartTransition(const MatterLEDTarget & target, uint32_t duration_ms, MatterLEDEasing easing = MATTER_LED_EASE_IN_OUT,
+                         MatterLEDTransitionCallback callback = NULL, void * context = NULL);
+    void StopTransition(void);
+    bool IsTransitioning(void);
+    // Sets the level from a stream of updates, such as the CurrentLevel steps of a level transition. Updates closer
+    // together than kGlideMaxMs glide linearly over the interval the next one is expected after, others are set at once.
+    void GlideBrightness(uint8_t brightness);
     uint8_t mBrightness;
-    uint16_t mHue;       // mHue [0, 360]
-    uint8_t mSaturation; // mSaturation [0, 100]
+    uint8_t mHue;        // mHue [0, 254]
+    uint8_t mSaturation; // mSaturation [0, 254]
     uint16_t mColorTemp;
 
 private:
@@ -35,22 +76,46 @@ private:
     bool mRgbw = false;
     bool mState;
     void DoSet();
-    uint16_t WhitePercentage[11][3] = 
+    void WritePulse(pwmout_t *pwm, uint32_t & pulse, uint32_t duty);
+    void Lock(void);
+    void Unlock(void);
+    void InitTransition(void);
+    void FinishTransition(void);
+    bool TransitionFrame(void);
+    static void TransitionTask(void *param);
+    static const uint32_t kPwmPeriodUs = 20000;
+    static const uint32_t kFrameMs = kPwmPeriodUs / 1000;
+    static const uint32_t kGlideMaxMs = 250;
+    MatterLEDColor mColor;
+    // what the output shows, it trails the targets during a transition
+    struct
     {
-        /*CT--coolwhite%--warmwhite%*/
-        {2708, 0, 100},
-        {2891, 10, 90},
-        {3110, 20, 80},
-        {3364, 30, 70},
-        {3656, 40, 60},
-        {3992, 50, 50},
-        {4376, 60, 40},
-        {4809, 70, 30},
-        {5304, 80, 20},
-        {5853, 90, 10},
-        {6471, 100, 0}
-    };
-
+        uint32_t level;     // [0, 254] in 1/256 steps
+        uint8_t hue;
+        uint8_t saturation;
+        uint16_t colortemp;
+    } mFrame = {254 << 8, 0, 0, 0};
+    struct
+    {
+        bool active;
+        MatterLEDEasing easing;
+        uint8_t mask;
+        TickType_t start;
+        uint32_t duration;
+        uint32_t level;     // start of the fade, in the units of mFrame
+        uint8_t hue;
+        int16_t hueDelta;   // the shorter way around the hue circle
+        uint8_t saturation;
+        uint16_t colortemp;
+        MatterLEDTransitionCallback callback;
+        void * context;
+    } mTransition = {};
+    SemaphoreHandle_t mLock = NULL;
+    TaskHandle_t mTransitionTask = NULL;
+    TickType_t mGlideTick = 0;      // when GlideBrightness was last called
+    uint32_t mGlideMs = 0;          // pace of its updates, 0 before the second update of a stream
+    // pulse widths last written, in the order red, green, blue, cool white, warm white (mono LED uses the first)
+    uint32_t mPulse[5] = {UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX};
 };
 // #define PWM_LED                     PA_23
 // #define GREEN_LED_GPIO_NUM          PA_19
@@ -68,9 +68,10 @@ static void example_matter_bridge_task(void *pvParameters)
 
     bridge.Init(node);
 
-    EndpointConfig bridgedonoffEndpointConfig;
-    Presets::Endpoints::matter_dimmable_light_preset(&bridgedonoffEndpointConfig);
-    bridge.addBridgedEndpoint(bridgedonoffEndpointConfig, Span<const EmberAfDeviceType>(gBridgedOnOffDeviceTypes));
+    bridge.addBridgedEndpoint(Presets::Tables::matter_dimmable_light_preset, Span<const EmberAfDeviceType>(gBridgedOnOffDeviceTypes));
+
+    // Report data model heap usage
+    node.printMemoryUsage();
 
     if(xTaskCreate(matter_customer_bridge_code, ((const char*)"matter_customer_bridge_code"), 1024, NULL, tskIDLE_PRIORITY + 1, NULL) != pdPASS)
         printf("\n\r%s xTaskCreate(matter_customer_bridge_code) failed\n", __FUNCTION__);
@@ -130,7 +130,8 @@ void matter_driver_uplink_update_handler(AppEvent *aEvent)
     case Clusters::LevelControl::Id:
         if(path.mAttributeId == Clusters::LevelControl::Attributes::CurrentLevel::Id)
         {
-            led.SetBrightness(aEvent->value._u8);
+            // steps of a level transition glide into each other
+            led.GlideBrightness(aEvent->value._u8);
         }
         break;
     case Clusters::Identify::Id:
@@ -66,18 +66,16 @@ static void example_matter_light_task(void *pvParameters)
     if (err != CHIP_NO_ERROR)
         ChipLogProgress(DeviceLayer, "matter_driver_led_init failed!\n");
     
-    EndpointConfig rootNodeEndpointConfig;
-    EndpointConfig dimmableLightEndpointConfig;
-    Presets::Endpoints::matter_root_node_preset(&rootNodeEndpointConfig);
-    Presets::Endpoints::matter_dimmable_light_preset(&dimmableLightEndpointConfig);
-
-    // Initial, root node on ep0, dimmable light on ep1
-    node.addEndpoint(rootNodeEndpointConfig, Span<const EmberAfDeviceType>(rootNodeDeviceTypes));
-    node.addEndpoint(dimmableLightEndpointConfig, Span<const EmberAfDeviceType>(dimmableLightDeviceTypes));
+    // Initial, root node on ep0, dimmable light on ep1, built from the static preset tables
+    node.addEndpoint(Presets::Tables::matter_root_node_preset, Span<const EmberAfDeviceType>(rootNodeDeviceTypes));
+    node.addEndpoint(Presets::Tables::matter_dimmable_light_preset, Span<const EmberAfDeviceType>(dimmableLightDeviceTypes));
 
     // Enable endpoints
     node.enableAllEndpoints();
 
+    // Report data model heap usage
+    node.printMemoryUsage();
+
     err = matter_driver_led_set_startup_value();
     if (err != CHIP_NO_ERROR)
         ChipLogProgress(DeviceLayer, "matter_driver_led_set_startup_value failed!\n");
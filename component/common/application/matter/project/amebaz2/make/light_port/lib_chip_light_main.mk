@@ -235,6 +235,7 @@ ifeq ($(CHIP_ENABLE_OTA_REQUESTOR), true)
 SRC_CPP += $(SDKROOTDIR)/component/common/application/matter/core/matter_ota_initializer.cpp
 endif
 SRC_CPP += $(SDKROOTDIR)/component/common/application/matter/driver/led_driver.cpp
+SRC_CPP += $(SDKROOTDIR)/component/common/application/matter/driver/led_color.cpp
 SRC_CPP += $(SDKROOTDIR)/component/common/application/matter/example/light/example_matter_light.cpp
 SRC_CPP += $(SDKROOTDIR)/component/common/application/matter/example/light/matter_drivers.cpp
 
@@ -13,6 +13,11 @@
 
 #include <osif.h>
 #include "bt_board.h"
+#if defined(configUSE_HEAP_TRACE) && (configUSE_HEAP_TRACE == 1)
+#include "freertos_heap_rtk.h"
+#else
+#define heapTRACE_TAGGED(tag, call) do { call; } while (0)
+#endif
 #if   defined ( __CC_ARM )
 #include "cmsis_armcc.h"
 /*
@@ -940,7 +945,10 @@ bool osif_msg_peek(void *p_handle, void *p_msg, uint32_t wait_ms)
 void *osif_mem_alloc(RAM_TYPE ram_type, size_t size)
 {
     (void) ram_type;
-    return pvPortMalloc(size);
+    void *p;
+
+    heapTRACE_TAGGED(heapTAG_BT, p = pvPortMalloc(size));
+    return p;
 }
 
 /****************************************************************************/
@@ -957,7 +965,7 @@ void *osif_mem_aligned_alloc(RAM_TYPE ram_type, size_t size, uint8_t alignment)
         alignment = portBYTE_ALIGNMENT;
     }
 
-    p = pvPortMalloc(size + sizeof(void *) + alignment);
+    heapTRACE_TAGGED(heapTAG_BT, p = pvPortMalloc(size + sizeof(void *) + alignment));
     if (p == NULL)
     {
         printf("%s fail!(p == NULL)\r\n", __FUNCTION__);
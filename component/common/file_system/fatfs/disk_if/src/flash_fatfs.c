@@ -9,6 +9,7 @@
 #include "integer.h"
 #include "stdint.h"
 #include "stdio.h"
+#include "string.h"
 #include <disk_if/inc/flash_fatfs.h>
 #include "device_lock.h"
 #include "platform_opts.h"
@@ -21,9 +22,47 @@
 
 #include "flash_api.h" // Flash interface
 
+/*
+ * Flash translation layer
+ *
+ * FatFs sectors are grouped in logical blocks that fill one flash erase unit each. A logical block
+ * is never rewritten in place: it goes to the free erase unit erased the fewest times, and a header
+ * written after its data makes the new copy valid. At mount the copy with the highest sequence
+ * number wins, so a write cut by a power loss leaves the previous copy in use.
+ *
+ * Sector writes collect in a small RAM cache of logical blocks and reach flash when a cache line
+ * is reused or at CTRL_SYNC (f_sync, f_close, f_unmount), so FAT and directory sectors updated
+ * many times between two syncs cost one erase.
+ *
+ * A volume formatted by the previous driver, one FatFs sector at the start of each erase unit, has
+ * no translation layer metadata. It is recognised by its boot sector at mount and kept in that
+ * layout, sectors are rewritten in place, so existing data is neither lost nor reformatted. Every
+ * erase unit holds one of its sectors, so it cannot be converted in place without a window in
+ * which a power loss destroys a sector; erasing the area turns the disk over to the translation
+ * layer at the next f_mkfs.
+ */
 #define FLASH_BLOCK_SIZE	512		// not passing any
-#define FLASH_SECTOR_COUNT	128
-#define SECTOR_SIZE_FLASH	4096
+#define SECTOR_SIZE_FLASH	4096	// flash erase unit
+#define FLASH_UNIT_COUNT	128		// erase units given to the disk, 512KB from FLASH_APP_BASE
+#define FLASH_SPARE_UNITS	8		// erase units kept free for copy-on-write
+#define DISK_SECTOR_SIZE	_MAX_SS
+#define FTL_HEADER_SIZE		32
+#define SECTORS_PER_BLOCK	((SECTOR_SIZE_FLASH - FTL_HEADER_SIZE) / DISK_SECTOR_SIZE)
+#define BLOCK_DATA_SIZE		(SECTORS_PER_BLOCK * DISK_SECTOR_SIZE)
+#define LOGICAL_BLOCK_COUNT	(FLASH_UNIT_COUNT - FLASH_SPARE_UNITS)
+#define FLASH_SECTOR_COUNT	(LOGICAL_BLOCK_COUNT * SECTORS_PER_BLOCK)
+#define FTL_MAGIC			0x4C544646	// "FFTL"
+#define FTL_NO_UNIT			0xFF
+#define FTL_RETRY			3
+#define LEGACY_SECTOR_COUNT	128		// volume size of the previous driver, one sector per erase unit
+
+#ifndef FLASH_CACHE_LINES
+#define FLASH_CACHE_LINES	2		// logical blocks held in RAM, BLOCK_DATA_SIZE bytes each
+#endif
+
+#if FLASH_UNIT_COUNT >= FTL_NO_UNIT || SECTORS_PER_BLOCK > 8
+#error "flash disk layout does not fit the translation layer"
+#endif
 
 #if defined(CONFIG_PLATFORM_8195BHP)
 #define FLASH_APP_BASE  0x440000
@@ -33,18 +72,264 @@
 #endif
 #endif
 
+// last bytes of every erase unit in use
+typedef struct {
+	uint32_t magic;
+	uint16_t lblock;
+	uint16_t reserved;
+	uint32_t seq;			// higher is newer
+	uint32_t erase_count;	// erases of this unit, including the one before this write
+	uint32_t pad[3];
+	uint32_t crc;			// CRC-32 of the bytes above
+} ftl_header_t;
+
+typedef struct {
+	uint8_t lblock;			// FTL_NO_UNIT when the line is unused
+	uint8_t valid;			// bit per sector holding the current data
+	uint8_t dirty;
+	uint32_t used;			// for least recently used replacement
+	BYTE data[BLOCK_DATA_SIZE];
+} ftl_cache_t;
 
 flash_t		flash;
 
+static uint8_t ftl_map[LOGICAL_BLOCK_COUNT];		// logical block to erase unit
+static uint32_t ftl_erase_count[FLASH_UNIT_COUNT];
+static uint32_t ftl_seq;
+static uint8_t ftl_mounted = 0;
+static uint8_t ftl_legacy = 0;		// volume in the layout of the previous driver
+static ftl_cache_t ftl_cache[FLASH_CACHE_LINES];
+static uint32_t ftl_clock;
+
 DRESULT interpret_flash_result(int out){
 	DRESULT res;
 	if(out)
 		res = RES_OK;
-	else 
+	else
 		res = RES_ERROR;
 	return res;
 }
 
+static uint32_t ftl_crc32(const uint8_t *data, uint32_t len){
+	uint32_t crc = 0xFFFFFFFF;
+
+	while(len--){
+		crc ^= *data++;
+		for(int i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+	}
+	return ~crc;
+}
+
+static uint32_t ftl_unit_addr(uint8_t unit){
+	return FLASH_APP_BASE + unit * SECTOR_SIZE_FLASH;
+}
+
+static DRESULT ftl_flash_read(uint32_t addr, uint32_t len, uint8_t *data){
+	DRESULT res;
+
+	device_mutex_lock(RT_DEV_LOCK_FLASH);
+	res = interpret_flash_result(flash_stream_read(&flash, addr, len, data));
+	device_mutex_unlock(RT_DEV_LOCK_FLASH);
+	return res;
+}
+
+static DRESULT ftl_flash_write(uint32_t addr, uint32_t len, const uint8_t *data){
+	DRESULT res;
+
+	device_mutex_lock(RT_DEV_LOCK_FLASH);
+	res = interpret_flash_result(flash_stream_write(&flash, addr, len, (uint8_t *) data));
+	device_mutex_unlock(RT_DEV_LOCK_FLASH);
+	return res;
+}
+
+static void ftl_flash_erase(uint32_t addr){
+	device_mutex_lock(RT_DEV_LOCK_FLASH);
+	flash_erase_sector(&flash, addr);
+	device_mutex_unlock(RT_DEV_LOCK_FLASH);
+}
+
+static int ftl_read_header(uint8_t unit, ftl_header_t *header){
+	if(ftl_flash_read(ftl_unit_addr(unit) + SECTOR_SIZE_FLASH - FTL_HEADER_SIZE, FTL_HEADER_SIZE, (uint8_t *) header) != RES_OK)
+		return 0;
+	return header->magic == FTL_MAGIC && header->lblock < LOGICAL_BLOCK_COUNT &&
+		header->crc == ftl_crc32((const uint8_t *) header, FTL_HEADER_SIZE - 4);
+}
+
+// FAT boot sector of a volume the previous driver formatted, sector 0 at the start of the first unit
+static int ftl_legacy_volume(void){
+	uint8_t bytes_per_sector[2], total_sectors[2], signature[2];
+
+	if(ftl_flash_read(FLASH_APP_BASE + 11, 2, bytes_per_sector) != RES_OK ||
+		ftl_flash_read(FLASH_APP_BASE + 19, 2, total_sectors) != RES_OK ||
+		ftl_flash_read(FLASH_APP_BASE + 510, 2, signature) != RES_OK)
+		return 0;
+	return signature[0] == 0x55 && signature[1] == 0xAA &&
+		(bytes_per_sector[0] | (bytes_per_sector[1] << 8)) == DISK_SECTOR_SIZE &&
+		(total_sectors[0] | (total_sectors[1] << 8)) == LEGACY_SECTOR_COUNT;
+}
+
+static void ftl_mount(void){
+	ftl_header_t header, other;
+	uint32_t known = 0, total = 0;
+	uint8_t unknown[FLASH_UNIT_COUNT];
+	int i;
+
+	memset(ftl_map, FTL_NO_UNIT, sizeof(ftl_map));
+	for(i = 0; i < FLASH_CACHE_LINES; i++){
+		ftl_cache[i].lblock = FTL_NO_UNIT;
+		ftl_cache[i].dirty = 0;
+	}
+	ftl_seq = 0;
+
+	for(i = 0; i < FLASH_UNIT_COUNT; i++){
+		unknown[i] = !ftl_read_header(i, &header);
+		if(unknown[i]){
+			ftl_erase_count[i] = 0;
+			continue;
+		}
+
+		ftl_erase_count[i] = header.erase_count;
+		known++;
+		total += header.erase_count;
+		if(header.seq >= ftl_seq)
+			ftl_seq = header.seq + 1;
+
+		// a copy superseded by a write that completed before a power loss
+		if(ftl_map[header.lblock] != FTL_NO_UNIT &&
+			ftl_read_header(ftl_map[header.lblock], &other) && other.seq > header.seq)
+			continue;
+		ftl_map[header.lblock] = i;
+	}
+
+	// units erased without a header written afterwards, or never used: assume average wear
+	for(i = 0; i < FLASH_UNIT_COUNT; i++){
+		if(unknown[i] && known)
+			ftl_erase_count[i] = total / known;
+	}
+
+	ftl_legacy = (known == 0 && ftl_legacy_volume());
+	if(ftl_legacy)
+		printf("FLASH disk: volume of the previous layout, kept without translation layer\n");
+	ftl_mounted = 1;
+}
+
+// the free erase unit with the fewest erases, so writes spread over every unit not holding live data
+static uint8_t ftl_alloc(void){
+	uint8_t used[(FLASH_UNIT_COUNT + 7) / 8] = {0};
+	uint8_t best = FTL_NO_UNIT;
+	int i;
+
+	for(i = 0; i < LOGICAL_BLOCK_COUNT; i++){
+		if(ftl_map[i] != FTL_NO_UNIT)
+			used[ftl_map[i] / 8] |= 1 << (ftl_map[i] % 8);
+	}
+	for(i = 0; i < FLASH_UNIT_COUNT; i++){
+		if(used[i / 8] & (1 << (i % 8)))
+			continue;
+		if(best == FTL_NO_UNIT || ftl_erase_count[i] < ftl_erase_count[best])
+			best = i;
+	}
+	return best;
+}
+
+static DRESULT ftl_commit(ftl_cache_t *line){
+	ftl_header_t header;
+	uint8_t old = ftl_map[line->lblock];
+	uint8_t unit;
+	char retry_cnt = 0;
+	DRESULT res = RES_ERROR;
+	int i;
+
+	if(!line->dirty)
+		return RES_OK;
+
+	// sectors never written nor read through this line keep their flash content
+	for(i = 0; i < SECTORS_PER_BLOCK; i++){
+		if(line->valid & (1 << i))
+			continue;
+		if(old == FTL_NO_UNIT)
+			memset(line->data + i * DISK_SECTOR_SIZE, 0xFF, DISK_SECTOR_SIZE);
+		else if(ftl_flash_read(ftl_unit_addr(old) + i * DISK_SECTOR_SIZE, DISK_SECTOR_SIZE, line->data + i * DISK_SECTOR_SIZE) != RES_OK)
+			return RES_ERROR;
+		line->valid |= 1 << i;
+	}
+
+	do{
+		unit = ftl_alloc();
+		if(unit == FTL_NO_UNIT)
+			return RES_ERROR;
+
+		ftl_flash_erase(ftl_unit_addr(unit));
+		ftl_erase_count[unit]++;
+
+		memset(&header, 0, sizeof(header));
+		header.magic = FTL_MAGIC;
+		header.lblock = line->lblock;
+		header.seq = ftl_seq;
+		header.erase_count = ftl_erase_count[unit];
+		header.crc = ftl_crc32((const uint8_t *) &header, FTL_HEADER_SIZE - 4);
+
+		// the header goes last, until it is in flash the previous copy stays valid
+		res = ftl_flash_write(ftl_unit_addr(unit), BLOCK_DATA_SIZE, line->data);
+		if(res == RES_OK)
+			res = ftl_flash_write(ftl_unit_addr(unit) + SECTOR_SIZE_FLASH - FTL_HEADER_SIZE, FTL_HEADER_SIZE, (const uint8_t *) &header);
+	}while(res != RES_OK && ++retry_cnt < FTL_RETRY);
+
+	if(res != RES_OK)
+		return res;
+
+	ftl_seq++;
+	ftl_map[line->lblock] = unit;
+	line->dirty = 0;
+	return RES_OK;
+}
+
+static ftl_cache_t *ftl_find(uint8_t lblock){
+	int i;
+
+	for(i = 0; i < FLASH_CACHE_LINES; i++){
+		if(ftl_cache[i].lblock == lblock){
+			ftl_cache[i].used = ++ftl_clock;
+			return &ftl_cache[i];
+		}
+	}
+	return NULL;
+}
+
+static ftl_cache_t *ftl_get(uint8_t lblock){
+	ftl_cache_t *line = ftl_find(lblock);
+	int i;
+
+	if(line != NULL)
+		return line;
+
+	line = &ftl_cache[0];
+	for(i = 1; i < FLASH_CACHE_LINES; i++){
+		if(ftl_cache[i].lblock == FTL_NO_UNIT || (line->lblock != FTL_NO_UNIT && ftl_cache[i].used < line->used))
+			line = &ftl_cache[i];
+	}
+	if(line->lblock != FTL_NO_UNIT && ftl_commit(line) != RES_OK)
+		return NULL;
+
+	line->lblock = lblock;
+	line->valid = 0;
+	line->dirty = 0;
+	line->used = ++ftl_clock;
+	return line;
+}
+
+static DRESULT ftl_sync(void){
+	DRESULT res = RES_OK;
+	int i;
+
+	for(i = 0; i < FLASH_CACHE_LINES; i++){
+		if(ftl_cache[i].lblock != FTL_NO_UNIT && ftl_commit(&ftl_cache[i]) != RES_OK)
+			res = RES_ERROR;
+	}
+	return res;
+}
+
 DSTATUS FLASH_disk_status(void){
 	DRESULT res;
 	res = RES_OK;
@@ -57,52 +342,101 @@ DSTATUS FLASH_disk_initialize(void){
 	//spic_deinit(&flash.hal_spic_adaptor);
 	flash_init(&flash);
 #endif
+	if(!ftl_mounted)
+		ftl_mount();
 	res = RES_OK;
 	return res;
 }
 
 DSTATUS FLASH_disk_deinitialize(void){
 	DRESULT res;
-	res = RES_OK;
+	res = ftl_mounted ? ftl_sync() : RES_OK;
+	ftl_mounted = 0;
 	return res;
 }
 
-/* Read sector(s) --------------------------------------------*/
-DRESULT FLASH_disk_read(BYTE *buff, DWORD sector, UINT count){			
-	DRESULT res;
-	char retry_cnt = 0, i = 0;  
-	device_mutex_lock(RT_DEV_LOCK_FLASH);
-	do{
-		res = interpret_flash_result(flash_stream_read(&flash, FLASH_APP_BASE + sector*SECTOR_SIZE_FLASH, count*SECTOR_SIZE_FLASH, (uint8_t *) buff));
-		if(++retry_cnt>=3)
-			break;
-	}while(res != RES_OK);
-	device_mutex_unlock(RT_DEV_LOCK_FLASH);
+static uint32_t legacy_sector_addr(DWORD sector){
+	return FLASH_APP_BASE + sector * SECTOR_SIZE_FLASH;
+}
+
+static DRESULT legacy_read(BYTE *buff, DWORD sector, UINT count){
+	DRESULT res = RES_OK;
+
+	for(; count > 0 && res == RES_OK; count--, sector++, buff += DISK_SECTOR_SIZE)
+		res = ftl_flash_read(legacy_sector_addr(sector), DISK_SECTOR_SIZE, (uint8_t *) buff);
 	return res;
 }
 
-/* Write sector(s) --------------------------------------------*/
-#if _USE_WRITE == 1	
-DRESULT FLASH_disk_write(BYTE const *buff, DWORD sector, UINT count){		
-	DRESULT res;
-	char retry_cnt = 0, i = 0;
+static DRESULT legacy_write(BYTE const *buff, DWORD sector, UINT count){
+	DRESULT res = RES_OK;
+	char retry_cnt;
 
-	device_mutex_lock(RT_DEV_LOCK_FLASH);
-	do{
-		for(i=0;i<count;i++){			
-			uint32_t erase_addr = FLASH_APP_BASE + (sector + i)*SECTOR_SIZE_FLASH;
+	for(; count > 0 && res == RES_OK; count--, sector++, buff += DISK_SECTOR_SIZE){
+		retry_cnt = 0;
+		do{
+			ftl_flash_erase(legacy_sector_addr(sector));
+			res = ftl_flash_write(legacy_sector_addr(sector), DISK_SECTOR_SIZE, buff);
+		}while(res != RES_OK && ++retry_cnt < FTL_RETRY);
+	}
+	return res;
+}
+
+/* Read sector(s) --------------------------------------------*/
+DRESULT FLASH_disk_read(BYTE *buff, DWORD sector, UINT count){
+	DRESULT res = RES_OK;
+	ftl_cache_t *line;
+	uint8_t lblock, slot, unit;
 
-			flash_erase_sector(&flash, erase_addr);
-			res = interpret_flash_result(flash_stream_write(&flash, FLASH_APP_BASE + (sector + i)*SECTOR_SIZE_FLASH, count*SECTOR_SIZE_FLASH, (uint8_t *) buff));		// Replace with Flash API
+	if(!ftl_mounted)
+		ftl_mount();
+	if(ftl_legacy)
+		return (sector + count > LEGACY_SECTOR_COUNT) ? RES_PARERR : legacy_read(buff, sector, count);
+	if(sector + count > FLASH_SECTOR_COUNT)
+		return RES_PARERR;
+
+	for(; count > 0 && res == RES_OK; count--, sector++, buff += DISK_SECTOR_SIZE){
+		lblock = sector / SECTORS_PER_BLOCK;
+		slot = sector % SECTORS_PER_BLOCK;
+		line = ftl_find(lblock);
+		if(line != NULL && (line->valid & (1 << slot))){
+			memcpy(buff, line->data + slot * DISK_SECTOR_SIZE, DISK_SECTOR_SIZE);
+			continue;
 		}
-		if(++retry_cnt>=3)
-			break;
-		
-	}while(res != RES_OK);
-	device_mutex_unlock(RT_DEV_LOCK_FLASH);
 
+		unit = ftl_map[lblock];
+		if(unit == FTL_NO_UNIT)
+			memset(buff, 0xFF, DISK_SECTOR_SIZE);
+		else
+			res = ftl_flash_read(ftl_unit_addr(unit) + slot * DISK_SECTOR_SIZE, DISK_SECTOR_SIZE, (uint8_t *) buff);
+	}
 	return res;
 }
+
+/* Write sector(s) --------------------------------------------*/
+#if _USE_WRITE == 1
+DRESULT FLASH_disk_write(BYTE const *buff, DWORD sector, UINT count){
+	ftl_cache_t *line;
+	uint8_t slot;
+
+	if(!ftl_mounted)
+		ftl_mount();
+	if(ftl_legacy)
+		return (sector + count > LEGACY_SECTOR_COUNT) ? RES_PARERR : legacy_write(buff, sector, count);
+	if(sector + count > FLASH_SECTOR_COUNT)
+		return RES_PARERR;
+
+	for(; count > 0; count--, sector++, buff += DISK_SECTOR_SIZE){
+		line = ftl_get(sector / SECTORS_PER_BLOCK);
+		if(line == NULL)
+			return RES_ERROR;
+
+		slot = sector % SECTORS_PER_BLOCK;
+		memcpy(line->data + slot * DISK_SECTOR_SIZE, buff, DISK_SECTOR_SIZE);
+		line->valid |= 1 << slot;
+		line->dirty = 1;
+	}
+	return RES_OK;
+}
 #endif
 
 /* IOCTL sector(s) --------------------------------------------*/
@@ -114,18 +448,20 @@ DRESULT FLASH_disk_ioctl (BYTE cmd, void* buff){
 
 	switch(cmd){
 		/* Generic command (used by FatFs) */
-		
+
 		/* Make sure that no pending write process in the physical drive */
 		case CTRL_SYNC:		/* Flush disk cache (for write functions) */
-			res = RES_OK;
+			res = ftl_mounted ? ftl_sync() : RES_OK;
 			break;
 		case GET_SECTOR_COUNT:	/* Get media size (for only f_mkfs()) */
-			*(DWORD*)buff = FLASH_SECTOR_COUNT;
+			if(!ftl_mounted)
+				ftl_mount();
+			*(DWORD*)buff = ftl_legacy ? LEGACY_SECTOR_COUNT : FLASH_SECTOR_COUNT;
 			res = RES_OK;
 			break;
 		/* for case _MAX_SS != _MIN_SS */
 		case GET_SECTOR_SIZE:	/* Get sector size (for multiple sector size (_MAX_SS >= 1024)) */
-			*(WORD*)buff = SECTOR_SIZE_FLASH;	//4096 or 2048 or 1024
+			*(WORD*)buff = DISK_SECTOR_SIZE;
 			res = RES_OK;
 			break;
 
@@ -176,4 +512,4 @@ ll_diskio_drv FLASH_disk_Driver ={
 #endif
 	.TAG	= "FLASH"
 };
-#endif
\ No newline at end of file
+#endif
@@ -14,6 +14,7 @@
 #include "ftl.h"
 
 #include "flash_api.h"
+#include "us_ticker_api.h"
 
 //////////////////////////////////////////////////
 
@@ -44,6 +45,11 @@
 #define FTL_USE_MAPPING_TABLE			1
 #define FTL_ONLY_GC_IN_IDLE				0
 #define FTL_APP_LOGICAL_ADDR_BASE		0
+#define FTL_BATCH_CELLS					32	// cells programmed per flash access by ftl_save_to_storage, 256 bytes
+#define FTL_GC_STEP_CELLS				8	// valid cells a garbage collection step copies at least
+#define FTL_GC_RESERVE_PAGES			0	// the oldest page is collected once no more pages than this are free
+#define FTL_GC_TASK_STACK				512	// words
+#define FTL_GC_TASK_PRIORITY			(tskIDLE_PRIORITY + 1)
 
 
 #if defined(WIN32) && (WIN32 == 1)
@@ -107,6 +113,16 @@ bool do_gc_in_idle = FALSE;
 uint8_t idle_gc_page_thres = 1;
 uint16_t idle_gc_cell_thres = PAGE_element / 2;
 
+#define FTL_GC_NO_PAGE      0xFF
+
+uint8_t  gc_page = FTL_GC_NO_PAGE;      // page under incremental garbage collection
+uint16_t gc_key_index;                  // next key of gc_page to look at, from the newest cell down
+uint16_t gc_live_cells;                 // valid cells of gc_page not copied yet, at most
+uint16_t gc_step_cells = FTL_GC_STEP_CELLS;
+uint8_t  gc_reserve_pages = FTL_GC_RESERVE_PAGES;
+T_FTL_GC_STATS gc_stats;
+TaskHandle_t ftl_gc_task_handle = NULL;
+
 extern uint32_t ftl_write(uint16_t logical_addr, uint32_t w_data);
 extern bool ftl_page_erase(struct Page_T *p);
 void ftl_mapping_table_init(void);
@@ -596,6 +612,7 @@ uint8_t ftl_page_garbage_collect(uint32_t page_thresh, uint32_t cell_thresh)
                 FTL_PRINTF(FTL_LEVEL_INFO, "[ftl] doGarbageCollection: page thres %d, cell thres %d", page_thresh,
                                   cell_thresh);
                 ftl_page_garbage_collect_Imp();
+                gc_page = FTL_GC_NO_PAGE;
                 result = 1;
             }
         }
@@ -611,6 +628,193 @@ uint8_t ftl_page_garbage_collect(uint32_t page_thresh, uint32_t cell_thresh)
     return result;
 }
 
+// Valid cells of a page, the mapping table points at them
+static uint16_t ftl_page_live_cells(uint8_t pageID)
+{
+    uint16_t logical_addr;
+    uint16_t count = 0;
+
+    for (logical_addr = 0; logical_addr < MAX_logical_address_size; logical_addr += 4)
+    {
+        uint16_t phy_addr = read_mapping_table(logical_addr);
+
+        if (phy_addr != 0 && phy_addr / PAGE_element == pageID)
+        {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+// erases gc_page once all its valid cells have been copied, the caller holds ftl_sem
+static bool ftl_gc_erase(void)
+{
+    if (!ftl_page_erase(g_pPage + gc_page))
+    {
+        return FALSE;
+    }
+
+    FTL_PRINTF(FTL_LEVEL_INFO, "[ftl] ftl_gc_erase: page %d erased\n", gc_page);
+    gc_page = FTL_GC_NO_PAGE;
+    g_free_page_count = ftl_get_free_page_count();
+    gc_stats.pages_erased++;
+    return TRUE;
+}
+
+// One bounded step of the incremental garbage collection. The oldest page is picked once no more than
+// page_thresh pages are free, every step then walks its cells from the newest down and copies the valid
+// ones to the current page. A step copies gc_step_cells valid cells and looks at four times as many, or
+// more when the room left would not last for the rest of the page at that pace with FTL_BATCH_CELLS
+// written per step. Once the last cell is copied the page waits for a step with erase set, the writes
+// leave the erase to the background. Returns 1 while a page is being collected, the caller holds ftl_sem.
+static uint8_t ftl_gc_step(uint8_t page_thresh, bool erase)
+{
+    uint32_t start = us_ticker_read();
+    uint16_t moved = 0;
+    uint16_t looked = 0;
+
+    if (g_doingGarbageCollection)
+    {
+        return 0;
+    }
+
+    if (gc_page != FTL_GC_NO_PAGE && gc_key_index < 3 && !erase)
+    {
+        return 1;
+    }
+
+    if (gc_page == FTL_GC_NO_PAGE)
+    {
+        // the oldest page must not be the current one
+        if (g_free_page_count > page_thresh || g_PAGE_num - g_free_page_count < 2)
+        {
+            return 0;
+        }
+
+        gc_page = ftl_page_get_oldest();
+        if (ftl_get_page_end_position(g_pPage + gc_page, &gc_key_index))
+        {
+            gc_key_index = PAGE_element - 1;
+        }
+        gc_live_cells = ftl_page_live_cells(gc_page);
+    }
+
+    g_doingGarbageCollection = 1;
+
+    if (gc_key_index >= 3)
+    {
+        uint16_t left = (gc_key_index - 1) / 2;
+        uint32_t room = (PAGE_element - g_free_cell_index) / 2 + g_free_page_count * PAGE_element_data;
+        uint16_t move_quota = gc_step_cells;
+        uint16_t look_quota = gc_step_cells * 4;
+        uint16_t pace = left;
+
+        // steps left before the writes and the copies fill the room, one of them for the erase
+        if (room > gc_live_cells + FTL_BATCH_CELLS * 2)
+        {
+            uint32_t steps = (room - gc_live_cells) / FTL_BATCH_CELLS - 1;
+
+            pace = (left + steps - 1) / steps;
+        }
+        if (move_quota < pace)
+        {
+            move_quota = pace;
+        }
+        if (look_quota < pace)
+        {
+            look_quota = pace;
+        }
+
+        while (gc_key_index >= 3 && moved < move_quota && looked < look_quota)
+        {
+            uint32_t key = ftl_page_read(g_pPage + gc_page, gc_key_index);
+
+            if (ftl_key_get_length(key) == 1)
+            {
+                uint16_t addr = key & 0xffff;
+
+                if (!ftl_page_can_addr_drop(addr, gc_page))
+                {
+                    uint32_t rdata = ftl_page_read(g_pPage + gc_page, gc_key_index - 1);
+
+                    if (ftl_write(addr, rdata) != FTL_WRITE_SUCCESS)
+                    {
+                        // leave the cell for the next step
+                        break;
+                    }
+                    ++moved;
+                }
+            }
+
+            gc_key_index -= 2;
+            ++looked;
+        }
+
+        gc_live_cells = (gc_live_cells > moved) ? gc_live_cells - moved : 0;
+    }
+    else
+    {
+        ftl_gc_erase();
+    }
+
+    g_doingGarbageCollection = 0;
+
+    gc_stats.steps++;
+    gc_stats.cells_moved += moved;
+    gc_stats.last_step_us = us_ticker_read() - start;
+    if (gc_stats.last_step_us > gc_stats.max_step_us)
+    {
+        gc_stats.max_step_us = gc_stats.last_step_us;
+    }
+
+    return (gc_page != FTL_GC_NO_PAGE);
+}
+
+// One garbage collection step, erase included, for the background task. It starts on the oldest page
+// at the same point as the writes, gc_reserve_pages sets how early. Returns 1 while a page is being
+// collected.
+uint8_t ftl_garbage_collect_in_background(void)
+{
+    uint8_t busy;
+
+    if (g_pPage == NULL)
+    {
+        return 0;
+    }
+
+    if (NULL != ftl_sem)
+    {
+        xSemaphoreTakeRecursive(ftl_sem, portMAX_DELAY);
+    }
+
+    busy = ftl_gc_step(gc_reserve_pages, TRUE);
+
+    if (NULL != ftl_sem)
+    {
+        xSemaphoreGiveRecursive(ftl_sem);
+    }
+
+    return busy;
+}
+
+// Woken by the writes once a page is under collection. It runs at the lowest priority above idle and
+// takes ftl_sem for one step at a time, a write only waits for the step in progress, the 45 ms erase
+// when it is one, as the flash could not be programmed during the erase anyway.
+static void ftl_gc_task(void *param)
+{
+    (void) param;
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (ftl_garbage_collect_in_background())
+        {
+        }
+    }
+}
+
 void ftl_garbage_collect_in_idle(void)
 {
     if (g_pPage == NULL)
@@ -619,11 +823,21 @@ void ftl_garbage_collect_in_idle(void)
     }
     if (do_gc_in_idle)
     {
-        if (g_free_page_count <= idle_gc_page_thres)
+        // a page under collection is finished first, whatever the thresholds
+        if (gc_page != FTL_GC_NO_PAGE ||
+            (g_free_page_count <= idle_gc_page_thres && g_free_cell_index <= idle_gc_cell_thres))
         {
-            if (g_free_cell_index <= idle_gc_cell_thres)
+            // the idle task must not block, try again on the next idle round
+            if (NULL != ftl_sem && xSemaphoreTakeRecursive(ftl_sem, 0) != TRUE)
+            {
+                return;
+            }
+
+            ftl_gc_step(idle_gc_page_thres, TRUE);
+
+            if (NULL != ftl_sem)
             {
-                ftl_page_garbage_collect(idle_gc_page_thres, idle_gc_cell_thres);
+                xSemaphoreGiveRecursive(ftl_sem);
             }
         }
     }
@@ -989,6 +1203,180 @@ L_retry:
     return  ret;
 }
 
+// close the current page and continue in the next one, the caller holds ftl_sem
+static uint32_t ftl_page_switch(void)
+{
+    uint16_t tmp;
+    if (ftl_get_page_end_position(g_pPage + g_cur_pageID, &tmp))
+    {
+        // invalid end pos
+        // so set end pos
+        ftl_set_page_end_position(g_pPage + g_cur_pageID, g_free_cell_index - 1);
+    }
+
+    // find invalid(free) page
+    uint8_t new_cur_pageID = g_cur_pageID + 1;
+    new_cur_pageID %= g_PAGE_num;
+
+    // the collected page is still waiting for the background to erase it, this write pays for the erase
+    if (new_cur_pageID == gc_page && gc_key_index < 3 && !g_doingGarbageCollection)
+    {
+        if (!ftl_gc_erase())
+        {
+            return FTL_WRITE_ERROR_ERASE_FAIL;
+        }
+        gc_stats.forced_erases++;
+    }
+
+    if (0 == ftl_page_is_valid(g_pPage + new_cur_pageID))
+    {
+        // out of space
+        FTL_ASSERT(0);
+        return FTL_WRITE_ERROR_OUT_OF_SPACE;
+    }
+
+    // invalid page and format it
+    uint8_t new_sequence = ftl_get_page_seq(g_pPage + g_cur_pageID) + 1;
+    if (!ftl_page_format(g_pPage + new_cur_pageID, new_sequence))
+    {
+        return FTL_WRITE_ERROR_ERASE_FAIL;
+    }
+
+    // updata current page info
+    g_cur_pageID = new_cur_pageID;
+    g_free_cell_index = INFO_size;
+
+    // the oldest page is collected a step at a time by the writes that follow and by ftl_gc_task, see
+    // ftl_write_cells.
+    // With FTL_ONLY_GC_IN_IDLE the writes leave it to ftl_garbage_collect_in_idle. ftl_write used to set
+    // FTL_WRITE_ERROR_NEED_GC here, but the retry that followed overwrote it, no caller ever saw it.
+
+    return FTL_WRITE_SUCCESS;
+}
+
+// Append count words from logical_addr on as cells of the current page. Up to FTL_BATCH_CELLS cells are
+// programmed in two flash accesses, their data words first and their keys after, as ftl_write does for
+// one cell, then read back with one more. A key only reaches flash over data already programmed, so a
+// power lost in between leaves whole cells valid and the others without a key.
+static uint32_t ftl_write_cells(uint16_t logical_addr, const uint8_t *pdata8, uint16_t count)
+{
+    uint32_t ret = FTL_WRITE_SUCCESS;
+    uint32_t cells[FTL_BATCH_CELLS * 2];
+    uint32_t keys[FTL_BATCH_CELLS * 2];
+    uint32_t rcells[FTL_BATCH_CELLS * 2];
+    uint8_t sem_flag = FALSE;
+    uint16_t start_addr = logical_addr;
+    uint16_t start_count = count;
+    flash_t flash;
+
+    if (0 != __get_IPSR())
+    {
+        FTL_PRINTF(FTL_LEVEL_WARN, "[ftl] FTL_write should not be called in interrupt handler!\n");
+        return FTL_WRITE_ERROR_IN_INTR;
+    }
+
+    if (count == 0 || ftl_check_logical_addr(logical_addr) || ftl_check_logical_addr(logical_addr + (count - 1) * 4))
+    {
+        return FTL_WRITE_ERROR_INVALID_ADDR;
+    }
+
+    if (NULL != ftl_sem)
+    {
+        if (xSemaphoreTakeRecursive(ftl_sem, portMAX_DELAY) == TRUE)
+        {
+            sem_flag = TRUE;
+        }
+    }
+
+    while (count > 0 && ret == FTL_WRITE_SUCCESS)
+    {
+        uint16_t room = (PAGE_element - g_free_cell_index) / 2;
+        uint16_t num = count;
+        uint16_t i;
+
+        if (room == 0)
+        {
+            ret = ftl_page_switch();
+            continue;
+        }
+
+        if (num > room)
+        {
+            num = room;
+        }
+        if (num > FTL_BATCH_CELLS)
+        {
+            num = FTL_BATCH_CELLS;
+        }
+
+        // programming WRITABLE_32BIT leaves a word as it is, the keys are left out of the first pass
+        // and the data words out of the second
+        for (i = 0; i < num; i++)
+        {
+            uint32_t key = ftl_key_init(logical_addr + i * 4, 1);
+
+            flash_set_bit(&key, BIT_VALID);
+            cells[i * 2] = (uint32_t)(pdata8[0] |
+                                      (pdata8[1] << 8) |
+                                      (pdata8[2] << 16) |
+                                      (pdata8[3] << 24));
+            cells[i * 2 + 1] = WRITABLE_32BIT;
+            keys[i * 2] = WRITABLE_32BIT;
+            keys[i * 2 + 1] = key;
+            pdata8 += 4;
+        }
+
+        uint32_t addr = (uint32_t)&g_pPage[g_cur_pageID].Data[g_free_cell_index];
+
+        device_mutex_lock(RT_DEV_LOCK_FLASH);
+        flash_stream_write(&flash, addr, num * 8, (uint8_t *)cells);
+        flash_stream_write(&flash, addr, num * 8, (uint8_t *)keys);
+        flash_stream_read(&flash, addr, num * 8, (uint8_t *)rcells);
+        device_mutex_unlock(RT_DEV_LOCK_FLASH);
+
+        for (i = 0; i < num; i++)
+        {
+            if (rcells[i * 2] != cells[i * 2] || rcells[i * 2 + 1] != keys[i * 2 + 1])
+            {
+                FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl](ftl_write_cells) P: %x, idx: %d, D: 0x%08x, read back: %x \n",
+                                   g_pPage + g_cur_pageID, g_free_cell_index + i * 2, cells[i * 2], rcells[i * 2]);
+                ret = FTL_WRITE_ERROR_READ_BACK;
+                continue;
+            }
+
+            if (FTL_USE_MAPPING_TABLE == 1) //mapping table otp
+            {
+                write_mapping_table(logical_addr + i * 4, g_cur_pageID, g_free_cell_index + i * 2);
+            }
+        }
+
+        g_free_cell_index += num * 2;
+        logical_addr += num * 4;
+        count -= num;
+
+        // every batch pays for one bounded copy step, enough to keep ahead of the writes, the rest of the
+        // collection and the erase are left to ftl_gc_task
+        if (FTL_ONLY_GC_IN_IDLE == 0 && ret == FTL_WRITE_SUCCESS)
+        {
+            ftl_gc_step(gc_reserve_pages, FALSE);
+        }
+    }
+
+    if (FTL_ONLY_GC_IN_IDLE == 0 && gc_page != FTL_GC_NO_PAGE && ftl_gc_task_handle != NULL)
+    {
+        xTaskNotifyGive(ftl_gc_task_handle);
+    }
+
+    if (sem_flag)
+    {
+        xSemaphoreGiveRecursive(ftl_sem);
+    }
+
+    FTL_PRINTF(FTL_LEVEL_WARN, "[ftl] w 0x%08x: %d cells (%d)\r\n", start_addr, start_count, ret);
+
+    return ret;
+}
+
 // return 0 success
 // return !0 fail
 uint32_t ftl_save_to_storage_i(void *pdata_tmp, uint16_t offset, uint16_t size)
@@ -1011,26 +1399,13 @@ uint32_t ftl_save_to_storage_i(void *pdata_tmp, uint16_t offset, uint16_t size)
 #endif
 
 
-    uint32_t ret = 0;
+    uint32_t start = us_ticker_read();
+    uint32_t ret = ftl_write_cells(offset, pdata8, size / 4);
+    uint32_t elapsed = us_ticker_read() - start;
 
-    while (size > 0)
+    if (elapsed > gc_stats.max_write_us)
     {
-        uint32_t data32 = (uint32_t)(pdata8[0] |
-                                     (pdata8[1] << 8) |
-                                     (pdata8[2] << 16) |
-                                     (pdata8[3] << 24));
-
-        ret = ftl_write(offset, data32);
-        FTL_ASSERT(result == 0);
-
-        if (ret)
-        {
-            break;
-        }
-
-        offset += 4;
-        size -= 4;
-        pdata8 += 4;
+        gc_stats.max_write_us = elapsed;
     }
 
 
@@ -1183,55 +1558,11 @@ L_retry:
         else
         {
             // try to find out free cell
-			
-            uint16_t tmp;
-            if (ftl_get_page_end_position(g_pPage + g_cur_pageID, &tmp))
-            {
-                // invalid end pos
-                // so set end pos
-                ftl_set_page_end_position(g_pPage + g_cur_pageID, g_free_cell_index - 1);
-            }
-
-            // find invalid(free) page
-            uint8_t new_cur_pageID = g_cur_pageID + 1;
-            new_cur_pageID %= g_PAGE_num;
-
-            if (ftl_page_is_valid(g_pPage + new_cur_pageID))
+            ret = ftl_page_switch();
+            if (ret == FTL_WRITE_SUCCESS)
             {
-                //DPRINTF("ftl_write: before format\n");
-                //ftl_ioctl( FTL_IOCTL_DEBUG, 0, 0);
-
-                // invalid page and format it
-                uint8_t new_sequence = ftl_get_page_seq(g_pPage + g_cur_pageID) + 1;
-                if (!ftl_page_format(g_pPage + new_cur_pageID, new_sequence))
-                {
-                    return FTL_WRITE_ERROR_ERASE_FAIL;
-                }
-
-                // updata current page info
-                g_cur_pageID = new_cur_pageID;
-                g_free_cell_index = INFO_size;
-
-                if (!g_doingGarbageCollection)
-                {
-                    if (FTL_ONLY_GC_IN_IDLE == 1)
-                    {
-                        ret = FTL_WRITE_ERROR_NEED_GC;
-                    }
-                    else
-                    {
-                        ftl_page_garbage_collect(0, PAGE_element / 2);
-                    }
-                }
-
                 goto L_retry;
             }
-            else
-            {
-                // out of space
-                FTL_ASSERT(0);
-                ret = FTL_WRITE_ERROR_OUT_OF_SPACE;
-            }
         }
     }
 
@@ -1305,6 +1636,7 @@ uint32_t ftl_ioctl(uint32_t cmd, uint32_t p1, uint32_t p2)
 
             //fix after FTL_IOCTL_CLEAR_ALL may not do gc bug
             g_free_page_count = ftl_get_free_page_count();
+            gc_page = FTL_GC_NO_PAGE;
 
             result = ftl_page_format(g_pPage + g_cur_pageID, 0) ? 0 : 1;
 
@@ -1362,6 +1694,19 @@ uint32_t ftl_ioctl(uint32_t cmd, uint32_t p1, uint32_t p2)
             result = 0;
         }
         break;
+    case FTL_IOCTL_SET_GC_STEP:
+        {
+            // at least two pages stay in use to pick the oldest from
+            if (p1 == 0 || p1 > PAGE_element_data || p2 > g_PAGE_num - 2)
+            {
+                result = FTL_WRITE_ERROR_INVALID_PARAMETER;
+                break;
+            }
+            gc_step_cells = p1;
+            gc_reserve_pages = p2;
+            result = 0;
+        }
+        break;
     default:
         break;
     }
@@ -1369,6 +1714,66 @@ uint32_t ftl_ioctl(uint32_t cmd, uint32_t p1, uint32_t p2)
     return result;
 }
 
+uint32_t ftl_get_gc_stats(T_FTL_GC_STATS *stats)
+{
+    uint16_t logical_addr;
+    uint8_t i;
+
+    if (g_pPage == NULL)
+    {
+        return FTL_READ_ERROR_NOT_INIT;
+    }
+
+    if (stats == NULL)
+    {
+        return FTL_READ_ERROR_INVALID_PARAMETER;
+    }
+
+    if (NULL != ftl_sem)
+    {
+        xSemaphoreTakeRecursive(ftl_sem, portMAX_DELAY);
+    }
+
+    *stats = gc_stats;
+    stats->free_pages = g_free_page_count;
+    stats->gc_page = gc_page;
+    memset(stats->valid_cells, 0, sizeof(stats->valid_cells));
+    memset(stats->used_cells, 0, sizeof(stats->used_cells));
+
+    for (i = 0; i < g_PAGE_num && i < FTL_GC_STATS_PAGES; ++i)
+    {
+        uint16_t end_pos;
+
+        if (i == g_cur_pageID)
+        {
+            stats->used_cells[i] = (g_free_cell_index - INFO_size) / 2;
+        }
+        else if (0 == ftl_page_is_valid(g_pPage + i))
+        {
+            stats->used_cells[i] = ftl_get_page_end_position(g_pPage + i, &end_pos) ?
+                                   PAGE_element_data : (end_pos + 1 - INFO_size) / 2;
+        }
+    }
+
+    // the mapping table holds the live cell of every logical address
+    for (logical_addr = 0; logical_addr < MAX_logical_address_size; logical_addr += 4)
+    {
+        uint16_t phy_addr = read_mapping_table(logical_addr);
+
+        if (phy_addr != 0 && phy_addr / PAGE_element < FTL_GC_STATS_PAGES)
+        {
+            stats->valid_cells[phy_addr / PAGE_element]++;
+        }
+    }
+
+    if (NULL != ftl_sem)
+    {
+        xSemaphoreGiveRecursive(ftl_sem);
+    }
+
+    return 0;
+}
+
 #if 0
 uint32_t ftl_load(void *pdata, uint16_t offset, uint16_t size)
 {
@@ -1395,6 +1800,13 @@ uint32_t ftl_init(uint32_t u32PageStartAddr, uint8_t pagenum)
 		ftl_sem = xSemaphoreCreateRecursiveMutex();
     }
 
+    if (ftl_gc_task_handle == NULL &&
+        xTaskCreate(ftl_gc_task, "ftl_gc", FTL_GC_TASK_STACK, NULL, FTL_GC_TASK_PRIORITY, &ftl_gc_task_handle) != pdPASS)
+    {
+        FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] no garbage collection task, page switches erase the collected page\n");
+        ftl_gc_task_handle = NULL;
+    }
+
     g_pPage = (struct Page_T *)(u32PageStartAddr);
 
     // find latest valid page by sequence num
@@ -1525,6 +1937,8 @@ uint32_t ftl_init(uint32_t u32PageStartAddr, uint8_t pagenum)
 
     ftl_recover_from_power_lost();
     g_free_page_count = ftl_get_free_page_count();
+    gc_page = FTL_GC_NO_PAGE;
+    memset(&gc_stats, 0, sizeof(gc_stats));
 
     return 0;
 }
@@ -76,8 +76,27 @@ typedef enum
     FTL_IOCTL_ENABLE_GC_IN_IDLE = 4,  /**< IO code to enable garbage collection in idle task*/
     FTL_IOCTL_DISABLE_GC_IN_IDLE = 5,  /**< IO code to disable garbage collection in idle task*/
     FTL_IOCTL_DO_GC_IN_APP = 6,  /**< IO code to do garbage collection in app*/
+    FTL_IOCTL_SET_GC_STEP = 7,  /**< IO code to set the valid cells copied per garbage collection step (p1) and the free page reserve (p2)*/
 } T_FTL_IOCTL_CODE;
 
+#define FTL_GC_STATS_PAGES            (8)
+
+/** Garbage collection statistics, see @ref ftl_get_gc_stats */
+typedef struct
+{
+    uint32_t steps;             /**< incremental garbage collection steps run */
+    uint32_t cells_moved;       /**< valid cells copied out of collected pages */
+    uint32_t pages_erased;      /**< pages erased by the incremental collection */
+    uint32_t forced_erases;     /**< of those, erased by a write that needed the page before the background erased it */
+    uint32_t last_step_us;      /**< time of the last step */
+    uint32_t max_step_us;       /**< longest step */
+    uint32_t max_write_us;      /**< longest ftl_save_to_storage, garbage collection included */
+    uint8_t  free_pages;        /**< free pages */
+    uint8_t  gc_page;           /**< page under collection, 0xFF for none */
+    uint16_t valid_cells[FTL_GC_STATS_PAGES];   /**< cells of each page holding the latest value of their address */
+    uint16_t used_cells[FTL_GC_STATS_PAGES];    /**< cells written in each page, out of 511 */
+} T_FTL_GC_STATS;
+
 /** End of FTL_Exported_Types
     * @}
     */
@@ -134,6 +153,16 @@ typedef enum
     */
 uint32_t ftl_ioctl(uint32_t cmd, uint32_t p1, uint32_t p2);
 
+/**
+    * @brief    Read the garbage collection statistics
+    * @param    stats  filled with the counters and the valid and used cells of the first
+    *                  FTL_GC_STATS_PAGES pages
+    * @return   status
+    * @retval   0  status successful
+    * @retval   otherwise fail
+    */
+uint32_t ftl_get_gc_stats(T_FTL_GC_STATS *stats);
+
 /** @} */ /* End of group FTL_Exported_Functions */
 
 static inline void flash_set_bit(uint32_t *addr, uint32_t bit)
@@ -71,6 +71,7 @@ uint32_t ftl_save_to_storage(void *pdata, uint16_t offset, uint16_t size);
 uint32_t ftl_load_from_storage(void *pdata, uint16_t offset, uint16_t size);
 
 void ftl_garbage_collect_in_idle(void);
+uint8_t ftl_garbage_collect_in_background(void);
 
 
 
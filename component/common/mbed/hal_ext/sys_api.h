@@ -85,6 +85,13 @@ void sys_adc_calibration(u8 write, u16 *offset, u16 *gain);
   */
 void sys_reset(void);
 
+/**
+  * @brief  called in task context by sys_reset(), software_reset() and ota_platform_reset() right before the reset.
+  * @note   Empty by default, a stack that keeps writes in RAM defines it to commit them.
+  * @retval none
+  */
+void sys_reset_prepare(void);
+
 ///@}
 
 #if defined(CONFIG_PLATFORM_8195A) && (CONFIG_PLATFORM_8195A == 1)
@@ -120,6 +127,7 @@ void sys_cpu_reset(void);
 
 #if (defined(CONFIG_PLATFORM_8710C) && (CONFIG_PLATFORM_8710C == 1))
 uint32_t sys_update_ota_prepare_addr(void);
+uint32_t sys_update_ota_get_curr_fw_addr(void);
 #endif
 
 #ifdef __cplusplus
@@ -177,9 +177,18 @@ void pwmout_pulsewidth_ms(pwmout_t *obj, int ms)
 
 void pwmout_pulsewidth_us(pwmout_t *obj, int us)
 {
-    float value = (float)us / (float)obj->period;
+    // set the pulse directly, a round trip through a float duty can land one us short
+    if (us < 0) {
+        us = 0;
+    } else if ((u32)us > obj->period) {
+        us = obj->period;
+    }
 
-    pwmout_write(obj, value);
+    obj->pulse = (uint32_t)us;
+    if (obj->polarity == 0) {
+        obj->offset_us = obj->period - obj->pulse;
+    }
+    hal_pwm_set_duty (&obj->pwm_hal_adp, obj->period, obj->pulse, obj->offset_us);
 }
 
 void pwmout_startoffset(pwmout_t *obj, float seconds)
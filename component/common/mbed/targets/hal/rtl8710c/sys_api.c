@@ -264,6 +264,20 @@ uint32_t sys_update_ota_prepare_addr(void)
 	return NewFWAddr;
 }
 
+/**
+  * @brief  get the address of the running firmware image.
+  * @retval address of the current fw
+  */
+uint32_t sys_update_ota_get_curr_fw_addr(void)
+{
+	uint32_t targetFWaddr;
+	uint32_t currentFWaddr;
+	uint32_t fw1_sn;
+	uint32_t fw2_sn;
+	get_fw_info(&targetFWaddr, &currentFWaddr, &fw1_sn, &fw2_sn);
+	return currentFWaddr;
+}
+
 /**
   * @brief  disable system fast boot.
   * @retval none
@@ -272,12 +286,21 @@ void sys_disable_fast_boot(void){
 	hal_sys_set_fast_boot(NULL, 0);
 }
 
+/**
+  * @brief  hook run before every software reset, see sys_api.h.
+  * @retval none
+  */
+__weak void sys_reset_prepare(void)
+{
+}
+
 /**
   * @brief  system software reset.
   * @retval none
   */
 void sys_reset(void)
 {
+	sys_reset_prepare();
 	sys_disable_fast_boot();
 	hal_misc_rst_by_wdt();
 }
@@ -288,6 +311,7 @@ void sys_reset(void)
   */
 void software_reset(void)
 {
+	sys_reset_prepare();
 	sys_disable_fast_boot();
 	hci_tp_close();  
 	hal_wlan_pwr_off();
@@ -41,6 +41,11 @@
 #include "queue.h"
 #include "lwip/timeouts.h"
 #include "autoconf.h"
+#if defined(configUSE_HEAP_TRACE) && (configUSE_HEAP_TRACE == 1)
+#include "freertos_heap_rtk.h"
+#else
+#define heapTRACE_TAGGED(tag, call) do { call; } while (0)
+#endif
 #if defined(CONFIG_USE_TCM_HEAP) && CONFIG_USE_TCM_HEAP
 #include "tcm_heap.h"
 #endif
@@ -65,7 +70,8 @@ err_t sys_mbox_new(sys_mbox_t *mbox, int size)
 {
 	(void ) size;
 	
-	*mbox = xQueueCreate( size, sizeof( void * ) );
+	/* Queues and semaphores of lwIP count as lwIP in the heap trace, whichever task asks for them */
+	heapTRACE_TAGGED(heapTAG_LWIP, *mbox = xQueueCreate( size, sizeof( void * ) ));
 
 #if SYS_STATS
       ++lwip_stats.sys.mbox.used;
@@ -232,7 +238,7 @@ void sys_mbox_set_invalid(sys_mbox_t *mbox)
 //  the initial state of the semaphore.
 err_t sys_sem_new(sys_sem_t *sem, u8_t count)
 {
-	vSemaphoreCreateBinary(*sem );
+	heapTRACE_TAGGED(heapTAG_LWIP, vSemaphoreCreateBinary(*sem ));
 	if(*sem == NULL)
 	{
 		
@@ -393,7 +399,7 @@ struct timeoutlist *tl;
 /* Create a new mutex*/
 err_t sys_mutex_new(sys_mutex_t *mutex) {
 
-  *mutex = xSemaphoreCreateMutex();
+  heapTRACE_TAGGED(heapTAG_LWIP, *mutex = xSemaphoreCreateMutex());
 		if(*mutex == NULL)
 	{
 #if SYS_STATS
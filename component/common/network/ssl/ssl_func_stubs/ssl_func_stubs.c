@@ -381,11 +381,33 @@ void init_rom_ssl_hw_crypto_3des_cbc(
 #include "rom_ssl_ram_map.h"
 extern struct _rom_ssl_ram_map rom_ssl_ram_map;
 
+#if defined(configUSE_HEAP_TRACE) && (configUSE_HEAP_TRACE == 1)
+#include "freertos_heap_rtk.h"
+
+/* What the ROM mbedTLS allocates goes through the calloc registered below, tagged for the heap trace */
+static void *(*ssl_traced_calloc_func)(unsigned int, unsigned int);
+
+static void *ssl_traced_calloc(unsigned int nelements, unsigned int elementSize)
+{
+	void *p;
+
+	heapTRACE_TAGGED(heapTAG_MBEDTLS, p = ssl_traced_calloc_func(nelements, elementSize));
+	return p;
+}
+#endif
+
 int platform_set_malloc_free(
 	void *(*ssl_calloc)(unsigned int, unsigned int),
 	void (*ssl_free)(void *)
 )
 {
+#if defined(configUSE_HEAP_TRACE) && (configUSE_HEAP_TRACE == 1)
+	if (ssl_calloc != ssl_traced_calloc) {
+		ssl_traced_calloc_func = ssl_calloc;
+		ssl_calloc = ssl_traced_calloc;
+	}
+#endif
+
 	/* Variables */
 	rom_ssl_ram_map.use_hw_crypto_func = 1;
 	
@@ -76,6 +76,7 @@ task.h is included from an application file. */
 
 #include "FreeRTOS.h"
 #include "task.h"
+#include "heap_trace.h"
 
 #define RTK_CUSTOMIZATION
 #ifdef RTK_CUSTOMIZATION
@@ -100,6 +101,9 @@ typedef struct A_BLOCK_LINK
 {
 	struct A_BLOCK_LINK *pxNextFreeBlock;	/*<< The next free block in the list. */
 	size_t xBlockSize;						/*<< The size of the free block. */
+	#if( configUSE_HEAP_TRACE == 1 )
+		HeapTraceBlock_t xTrace;
+	#endif
 } BlockLink_t;
 
 /*-----------------------------------------------------------*/
@@ -125,6 +129,7 @@ static BlockLink_t xStart, *pxEnd = NULL;
 fragmentation. */
 static size_t xFreeBytesRemaining = 0U;
 static size_t xMinimumEverFreeBytesRemaining = 0U;
+static size_t xHeapBytes = 0U;
 
 /* Gets set to the top bit of an size_t type.  When this bit in the xBlockSize
 member of an BlockLink_t structure is set then the block belongs to the
@@ -134,122 +139,114 @@ static size_t xBlockAllocatedBit = 0;
 
 /*-----------------------------------------------------------*/
 
-void *pvPortMalloc( size_t xWantedSize )
+/*
+ * First fit from the free list, the caller has suspended the scheduler.
+ */
+static void *prvHeapMalloc( size_t xWantedSize )
 {
 BlockLink_t *pxBlock, *pxPreviousBlock, *pxNewBlockLink;
 void *pvReturn = NULL;
 
-	/* The heap must be initialised before the first call to
-	prvPortMalloc(). */
-	configASSERT( pxEnd );
-
-	vTaskSuspendAll();
+	/* Check the requested block size is not so large that the top bit is
+	set.  The top bit of the block size member of the BlockLink_t structure
+	is used to determine who owns the block - the application or the
+	kernel, so it must be free. */
+	if( ( xWantedSize & xBlockAllocatedBit ) == 0 )
 	{
-		/* Check the requested block size is not so large that the top bit is
-		set.  The top bit of the block size member of the BlockLink_t structure
-		is used to determine who owns the block - the application or the
-		kernel, so it must be free. */
-		if( ( xWantedSize & xBlockAllocatedBit ) == 0 )
+		/* The wanted size is increased so it can contain a BlockLink_t
+		structure in addition to the requested amount of bytes. */
+		if( ( xWantedSize > 0 ) &&
+			( ( xWantedSize + xHeapStructSize ) >  xWantedSize ) ) /* Overflow check */
 		{
-			/* The wanted size is increased so it can contain a BlockLink_t
-			structure in addition to the requested amount of bytes. */
-			if( ( xWantedSize > 0 ) &&
-				( ( xWantedSize + xHeapStructSize ) >  xWantedSize ) ) /* Overflow check */
-			{
-				xWantedSize += xHeapStructSize;
+			xWantedSize += xHeapStructSize;
 
-				/* Ensure that blocks are always aligned to the required number
-				of bytes. */
-				if( ( xWantedSize & portBYTE_ALIGNMENT_MASK ) != 0x00 )
+			/* Ensure that blocks are always aligned to the required number
+			of bytes. */
+			if( ( xWantedSize & portBYTE_ALIGNMENT_MASK ) != 0x00 )
+			{
+				/* Byte alignment required. Check for overflow */
+				if( ( xWantedSize + ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) ) ) >
+					xWantedSize )
 				{
-					/* Byte alignment required. Check for overflow */
-					if( ( xWantedSize + ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) ) ) >
-						xWantedSize )
-					{
-						xWantedSize += ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) );
-					} 
-					else 
-					{
-						xWantedSize = 0;
-					}
-				}
-				else
+					xWantedSize += ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) );
+				} 
+				else 
 				{
-					mtCOVERAGE_TEST_MARKER();
+					xWantedSize = 0;
 				}
 			}
 			else
 			{
-				xWantedSize = 0;
+				mtCOVERAGE_TEST_MARKER();
 			}
+		}
+		else
+		{
+			xWantedSize = 0;
+		}
 
-			if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
+		if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
+		{
+			/* Traverse the list from the start	(lowest address) block until
+			one of adequate size is found. */
+			pxPreviousBlock = &xStart;
+			pxBlock = xStart.pxNextFreeBlock;
+			while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != NULL ) )
 			{
-				/* Traverse the list from the start	(lowest address) block until
-				one of adequate size is found. */
-				pxPreviousBlock = &xStart;
-				pxBlock = xStart.pxNextFreeBlock;
-				while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != NULL ) )
-				{
-					pxPreviousBlock = pxBlock;
-					pxBlock = pxBlock->pxNextFreeBlock;
-				}
-
-				/* If the end marker was reached then a block of adequate size
-				was not found. */
-				if( pxBlock != pxEnd )
-				{
-					/* Return the memory space pointed to - jumping over the
-					BlockLink_t structure at its start. */
-					pvReturn = ( void * ) ( ( ( uint8_t * ) pxPreviousBlock->pxNextFreeBlock ) + xHeapStructSize );
+				pxPreviousBlock = pxBlock;
+				pxBlock = pxBlock->pxNextFreeBlock;
+			}
 
-					/* This block is being returned for use so must be taken out
-					of the list of free blocks. */
-					pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+			/* If the end marker was reached then a block of adequate size
+			was not found. */
+			if( pxBlock != pxEnd )
+			{
+				/* Return the memory space pointed to - jumping over the
+				BlockLink_t structure at its start. */
+				pvReturn = ( void * ) ( ( ( uint8_t * ) pxPreviousBlock->pxNextFreeBlock ) + xHeapStructSize );
 
-					/* If the block is larger than required it can be split into
-					two. */
-					if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
-					{
-						/* This block is to be split into two.  Create a new
-						block following the number of bytes requested. The void
-						cast is used to prevent byte alignment warnings from the
-						compiler. */
-						pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
-
-						/* Calculate the sizes of two blocks split from the
-						single block. */
-						pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
-						pxBlock->xBlockSize = xWantedSize;
-
-						/* Insert the new block into the list of free blocks. */
-						prvInsertBlockIntoFreeList( ( pxNewBlockLink ) );
-					}
-					else
-					{
-						mtCOVERAGE_TEST_MARKER();
-					}
+				/* This block is being returned for use so must be taken out
+				of the list of free blocks. */
+				pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
 
-					xFreeBytesRemaining -= pxBlock->xBlockSize;
+				/* If the block is larger than required it can be split into
+				two. */
+				if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+				{
+					/* This block is to be split into two.  Create a new
+					block following the number of bytes requested. The void
+					cast is used to prevent byte alignment warnings from the
+					compiler. */
+					pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+
+					/* Calculate the sizes of two blocks split from the
+					single block. */
+					pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+					pxBlock->xBlockSize = xWantedSize;
+
+					/* Insert the new block into the list of free blocks. */
+					prvInsertBlockIntoFreeList( ( pxNewBlockLink ) );
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
 
-					if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
-					{
-						xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
-					}
-					else
-					{
-						mtCOVERAGE_TEST_MARKER();
-					}
+				xFreeBytesRemaining -= pxBlock->xBlockSize;
 
-					/* The block is being returned - it is allocated and owned
-					by the application and has no "next" block. */
-					pxBlock->xBlockSize |= xBlockAllocatedBit;
-					pxBlock->pxNextFreeBlock = NULL;
+				if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+				{
+					xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
 				}
 				else
 				{
 					mtCOVERAGE_TEST_MARKER();
 				}
+
+				/* The block is being returned - it is allocated and owned
+				by the application and has no "next" block. */
+				pxBlock->xBlockSize |= xBlockAllocatedBit;
+				pxBlock->pxNextFreeBlock = NULL;
 			}
 			else
 			{
@@ -260,6 +257,57 @@ void *pvReturn = NULL;
 		{
 			mtCOVERAGE_TEST_MARKER();
 		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Returns an allocated block to the free list, the caller has suspended the
+ * scheduler.
+ */
+static void prvHeapFree( BlockLink_t *pxLink )
+{
+	/* The block is being returned to the heap - it is no longer
+	allocated. */
+	pxLink->xBlockSize &= ~xBlockAllocatedBit;
+
+	/* Add this block to the list of free blocks. */
+	xFreeBytesRemaining += pxLink->xBlockSize;
+	prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * pvPortMalloc() on behalf of the code at ulCaller, pvPortReAlloc() and
+ * pvPortCalloc() pass on their own caller so the trace names it.
+ */
+static void *prvPortMalloc( size_t xWantedSize, uint32_t ulCaller )
+{
+void *pvReturn = NULL;
+
+	/* The heap must be initialised before the first call to
+	prvPortMalloc(). */
+	configASSERT( pxEnd );
+
+	vTaskSuspendAll();
+	{
+		pvReturn = prvHeapMalloc( xWantedSize );
+
+		#if( configUSE_HEAP_TRACE == 1 )
+		{
+			vPortHeapTraceMalloc( pvReturn, xWantedSize, ulCaller );
+		}
+		#else
+		{
+			( void ) ulCaller;
+		}
+		#endif
 
 		traceMALLOC( pvReturn, xWantedSize );
 	}
@@ -283,11 +331,22 @@ void *pvReturn = NULL;
 }
 /*-----------------------------------------------------------*/
 
-void vPortFree( void *pv )
+void *pvPortMalloc( size_t xWantedSize )
+{
+	return prvPortMalloc( xWantedSize, heapTRACE_CALLER() );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * vPortFree() on behalf of the code at ulCaller.
+ */
+static void prvPortFree( void *pv, uint32_t ulCaller )
 {
 uint8_t *puc = ( uint8_t * ) pv;
 BlockLink_t *pxLink;
 
+	( void ) ulCaller;
+
 	if( pv != NULL )
 	{
 		/* The memory being freed will have an BlockLink_t structure immediately
@@ -299,22 +358,22 @@ BlockLink_t *pxLink;
 
 		/* Check the block is actually allocated. */
 		configASSERT( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 );
+
 		configASSERT( pxLink->pxNextFreeBlock == NULL );
 
 		if( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 )
 		{
 			if( pxLink->pxNextFreeBlock == NULL )
 			{
-				/* The block is being returned to the heap - it is no longer
-				allocated. */
-				pxLink->xBlockSize &= ~xBlockAllocatedBit;
-
 				vTaskSuspendAll();
 				{
-					/* Add this block to the list of free blocks. */
-					xFreeBytesRemaining += pxLink->xBlockSize;
-					traceFREE( pv, pxLink->xBlockSize );
-					prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
+					#if( configUSE_HEAP_TRACE == 1 )
+					{
+						vPortHeapTraceFree( pv, ulCaller );
+					}
+					#endif
+					traceFREE( pv, pxLink->xBlockSize & ~xBlockAllocatedBit );
+					prvHeapFree( pxLink );
 				}
 				( void ) xTaskResumeAll();
 			}
@@ -331,6 +390,12 @@ BlockLink_t *pxLink;
 }
 /*-----------------------------------------------------------*/
 
+void vPortFree( void *pv )
+{
+	prvPortFree( pv, heapTRACE_CALLER() );
+}
+/*-----------------------------------------------------------*/
+
 size_t xPortGetFreeHeapSize( void )
 {
 	return xFreeBytesRemaining;
@@ -489,6 +554,7 @@ const HeapRegion_t *pxHeapRegion;
 
 	xMinimumEverFreeBytesRemaining = xTotalHeapSize;
 	xFreeBytesRemaining = xTotalHeapSize;
+	xHeapBytes = xTotalHeapSize;
 
 	/* Check something was actually defined before it is accessed. */
 	configASSERT( xTotalHeapSize );
@@ -496,10 +562,57 @@ const HeapRegion_t *pxHeapRegion;
 	/* Work out the position of the top bit in a size_t variable. */
 	xBlockAllocatedBit = ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 );
 }
+/*-----------------------------------------------------------*/
+
+size_t xPortGetLargestFreeBlockSize( void )
+{
+BlockLink_t *pxBlock;
+size_t xLargest = 0;
+
+	vTaskSuspendAll();
+	{
+		for( pxBlock = xStart.pxNextFreeBlock; pxBlock != NULL && pxBlock != pxEnd; pxBlock = pxBlock->pxNextFreeBlock )
+		{
+			if( pxBlock->xBlockSize > xLargest )
+			{
+				xLargest = pxBlock->xBlockSize;
+			}
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	/* What a caller can get out of it. */
+	return ( xLargest > xHeapStructSize ) ? xLargest - xHeapStructSize : 0;
+}
+/*-----------------------------------------------------------*/
+
+#if( configUSE_HEAP_TRACE == 1 )
+
+HeapTraceBlock_t *pxPortHeapTraceBlock( void *pv, size_t *pxBytes )
+{
+BlockLink_t *pxLink;
+
+	pxLink = ( void * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+	*pxBytes = pxLink->xBlockSize & ~xBlockAllocatedBit;
+	return &( pxLink->xTrace );
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_HEAP_TRACE */
+
+size_t xPortHeapTraceFigures( HeapTraceStats_t *pxStats )
+{
+	pxStats->xHeapBytes = xHeapBytes;
+	pxStats->xFreeBytes = xFreeBytesRemaining;
+	pxStats->xMinimumEverFreeBytes = xMinimumEverFreeBytesRemaining;
+
+	return xHeapStructSize;
+}
 
 #ifdef RTK_CUSTOMIZATION
 void* pvPortReAlloc( void *pv,  size_t xWantedSize )
 {
+	uint32_t ulCaller = heapTRACE_CALLER();
 	BlockLink_t *pxLink;
 	unsigned char *puc = ( unsigned char * ) pv;
 
@@ -507,37 +620,30 @@ void* pvPortReAlloc( void *pv,  size_t xWantedSize )
 	{
 		if( !xWantedSize )
 		{
-			vPortFree( pv );
+			prvPortFree( pv, ulCaller );
 			return NULL;
 		}
 
-		void *newArea = pvPortMalloc( xWantedSize );
-		if( newArea )
-		{
-			/* The memory being freed will have an xBlockLink structure immediately
-				before it. */
-			puc -= xHeapStructSize;
+		/* The memory being freed will have an xBlockLink structure immediately
+			before it. */
+		puc -= xHeapStructSize;
 
-			/* This casting is to keep the compiler from issuing warnings. */
-			pxLink = ( void * ) puc;
+		/* This casting is to keep the compiler from issuing warnings. */
+		pxLink = ( void * ) puc;
 
+		void *newArea = prvPortMalloc( xWantedSize, ulCaller );
+		if( newArea )
+		{
 			int oldSize =  (pxLink->xBlockSize & ~xBlockAllocatedBit) - xHeapStructSize;
 			int copySize = ( oldSize < xWantedSize ) ? oldSize : xWantedSize;
 			memcpy( newArea, pv, copySize );
 
-			vTaskSuspendAll();
-			{
-				/* Add this block to the list of free blocks. */
-				pxLink->xBlockSize &= ~xBlockAllocatedBit;
-				xFreeBytesRemaining += pxLink->xBlockSize;
-				prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
-			}
-			xTaskResumeAll();
+			prvPortFree( pv, ulCaller );
 			return newArea;
 		}
 	}
 	else if( xWantedSize )
-		return pvPortMalloc( xWantedSize );
+		return prvPortMalloc( xWantedSize, ulCaller );
 	else
 		return NULL;
 
@@ -549,11 +655,11 @@ void *pvPortCalloc(size_t xWantedCnt, size_t xWantedSize)
 	void *p;
 
 	/* allocate 'xWantedCnt' objects of size 'xWantedSize' */
-	p = pvPortMalloc(xWantedCnt * xWantedSize);
+	p = prvPortMalloc(xWantedCnt * xWantedSize, heapTRACE_CALLER());
 	if (p) {
 		/* zero the memory */
 		memset(p, 0, xWantedCnt * xWantedSize);
 	}
 	return p;
 }
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+#ifndef __FREERTOS_HEAP_RTK_H_
+#define __FREERTOS_HEAP_RTK_H_
+
+#include "FreeRTOS.h"
+
+/* Size of the largest block in the free list of the heap. */
+size_t xPortGetLargestFreeBlockSize( void );
+
+/*
+ * Allocation trace of heap_trace.c, for heap_5.c and freertos_heap_rtk.c. Define
+ * configUSE_HEAP_TRACE to 1 for the whole build to tag every block with the subsystem that asked for
+ * it and the tick it was handed out, to keep live and peak bytes per subsystem,
+ * and to record allocations and frees in a ring of configHEAP_TRACE_RECORDS
+ * entries. Blocks grow by eight bytes of header while the trace is built in.
+ * The ATSH command prints the figures and dumps the ring, tools/heap/trace
+ * turns the dump into a report.
+ *
+ * HEAP_TRACE_MAKE_OPTION in application.is.matter.mk defines it for the GCC
+ * Matter build. Code that tags its allocations includes this header only when
+ * the trace is built in.
+ */
+#ifndef configUSE_HEAP_TRACE
+	#define configUSE_HEAP_TRACE		0
+#endif
+
+#ifndef configHEAP_TRACE_RECORDS
+	#define configHEAP_TRACE_RECORDS	256
+#endif
+
+/* Tasks that can hold a tag set by uxPortHeapTraceSetTag() at the same time. */
+#ifndef configHEAP_TRACE_TASKS
+	#define configHEAP_TRACE_TASKS		16
+#endif
+
+/* Tags of the tasks that hold none set by uxPortHeapTraceSetTag(), by the
+start of the task name. Allocations of other tasks count as heapTAG_APP. */
+#ifndef configHEAP_TRACE_TASK_NAMES
+	#define configHEAP_TRACE_TASK_NAMES	{ "TCP_IP", heapTAG_LWIP }, { "CHIP", heapTAG_MATTER }, { "matter", heapTAG_MATTER }
+#endif
+
+#define heapTAG_APP					0
+#define heapTAG_LWIP				1
+#define heapTAG_MBEDTLS				2
+#define heapTAG_MATTER				3
+#define heapTAG_BT					4
+#define heapTAG_WLAN				5
+#define heapTAGS					6
+#define heapTAG_TASK				0xF		/* No tag set, the task name decides. */
+
+/* Events in the ulInfo member of a trace record. */
+#define heapTRACE_MALLOC			1
+#define heapTRACE_FREE				2
+#define heapTRACE_FAILED			3
+
+#define heapTRACE_SIZE( ulInfo )	( ( ulInfo ) & 0x00FFFFFFUL )
+#define heapTRACE_TAG( ulInfo )		( ( ( ulInfo ) >> 24 ) & 0xFUL )
+#define heapTRACE_EVENT( ulInfo )	( ( ulInfo ) >> 28 )
+
+typedef struct xHEAP_TRACE_RECORD
+{
+	uint32_t ulTime;			/* Tick of the event. */
+	uint32_t ulAddress;			/* Block handed out or given back, 0 for a failed request. */
+	uint32_t ulCaller;			/* Return address into the caller of pvPortMalloc() or vPortFree(). */
+	uint32_t ulInfo;			/* Bytes asked for in bits 0 to 23, tag in bits 24 to 27, event in bits 28 to 31. */
+	uint32_t ulLifetime;		/* Ticks the block was held, for a free. */
+} HeapTraceRecord_t;
+
+typedef struct xHEAP_TRACE_TAG_STATS
+{
+	size_t xLiveBytes;			/* Heap bytes held, headers and alignment included. */
+	size_t xPeakBytes;
+	size_t xLiveBlocks;
+	size_t xAllocations;
+	size_t xFailures;
+} HeapTraceTagStats_t;
+
+typedef struct xHEAP_TRACE_STATS
+{
+	HeapTraceTagStats_t xTags[ heapTAGS ];
+	size_t xHeapBytes;
+	size_t xFreeBytes;
+	size_t xMinimumEverFreeBytes;
+	size_t xLargestFreeBlock;
+	uint32_t ulFragmentation;	/* Per mille of the free bytes outside the largest free block. */
+	uint32_t ulEvents;			/* Recorded since the last clear, the ring keeps the latest. */
+	uint32_t ulTime;
+} HeapTraceStats_t;
+
+/*
+ * Sets the tag of the allocations of the calling task and returns the one it
+ * replaces, heapTAG_TASK hands the decision back to the task name. Code that
+ * allocates on behalf of a subsystem wraps the call with heapTRACE_TAGGED().
+ */
+UBaseType_t uxPortHeapTraceSetTag( UBaseType_t uxTag );
+
+/* Starts or stops recording into the ring and returns the previous state, the accounting goes on. */
+BaseType_t xPortHeapTraceRecord( BaseType_t xRecord );
+
+/* Empties the ring and brings the peaks down to the live figures. */
+void vPortHeapTraceClear( void );
+
+void vPortGetHeapTraceStats( HeapTraceStats_t *pxStats );
+
+/*
+ * Copies event ulEvent, counted from the last clear, out of the ring. Returns
+ * pdFALSE when it has not happened yet or has been overwritten.
+ */
+BaseType_t xPortGetHeapTraceRecord( uint32_t ulEvent, HeapTraceRecord_t *pxRecord );
+
+#if( configUSE_HEAP_TRACE == 1 )
+	#define heapTRACE_TAGGED( uxTag, xCall )												\
+		do {																				\
+			UBaseType_t uxHeapTracePrevious = uxPortHeapTraceSetTag( uxTag );				\
+			xCall;																			\
+			( void ) uxPortHeapTraceSetTag( uxHeapTracePrevious );							\
+		} while( 0 )
+#else
+	#define heapTRACE_TAGGED( uxTag, xCall )	do { xCall; } while( 0 )
+#endif
+
+#endif
@@ -68,6 +68,7 @@
  *
  */
 #include <stdlib.h>
+#include <string.h>
 
 /* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
 all the API functions to use the MPU wrappers.  That should only be done when
@@ -77,6 +78,7 @@ task.h is included from an application file. */
 #include "FreeRTOS.h"
 #include "task.h"
 #include "platform_opts.h"
+#include "heap_trace.h"
 
 #undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
 
@@ -96,6 +98,9 @@ typedef struct A_BLOCK_LINK
 {
 	struct A_BLOCK_LINK *pxNextFreeBlock;	/*<< The next free block in the list. */
 	size_t xBlockSize;						/*<< The size of the free block. */
+	#if( configUSE_HEAP_TRACE == 1 )
+		HeapTraceBlock_t xTrace;
+	#endif
 } BlockLink_t;
 
 /*-----------------------------------------------------------*/
@@ -121,6 +126,7 @@ static BlockLink_t xStart, *pxEnd = NULL;
 fragmentation. */
 static size_t xFreeBytesRemaining = 0U;
 static size_t xMinimumEverFreeBytesRemaining = 0U;
+static size_t xHeapBytes = 0U;
 
 /* Gets set to the top bit of an size_t type.  When this bit in the xBlockSize
 member of an BlockLink_t structure is set then the block belongs to the
@@ -243,10 +249,17 @@ __WEAK BaseType_t xTaskResumeAll( void )
 }
 #endif
 
-void *pvPortMalloc( size_t xWantedSize )
+/*
+ * pvPortMalloc() on behalf of the code at ulCaller, pvPortReAlloc() and
+ * pvPortCalloc() pass on their own caller so the trace names it.
+ */
+static void *prvPortMalloc( size_t xWantedSize, uint32_t ulCaller )
 {
 BlockLink_t *pxBlock, *pxPreviousBlock, *pxNewBlockLink;
 void *pvReturn = NULL;
+#if( configUSE_HEAP_TRACE == 1 )
+size_t xRequestedSize = xWantedSize;
+#endif
 
 	/* Realtek test code start */
 	if(pxEnd == NULL)
@@ -274,6 +287,7 @@ void *pvReturn = NULL;
 
 	vTaskSuspendAll();
 	{
+
 		/* Check the requested block size is not so large that the top bit is
 		set.  The top bit of the block size member of the BlockLink_t structure
 		is used to determine who owns the block - the application or the
@@ -390,6 +404,16 @@ void *pvReturn = NULL;
 			mtCOVERAGE_TEST_MARKER();
 		}
 
+		#if( configUSE_HEAP_TRACE == 1 )
+		{
+			vPortHeapTraceMalloc( pvReturn, xRequestedSize, ulCaller );
+		}
+		#else
+		{
+			( void ) ulCaller;
+		}
+		#endif
+
 		traceMALLOC( pvReturn, xWantedSize );
 	}
 	( void ) xTaskResumeAll();
@@ -412,11 +436,22 @@ void *pvReturn = NULL;
 }
 /*-----------------------------------------------------------*/
 
-void __vPortFree( void *pv )
+void *pvPortMalloc( size_t xWantedSize )
+{
+	return prvPortMalloc( xWantedSize, heapTRACE_CALLER() );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * __vPortFree() on behalf of the code at ulCaller.
+ */
+static void prvPortFree( void *pv, uint32_t ulCaller )
 {
 uint8_t *puc = ( uint8_t * ) pv;
 BlockLink_t *pxLink;
 
+	( void ) ulCaller;
+
 	if( pv != NULL )
 	{
 		/* The memory being freed will have an BlockLink_t structure immediately
@@ -440,6 +475,12 @@ BlockLink_t *pxLink;
 
 				vTaskSuspendAll();
 				{
+					#if( configUSE_HEAP_TRACE == 1 )
+					{
+						vPortHeapTraceFree( pv, ulCaller );
+					}
+					#endif
+
 					/* Add this block to the list of free blocks. */
 					xFreeBytesRemaining += pxLink->xBlockSize;
 					traceFREE( pv, pxLink->xBlockSize );
@@ -458,6 +499,12 @@ BlockLink_t *pxLink;
 		}
 	}
 }
+/*-----------------------------------------------------------*/
+
+void __vPortFree( void *pv )
+{
+	prvPortFree( pv, heapTRACE_CALLER() );
+}
 
 /*-----------------------------------------------------------*/
 /* Add by Alfa 2015/02/04 -----------------------------------*/
@@ -477,7 +524,7 @@ void vPortFree( void *pv )
 		// use external free function
 		if( ext_free )	ext_free( pv );
 	}else
-		__vPortFree( pv );
+		prvPortFree( pv, heapTRACE_CALLER() );
 }
 
 /*-----------------------------------------------------------*/
@@ -666,6 +713,7 @@ const HeapRegion_t *pxHeapRegion;
 
 	xMinimumEverFreeBytesRemaining = xTotalHeapSize;
 	xFreeBytesRemaining = xTotalHeapSize;
+	xHeapBytes = xTotalHeapSize;
 
 	/* Check something was actually defined before it is accessed. */
 	configASSERT( xTotalHeapSize );
@@ -673,9 +721,57 @@ const HeapRegion_t *pxHeapRegion;
 	/* Work out the position of the top bit in a size_t variable. */
 	xBlockAllocatedBit = ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 );
 }
+/*-----------------------------------------------------------*/
+
+size_t xPortGetLargestFreeBlockSize( void )
+{
+BlockLink_t *pxBlock;
+size_t xLargest = 0;
+
+	vTaskSuspendAll();
+	{
+		for( pxBlock = xStart.pxNextFreeBlock; pxBlock != NULL && pxBlock != pxEnd; pxBlock = pxBlock->pxNextFreeBlock )
+		{
+			if( pxBlock->xBlockSize > xLargest )
+			{
+				xLargest = pxBlock->xBlockSize;
+			}
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	/* What a caller can get out of it. */
+	return ( xLargest > xHeapStructSize ) ? xLargest - xHeapStructSize : 0;
+}
+/*-----------------------------------------------------------*/
+
+#if( configUSE_HEAP_TRACE == 1 )
+
+HeapTraceBlock_t *pxPortHeapTraceBlock( void *pv, size_t *pxBytes )
+{
+BlockLink_t *pxLink;
+
+	pxLink = ( void * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+	*pxBytes = pxLink->xBlockSize & ~xBlockAllocatedBit;
+	return &( pxLink->xTrace );
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_HEAP_TRACE */
+
+size_t xPortHeapTraceFigures( HeapTraceStats_t *pxStats )
+{
+	pxStats->xHeapBytes = xHeapBytes;
+	pxStats->xFreeBytes = xFreeBytesRemaining;
+	pxStats->xMinimumEverFreeBytes = xMinimumEverFreeBytesRemaining;
+
+	return xHeapStructSize;
+}
+/*-----------------------------------------------------------*/
 
 void* pvPortReAlloc( void *pv,  size_t xWantedSize )
 {
+	uint32_t ulCaller = heapTRACE_CALLER();
 	BlockLink_t *pxLink;
 
 	if( ((uint32_t)pv >= ext_lower) && ((uint32_t)pv < ext_upper) ){
@@ -689,11 +785,11 @@ void* pvPortReAlloc( void *pv,  size_t xWantedSize )
 	{
 		if( !xWantedSize )
 		{
-			vPortFree( pv );
+			prvPortFree( pv, ulCaller );
 			return NULL;
 		}
 
-		void *newArea = pvPortMalloc( xWantedSize );
+		void *newArea = prvPortMalloc( xWantedSize, ulCaller );
 		if( newArea )
 		{
 			/* The memory being freed will have an xBlockLink structure immediately
@@ -707,19 +803,12 @@ void* pvPortReAlloc( void *pv,  size_t xWantedSize )
 			int copySize = ( oldSize < xWantedSize ) ? oldSize : xWantedSize;
 			memcpy( newArea, pv, copySize );
 
-			vTaskSuspendAll();
-			{
-				/* Add this block to the list of free blocks. */
-				pxLink->xBlockSize &= ~xBlockAllocatedBit;
-				xFreeBytesRemaining += pxLink->xBlockSize;
-				prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
-			}
-			xTaskResumeAll();
+			prvPortFree( pv, ulCaller );
 			return newArea;
 		}
 	}
 	else if( xWantedSize )
-		return pvPortMalloc( xWantedSize );
+		return prvPortMalloc( xWantedSize, ulCaller );
 	else
 		return NULL;
 
@@ -731,7 +820,7 @@ void *pvPortCalloc(size_t xWantedCnt, size_t xWantedSize)
 	void *p;
 
 	/* allocate 'xWantedCnt' objects of size 'xWantedSize' */
-	p = pvPortMalloc(xWantedCnt * xWantedSize);
+	p = prvPortMalloc(xWantedCnt * xWantedSize, heapTRACE_CALLER());
 	if (p) {
 		/* zero the memory */
 		memset(p, 0, xWantedCnt * xWantedSize);
@@ -0,0 +1,329 @@
+/*
+ * Allocation trace shared by heap_5.c and freertos_heap_rtk.c, see
+ * freertos_heap_rtk.h. The heap calls vPortHeapTraceMalloc() and
+ * vPortHeapTraceFree() with the scheduler suspended and finds the trace header
+ * of a block for it through pxPortHeapTraceBlock().
+ */
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "heap_trace.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configUSE_HEAP_TRACE == 1 )
+
+typedef struct HEAP_TRACE_TASK
+{
+	TaskHandle_t xTask;				/*<< NULL while the entry is unused. */
+	UBaseType_t uxTag;
+} HeapTraceTask_t;
+
+typedef struct HEAP_TRACE_TASK_NAME
+{
+	const char *pcPrefix;
+	UBaseType_t uxTag;
+} HeapTraceTaskName_t;
+
+static HeapTraceRecord_t xTraceRecords[ configHEAP_TRACE_RECORDS ];
+static uint32_t ulTraceEvents = 0;		/*<< Recorded since the last clear, the next goes to ulTraceEvents % configHEAP_TRACE_RECORDS. */
+static BaseType_t xTraceRecording = pdTRUE;
+static HeapTraceTagStats_t xTraceTags[ heapTAGS ];
+static HeapTraceTask_t xTraceTasks[ configHEAP_TRACE_TASKS ];
+static const HeapTraceTaskName_t xTraceTaskNames[] = { configHEAP_TRACE_TASK_NAMES };
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Task the tags are kept for, NULL before the scheduler runs.
+ */
+static TaskHandle_t prvHeapTraceTask( void )
+{
+	if( xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED )
+	{
+		return NULL;
+	}
+
+	return xTaskGetCurrentTaskHandle();
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Tag of an allocation by the calling task, the caller has suspended the
+ * scheduler.
+ */
+static UBaseType_t prvHeapTraceTag( void )
+{
+TaskHandle_t xTask = prvHeapTraceTask();
+const char *pcName;
+UBaseType_t ux;
+
+	if( xTask == NULL )
+	{
+		return heapTAG_APP;
+	}
+
+	for( ux = 0; ux < configHEAP_TRACE_TASKS; ux++ )
+	{
+		if( xTraceTasks[ ux ].xTask == xTask )
+		{
+			return xTraceTasks[ ux ].uxTag;
+		}
+	}
+
+	pcName = pcTaskGetName( xTask );
+	for( ux = 0; ux < sizeof( xTraceTaskNames ) / sizeof( xTraceTaskNames[ 0 ] ); ux++ )
+	{
+		if( strncmp( pcName, xTraceTaskNames[ ux ].pcPrefix, strlen( xTraceTaskNames[ ux ].pcPrefix ) ) == 0 )
+		{
+			return xTraceTaskNames[ ux ].uxTag;
+		}
+	}
+
+	return heapTAG_APP;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapTraceEvent( uint32_t ulEvent, void *pv, uint32_t ulInfo, uint32_t ulCaller, uint32_t ulLifetime )
+{
+HeapTraceRecord_t *pxRecord;
+
+	if( xTraceRecording != pdFALSE )
+	{
+		pxRecord = &( xTraceRecords[ ulTraceEvents % configHEAP_TRACE_RECORDS ] );
+		ulTraceEvents++;
+
+		pxRecord->ulTime = ( uint32_t ) xTaskGetTickCount();
+		pxRecord->ulAddress = ( uint32_t ) pv;
+		pxRecord->ulCaller = ulCaller;
+		pxRecord->ulInfo = ulInfo | ( ulEvent << 28 );
+		pxRecord->ulLifetime = ulLifetime;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortHeapTraceMalloc( void *pv, size_t xWantedSize, uint32_t ulCaller )
+{
+UBaseType_t uxTag = prvHeapTraceTag();
+HeapTraceTagStats_t *pxTag = &( xTraceTags[ uxTag ] );
+uint32_t ulInfo = ( ( uint32_t ) xWantedSize & 0x00FFFFFFUL ) | ( ( uint32_t ) uxTag << 24 );
+HeapTraceBlock_t *pxTrace;
+size_t xBytes;
+
+	if( pv == NULL )
+	{
+		if( xWantedSize > 0 )
+		{
+			pxTag->xFailures++;
+			prvHeapTraceEvent( heapTRACE_FAILED, NULL, ulInfo, ulCaller, 0 );
+		}
+		return;
+	}
+
+	pxTrace = pxPortHeapTraceBlock( pv, &xBytes );
+	pxTrace->ulTime = ( uint32_t ) xTaskGetTickCount();
+	pxTrace->ulInfo = ulInfo;
+
+	pxTag->xAllocations++;
+	pxTag->xLiveBlocks++;
+	pxTag->xLiveBytes += xBytes;
+	if( pxTag->xLiveBytes > pxTag->xPeakBytes )
+	{
+		pxTag->xPeakBytes = pxTag->xLiveBytes;
+	}
+
+	prvHeapTraceEvent( heapTRACE_MALLOC, pv, ulInfo, ulCaller, 0 );
+}
+/*-----------------------------------------------------------*/
+
+void vPortHeapTraceFree( void *pv, uint32_t ulCaller )
+{
+size_t xBytes;
+HeapTraceBlock_t *pxTrace = pxPortHeapTraceBlock( pv, &xBytes );
+HeapTraceTagStats_t *pxTag = &( xTraceTags[ heapTRACE_TAG( pxTrace->ulInfo ) ] );
+
+	pxTag->xLiveBlocks--;
+	pxTag->xLiveBytes -= xBytes;
+
+	prvHeapTraceEvent( heapTRACE_FREE, pv, pxTrace->ulInfo, ulCaller, ( uint32_t ) xTaskGetTickCount() - pxTrace->ulTime );
+}
+
+#endif /* configUSE_HEAP_TRACE */
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortHeapTraceSetTag( UBaseType_t uxTag )
+{
+UBaseType_t uxPrevious = heapTAG_TASK;
+
+	#if( configUSE_HEAP_TRACE == 1 )
+	{
+	TaskHandle_t xTask = prvHeapTraceTask();
+	HeapTraceTask_t *pxEntry = NULL, *pxUnused = NULL;
+	UBaseType_t ux;
+
+		configASSERT( ( uxTag < heapTAGS ) || ( uxTag == heapTAG_TASK ) );
+
+		/* Before the scheduler runs everything counts as heapTAG_APP. */
+		if( xTask == NULL )
+		{
+			return heapTAG_TASK;
+		}
+
+		vTaskSuspendAll();
+		{
+			for( ux = 0; ux < configHEAP_TRACE_TASKS; ux++ )
+			{
+				if( xTraceTasks[ ux ].xTask == xTask )
+				{
+					pxEntry = &( xTraceTasks[ ux ] );
+				}
+				else if( ( xTraceTasks[ ux ].xTask == NULL ) && ( pxUnused == NULL ) )
+				{
+					pxUnused = &( xTraceTasks[ ux ] );
+				}
+			}
+
+			if( pxEntry != NULL )
+			{
+				uxPrevious = pxEntry->uxTag;
+				if( uxTag == heapTAG_TASK )
+				{
+					pxEntry->xTask = NULL;
+				}
+				else
+				{
+					pxEntry->uxTag = uxTag;
+				}
+			}
+			else if( ( uxTag != heapTAG_TASK ) && ( pxUnused != NULL ) )
+			{
+				/* With every entry taken the task keeps the tag of its name. */
+				pxUnused->xTask = xTask;
+				pxUnused->uxTag = uxTag;
+			}
+		}
+		( void ) xTaskResumeAll();
+	}
+	#else
+	{
+		( void ) uxTag;
+	}
+	#endif
+
+	return uxPrevious;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortHeapTraceRecord( BaseType_t xRecord )
+{
+BaseType_t xPrevious = pdFALSE;
+
+	#if( configUSE_HEAP_TRACE == 1 )
+	{
+		vTaskSuspendAll();
+		{
+			xPrevious = xTraceRecording;
+			xTraceRecording = xRecord;
+		}
+		( void ) xTaskResumeAll();
+	}
+	#else
+	{
+		( void ) xRecord;
+	}
+	#endif
+
+	return xPrevious;
+}
+/*-----------------------------------------------------------*/
+
+void vPortHeapTraceClear( void )
+{
+	#if( configUSE_HEAP_TRACE == 1 )
+	{
+	UBaseType_t ux;
+
+		vTaskSuspendAll();
+		{
+			ulTraceEvents = 0;
+			for( ux = 0; ux < heapTAGS; ux++ )
+			{
+				xTraceTags[ ux ].xPeakBytes = xTraceTags[ ux ].xLiveBytes;
+				xTraceTags[ ux ].xAllocations = 0;
+				xTraceTags[ ux ].xFailures = 0;
+			}
+		}
+		( void ) xTaskResumeAll();
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapTraceStats( HeapTraceStats_t *pxStats )
+{
+size_t xLargest = xPortGetLargestFreeBlockSize();
+size_t xHeader;
+
+	memset( pxStats, 0, sizeof( HeapTraceStats_t ) );
+
+	vTaskSuspendAll();
+	{
+		#if( configUSE_HEAP_TRACE == 1 )
+		{
+			memcpy( pxStats->xTags, xTraceTags, sizeof( xTraceTags ) );
+			pxStats->ulEvents = ulTraceEvents;
+		}
+		#endif
+
+		xHeader = xPortHeapTraceFigures( pxStats );
+	}
+	( void ) xTaskResumeAll();
+
+	pxStats->xLargestFreeBlock = xLargest;
+	pxStats->ulTime = ( uint32_t ) xTaskGetTickCount();
+
+	/* The free space in one block, header and all, is no fragmentation. */
+	if( ( pxStats->xFreeBytes > 0 ) && ( xLargest > 0 ) )
+	{
+		xLargest += xHeader;
+		pxStats->ulFragmentation = ( xLargest < pxStats->xFreeBytes ) ?
+			( uint32_t ) ( 1000 - ( ( uint64_t ) xLargest * 1000 ) / pxStats->xFreeBytes ) : 0;
+	}
+	else if( pxStats->xFreeBytes > 0 )
+	{
+		pxStats->ulFragmentation = 1000;
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortGetHeapTraceRecord( uint32_t ulEvent, HeapTraceRecord_t *pxRecord )
+{
+BaseType_t xReturn = pdFALSE;
+
+	#if( configUSE_HEAP_TRACE == 1 )
+	{
+		vTaskSuspendAll();
+		{
+			if( ( ulEvent < ulTraceEvents ) && ( ( ulTraceEvents - ulEvent ) <= configHEAP_TRACE_RECORDS ) )
+			{
+				*pxRecord = xTraceRecords[ ulEvent % configHEAP_TRACE_RECORDS ];
+				xReturn = pdTRUE;
+			}
+		}
+		( void ) xTaskResumeAll();
+	}
+	#else
+	{
+		( void ) ulEvent;
+		( void ) pxRecord;
+	}
+	#endif
+
+	return xReturn;
+}
@@ -0,0 +1,64 @@
+#ifndef __HEAP_TRACE_H_
+#define __HEAP_TRACE_H_
+
+#include "FreeRTOS.h"
+#include "freertos_heap_rtk.h"
+
+#if( configUSE_HEAP_TRACE == 1 ) && defined( __ICCARM__ )
+	#include <intrinsics.h>
+#endif
+
+/*
+ * What heap_trace.c needs from the heap it traces, heap_5.c or
+ * freertos_heap_rtk.c, and what the heap calls into it. The application uses
+ * the API in freertos_heap_rtk.h.
+ */
+
+/* Return address of the function that uses it, for the heap trace. */
+#if( configUSE_HEAP_TRACE == 1 ) && defined( __GNUC__ )
+	#define heapTRACE_CALLER()	( ( uint32_t ) __builtin_return_address( 0 ) )
+#elif( configUSE_HEAP_TRACE == 1 ) && defined( __ICCARM__ )
+	#define heapTRACE_CALLER()	( ( uint32_t ) __get_LR() )
+#else
+	#define heapTRACE_CALLER()	( 0UL )
+#endif
+
+/* Tick an allocated block was handed out, and the bytes asked for and the tag
+laid out as in HeapTraceRecord_t. The heap keeps one in the header of every
+block while the trace is built in. */
+typedef struct HEAP_TRACE_BLOCK
+{
+	uint32_t ulTime;
+	uint32_t ulInfo;
+} HeapTraceBlock_t;
+
+#if( configUSE_HEAP_TRACE == 1 )
+
+/*
+ * Tags the block pvPortMalloc() is about to return and books it, a failed
+ * request passes pv NULL. The caller has suspended the scheduler.
+ */
+void vPortHeapTraceMalloc( void *pv, size_t xWantedSize, uint32_t ulCaller );
+
+/*
+ * Books the block vPortFree() is about to give back, the caller has suspended
+ * the scheduler.
+ */
+void vPortHeapTraceFree( void *pv, uint32_t ulCaller );
+
+/*
+ * Hook of the heap. Tick and tag of the allocated block at pv, *pxBytes gets
+ * the heap bytes the block holds.
+ */
+HeapTraceBlock_t *pxPortHeapTraceBlock( void *pv, size_t *pxBytes );
+
+#endif /* configUSE_HEAP_TRACE */
+
+/*
+ * Hook of the heap. Fills in the heap, free and minimum ever free bytes of
+ * pxStats, the caller has suspended the scheduler. Returns the bytes of the
+ * header in front of every block.
+ */
+size_t xPortHeapTraceFigures( HeapTraceStats_t *pxStats );
+
+#endif
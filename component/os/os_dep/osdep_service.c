@@ -7,6 +7,11 @@
 #if defined(CONFIG_USE_TCM_HEAP) && CONFIG_USE_TCM_HEAP
 #include "tcm_heap.h"
 #endif
+#if defined(PLATFORM_FREERTOS) && defined(configUSE_HEAP_TRACE) && (configUSE_HEAP_TRACE == 1)
+#include "freertos_heap_rtk.h"
+#else
+#define heapTRACE_TAGGED(tag, call) do { call; } while (0)
+#endif
 
 #define OSDEP_DBG(x, ...) do {} while(0)
 
@@ -85,7 +90,8 @@ u8* _rtw_vmalloc(u32 sz)
 #endif
 	if(pbuf==NULL){
 		if(osdep_service.rtw_vmalloc) {
-			pbuf = osdep_service.rtw_vmalloc(sz);
+			/* The heap trace counts what the driver allocates through the osdep service as WLAN */
+			heapTRACE_TAGGED(heapTAG_WLAN, pbuf = osdep_service.rtw_vmalloc(sz));
 		} else
 			OSDEP_DBG("Not implement osdep service: rtw_vmalloc");	
 	}
@@ -100,7 +106,7 @@ u8* _rtw_zvmalloc(u32 sz)
 #endif
 	if(pbuf==NULL){
 		if(osdep_service.rtw_zvmalloc) {
-			pbuf = osdep_service.rtw_zvmalloc(sz);
+			heapTRACE_TAGGED(heapTAG_WLAN, pbuf = osdep_service.rtw_zvmalloc(sz));
 		} else
 			OSDEP_DBG("Not implement osdep service: rtw_zvmalloc");	
 	}
@@ -126,7 +132,8 @@ void _rtw_vmfree(u8 *pbuf, u32 sz)
 u8* _rtw_malloc(u32 sz)
 {
 	if(osdep_service.rtw_malloc) {
-		u8 *pbuf = osdep_service.rtw_malloc(sz);
+		u8 *pbuf;
+		heapTRACE_TAGGED(heapTAG_WLAN, pbuf = osdep_service.rtw_malloc(sz));
 		return pbuf;
 	} else
 		OSDEP_DBG("Not implement osdep service: rtw_malloc");	
@@ -137,7 +144,8 @@ u8* _rtw_malloc(u32 sz)
 u8* _rtw_zmalloc(u32 sz)
 {
 	if(osdep_service.rtw_zmalloc) {
-		u8 *pbuf = osdep_service.rtw_zmalloc(sz);
+		u8 *pbuf;
+		heapTRACE_TAGGED(heapTAG_WLAN, pbuf = osdep_service.rtw_zmalloc(sz));
 		return pbuf;
 	} else
 		OSDEP_DBG("Not implement osdep service: rtw_zmalloc");	
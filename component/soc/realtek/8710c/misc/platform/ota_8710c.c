@@ -31,6 +31,7 @@ void update_free(void *buf){
 }
 
 void ota_platform_reset(void){
+	sys_reset_prepare();
 	sys_disable_fast_boot();
 	hal_misc_rst_by_wdt();
 	while(1) osDelay(1000);
@@ -62,6 +62,9 @@ ROMIMG =
 # Uncomment to enable multiple BLE with matter
 #BLE_MATTER_ADAPTER = 1
 
+# Uncomment to trace the heap allocations of heap_5.c, ATSH prints them
+#HEAP_TRACE_MAKE_OPTION = 1
+
 # Include folder list
 # -------------------------------------------------------------------
 
@@ -412,7 +415,10 @@ SRC_C += ../../../component/common/utilities/gb2unicode.c
 
 #matter - app
 SRC_C += ../../../component/common/application/matter/common/port/matter_dcts.c
+SRC_C += ../../../component/common/application/matter/common/port/matter_kvs_log.c
 SRC_C += ../../../component/common/application/matter/common/port/matter_ota.c
+SRC_C += ../../../component/common/application/matter/common/port/matter_ota_delta.c
+SRC_C += ../../../component/common/application/matter/common/port/matter_ota_lz.c
 SRC_C += ../../../component/common/application/matter/common/port/matter_timers.c
 SRC_C += ../../../component/common/application/matter/common/port/matter_utils.c
 SRC_C += ../../../component/common/application/matter/common/port/matter_wifis.c
@@ -611,6 +617,7 @@ SRC_C += ../../../component/os/freertos/freertos_cb.c
 SRC_C += ../../../component/os/freertos/freertos_service.c
 SRC_C += ../../../component/os/os_dep/osdep_service.c
 SRC_C += ../../../component/os/freertos/freertos_pmu.c
+SRC_C += ../../../component/os/freertos/heap_trace.c
 
 #os - freertos
 SRC_C += ../../../component/os/freertos/freertos_v10.0.1/Source/croutine.c
@@ -766,6 +773,11 @@ else
 CFLAGS += -DCONFIG_SYSTEM_TIME64=0
 endif
 
+# for heap trace
+ifdef HEAP_TRACE_MAKE_OPTION
+CFLAGS += -DconfigUSE_HEAP_TRACE=1
+endif
+
 # for matter mesh
 ifdef BT_MATTER_MESH_ADAPTER
 CFLAGS += -DCONFIG_BT_MESH_WITH_MATTER=1
@@ -782,6 +794,9 @@ CFLAGS += -DCONFIG_ENABLE_OTA_REQUESTOR=1
 CFLAGS += -DCONFIG_ENABLE_MATTER_PRNG=0
 CFLAGS += -DCONFIG_ENABLE_FACTORY_DATA_ENCRYPTION=0
 CFLAGS += -DCONFIG_ENABLE_DCT_ENCRYPTION=0
+# the log-structured KVS takes over the DCT1 + DCT2 flash (DCT_BEGIN_ADDR2, 84K) without migrating it,
+# switching this either way loses the stored fabrics and keys and the device must be commissioned again
+CFLAGS += -DCONFIG_ENABLE_MATTER_KVS_LOG=0
 CFLAGS += -DMBEDTLS_CONFIG_FILE=\"mbedtls_config.h\"
 
 CPPFLAGS := $(CFLAGS)
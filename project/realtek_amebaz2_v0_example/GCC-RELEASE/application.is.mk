@@ -416,6 +416,7 @@ SRC_C += ../../../component/os/freertos/freertos_cb.c
 SRC_C += ../../../component/os/freertos/freertos_service.c
 SRC_C += ../../../component/os/os_dep/osdep_service.c
 SRC_C += ../../../component/os/freertos/freertos_pmu.c
+SRC_C += ../../../component/os/freertos/heap_trace.c
 
 #os - freertos
 SRC_C += ../../../component/os/freertos/freertos_v10.0.1/Source/croutine.c
@@ -0,0 +1,13 @@
+/* Host stand-in for the SDK flash API, backed by the simulated flash in flash_fatfs_sim.c */
+#ifndef _FLASH_API_H_
+#define _FLASH_API_H_
+#include <stdint.h>
+
+typedef struct {
+	int unused;
+} flash_t;
+
+void flash_erase_sector(flash_t *obj, uint32_t address);
+int flash_stream_read(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data);
+int flash_stream_write(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data);
+#endif
@@ -0,0 +1,398 @@
+/*
+   Host simulation of the FatFs flash disk (fatfs/disk_if/src/flash_fatfs.c) on a simulated NOR flash.
+
+   FATFS=component/common/file_system/fatfs
+   gcc -O2 -I. -I$FATFS -I$FATFS/r0.10c/include -o flash_fatfs_sim flash_fatfs_sim.c \
+       $FATFS/disk_if/src/flash_fatfs.c $FATFS/fatfs_ext/src/ff_driver.c \
+       $FATFS/r0.10c/src/ff.c $FATFS/r0.10c/src/diskio.c $FATFS/r0.10c/src/option/ccsbcs.c
+   ./flash_fatfs_sim [records] [records per sync]
+
+   A logging workload appends fixed size records to a file through FatFs and syncs it every few
+   records, once on the previous driver (one erase unit per sector, rewritten in place) and once on
+   the translation layer. Erase counts come from the simulated flash, time from typical SPI NOR
+   figures. A volume written by the previous driver must then read back and take new records through
+   the translation layer driver. Finally the translation layer is cut off at many points of the same
+   workload to check that the volume mounts afterwards and keeps every record synced before the cut.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ff.h"
+#include "diskio.h"
+#include "fatfs_ext/inc/ff_driver.h"
+#include "disk_if/inc/flash_fatfs.h"
+#include "flash_api.h"
+#include "platform_opts.h"
+
+#define SIM_FLASH_SIZE		0x200000
+#define SIM_UNIT_SIZE		4096
+#define SIM_DISK_UNITS		128		// the 512KB flash disk area
+#define SIM_ERASE_US		45000.0	// 4KB sector erase
+#define SIM_PROGRAM_US		2.4		// per byte, 256 byte page in about 0.6 ms
+#define SIM_READ_US			0.05	// per byte
+#define SIM_RECORD_SIZE		64
+#define SIM_LEGACY_SECTORS	128
+
+static uint8_t sim_flash[SIM_FLASH_SIZE];
+static uint32_t sim_erases[SIM_FLASH_SIZE / SIM_UNIT_SIZE];
+static uint64_t sim_programmed;
+static uint64_t sim_read;
+static long sim_cut_after = -1;	// mutating flash operations left before the power goes, -1 never
+static int sim_dead;
+
+// power on, and off again after cut_after mutating flash operations unless it is -1
+static void sim_power(long cut_after)
+{
+	sim_cut_after = cut_after;
+	sim_dead = 0;
+}
+
+// 1 with power, 0 for the operation the power goes in, -1 after it
+static int sim_powered(void)
+{
+	if (sim_dead)
+		return -1;
+	if (sim_cut_after < 0)
+		return 1;
+	if (sim_cut_after == 0) {
+		sim_dead = 1;
+		return 0;
+	}
+	sim_cut_after--;
+	return 1;
+}
+
+void flash_erase_sector(flash_t *obj, uint32_t address)
+{
+	int powered = sim_powered();
+
+	(void) obj;
+	address &= ~(SIM_UNIT_SIZE - 1);
+	if (powered < 0)
+		return;
+	if (powered == 0) {
+		// an erase cut short leaves part of the sector as it was
+		memset(sim_flash + address, 0xFF, SIM_UNIT_SIZE / 2);
+		return;
+	}
+	memset(sim_flash + address, 0xFF, SIM_UNIT_SIZE);
+	sim_erases[address / SIM_UNIT_SIZE]++;
+}
+
+int flash_stream_read(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data)
+{
+	(void) obj;
+	memcpy(data, sim_flash + address, len);
+	sim_read += len;
+	return 1;
+}
+
+int flash_stream_write(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data)
+{
+	uint32_t i, done = len;
+	int powered = sim_powered();
+
+	(void) obj;
+	if (powered < 0)
+		return 0;
+	if (powered == 0)
+		done = len / 2;
+	// NOR programming only clears bits, writing over data that was not erased corrupts it
+	for (i = 0; i < done; i++)
+		sim_flash[address + i] &= data[i];
+	sim_programmed += done;
+	return 1;
+}
+
+/* The previous driver, one erase unit per FatFs sector ------------------------------------*/
+static flash_t legacy_flash;
+
+static DSTATUS legacy_status(void) { return RES_OK; }
+static DSTATUS legacy_initialize(void) { return RES_OK; }
+static DSTATUS legacy_deinitialize(void) { return RES_OK; }
+
+static DRESULT legacy_read(BYTE *buff, DWORD sector, UINT count)
+{
+	for (; count > 0; count--, sector++, buff += _MAX_SS)
+		flash_stream_read(&legacy_flash, FLASH_APP_BASE + sector * SIM_UNIT_SIZE, _MAX_SS, buff);
+	return RES_OK;
+}
+
+static DRESULT legacy_write(const BYTE *buff, DWORD sector, UINT count)
+{
+	uint8_t unit[SIM_UNIT_SIZE];
+
+	for (; count > 0; count--, sector++, buff += _MAX_SS) {
+		memset(unit, 0xFF, sizeof(unit));
+		memcpy(unit, buff, _MAX_SS);
+		flash_erase_sector(&legacy_flash, FLASH_APP_BASE + sector * SIM_UNIT_SIZE);
+		flash_stream_write(&legacy_flash, FLASH_APP_BASE + sector * SIM_UNIT_SIZE, SIM_UNIT_SIZE, unit);
+	}
+	return RES_OK;
+}
+
+static DRESULT legacy_ioctl(BYTE cmd, void *buff)
+{
+	switch (cmd) {
+	case CTRL_SYNC:
+		return RES_OK;
+	case GET_SECTOR_COUNT:
+		*(DWORD *) buff = SIM_LEGACY_SECTORS;
+		return RES_OK;
+	case GET_SECTOR_SIZE:
+		*(WORD *) buff = _MAX_SS;
+		return RES_OK;
+	default:
+		return RES_PARERR;
+	}
+}
+
+static ll_diskio_drv legacy_driver = {
+	.disk_initialize = legacy_initialize,
+	.disk_status = legacy_status,
+	.disk_read = legacy_read,
+	.disk_deinitialize = legacy_deinitialize,
+	.disk_write = legacy_write,
+	.disk_ioctl = legacy_ioctl,
+	.TAG = (unsigned char *) "LEGACY"
+};
+
+/* Workload ----------------------------------------------------------------------------------*/
+static void sim_reset_counters(void)
+{
+	memset(sim_erases, 0, sizeof(sim_erases));
+	sim_programmed = 0;
+	sim_read = 0;
+}
+
+// FAT12, one sector per cluster, 64 root entries
+static int sim_format(ll_diskio_drv *drv)
+{
+	BYTE sector[_MAX_SS];
+	DWORD count, i, fat_sectors;
+
+	if (drv->disk_ioctl(GET_SECTOR_COUNT, &count) != RES_OK)
+		return -1;
+	fat_sectors = (count * 3 / 2 + 3 + _MAX_SS - 1) / _MAX_SS;
+
+	memset(sector, 0, sizeof(sector));
+	memcpy(sector, "\xEB\x3C\x90MSDOS5.0", 11);
+	sector[11] = _MAX_SS & 0xFF;
+	sector[12] = _MAX_SS >> 8;
+	sector[13] = 1;				// sectors per cluster
+	sector[14] = 1;				// reserved sectors
+	sector[16] = 1;				// FATs
+	sector[17] = 64;			// root entries
+	sector[19] = count & 0xFF;
+	sector[20] = count >> 8;
+	sector[21] = 0xF8;
+	sector[22] = fat_sectors;
+	sector[38] = 0x29;
+	memcpy(sector + 43, "NO NAME    FAT12   ", 19);
+	sector[510] = 0x55;
+	sector[511] = 0xAA;
+	if (drv->disk_write(sector, 0, 1) != RES_OK)
+		return -1;
+
+	for (i = 1; i < 1 + fat_sectors + 4; i++) {
+		memset(sector, 0, sizeof(sector));
+		if (i == 1)
+			memcpy(sector, "\xF8\xFF\xFF", 3);
+		if (drv->disk_write(sector, i, 1) != RES_OK)
+			return -1;
+	}
+	return drv->disk_ioctl(CTRL_SYNC, NULL) == RES_OK ? 0 : -1;
+}
+
+static void sim_record(int index, char *record)
+{
+	int len = snprintf(record, SIM_RECORD_SIZE, "%06d sensor=%05d state=ok ", index, (index * 7919) % 100000);
+
+	memset(record + len, '.', SIM_RECORD_SIZE - 1 - len);
+	record[SIM_RECORD_SIZE - 1] = '\n';
+}
+
+// appends records, returns how many were synced when the workload ended or the power went
+static int sim_log(int records, int per_sync)
+{
+	FATFS fs;
+	FIL file;
+	char record[SIM_RECORD_SIZE];
+	UINT written;
+	int i, synced = 0;
+
+	if (f_mount(&fs, "0:", 1) != FR_OK || f_open(&file, "0:log.txt", FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+		return -1;
+	for (i = 0; i < records; i++) {
+		sim_record(i, record);
+		if (f_write(&file, record, SIM_RECORD_SIZE, &written) != FR_OK || written != SIM_RECORD_SIZE)
+			break;
+		if ((i + 1) % per_sync == 0) {
+			if (f_sync(&file) != FR_OK)
+				break;
+			if (!sim_dead)
+				synced = i + 1;
+		}
+	}
+	if (i == records && f_close(&file) == FR_OK && !sim_dead)
+		synced = records;
+	f_mount(NULL, "0:", 0);
+	return synced;
+}
+
+// returns the number of records read back intact, -1 without the file, -2 when the volume does not mount
+static int sim_check(void)
+{
+	FATFS fs;
+	FIL file;
+	char record[SIM_RECORD_SIZE], expect[SIM_RECORD_SIZE];
+	UINT got;
+	int i = 0;
+
+	if (f_mount(&fs, "0:", 1) != FR_OK)
+		return -2;
+	if (f_open(&file, "0:log.txt", FA_READ) != FR_OK) {
+		f_mount(NULL, "0:", 0);
+		return -1;
+	}
+	while (f_read(&file, record, SIM_RECORD_SIZE, &got) == FR_OK && got == SIM_RECORD_SIZE) {
+		sim_record(i, expect);
+		if (memcmp(record, expect, SIM_RECORD_SIZE) != 0)
+			break;
+		i++;
+	}
+	f_close(&file);
+	f_mount(NULL, "0:", 0);
+	return i;
+}
+
+static int sim_run(ll_diskio_drv *drv, const char *name, int records, int per_sync)
+{
+	uint32_t i, max = 0, total = 0, units = 0;
+	double us;
+	int synced, ok;
+
+	memset(sim_flash, 0xFF, sizeof(sim_flash));
+	sim_power(-1);
+	if (FATFS_RegisterDiskDriver(drv) < 0)
+		return -1;
+	drv->disk_initialize();
+	if (sim_format(drv) < 0) {
+		printf("%s: format failed\n", name);
+		return -1;
+	}
+	sim_reset_counters();
+
+	synced = sim_log(records, per_sync);
+	for (i = 0; i < SIM_DISK_UNITS; i++) {
+		uint32_t n = sim_erases[FLASH_APP_BASE / SIM_UNIT_SIZE + i];
+
+		total += n;
+		units += (n != 0);
+		if (n > max)
+			max = n;
+	}
+	us = total * SIM_ERASE_US + sim_programmed * SIM_PROGRAM_US + sim_read * SIM_READ_US;
+
+	// remount from flash alone before reading back
+	drv->disk_deinitialize();
+	drv->disk_initialize();
+	ok = (synced == records && sim_check() == records);
+	printf("%-8s %8u %6u %8u %10.1f %8.2f KB/s  %s\n", name, total, units, max, sim_programmed / 1024.0,
+		   records * SIM_RECORD_SIZE / 1024.0 / (us / 1e6), ok ? "ok" : "READBACK FAILED");
+	drv->disk_deinitialize();
+	FATFS_UnRegisterDiskDriver(drv->drv_num);
+	return ok ? 0 : -1;
+}
+
+// a volume of the previous driver is served in its own layout, neither lost nor reformatted
+static int sim_legacy_volume(int records, int per_sync)
+{
+	int before, after;
+
+	memset(sim_flash, 0xFF, sizeof(sim_flash));
+	sim_power(-1);
+	FATFS_RegisterDiskDriver(&legacy_driver);
+	sim_format(&legacy_driver);
+	sim_log(records, per_sync);
+	FATFS_UnRegisterDiskDriver(legacy_driver.drv_num);
+
+	FATFS_RegisterDiskDriver(&FLASH_disk_Driver);
+	FLASH_disk_Driver.disk_initialize();
+	before = sim_check();
+	sim_log(records, per_sync);
+	FLASH_disk_Driver.disk_deinitialize();
+	FLASH_disk_Driver.disk_initialize();
+	after = sim_check();
+	FLASH_disk_Driver.disk_deinitialize();
+	FATFS_UnRegisterDiskDriver(FLASH_disk_Driver.drv_num);
+
+	printf("legacy volume: %d of %d records read back, %d after rewriting through the flash disk\n", before, records, after);
+	return (before == records && after == records) ? 0 : -1;
+}
+
+// cuts the power after every step-th flash operation of the workload and checks what survives
+static int sim_power_cuts(int records, int per_sync, int step)
+{
+	long ops, cut;
+	int cuts = 0, failed = 0;
+
+	FATFS_RegisterDiskDriver(&FLASH_disk_Driver);
+
+	// count the mutating operations of a full run
+	memset(sim_flash, 0xFF, sizeof(sim_flash));
+	sim_power(-1);
+	FLASH_disk_Driver.disk_initialize();
+	sim_format(&FLASH_disk_Driver);
+	sim_power(1L << 30);
+	sim_log(records, per_sync);
+	ops = (1L << 30) - sim_cut_after;
+	FLASH_disk_Driver.disk_deinitialize();
+
+	for (cut = 1; cut < ops; cut += step) {
+		int synced, found;
+
+		memset(sim_flash, 0xFF, sizeof(sim_flash));
+		sim_power(-1);
+		FLASH_disk_Driver.disk_initialize();
+		sim_format(&FLASH_disk_Driver);
+		sim_power(cut);
+		synced = sim_log(records, per_sync);
+		// the RAM state is lost with the power, nothing it still held reaches flash
+		FLASH_disk_Driver.disk_deinitialize();
+		sim_power(-1);
+		FLASH_disk_Driver.disk_initialize();
+		found = sim_check();
+		FLASH_disk_Driver.disk_deinitialize();
+
+		cuts++;
+		// before the first sync the file may not exist yet, the volume must mount all the same
+		if (found == -2 || (synced > 0 && found < synced)) {
+			printf("cut after %ld operations: %d records synced, %d found\n", cut, synced, found);
+			failed++;
+		}
+	}
+	printf("power cuts: %d of %d left synced records unreadable\n", failed, cuts);
+	FATFS_UnRegisterDiskDriver(FLASH_disk_Driver.drv_num);
+	return failed ? -1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int records = (argc > 1) ? atoi(argv[1]) : 700;
+	int per_sync = (argc > 2) ? atoi(argv[2]) : 10;
+	int ret = 0;
+
+	if (records <= 0 || per_sync <= 0) {
+		fprintf(stderr, "usage: %s [records] [records per sync]\n", argv[0]);
+		return 2;
+	}
+
+	printf("%d records of %d bytes, f_sync every %d records\n", records, SIM_RECORD_SIZE, per_sync);
+	printf("%-8s %8s %6s %8s %10s %13s\n", "driver", "erases", "units", "max/unit", "KB written", "throughput");
+	ret |= sim_run(&legacy_driver, "legacy", records, per_sync);
+	ret |= sim_run(&FLASH_disk_Driver, "ftl", records, per_sync);
+	ret |= sim_legacy_volume(records, per_sync);
+	ret |= sim_power_cuts(records, per_sync, 7);
+	return ret ? 1 : 0;
+}
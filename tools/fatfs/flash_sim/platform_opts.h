@@ -0,0 +1,6 @@
+/* Host stand-in with the flash disk settings of project/realtek_amebaz2_v0_example/inc/platform_opts.h */
+#ifndef _PLATFORM_OPTS_H_
+#define _PLATFORM_OPTS_H_
+#define FATFS_DISK_FLASH	1
+#define FLASH_APP_BASE		(0x200000 - 0xA9000)
+#endif
@@ -0,0 +1,4 @@
+/* Host stand-in */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
@@ -0,0 +1,15 @@
+/* Host stand-in for the SDK flash API, backed by the simulated flash in ftl_gc_sim.c */
+#ifndef _FLASH_API_H_
+#define _FLASH_API_H_
+#include <stdint.h>
+
+typedef struct {
+	int unused;
+} flash_t;
+
+int flash_read_word(flash_t *obj, uint32_t address, uint32_t *data);
+int flash_write_word(flash_t *obj, uint32_t address, uint32_t data);
+void flash_erase_sector(flash_t *obj, uint32_t address);
+int flash_stream_read(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data);
+int flash_stream_write(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data);
+#endif
@@ -0,0 +1,48 @@
+/* Host stand-in, the simulation is single threaded so the FTL semaphore is always free and the garbage
+   collection task never runs, ftl_gc_sim.c calls its steps between the writes */
+#ifndef _FREERTOS_SERVICE_H_
+#define _FREERTOS_SERVICE_H_
+typedef void *QueueHandle_t;
+typedef void *TaskHandle_t;
+#define portMAX_DELAY		0xffffffffu
+#define pdPASS				1
+#define pdTRUE				1
+#define tskIDLE_PRIORITY	0
+
+static inline QueueHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+	return (QueueHandle_t) 1;
+}
+
+static inline int xSemaphoreTakeRecursive(QueueHandle_t sem, uint32_t ticks)
+{
+	return TRUE;
+}
+
+static inline int xSemaphoreGiveRecursive(QueueHandle_t sem)
+{
+	return TRUE;
+}
+
+static inline int xTaskCreate(void (*task)(void *), const char *name, uint16_t stack, void *param, uint32_t priority,
+	TaskHandle_t *handle)
+{
+	(void) task;
+	*handle = (TaskHandle_t) 1;
+	return pdPASS;
+}
+
+static inline void xTaskNotifyGive(TaskHandle_t task)
+{
+}
+
+static inline uint32_t ulTaskNotifyTake(int clear, uint32_t ticks)
+{
+	return 0;
+}
+
+static inline uint32_t __get_IPSR(void)
+{
+	return 0;
+}
+#endif
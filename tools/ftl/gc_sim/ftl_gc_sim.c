@@ -0,0 +1,261 @@
+/*
+   Host simulation of the incremental garbage collection of the BT FTL (file_system/ftl/ftl.c).
+
+   FTL=component/common/file_system/ftl
+   gcc -O2 -I. -I$FTL -o ftl_gc_sim ftl_gc_sim.c $FTL/ftl.c
+   ./ftl_gc_sim [writes] [live data percent] [pages]
+
+   Records of 4 to 64 bytes are saved again and again, most of them to a few hot slots, on an FTL
+   of three pages by default, the size bt_example_entry.c sets up. Every garbage collection setting
+   runs the same workload on a fresh flash and reports the write latency, time comes from typical
+   SPI NOR figures kept on a simulated clock. A write arrives a fixed gap after the previous one
+   returned, the garbage collection task runs its steps in the gap, and a step still running when the
+   write arrives delays it. Without a gap the task never runs and the page switches erase.
+
+   The latency a write sees is reported along with the time it spent in the FTL itself, and that time
+   for the writes that did not erase, the bound the bounded copy step keeps the write path to. A write
+   copies more than a step when the room left would not last for the rest of the page at that pace,
+   the most cells a write copied shows how often the task left that to the writes. The
+   stored data is compared with a shadow copy after every run, once as written and once more after
+   the FTL is brought up again.
+*/
+#include "platform_stdlib.h"
+#include "ftl_int.h"
+#include "flash_api.h"
+#include "us_ticker_api.h"
+
+#define SIM_BASE			0x100000
+#define SIM_MAX_PAGES		8
+#define SIM_PAGE_SIZE		4096
+#define SIM_LOGICAL_SIZE	((511 * (sim_pages - 1) - 1) * 4)
+#define SIM_SLOT_SIZE		64
+#define SIM_ERASE_US		45000.0	// 4KB sector erase
+#define SIM_COMMAND_US		5.0		// per flash command
+#define SIM_PROGRAM_US		2.4		// per byte, 256 byte page in about 0.6 ms
+#define SIM_READ_US			0.05	// per byte
+
+static uint8_t sim_flash[SIM_MAX_PAGES * SIM_PAGE_SIZE];
+static uint8_t sim_pages = 3;
+static double sim_clock;
+static uint32_t sim_erases;
+
+extern uint8_t *ftl_mapping_table;
+
+static uint8_t *sim_at(uint32_t address)
+{
+	return sim_flash + (address - SIM_BASE);
+}
+
+uint32_t us_ticker_read(void)
+{
+	return (uint32_t) sim_clock;
+}
+
+int flash_read_word(flash_t *obj, uint32_t address, uint32_t *data)
+{
+	memcpy(data, sim_at(address), 4);
+	sim_clock += SIM_COMMAND_US + 4 * SIM_READ_US;
+	return 1;
+}
+
+int flash_write_word(flash_t *obj, uint32_t address, uint32_t data)
+{
+	uint8_t *bytes = (uint8_t *) &data;
+	int i;
+
+	for (i = 0; i < 4; i++)
+		sim_at(address)[i] &= bytes[i];
+	sim_clock += SIM_COMMAND_US + 4 * SIM_PROGRAM_US;
+	return 1;
+}
+
+void flash_erase_sector(flash_t *obj, uint32_t address)
+{
+	memset(sim_at(address & ~(SIM_PAGE_SIZE - 1)), 0xFF, SIM_PAGE_SIZE);
+	sim_clock += SIM_ERASE_US;
+	sim_erases++;
+}
+
+int flash_stream_read(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data)
+{
+	memcpy(data, sim_at(address), len);
+	sim_clock += SIM_COMMAND_US + len * SIM_READ_US;
+	return 1;
+}
+
+int flash_stream_write(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		sim_at(address)[i] &= data[i];
+	sim_clock += SIM_COMMAND_US * ((len + 255) / 256) + len * SIM_PROGRAM_US;
+	return 1;
+}
+
+static int sim_compare(const uint8_t *shadow, uint16_t size)
+{
+	static uint8_t data[(511 * (SIM_MAX_PAGES - 1) - 1) * 4];
+	uint16_t offset;
+
+	for (offset = 0; offset < size; offset += SIM_SLOT_SIZE)
+	{
+		if (ftl_load_from_storage(data + offset, offset, SIM_SLOT_SIZE))
+			return -1;
+	}
+	return memcmp(data, shadow, size) ? -1 : 0;
+}
+
+static int sim_cmp_latency(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+// run the workload with step_cells valid cells per collection step, the task collecting for gap_us between writes
+static int sim_run(const char *name, uint32_t step_cells, uint32_t reserve, uint32_t gap_us, int writes, int live_percent)
+{
+	static uint8_t shadow[(511 * (SIM_MAX_PAGES - 1) - 1) * 4];
+	uint32_t *latency = malloc(writes * sizeof(uint32_t));
+	uint16_t slots = SIM_LOGICAL_SIZE * live_percent / 100 / SIM_SLOT_SIZE;
+	uint16_t size = slots * SIM_SLOT_SIZE;
+	uint32_t max_service = 0;
+	uint32_t max_bounded = 0;
+	uint32_t write_erases = 0;
+	uint32_t max_moved = 0;
+	double total = 0;
+	T_FTL_GC_STATS stats;
+	int failed = 0;
+	int i;
+
+	memset(sim_flash, 0xFF, sizeof(sim_flash));
+	memset(shadow, 0, sizeof(shadow));
+	free(ftl_mapping_table);
+	ftl_mapping_table = NULL;
+	if (ftl_init(SIM_BASE, sim_pages) || ftl_ioctl(FTL_IOCTL_SET_GC_STEP, step_cells, reserve))
+	{
+		printf("%s: init failed\n", name);
+		return 1;
+	}
+	// the blank pages erased the way the collection leaves them, their first format does not erase
+	ftl_ioctl(FTL_IOCTL_ERASE_INVALID_PAGE, 0, 0);
+
+	// every slot written once, then the measured rewrites
+	for (i = 0; i < slots; i++)
+		ftl_save_to_storage(shadow + i * SIM_SLOT_SIZE, i * SIM_SLOT_SIZE, SIM_SLOT_SIZE);
+
+	srand(1);
+	sim_erases = 0;
+	for (i = 0; i < writes && !failed; i++)
+	{
+		// three out of four writes go to the first eighth of the slots
+		uint16_t slot = (rand() % 4) ? rand() % ((slots + 7) / 8) : rand() % slots;
+		uint16_t words = 1 + rand() % (SIM_SLOT_SIZE / 4);
+		uint8_t *data = shadow + slot * SIM_SLOT_SIZE;
+		uint32_t erases;
+		uint32_t moved;
+		uint32_t service;
+		double arrival;
+		double start;
+		int j;
+
+		for (j = 0; j < words * 4; j++)
+			data[j] = rand();
+
+		// the task collects until the write arrives, the step it is in finishes first
+		arrival = sim_clock + gap_us;
+		while (gap_us && sim_clock < arrival && ftl_garbage_collect_in_background())
+			;
+		if (sim_clock < arrival)
+			sim_clock = arrival;
+
+		ftl_get_gc_stats(&stats);
+		moved = stats.cells_moved;
+		erases = sim_erases;
+		start = sim_clock;
+		if (ftl_save_to_storage(data, slot * SIM_SLOT_SIZE, words * 4))
+		{
+			printf("%s: write %d failed\n", name, i);
+			failed = 1;
+		}
+		service = (uint32_t) (sim_clock - start);
+		latency[i] = (uint32_t) (sim_clock - arrival);
+		total += latency[i];
+		if (service > max_service)
+			max_service = service;
+		ftl_get_gc_stats(&stats);
+		if (stats.cells_moved - moved > max_moved)
+			max_moved = stats.cells_moved - moved;
+		if (sim_erases != erases)
+			write_erases += sim_erases - erases;
+		else if (service > max_bounded)
+			max_bounded = service;
+	}
+
+	ftl_get_gc_stats(&stats);
+	if (!failed)
+	{
+		qsort(latency, writes, sizeof(uint32_t), sim_cmp_latency);
+		printf("%-30s mean %6.0f us  p99 %6u us  max %6u us  in FTL max %6u us, %6u us without erase\n",
+			name, total / writes, latency[writes * 99 / 100], latency[writes - 1], max_service, max_bounded);
+		printf("%-30s steps %6u  longest step %6u us  most cells copied by a write %3u  erases %u, %u by writes\n", "",
+			stats.steps, stats.max_step_us, max_moved, sim_erases, write_erases);
+		printf("%-30s pages valid/used cells:", "");
+		for (i = 0; i < sim_pages; i++)
+			printf(" %u/%u", stats.valid_cells[i], stats.used_cells[i]);
+		printf(", free %u, collecting %d\n", stats.free_pages, (stats.gc_page == 0xFF) ? -1 : stats.gc_page);
+	}
+
+	if (!failed && sim_compare(shadow, size))
+	{
+		printf("%s: data mismatch\n", name);
+		failed = 1;
+	}
+
+	// bring the FTL up again from the flash alone
+	free(ftl_mapping_table);
+	ftl_mapping_table = NULL;
+	if (!failed && (ftl_init(SIM_BASE, sim_pages) || sim_compare(shadow, size)))
+	{
+		printf("%s: data mismatch after init\n", name);
+		failed = 1;
+	}
+
+	free(latency);
+	return failed;
+}
+
+int main(int argc, char **argv)
+{
+	int writes = (argc > 1) ? atoi(argv[1]) : 20000;
+	int live_percent = (argc > 2) ? atoi(argv[2]) : 50;
+	double start;
+	int failed = 0;
+
+	if (argc > 3)
+		sim_pages = atoi(argv[3]);
+	if (sim_pages < 3 || sim_pages > SIM_MAX_PAGES || live_percent < 1 || live_percent > 100)
+	{
+		printf("3 to %d pages, 1 to 100%% live\n", SIM_MAX_PAGES);
+		return 1;
+	}
+
+	printf("%d writes, %d%% of the %d byte FTL space live, %d pages\n", writes, live_percent, SIM_LOGICAL_SIZE, sim_pages);
+	failed |= sim_run("whole page per step, no task", 511, 0, 0, writes, live_percent);
+	failed |= sim_run("8 cells per step, no task", 8, 0, 0, writes, live_percent);
+	failed |= sim_run("8 cells per step, 100 ms gap", 8, 0, 100000, writes, live_percent);
+	failed |= sim_run("8 cells per step, 20 ms gap", 8, 0, 20000, writes, live_percent);
+	failed |= sim_run("8 cells per step, 5 ms gap", 8, 0, 5000, writes, live_percent);
+	failed |= sim_run("2 cells per step, 20 ms gap", 2, 0, 20000, writes, live_percent);
+	if (sim_pages > 3)
+		failed |= sim_run("8 cells, reserve 1, 20 ms gap", 8, 1, 20000, writes, live_percent);
+
+	// for reference, one full collection of the oldest page as FTL_IOCTL_DO_GC_IN_APP runs it
+	start = sim_clock;
+	ftl_ioctl(FTL_IOCTL_DO_GC_IN_APP, sim_pages, 0xFFFF);
+	printf("full collection of the oldest page: %.0f us\n", sim_clock - start);
+
+	printf("%s\n", failed ? "FAILED" : "ok");
+	return failed;
+}
@@ -0,0 +1,5 @@
+/* Host stand-in */
+#ifndef _OSDEP_SERVICE_H_
+#define _OSDEP_SERVICE_H_
+#define rtw_zmalloc(size)	calloc(1, size)
+#endif
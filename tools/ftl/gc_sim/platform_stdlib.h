@@ -0,0 +1,13 @@
+/* Host stand-in */
+#ifndef _PLATFORM_STDLIB_H_
+#define _PLATFORM_STDLIB_H_
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#define TRUE	1
+#define FALSE	0
+#define BIT31	0x80000000u
+#define __WEAK	__attribute__((weak))
+#endif
@@ -0,0 +1,6 @@
+/* Host stand-in, reads the simulated clock of ftl_gc_sim.c */
+#ifndef _US_TICKER_API_H_
+#define _US_TICKER_API_H_
+#include <stdint.h>
+uint32_t us_ticker_read(void);
+#endif
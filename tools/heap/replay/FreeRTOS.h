@@ -0,0 +1,32 @@
+/* Host stand-in with what heap_5.c needs from FreeRTOS.h */
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+#include <string.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdTRUE								( ( BaseType_t ) 1 )
+#define pdFALSE								( ( BaseType_t ) 0 )
+#define portBYTE_ALIGNMENT					8
+#define portBYTE_ALIGNMENT_MASK				( 0x0007 )
+#define configSUPPORT_DYNAMIC_ALLOCATION	1
+#define configUSE_MALLOC_FAILED_HOOK		0
+#define configASSERT( x )					assert( x )
+#define mtCOVERAGE_TEST_MARKER()
+#define traceMALLOC( pvAddress, uiSize )
+#define traceFREE( pvAddress, uiSize )
+
+typedef struct HeapRegion
+{
+	uint8_t *pucStartAddress;
+	size_t xSizeInBytes;
+} HeapRegion_t;
+
+void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions );
+void *pvPortMalloc( size_t xSize );
+void vPortFree( void *pv );
+#endif
@@ -0,0 +1,11 @@
+/* Host stand-in with what heap_5.c needs to find the 8710C heap regions, the replay defines its own */
+#ifndef _HAL_API_H_
+#define _HAL_API_H_
+#define HAL_OK						0
+#define FLASH_PORTB					1
+
+static inline int hal_get_flash_port_cfg( void )
+{
+	return FLASH_PORTB;
+}
+#endif
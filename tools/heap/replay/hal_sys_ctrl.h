@@ -0,0 +1 @@
+/* Host stand-in, nothing of it is used by heap_5.c */
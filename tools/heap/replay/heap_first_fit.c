@@ -0,0 +1,5 @@
+/* heap_5.c as the GCC application makefiles build it, the first fit free list, with the trace it calls into */
+#define HEAP_PREFIX( name )		first_fit_##name
+#include "heap_rename.h"
+#include "heap_5.c"
+#include "heap_trace.c"
@@ -0,0 +1,22 @@
+/* Gives the heap functions the prefix HEAP_PREFIX so several builds of a heap link into heap_replay */
+#define pvPortMalloc					HEAP_PREFIX( pvPortMalloc )
+#define vPortFree						HEAP_PREFIX( vPortFree )
+#define __vPortFree						HEAP_PREFIX( __vPortFree )
+#define vPortSetExtFree					HEAP_PREFIX( vPortSetExtFree )
+#define pvPortReAlloc					HEAP_PREFIX( pvPortReAlloc )
+#define pvPortCalloc					HEAP_PREFIX( pvPortCalloc )
+#define xPortGetFreeHeapSize			HEAP_PREFIX( xPortGetFreeHeapSize )
+#define xPortGetMinimumEverFreeHeapSize	HEAP_PREFIX( xPortGetMinimumEverFreeHeapSize )
+#define xPortGetLargestFreeBlockSize	HEAP_PREFIX( xPortGetLargestFreeBlockSize )
+#define vPortDefineHeapRegions			HEAP_PREFIX( vPortDefineHeapRegions )
+#define xHeapRegions					HEAP_PREFIX( xHeapRegions )
+#define dump_mem_block_list				HEAP_PREFIX( dump_mem_block_list )
+#define uxPortHeapTraceSetTag			HEAP_PREFIX( uxPortHeapTraceSetTag )
+#define xPortHeapTraceRecord			HEAP_PREFIX( xPortHeapTraceRecord )
+#define vPortHeapTraceClear				HEAP_PREFIX( vPortHeapTraceClear )
+#define vPortGetHeapTraceStats			HEAP_PREFIX( vPortGetHeapTraceStats )
+#define xPortGetHeapTraceRecord			HEAP_PREFIX( xPortGetHeapTraceRecord )
+#define vPortHeapTraceMalloc			HEAP_PREFIX( vPortHeapTraceMalloc )
+#define vPortHeapTraceFree				HEAP_PREFIX( vPortHeapTraceFree )
+#define pxPortHeapTraceBlock			HEAP_PREFIX( pxPortHeapTraceBlock )
+#define xPortHeapTraceFigures			HEAP_PREFIX( xPortHeapTraceFigures )
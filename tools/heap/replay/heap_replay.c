@@ -0,0 +1,354 @@
+/*
+   Host replay of allocation traces against heap_5.c, the heap of the GCC application makefiles.
+   Another allocator is compared by building it under its own prefix, see heap_first_fit.c, and
+   adding it to replay_heaps; every heap gets the same memory.
+
+   FREERTOS=component/os/freertos
+   MEMMANG=$FREERTOS/freertos_v10.0.1/Source/portable/MemMang
+   gcc -O2 -I. -I$FREERTOS -I$MEMMANG -o heap_replay heap_replay.c heap_first_fit.c
+   ./heap_replay [trace] [heap KB]
+
+   Size-class slabs in a fixed region in front of the free list were tried this way and dropped.
+   On the generated day first fit alone fails 24 requests above 256 bytes and no TLS buffer. With
+   slab regions of 4 to 24KB, those failures grow from 39 to 9672, and 22 TLS buffers fail at
+   24KB: every region is memory first fit can no longer merge, and the small requests it saves
+   were never the ones failing.
+
+   A trace has one operation per line, ids name the blocks:
+     m <id> <size> [tag]   pvPortMalloc
+     r <id> <size>         pvPortReAlloc
+     f <id>                vPortFree
+   lines starting with # are skipped. Without a trace a day of a Matter light is generated: lwIP
+   buffers living a few ticks, Matter objects living minutes, and a TLS session every few minutes
+   whose 16KB record buffers need a contiguous block. The heap is 96KB unless given.
+
+   Headers are twice as large on a 64 bit host as on the target, so absolute numbers run a little
+   pessimistic for both allocators alike.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "FreeRTOS.h"
+#include "freertos_heap_rtk.h"
+
+#define REPLAY_MAX_IDS		65536
+#define REPLAY_TLS_BUFFER	16384
+#define REPLAY_SMALL		256		// failures up to this size are counted apart
+
+typedef struct
+{
+	char op;
+	uint32_t id;
+	uint32_t size;
+} ReplayOp_t;
+
+typedef struct
+{
+	const char *name;
+	void (*define)(const HeapRegion_t * const regions);
+	void *(*malloc)(size_t size);
+	void *(*realloc)(void *pv, size_t size);
+	void (*free)(void *pv);
+	size_t (*free_size)(void);
+	size_t (*min_free_size)(void);
+	size_t (*largest_free)(void);
+} ReplayHeap_t;
+
+#define REPLAY_HEAP(prefix) \
+	void prefix##_vPortDefineHeapRegions(const HeapRegion_t * const regions); \
+	void *prefix##_pvPortMalloc(size_t size); \
+	void *prefix##_pvPortReAlloc(void *pv, size_t size); \
+	void prefix##_vPortFree(void *pv); \
+	size_t prefix##_xPortGetFreeHeapSize(void); \
+	size_t prefix##_xPortGetMinimumEverFreeHeapSize(void); \
+	size_t prefix##_xPortGetLargestFreeBlockSize(void);
+
+REPLAY_HEAP(first_fit)
+
+// linker symbols heap_5.c finds the 8710C heap regions by, the replay defines its own regions
+uint8_t __sram_end__[1], __eram_end__[1], __bss_end__[1], __eram_bss_end__[1];
+
+#define REPLAY_HEAP_ENTRY(label, prefix) \
+	{ label, prefix##_vPortDefineHeapRegions, prefix##_pvPortMalloc, prefix##_pvPortReAlloc, prefix##_vPortFree, \
+	  prefix##_xPortGetFreeHeapSize, prefix##_xPortGetMinimumEverFreeHeapSize, prefix##_xPortGetLargestFreeBlockSize }
+
+static const ReplayHeap_t replay_heaps[] =
+{
+	REPLAY_HEAP_ENTRY("first fit", first_fit),
+};
+
+static ReplayOp_t *replay_ops;
+static size_t replay_count;
+static size_t replay_capacity;
+static void *replay_blocks[REPLAY_MAX_IDS];
+static uint32_t replay_sizes[REPLAY_MAX_IDS];
+
+static void replay_add(char op, uint32_t id, uint32_t size)
+{
+	if (replay_count == replay_capacity)
+	{
+		replay_capacity = replay_capacity ? replay_capacity * 2 : 65536;
+		replay_ops = realloc(replay_ops, replay_capacity * sizeof(ReplayOp_t));
+	}
+	replay_ops[replay_count].op = op;
+	replay_ops[replay_count].id = id;
+	replay_ops[replay_count].size = size;
+	replay_count++;
+}
+
+static int replay_load(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	char line[256];
+	char op;
+	unsigned id, size;
+
+	if (file == NULL)
+	{
+		perror(path);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), file))
+	{
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+		size = 0;
+		if (sscanf(line, "%c %u %u", &op, &id, &size) < 2 || id >= REPLAY_MAX_IDS || strchr("mrf", op) == NULL)
+		{
+			printf("%s: bad line %s", path, line);
+			fclose(file);
+			return -1;
+		}
+		replay_add(op, id, size);
+	}
+	fclose(file);
+	return 0;
+}
+
+/* ---- generated trace, ids are taken from a free list and released when the block is freed ---- */
+
+#define GEN_TICKS			(24 * 3600)		// one tick per second
+#define GEN_MAX_PENDING		REPLAY_MAX_IDS
+
+static uint32_t gen_free_ids[REPLAY_MAX_IDS];
+static uint32_t gen_free_count;
+static struct
+{
+	uint32_t tick;
+	uint32_t id;
+} gen_pending[GEN_MAX_PENDING];
+static uint32_t gen_pending_count;
+
+static uint32_t gen_range(uint32_t low, uint32_t high)
+{
+	return low + (uint32_t) rand() % (high - low + 1);
+}
+
+static uint32_t gen_malloc(uint32_t size)
+{
+	uint32_t id = gen_free_ids[--gen_free_count];
+
+	replay_add('m', id, size);
+	return id;
+}
+
+static void gen_free_at(uint32_t id, uint32_t tick)
+{
+	gen_pending[gen_pending_count].tick = tick;
+	gen_pending[gen_pending_count].id = id;
+	gen_pending_count++;
+}
+
+static void gen_expire(uint32_t tick)
+{
+	uint32_t i = 0;
+
+	while (i < gen_pending_count)
+	{
+		if (gen_pending[i].tick <= tick)
+		{
+			replay_add('f', gen_pending[i].id, 0);
+			gen_free_ids[gen_free_count++] = gen_pending[i].id;
+			gen_pending[i] = gen_pending[--gen_pending_count];
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+static void replay_generate(void)
+{
+	uint32_t tick, i;
+
+	srand(1);
+	for (i = 0; i < REPLAY_MAX_IDS; i++)
+		gen_free_ids[i] = REPLAY_MAX_IDS - 1 - i;
+	gen_free_count = REPLAY_MAX_IDS;
+
+	// tasks, queues and driver state of the boot, never freed
+	for (i = 0; i < 30; i++)
+		gen_malloc(gen_range(64, 1536));
+
+	for (tick = 0; tick < GEN_TICKS; tick++)
+	{
+		// lwIP: buffers and pcbs of the traffic, gone within seconds
+		for (i = gen_range(0, 6); i > 0; i--)
+			gen_free_at(gen_malloc(gen_range(16, 600)), tick + gen_range(0, 3));
+
+		// Matter: exchange contexts and packet buffers living up to two minutes, now and then a
+		// subscription or a cached session that stays for hours
+		for (i = gen_range(0, 1); i > 0; i--)
+		{
+			uint32_t life = (rand() % 200) ? gen_range(1, 120) : gen_range(3600, 6 * 3600);
+
+			gen_free_at(gen_malloc(gen_range(24, 320)), tick + life);
+		}
+
+		// a TLS session every five minutes: the handshake state, then the record buffers for a minute
+		if (tick % 300 == 0)
+		{
+			uint32_t in = gen_malloc(REPLAY_TLS_BUFFER + 13 + 16 + 64);
+			uint32_t out = gen_malloc(REPLAY_TLS_BUFFER + 13 + 16 + 64);
+
+			for (i = 0; i < 60; i++)
+				gen_free_at(gen_malloc(gen_range(16, 512)), tick + gen_range(0, 5));
+			for (i = 0; i < 4; i++)
+				gen_free_at(gen_malloc(gen_range(600, 2500)), tick + gen_range(1, 5));
+			gen_free_at(in, tick + 60);
+			gen_free_at(out, tick + 60);
+		}
+
+		gen_expire(tick);
+	}
+	gen_expire(~0u);
+}
+
+/* ---- replay ---- */
+
+static double replay_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int replay_run(const ReplayHeap_t *heap, size_t heap_size)
+{
+	uint8_t *memory = malloc(heap_size);
+	HeapRegion_t regions[] = {{memory, heap_size}, {NULL, 0}};
+	size_t failed_small = 0, failed_large = 0, failed_tls = 0;
+	size_t min_largest = heap_size;
+	double start, elapsed;
+	size_t i;
+
+	memset(replay_blocks, 0, sizeof(replay_blocks));
+	heap->define(regions);
+
+	start = replay_now();
+	for (i = 0; i < replay_count; i++)
+	{
+		const ReplayOp_t *op = &replay_ops[i];
+
+		switch (op->op)
+		{
+		case 'm':
+			replay_blocks[op->id] = heap->malloc(op->size);
+			replay_sizes[op->id] = op->size;
+			break;
+		case 'r':
+			{
+				void *block = heap->realloc(replay_blocks[op->id], op->size);
+
+				if (block != NULL || op->size == 0)
+				{
+					replay_blocks[op->id] = block;
+					replay_sizes[op->id] = op->size;
+				}
+			}
+			break;
+		default:
+			heap->free(replay_blocks[op->id]);
+			replay_blocks[op->id] = NULL;
+			continue;
+		}
+
+		if (replay_blocks[op->id] == NULL && op->size > 0)
+		{
+			if (op->size >= REPLAY_TLS_BUFFER)
+				failed_tls++;
+			else if (op->size > REPLAY_SMALL)
+				failed_large++;
+			else
+				failed_small++;
+		}
+		else if (replay_blocks[op->id] != NULL)
+		{
+			// the block must be writable over its whole size without hurting its neighbours
+			memset(replay_blocks[op->id], (uint8_t) op->id, op->size);
+		}
+
+		if ((i & 1023) == 0)
+		{
+			size_t largest = heap->largest_free();
+
+			if (largest < min_largest)
+				min_largest = largest;
+		}
+	}
+	elapsed = replay_now() - start;
+
+	printf("%s\n", heap->name);
+	printf("  %.0f ns per operation, failed allocations: %zu up to %d bytes, %zu larger, %zu TLS record buffers\n",
+		elapsed * 1e9 / replay_count, failed_small, REPLAY_SMALL, failed_large, failed_tls);
+	printf("  free %zu of %zu bytes, minimum ever %zu, largest free block %zu now and %zu at least\n",
+		heap->free_size(), heap_size, heap->min_free_size(), heap->largest_free(), min_largest);
+
+	// blocks still allocated at the end of the trace keep their data
+	for (i = 0; i < REPLAY_MAX_IDS; i++)
+	{
+		uint32_t j;
+
+		for (j = 0; replay_blocks[i] != NULL && j < replay_sizes[i]; j++)
+		{
+			if (((uint8_t *) replay_blocks[i])[j] != (uint8_t) i)
+			{
+				printf("  block %zu corrupted\n", i);
+				return 1;
+			}
+		}
+	}
+
+	free(memory);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	size_t heap_size = ((argc > 2) ? atoi(argv[2]) : 96) * 1024;
+	size_t allocations = 0;
+	int failed = 0;
+	size_t i;
+
+	if (argc > 1 && strcmp(argv[1], "-") != 0)
+	{
+		if (replay_load(argv[1]))
+			return 1;
+	}
+	else
+	{
+		replay_generate();
+	}
+
+	for (i = 0; i < replay_count; i++)
+		allocations += (replay_ops[i].op == 'm');
+	printf("%zu operations, %zu allocations, %zu KB heap\n", replay_count, allocations, heap_size / 1024);
+
+	for (i = 0; i < sizeof(replay_heaps) / sizeof(replay_heaps[0]); i++)
+		failed |= replay_run(&replay_heaps[i], heap_size);
+
+	return failed;
+}
@@ -0,0 +1,5 @@
+/* Host stand-in, the replay builds heap_5.c as for the 8710C */
+#ifndef __PLATFORM_OPTS_H__
+#define __PLATFORM_OPTS_H__
+#define CONFIG_PLATFORM_8710C		1
+#endif
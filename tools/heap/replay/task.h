@@ -0,0 +1,36 @@
+/* Host stand-in, the replay is single threaded */
+#ifndef INC_TASK_H
+#define INC_TASK_H
+static inline void vTaskSuspendAll( void )
+{
+}
+
+static inline BaseType_t xTaskResumeAll( void )
+{
+	return pdFALSE;
+}
+
+/* For builds with configUSE_HEAP_TRACE, every allocation comes before the scheduler */
+typedef void *TaskHandle_t;
+#define taskSCHEDULER_NOT_STARTED		( ( BaseType_t ) 1 )
+
+static inline BaseType_t xTaskGetSchedulerState( void )
+{
+	return taskSCHEDULER_NOT_STARTED;
+}
+
+static inline TaskHandle_t xTaskGetCurrentTaskHandle( void )
+{
+	return NULL;
+}
+
+static inline char *pcTaskGetName( TaskHandle_t xTask )
+{
+	return "";
+}
+
+static inline uint32_t xTaskGetTickCount( void )
+{
+	return 0;
+}
+#endif
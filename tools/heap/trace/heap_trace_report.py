@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+
+"""
+Report on the heap allocation trace of heap_5.c and freertos_heap_rtk.c (configUSE_HEAP_TRACE).
+
+The device prints its figures and the ring of the latest allocations and frees on ATSH=dump as
+"HT" lines of hex words between "[ATSH] dump of N records" and "[ATSH] dump end". Capture the
+UART log around the command and hand it to this script, the last dump in the log is used:
+
+./heap_trace_report.py uart.log
+./heap_trace_report.py --elf application_is.axf --nm arm-none-eabi-nm uart.log
+./heap_trace_report.py --replay matter.trace uart.log
+
+The report has the heap figures and a sizing hint for configTOTAL_HEAP_SIZE, the live and peak
+bytes per subsystem, how long the blocks of every subsystem lived, the callers that asked for
+the most, and the leak candidates: blocks allocated in the window of the ring that are still
+held after --leak-age seconds. Callers are return addresses, --elf turns them into symbols.
+
+--replay writes the allocations and frees of the window in the trace format of
+tools/heap/replay, frees of blocks allocated before the window are left out.
+
+Dump layout, 32 bit words:
+    header   magic "HTR1", header words, tags, words per record, records, events since the
+             last clear, tick, heap, free, minimum ever free, largest free block,
+             fragmentation per mille
+    tags     live bytes, peak bytes, live blocks, allocations, failures for every tag
+    records  tick, address, caller, info (size in bits 0 to 23, tag in 24 to 27, event in
+             28 to 31: 1 malloc, 2 free, 3 failed), ticks held for a free
+"""
+
+import argparse
+import bisect
+import collections
+import re
+import subprocess
+import sys
+
+DUMP_MAGIC = 0x31525448
+TAG_NAMES = ['app', 'lwip', 'mbedtls', 'matter', 'bt', 'wlan']
+
+EVENT_MALLOC = 1
+EVENT_FREE = 2
+EVENT_FAILED = 3
+
+LINE_PATTERN = re.compile(r'\bHT((?: [0-9a-fA-F]{8}){8})\s*$')
+START_PATTERN = re.compile(r'\[ATSH\] dump of \d+ records')
+
+Dump = collections.namedtuple('Dump', 'events tick heap free min_free largest fragmentation tags records')
+TagStats = collections.namedtuple('TagStats', 'live peak blocks allocations failures')
+Record = collections.namedtuple('Record', 'tick address caller size tag event lifetime')
+
+
+def error(message: str):
+    sys.stderr.write(f'error: {message}\n')
+    sys.exit(1)
+
+
+def tag_name(tag: int) -> str:
+    return TAG_NAMES[tag] if tag < len(TAG_NAMES) else f'tag {tag}'
+
+
+def read_dump(path: str) -> Dump:
+    dumps = []
+    words = None
+    with open(path, 'r', errors='replace') as log:
+        for line in log:
+            if START_PATTERN.search(line):
+                words = []
+                dumps.append(words)
+                continue
+            match = LINE_PATTERN.search(line)
+            if match:
+                if words is None:
+                    words = []
+                    dumps.append(words)
+                words.extend(int(word, 16) for word in match.group(1).split())
+    if not dumps:
+        error(f'no heap trace dump in {path}')
+    return parse_dump(dumps[-1])
+
+
+def parse_dump(words: list) -> Dump:
+    if len(words) < 12 or words[0] != DUMP_MAGIC:
+        error('dump does not start with the header, was the log cut?')
+    header_words, tags, record_words, records, events = words[1:6]
+    if record_words < 5:
+        error(f'records of {record_words} words, 5 expected')
+
+    position = header_words
+    tag_stats = []
+    for _ in range(tags):
+        tag_stats.append(TagStats(*words[position:position + 5]))
+        position += 5
+
+    record_list = []
+    for _ in range(records):
+        if position + record_words > len(words):
+            error(f'dump ends after {len(record_list)} of {records} records')
+        tick, address, caller, info, lifetime = words[position:position + 5]
+        position += record_words
+        event = info >> 28
+        if event == 0:
+            # overwritten while the dump was taken
+            continue
+        record_list.append(Record(tick, address, caller, info & 0xFFFFFF, (info >> 24) & 0xF, event, lifetime))
+
+    return Dump(events, *words[6:12], tag_stats, record_list)
+
+
+class Symbols:
+    def __init__(self, elf: str, nm: str):
+        self.addresses = []
+        self.sizes = []
+        self.names = []
+        if elf is None:
+            return
+        try:
+            output = subprocess.run([nm, '-n', '-S', '--defined-only', elf], check=True, capture_output=True,
+                                    text=True).stdout
+        except (OSError, subprocess.CalledProcessError) as exception:
+            error(f'{nm} {elf}: {exception}')
+        for line in output.splitlines():
+            fields = line.split()
+            if len(fields) == 4 and fields[2] in 'tTwW':
+                self.addresses.append(int(fields[0], 16))
+                self.sizes.append(int(fields[1], 16))
+                self.names.append(fields[3])
+
+    def lookup(self, address: int) -> str:
+        # return addresses of Thumb code have bit 0 set
+        address &= ~1
+        index = bisect.bisect_right(self.addresses, address) - 1
+        if address == 0:
+            return '?'
+        if index < 0 or address >= self.addresses[index] + self.sizes[index]:
+            return f'0x{address:08x}'
+        return f'{self.names[index]}+0x{address - self.addresses[index]:x}'
+
+
+def seconds(ticks: int, tick_hz: int) -> str:
+    return f'{ticks / tick_hz:.3f}s' if ticks < 10 * tick_hz else f'{ticks / tick_hz:.0f}s'
+
+
+def percentile(values: list, percent: int) -> int:
+    return values[min(len(values) - 1, len(values) * percent // 100)]
+
+
+def report_heap(dump: Dump, tick_hz: int):
+    peak_use = dump.heap - dump.min_free
+    print(f'heap {dump.heap} bytes at tick {dump.tick} ({seconds(dump.tick, tick_hz)})')
+    print(f'  free {dump.free}, minimum ever free {dump.min_free}, peak use {peak_use} '
+          f'({peak_use * 100 // max(dump.heap, 1)}%)')
+    print(f'  largest free block {dump.largest}, fragmentation {dump.fragmentation / 10:.1f}%')
+    print(f'  {dump.events} events since the last clear, {len(dump.records)} in the window')
+    print()
+
+    print('tag          live   blocks     peak  share  allocations  failures')
+    for tag, stats in enumerate(dump.tags):
+        print(f'{tag_name(tag):10} {stats.live:6} {stats.blocks:8} {stats.peak:8} '
+              f'{stats.peak * 100 // max(peak_use, 1):5}% {stats.allocations:12} {stats.failures:9}')
+    print()
+
+
+def report_sizing(dump: Dump, failed: list):
+    peak_use = dump.heap - dump.min_free
+    largest_failed = max((record.size for record in failed), default=0)
+    if largest_failed:
+        # a request that failed needed a block of its own on top of the peak
+        needed = peak_use + largest_failed + 8
+        print(f'sizing: {len(failed)} requests failed in the window, the largest for {largest_failed} bytes.')
+        print(f'  configTOTAL_HEAP_SIZE of at least {needed} would have served it at the peak, '
+              f'more when the free space is fragmented.')
+    elif sum(stats.failures for stats in dump.tags):
+        print('sizing: requests failed before the window, see the failures per tag, take a dump closer to them.')
+    else:
+        print(f'sizing: no request failed, the heap never had less than {dump.min_free} bytes free;')
+        print(f'  configTOTAL_HEAP_SIZE could shrink by about {dump.min_free - dump.min_free // 4} bytes '
+              f'and keep a quarter of that margin.')
+    print()
+
+
+def report_lifetimes(records: list, tick_hz: int):
+    lifetimes = collections.defaultdict(list)
+    for record in records:
+        if record.event == EVENT_FREE:
+            lifetimes[record.tag].append(record.lifetime)
+    if not lifetimes:
+        return
+    print('lifetimes of the blocks freed in the window')
+    print('tag         frees   median      p90      max')
+    for tag in sorted(lifetimes):
+        values = sorted(lifetimes[tag])
+        print(f'{tag_name(tag):10} {len(values):6} {seconds(percentile(values, 50), tick_hz):>8} '
+              f'{seconds(percentile(values, 90), tick_hz):>8} {seconds(values[-1], tick_hz):>8}')
+    print()
+
+
+def report_callers(records: list, symbols: Symbols, top: int):
+    callers = collections.defaultdict(lambda: [0, 0])
+    for record in records:
+        if record.event == EVENT_MALLOC:
+            callers[(record.tag, record.caller)][0] += 1
+            callers[(record.tag, record.caller)][1] += record.size
+    if not callers:
+        return
+    print(f'top {top} callers by bytes allocated in the window')
+    print('tag          count    bytes  caller')
+    for (tag, caller), (count, size) in sorted(callers.items(), key=lambda item: -item[1][1])[:top]:
+        print(f'{tag_name(tag):10} {count:7} {size:8}  {symbols.lookup(caller)}')
+    print()
+
+
+def report_failed(failed: list, symbols: Symbols):
+    if not failed:
+        return
+    groups = collections.Counter((record.tag, record.caller, record.size) for record in failed)
+    print('failed requests in the window')
+    print('tag          count     size  caller')
+    for (tag, caller, size), count in sorted(groups.items(), key=lambda item: -item[0][2]):
+        print(f'{tag_name(tag):10} {count:7} {size:8}  {symbols.lookup(caller)}')
+    print()
+
+
+def report_leaks(dump: Dump, symbols: Symbols, leak_ticks: int, tick_hz: int):
+    held = {}
+    for record in dump.records:
+        if record.event == EVENT_MALLOC:
+            held[record.address] = record
+        elif record.event == EVENT_FREE:
+            held.pop(record.address, None)
+
+    groups = collections.defaultdict(list)
+    for record in held.values():
+        age = (dump.tick - record.tick) & 0xFFFFFFFF
+        if age >= leak_ticks:
+            groups[(record.tag, record.caller, record.size)].append(age)
+    if not groups:
+        print(f'leak candidates: none held longer than {seconds(leak_ticks, tick_hz)}')
+        return
+    print(f'leak candidates: allocated in the window and held longer than {seconds(leak_ticks, tick_hz)}')
+    print('tag         blocks    bytes   oldest  caller')
+    for (tag, caller, size), ages in sorted(groups.items(), key=lambda item: -len(item[1]) * item[0][2]):
+        print(f'{tag_name(tag):10} {len(ages):7} {len(ages) * size:8} {seconds(max(ages), tick_hz):>8}  '
+              f'{symbols.lookup(caller)}')
+
+
+def write_replay(dump: Dump, path: str):
+    ids = {}
+    free_ids = list(range(65535, -1, -1))
+    with open(path, 'w') as trace:
+        trace.write(f'# {len(dump.records)} events of a {dump.heap} byte heap, tick {dump.tick}\n')
+        for record in dump.records:
+            if record.event == EVENT_MALLOC:
+                if record.address in ids:
+                    # the free went by before the window, the address is in use again
+                    free_ids.append(ids.pop(record.address))
+                ids[record.address] = free_ids.pop()
+                trace.write(f'm {ids[record.address]} {record.size} {tag_name(record.tag)}\n')
+            elif record.event == EVENT_FAILED:
+                trace.write(f'm {free_ids[-1]} {record.size} {tag_name(record.tag)}\n')
+                trace.write(f'f {free_ids[-1]}\n')
+            elif record.event == EVENT_FREE and record.address in ids:
+                block = ids.pop(record.address)
+                trace.write(f'f {block}\n')
+                free_ids.append(block)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Report on an ATSH=dump heap trace captured from the UART log')
+    parser.add_argument('log', help='UART log holding the dump')
+    parser.add_argument('--elf', help='image the callers are looked up in')
+    parser.add_argument('--nm', default='arm-none-eabi-nm', help='nm of the toolchain, arm-none-eabi-nm by default')
+    parser.add_argument('--leak-age', type=float, default=60, help='seconds a block must be held to be a leak candidate')
+    parser.add_argument('--top', type=int, default=10, help='callers listed')
+    parser.add_argument('--tick-hz', type=int, default=1000, help='configTICK_RATE_HZ of the image')
+    parser.add_argument('--replay', help='write the window as a tools/heap/replay trace to this file')
+    args = parser.parse_args()
+
+    dump = read_dump(args.log)
+    symbols = Symbols(args.elf, args.nm)
+    failed = [record for record in dump.records if record.event == EVENT_FAILED]
+
+    report_heap(dump, args.tick_hz)
+    report_sizing(dump, failed)
+    report_lifetimes(dump.records, args.tick_hz)
+    report_callers(dump.records, symbols, args.top)
+    report_failed(failed, symbols)
+    report_leaks(dump, symbols, int(args.leak_age * args.tick_hz), args.tick_hz)
+
+    if args.replay:
+        write_replay(dump, args.replay)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,3 @@
+/* Host stand-in, see chip_host.h */
+#pragma once
+#include "chip_host.h"
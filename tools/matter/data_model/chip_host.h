@@ -0,0 +1,278 @@
+/* Host stand-in for the parts of the CHIP SDK the dynamic data model (core/matter_data_model.*) builds against */
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+typedef int CHIP_ERROR;
+typedef int ChipError;
+#define CHIP_NO_ERROR					0
+#define CHIP_ERROR_INTERNAL				1
+#define CHIP_DEVICE_CONFIG_CHIP_TASK_NAME	"CHIP"
+
+// the bench times the data model, not the console
+#define ChipLogError(module, ...)		do {} while (0)
+#define ChipLogProgress(module, ...)	do {} while (0)
+#define ChipLogDetail(module, ...)		do {} while (0)
+
+namespace chip {
+
+typedef uint16_t EndpointId;
+typedef uint32_t ClusterId;
+typedef uint32_t AttributeId;
+typedef uint32_t CommandId;
+typedef uint32_t EventId;
+typedef uint32_t DataVersion;
+typedef uint32_t DeviceTypeId;
+typedef uint32_t TransactionId;
+typedef uint64_t EventNumber;
+typedef uint64_t FabricId;
+typedef uint64_t NodeId;
+typedef uint16_t GroupId;
+typedef uint16_t Percent100ths;
+typedef uint8_t Percent;
+
+constexpr CommandId kInvalidCommandId = 0xFFFFFFFF;
+
+template <class T>
+class Span
+{
+public:
+    constexpr Span() : mData(nullptr), mSize(0) {}
+    constexpr Span(T *data, size_t size) : mData(data), mSize(size) {}
+    template <size_t N>
+    constexpr explicit Span(T (&array)[N]) : mData(array), mSize(N) {}
+    template <class U>
+    constexpr Span(const Span<U> &other) : mData(other.data()), mSize(other.size()) {}
+    constexpr T *data() const { return mData; }
+    constexpr size_t size() const { return mSize; }
+    constexpr T *begin() const { return mData; }
+    constexpr T *end() const { return mData + mSize; }
+
+private:
+    T *mData;
+    size_t mSize;
+};
+
+namespace System {
+namespace Clock {
+typedef std::chrono::duration<uint32_t, std::milli> Milliseconds32;
+typedef std::chrono::duration<uint64_t, std::milli> Milliseconds64;
+}
+
+class Layer;
+typedef void (*TimerCompleteCallback)(Layer *layer, void *context);
+
+// one pending timer, fired by the bench when its simulated clock passes the deadline
+class Layer
+{
+public:
+    CHIP_ERROR StartTimer(Clock::Milliseconds32 delay, TimerCompleteCallback callback, void *context);
+    void CancelTimer(TimerCompleteCallback callback, void *context);
+    bool IsInitialized() const { return true; }
+    TimerCompleteCallback callback = nullptr;
+    void *context = nullptr;
+    uint64_t deadline = 0;
+};
+
+class ClockImpl
+{
+public:
+    Clock::Milliseconds64 GetMonotonicMilliseconds64() { return Clock::Milliseconds64(now); }
+    uint64_t now = 0;
+};
+
+ClockImpl &SystemClock();
+} // namespace System
+
+namespace DeviceLayer {
+class PlatformManager
+{
+public:
+    void LockChipStack() { locks++; }
+    bool TryLockChipStack() { locks++; return true; }
+    void UnlockChipStack() {}
+    uint32_t locks = 0;
+};
+
+PlatformManager &PlatformMgr();
+System::Layer &SystemLayer();
+
+namespace PersistedStorage {
+class KeyValueStoreManager {};
+KeyValueStoreManager &KeyValueStoreMgr();
+}
+
+namespace Internal {
+enum class AmebaErrorType { kDctError };
+class AmebaUtils
+{
+public:
+    static CHIP_ERROR MapError(int32_t error, AmebaErrorType type) { return (error == 0) ? CHIP_NO_ERROR : CHIP_ERROR_INTERNAL; }
+};
+}
+} // namespace DeviceLayer
+
+namespace Protocols {
+namespace InteractionModel {
+enum class Status { Success, Failure, UnsupportedAttribute, ResourceExhausted };
+}
+}
+} // namespace chip
+
+typedef uint8_t EmberAfAttributeType;
+typedef uint8_t EmberAfAttributeMask;
+typedef uint8_t EmberAfClusterMask;
+typedef void (*EmberAfGenericClusterFunction)(void);
+
+struct EmberAfAttributeMinMaxValue;
+
+union EmberAfDefaultAttributeValue
+{
+    constexpr EmberAfDefaultAttributeValue(const uint8_t *ptr) : ptrToDefaultValue(ptr) {}
+    constexpr EmberAfDefaultAttributeValue(uint16_t value) : defaultValue(value) {}
+    const uint8_t *ptrToDefaultValue;
+    uint16_t defaultValue;
+};
+
+union EmberAfDefaultOrMinMaxAttributeValue
+{
+    constexpr EmberAfDefaultOrMinMaxAttributeValue(const uint8_t *ptr) : ptrToDefaultValue(ptr) {}
+    constexpr EmberAfDefaultOrMinMaxAttributeValue(uint32_t value) : defaultValue(value) {}
+    constexpr EmberAfDefaultOrMinMaxAttributeValue(const EmberAfAttributeMinMaxValue *ptr) : ptrToMinMaxValue(ptr) {}
+    const uint8_t *ptrToDefaultValue;
+    uint32_t defaultValue;
+    const EmberAfAttributeMinMaxValue *ptrToMinMaxValue;
+};
+
+struct EmberAfAttributeMinMaxValue
+{
+    EmberAfDefaultAttributeValue defaultValue;
+    EmberAfDefaultAttributeValue minValue;
+    EmberAfDefaultAttributeValue maxValue;
+};
+
+struct EmberAfAttributeMetadata
+{
+    EmberAfDefaultOrMinMaxAttributeValue defaultValue;
+    chip::AttributeId attributeId;
+    uint16_t size;
+    EmberAfAttributeType attributeType;
+    EmberAfAttributeMask mask;
+};
+
+struct EmberAfCluster
+{
+    chip::ClusterId clusterId;
+    const EmberAfAttributeMetadata *attributes;
+    uint16_t attributeCount;
+    uint16_t clusterSize;
+    EmberAfClusterMask mask;
+    const EmberAfGenericClusterFunction *functions;
+    const chip::CommandId *acceptedCommandList;
+    const chip::CommandId *generatedCommandList;
+    const chip::EventId *eventList;
+    uint16_t eventCount;
+};
+
+struct EmberAfEndpointType
+{
+    const EmberAfCluster *cluster;
+    uint8_t clusterCount;
+    uint16_t endpointSize;
+};
+
+struct EmberAfDeviceType
+{
+    chip::DeviceTypeId deviceId;
+    uint8_t deviceVersion;
+};
+
+CHIP_ERROR emberAfSetDynamicEndpoint(uint16_t index, chip::EndpointId id, const EmberAfEndpointType *ep,
+                                     const chip::Span<chip::DataVersion> &dataVersionStorage,
+                                     chip::Span<const EmberAfDeviceType> deviceTypeList, chip::EndpointId parentEndpointId);
+chip::EndpointId emberAfClearDynamicEndpoint(uint16_t index);
+uint16_t emberAfGetDynamicIndexFromEndpoint(chip::EndpointId id);
+
+#define ATTRIBUTE_LARGEST				259
+#define ATTRIBUTE_MASK_WRITABLE			0x01
+#define ATTRIBUTE_MASK_TOKENIZE			0x02
+#define ATTRIBUTE_MASK_MIN_MAX			0x04
+#define ATTRIBUTE_MASK_EXTERNAL_STORAGE	0x10
+#define ATTRIBUTE_MASK_SINGLETON		0x20
+#define ATTRIBUTE_MASK_NULLABLE			0x40
+#define CLUSTER_MASK_SERVER				0x02
+#define CLUSTER_MASK_INIT_FUNCTION		0x04
+#define CLUSTER_MASK_ATTRIBUTE_CHANGED_FUNCTION		0x08
+#define CLUSTER_MASK_SHUTDOWN_FUNCTION	0x10
+#define CLUSTER_MASK_PRE_ATTRIBUTE_CHANGED_FUNCTION	0x20
+
+enum
+{
+    ZCL_BOOLEAN_ATTRIBUTE_TYPE = 0x10,
+    ZCL_BITMAP8_ATTRIBUTE_TYPE = 0x18,
+    ZCL_BITMAP16_ATTRIBUTE_TYPE = 0x19,
+    ZCL_BITMAP32_ATTRIBUTE_TYPE = 0x1B,
+    ZCL_BITMAP64_ATTRIBUTE_TYPE = 0x1F,
+    ZCL_INT8U_ATTRIBUTE_TYPE = 0x20,
+    ZCL_INT16U_ATTRIBUTE_TYPE = 0x21,
+    ZCL_INT24U_ATTRIBUTE_TYPE = 0x22,
+    ZCL_INT32U_ATTRIBUTE_TYPE = 0x23,
+    ZCL_INT40U_ATTRIBUTE_TYPE = 0x24,
+    ZCL_INT48U_ATTRIBUTE_TYPE = 0x25,
+    ZCL_INT56U_ATTRIBUTE_TYPE = 0x26,
+    ZCL_INT64U_ATTRIBUTE_TYPE = 0x27,
+    ZCL_INT8S_ATTRIBUTE_TYPE = 0x28,
+    ZCL_INT16S_ATTRIBUTE_TYPE = 0x29,
+    ZCL_INT24S_ATTRIBUTE_TYPE = 0x2A,
+    ZCL_INT32S_ATTRIBUTE_TYPE = 0x2B,
+    ZCL_INT40S_ATTRIBUTE_TYPE = 0x2C,
+    ZCL_INT48S_ATTRIBUTE_TYPE = 0x2D,
+    ZCL_INT56S_ATTRIBUTE_TYPE = 0x2E,
+    ZCL_INT64S_ATTRIBUTE_TYPE = 0x2F,
+    ZCL_ENUM8_ATTRIBUTE_TYPE = 0x30,
+    ZCL_ENUM16_ATTRIBUTE_TYPE = 0x31,
+    ZCL_PRIORITY_ATTRIBUTE_TYPE = 0x32,
+    ZCL_STATUS_ATTRIBUTE_TYPE = 0x33,
+    ZCL_SINGLE_ATTRIBUTE_TYPE = 0x39,
+    ZCL_DOUBLE_ATTRIBUTE_TYPE = 0x3A,
+    ZCL_OCTET_STRING_ATTRIBUTE_TYPE = 0x41,
+    ZCL_CHAR_STRING_ATTRIBUTE_TYPE = 0x42,
+    ZCL_LONG_OCTET_STRING_ATTRIBUTE_TYPE = 0x43,
+    ZCL_LONG_CHAR_STRING_ATTRIBUTE_TYPE = 0x44,
+    ZCL_ARRAY_ATTRIBUTE_TYPE = 0x48,
+    ZCL_STRUCT_ATTRIBUTE_TYPE = 0x4C,
+    ZCL_TOD_ATTRIBUTE_TYPE = 0xE0,
+    ZCL_DATE_ATTRIBUTE_TYPE = 0xE1,
+    ZCL_UTC_ATTRIBUTE_TYPE = 0xE2,
+    ZCL_EPOCH_US_ATTRIBUTE_TYPE = 0xE3,
+    ZCL_EPOCH_S_ATTRIBUTE_TYPE = 0xE4,
+    ZCL_SYSTIME_US_ATTRIBUTE_TYPE = 0xE5,
+    ZCL_PERCENT_ATTRIBUTE_TYPE = 0xE6,
+    ZCL_PERCENT100THS_ATTRIBUTE_TYPE = 0xE7,
+    ZCL_CLUSTER_ID_ATTRIBUTE_TYPE = 0xE8,
+    ZCL_ATTRIB_ID_ATTRIBUTE_TYPE = 0xE9,
+    ZCL_FIELD_ID_ATTRIBUTE_TYPE = 0xEA,
+    ZCL_EVENT_ID_ATTRIBUTE_TYPE = 0xEB,
+    ZCL_COMMAND_ID_ATTRIBUTE_TYPE = 0xEC,
+    ZCL_ACTION_ID_ATTRIBUTE_TYPE = 0xED,
+    ZCL_TRANS_ID_ATTRIBUTE_TYPE = 0xEF,
+    ZCL_NODE_ID_ATTRIBUTE_TYPE = 0xF0,
+    ZCL_VENDOR_ID_ATTRIBUTE_TYPE = 0xF1,
+    ZCL_DEVTYPE_ID_ATTRIBUTE_TYPE = 0xF2,
+    ZCL_FABRIC_ID_ATTRIBUTE_TYPE = 0xF3,
+    ZCL_GROUP_ID_ATTRIBUTE_TYPE = 0xF4,
+    ZCL_STATUS_CODE_ATTRIBUTE_TYPE = 0xF5,
+    ZCL_ENDPOINT_NO_ATTRIBUTE_TYPE = 0xF6,
+    ZCL_EVENT_NO_ATTRIBUTE_TYPE = 0xF7,
+    ZCL_DATA_VER_ATTRIBUTE_TYPE = 0xF8,
+    ZCL_FABRIC_IDX_ATTRIBUTE_TYPE = 0xF9,
+    ZCL_ENTRY_IDX_ATTRIBUTE_TYPE = 0xFA,
+    ZCL_SYSTIME_MS_ATTRIBUTE_TYPE = 0xFB,
+    ZCL_ELAPSED_S_ATTRIBUTE_TYPE = 0xFC,
+    ZCL_TEMPERATURE_ATTRIBUTE_TYPE = 0xFD,
+    ZCL_POSIX_MS_ATTRIBUTE_TYPE = 0xFE,
+};
@@ -0,0 +1,529 @@
+/*
+   Host benchmark of the dynamic data model (core/matter_data_model.cpp).
+
+   CORE=component/common/application/matter/core
+   PORT=component/common/application/matter/common/port
+   g++ -O2 -std=c++17 -I. -I$CORE -I$PORT -o data_model_bench data_model_bench.cpp $CORE/matter_data_model.cpp
+   ./data_model_bench
+
+   A bridge is grown from 2 to 200 bridged endpoints of a dimmable light each. At every size the
+   external attribute read callback, which resolves the path through the attribute index, is timed
+   on random paths next to the walk it replaced: Node::getEndpoint, Endpoint::getCluster and
+   Cluster::getAttribute, three linear scans.
+
+   The bridge is then taken down and the endpoint life cycle is run at 1, 10, 100 and 250
+   endpoints: Node::addEndpoint, Node::enableEndpoints, external reads and writes, Node::
+   disableEndpoints and Node::removeEndpoint, timed per endpoint or per access. Writes hit
+   tokenized and plain writable attributes while a simulated clock runs at 10 ms per write, so the
+   write-behind queue commits on its timer as it does on the device. The persistence table counts
+   the DCT calls (direct reads and writes, transaction writes, deletes and commits) and the chip
+   stack locks of every size. The heap peak is the largest malloc footprint above the empty node
+   while the endpoints are added and enabled, the DCT stand-in grows with the writes and is left out.
+
+   The CHIP stack and the DCT are stand-ins kept in this file and in chip_host.h.
+*/
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <malloc.h>
+#include <time.h>
+#include "matter_data_model.h"
+#include <platform/Ameba/AmebaUtils.h>
+
+using chip::Protocols::InteractionModel::Status;
+
+Status emberAfExternalAttributeReadCallback(EndpointId endpoint_id, ClusterId cluster_id,
+                                            const EmberAfAttributeMetadata *matter_attribute, uint8_t *buffer,
+                                            uint16_t max_read_length);
+Status emberAfExternalAttributeWriteCallback(EndpointId endpoint_id, ClusterId cluster_id,
+                                             const EmberAfAttributeMetadata *matter_attribute, uint8_t *buffer);
+
+/* ---- CHIP stack and DCT stand-ins ---- */
+
+static std::map<std::string, std::vector<uint8_t>> bench_dct;
+
+// calls into the stack and the DCT, cleared before every phase
+struct BenchCalls
+{
+    uint32_t dynamicSet, dynamicClear;
+    uint32_t prefGet, prefSet, prefDelete;
+    uint32_t txnSet, txnDelete, txnCommit;
+};
+
+static BenchCalls bench_calls;
+
+struct pref_txn_op
+{
+    std::string key;
+    std::vector<uint8_t> value;
+    bool erase;
+};
+
+namespace chip {
+namespace System {
+ClockImpl &SystemClock()
+{
+    static ClockImpl clock;
+    return clock;
+}
+
+CHIP_ERROR Layer::StartTimer(Clock::Milliseconds32 delay, TimerCompleteCallback timerCallback, void *timerContext)
+{
+    callback = timerCallback;
+    context = timerContext;
+    deadline = SystemClock().now + delay.count();
+    return CHIP_NO_ERROR;
+}
+
+void Layer::CancelTimer(TimerCompleteCallback timerCallback, void *timerContext)
+{
+    callback = nullptr;
+}
+} // namespace System
+
+namespace DeviceLayer {
+PlatformManager &PlatformMgr()
+{
+    static PlatformManager manager;
+    return manager;
+}
+
+System::Layer &SystemLayer()
+{
+    static System::Layer layer;
+    return layer;
+}
+
+namespace PersistedStorage {
+KeyValueStoreManager &KeyValueStoreMgr()
+{
+    static KeyValueStoreManager manager;
+    return manager;
+}
+}
+} // namespace DeviceLayer
+} // namespace chip
+
+CHIP_ERROR emberAfSetDynamicEndpoint(uint16_t index, chip::EndpointId id, const EmberAfEndpointType *ep,
+                                     const chip::Span<chip::DataVersion> &dataVersionStorage,
+                                     chip::Span<const EmberAfDeviceType> deviceTypeList, chip::EndpointId parentEndpointId)
+{
+    bench_calls.dynamicSet++;
+    return CHIP_NO_ERROR;
+}
+
+chip::EndpointId emberAfClearDynamicEndpoint(uint16_t index)
+{
+    bench_calls.dynamicClear++;
+    return index;
+}
+
+uint16_t emberAfGetDynamicIndexFromEndpoint(chip::EndpointId id)
+{
+    return id;
+}
+
+s32 setPref_new(const char *domain, const char *key, u8 *value, size_t byteCount)
+{
+    bench_calls.prefSet++;
+    bench_dct[key].assign(value, value + byteCount);
+    return 0;
+}
+
+s32 getPref_bin_new(const char *domain, const char *key, u8 *buf, size_t bufSize, size_t *outLen)
+{
+    auto it = bench_dct.find(key);
+
+    bench_calls.prefGet++;
+    if (it == bench_dct.end())
+        return -1;
+    *outLen = std::min(bufSize, it->second.size());
+    memcpy(buf, it->second.data(), *outLen);
+    return 0;
+}
+
+s32 deleteKey(const char *domain, const char *key)
+{
+    bench_calls.prefDelete++;
+    bench_dct.erase(key);
+    return 0;
+}
+
+s32 beginPrefTxn(pref_txn_t *txn)
+{
+    txn->ops = nullptr;
+    txn->count = 0;
+    txn->capacity = 0;
+    return 0;
+}
+
+static s32 bench_txn_add(pref_txn_t *txn, const char *key, u8 *value, size_t byteCount, bool erase)
+{
+    std::vector<pref_txn_op> *ops = reinterpret_cast<std::vector<pref_txn_op> *>(txn->ops);
+
+    if (ops == nullptr)
+    {
+        ops = new std::vector<pref_txn_op>();
+        txn->ops = reinterpret_cast<pref_txn_op_t *>(ops);
+    }
+    ops->push_back(pref_txn_op{key, std::vector<uint8_t>(value, value + byteCount), erase});
+    txn->count = ops->size();
+    return 0;
+}
+
+s32 setPrefTxn(pref_txn_t *txn, const char *key, u8 *value, size_t byteCount)
+{
+    bench_calls.txnSet++;
+    return bench_txn_add(txn, key, value, byteCount, false);
+}
+
+s32 deletePrefTxn(pref_txn_t *txn, const char *key)
+{
+    bench_calls.txnDelete++;
+    return bench_txn_add(txn, key, nullptr, 0, true);
+}
+
+void abortPrefTxn(pref_txn_t *txn)
+{
+    delete reinterpret_cast<std::vector<pref_txn_op> *>(txn->ops);
+    txn->ops = nullptr;
+    txn->count = 0;
+}
+
+// set to fail every commit, the DCT is left untouched
+static bool bench_commit_fails = false;
+
+s32 commitPrefTxn(pref_txn_t *txn)
+{
+    std::vector<pref_txn_op> *ops = reinterpret_cast<std::vector<pref_txn_op> *>(txn->ops);
+
+    bench_calls.txnCommit++;
+    if (bench_commit_fails)
+    {
+        abortPrefTxn(txn);
+        return -1;
+    }
+    for (size_t i = 0; ops != nullptr && i < ops->size(); i++)
+    {
+        if ((*ops)[i].erase)
+            bench_dct.erase((*ops)[i].key);
+        else
+            bench_dct[(*ops)[i].key] = (*ops)[i].value;
+    }
+    abortPrefTxn(txn);
+    return 0;
+}
+
+s32 registerPrefFlushHandler(pref_flush_handler_t handler)
+{
+    return 0;
+}
+
+void flushPref(void)
+{
+}
+
+/* ---- workload ---- */
+
+struct BenchPath
+{
+    chip::EndpointId endpointId;
+    chip::ClusterId clusterId;
+    chip::AttributeId attributeId;
+};
+
+static const uint8_t bench_label[33] = "bridged light";
+
+// a bridged dimmable light: descriptor, bridged device basic information, identify, on/off and level control
+static EndpointConfig bench_light_config(void)
+{
+    EndpointConfig endpoint;
+    ClusterConfig descriptor, basic, identify, onoff, level;
+
+    descriptor.clusterId = 0x001D;
+    for (uint32_t id = 0; id < 4; id++)
+        descriptor.attributeConfigs.push_back(AttributeConfig(id, ZCL_ARRAY_ATTRIBUTE_TYPE, (uint32_t) 0, 0, ATTRIBUTE_MASK_EXTERNAL_STORAGE));
+
+    basic.clusterId = 0x0039;
+    basic.attributeConfigs.push_back(AttributeConfig(0x0005, ZCL_CHAR_STRING_ATTRIBUTE_TYPE, bench_label, 33, ATTRIBUTE_MASK_EXTERNAL_STORAGE | ATTRIBUTE_MASK_WRITABLE));
+    basic.attributeConfigs.push_back(AttributeConfig(0x0011, ZCL_BOOLEAN_ATTRIBUTE_TYPE, (uint32_t) 1, 1, ATTRIBUTE_MASK_EXTERNAL_STORAGE));
+
+    identify.clusterId = 0x0003;
+    identify.attributeConfigs.push_back(AttributeConfig(0x0000, ZCL_INT16U_ATTRIBUTE_TYPE, (uint32_t) 0, 2, ATTRIBUTE_MASK_EXTERNAL_STORAGE | ATTRIBUTE_MASK_WRITABLE));
+    identify.attributeConfigs.push_back(AttributeConfig(0x0001, ZCL_ENUM8_ATTRIBUTE_TYPE, (uint32_t) 2, 1, ATTRIBUTE_MASK_EXTERNAL_STORAGE));
+
+    onoff.clusterId = 0x0006;
+    onoff.attributeConfigs.push_back(AttributeConfig(0x0000, ZCL_BOOLEAN_ATTRIBUTE_TYPE, (uint32_t) 0, 1, ATTRIBUTE_MASK_EXTERNAL_STORAGE | ATTRIBUTE_MASK_TOKENIZE));
+    onoff.attributeConfigs.push_back(AttributeConfig(0x4000, ZCL_BOOLEAN_ATTRIBUTE_TYPE, (uint32_t) 1, 1, ATTRIBUTE_MASK_EXTERNAL_STORAGE));
+    onoff.attributeConfigs.push_back(AttributeConfig(0x4001, ZCL_INT16U_ATTRIBUTE_TYPE, (uint32_t) 0, 2, ATTRIBUTE_MASK_EXTERNAL_STORAGE | ATTRIBUTE_MASK_WRITABLE));
+    onoff.attributeConfigs.push_back(AttributeConfig(0x4002, ZCL_INT16U_ATTRIBUTE_TYPE, (uint32_t) 0, 2, ATTRIBUTE_MASK_EXTERNAL_STORAGE | ATTRIBUTE_MASK_WRITABLE));
+    onoff.attributeConfigs.push_back(AttributeConfig(0x4003, ZCL_ENUM8_ATTRIBUTE_TYPE, (uint32_t) 0, 1, ATTRIBUTE_MASK_EXTERNAL_STORAGE | ATTRIBUTE_MASK_TOKENIZE));
+    onoff.attributeConfigs.push_back(AttributeConfig(0xFFFC, ZCL_BITMAP32_ATTRIBUTE_TYPE, (uint32_t) 1, 4, ATTRIBUTE_MASK_EXTERNAL_STORAGE));
+    onoff.attributeConfigs.push_back(AttributeConfig(0xFFFD, ZCL_INT16U_ATTRIBUTE_TYPE, (uint32_t) 5, 2, ATTRIBUTE_MASK_EXTERNAL_STORAGE));
+    for (uint32_t id = 0; id < 3; id++)
+        onoff.commandConfigs.push_back(CommandConfig(id, COMMAND_MASK_ACCEPTED));
+
+    level.clusterId = 0x0008;
+    level.attributeConfigs.push_back(AttributeConfig(0x0000, ZCL_INT8U_ATTRIBUTE_TYPE, (uint32_t) 254, 1, ATTRIBUTE_MASK_EXTERNAL_STORAGE | ATTRIBUTE_MASK_TOKENIZE));
+    level.attributeConfigs.push_back(AttributeConfig(0x0001, ZCL_INT16U_ATTRIBUTE_TYPE, (uint32_t) 0, 2, ATTRIBUTE_MASK_EXTERNAL_STORAGE));
+    level.attributeConfigs.push_back(AttributeConfig(0x0002, ZCL_INT8U_ATTRIBUTE_TYPE, (uint32_t) 1, 1, ATTRIBUTE_MASK_EXTERNAL_STORAGE));
+    level.attributeConfigs.push_back(AttributeConfig(0x0003, ZCL_INT8U_ATTRIBUTE_TYPE, (uint32_t) 254, 1, ATTRIBUTE_MASK_EXTERNAL_STORAGE));
+    level.attributeConfigs.push_back(AttributeConfig(0x000F, ZCL_BITMAP8_ATTRIBUTE_TYPE, (uint32_t) 0, 1, ATTRIBUTE_MASK_EXTERNAL_STORAGE | ATTRIBUTE_MASK_WRITABLE));
+    level.attributeConfigs.push_back(AttributeConfig(0x0010, ZCL_INT16U_ATTRIBUTE_TYPE, (uint32_t) 0, 2, ATTRIBUTE_MASK_EXTERNAL_STORAGE | ATTRIBUTE_MASK_WRITABLE));
+    level.attributeConfigs.push_back(AttributeConfig(0x0011, ZCL_INT8U_ATTRIBUTE_TYPE, (uint32_t) 255, 1, ATTRIBUTE_MASK_EXTERNAL_STORAGE | ATTRIBUTE_MASK_WRITABLE));
+    level.attributeConfigs.push_back(AttributeConfig(0x4000, ZCL_INT8U_ATTRIBUTE_TYPE, (uint32_t) 255, 1, ATTRIBUTE_MASK_EXTERNAL_STORAGE | ATTRIBUTE_MASK_TOKENIZE));
+    level.attributeConfigs.push_back(AttributeConfig(0xFFFC, ZCL_BITMAP32_ATTRIBUTE_TYPE, (uint32_t) 3, 4, ATTRIBUTE_MASK_EXTERNAL_STORAGE));
+    level.attributeConfigs.push_back(AttributeConfig(0xFFFD, ZCL_INT16U_ATTRIBUTE_TYPE, (uint32_t) 5, 2, ATTRIBUTE_MASK_EXTERNAL_STORAGE));
+    for (uint32_t id = 0; id < 8; id++)
+        level.commandConfigs.push_back(CommandConfig(id, COMMAND_MASK_ACCEPTED));
+
+    endpoint.clusterConfigs = {descriptor, basic, identify, onoff, level};
+    return endpoint;
+}
+
+static double bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const EmberAfDeviceType bench_device_types[] = {{0x0101, 1}, {0x0013, 1}};
+
+// writable attributes of the light, the first four are tokenized
+static const BenchPath bench_write_paths[] = {
+    {0, 0x0006, 0x0000}, {0, 0x0006, 0x4003}, {0, 0x0008, 0x0000}, {0, 0x0008, 0x4000},
+    {0, 0x0003, 0x0000}, {0, 0x0008, 0x0010},
+};
+
+static size_t bench_heap(void)
+{
+    return mallinfo2().uordblks;
+}
+
+// advance the simulated clock and fire the persistence timer once it is due
+static void bench_advance(uint32_t ms)
+{
+    chip::System::Layer &layer = chip::DeviceLayer::SystemLayer();
+
+    chip::System::SystemClock().now += ms;
+    if (layer.callback != nullptr && chip::System::SystemClock().now >= layer.deadline)
+    {
+        chip::System::TimerCompleteCallback callback = layer.callback;
+
+        layer.callback = nullptr;
+        callback(&layer, layer.context);
+    }
+}
+
+struct LifecycleResult
+{
+    double add, enable, read, write, disable, remove;
+    BenchCalls addCalls, writeCalls, disableCalls;
+    uint32_t enableLocks, writeLocks, disableLocks;
+    size_t heapPeak;
+};
+
+static LifecycleResult bench_lifecycle(size_t count, const EndpointConfig &light, uint32_t &checksum, int &failed)
+{
+    const size_t accesses = 100000;
+    Node &node = Node::getInstance();
+    chip::DeviceLayer::PlatformManager &platform = chip::DeviceLayer::PlatformMgr();
+    std::vector<chip::EndpointId> ids;
+    std::vector<BenchPath> paths;
+    std::vector<BenchPath> order(accesses);
+    uint8_t buffer[ATTRIBUTE_LARGEST];
+    LifecycleResult result = {};
+
+    ids.reserve(count);
+    paths.reserve(count * 25);
+    size_t heapBase = bench_heap();
+    size_t heapPeak = heapBase;
+    bench_calls = BenchCalls();
+    double start = bench_now();
+    for (size_t i = 0; i < count; i++)
+    {
+        ids.push_back(node.addEndpoint(light, chip::Span<const EmberAfDeviceType>(bench_device_types)));
+        heapPeak = std::max(heapPeak, bench_heap());
+    }
+    result.add = (bench_now() - start) / count;
+    result.addCalls = bench_calls;
+
+    for (chip::EndpointId id : ids)
+        for (const ClusterConfig &cluster : light.clusterConfigs)
+            for (const AttributeConfig &attribute : cluster.attributeConfigs)
+                paths.push_back(BenchPath{id, cluster.clusterId, attribute.attributeId});
+
+    uint32_t locks = platform.locks;
+    start = bench_now();
+    node.enableEndpoints(ids);
+    result.enable = (bench_now() - start) / count;
+    result.enableLocks = platform.locks - locks;
+    heapPeak = std::max(heapPeak, bench_heap());
+    result.heapPeak = heapPeak - heapBase;
+
+    for (BenchPath &path : order)
+        path = paths[rand() % paths.size()];
+    start = bench_now();
+    for (const BenchPath &path : order)
+    {
+        EmberAfAttributeMetadata metadata = {(uint32_t) 0, path.attributeId, 0, 0, 0};
+
+        if (emberAfExternalAttributeReadCallback(path.endpointId, path.clusterId, &metadata, buffer, sizeof(buffer)) != Status::Success)
+            failed = 1;
+        checksum += buffer[0];
+    }
+    result.read = (bench_now() - start) / accesses;
+
+    for (BenchPath &path : order)
+    {
+        path = bench_write_paths[rand() % (sizeof(bench_write_paths) / sizeof(bench_write_paths[0]))];
+        path.endpointId = ids[rand() % ids.size()];
+    }
+    bench_calls = BenchCalls();
+    locks = platform.locks;
+    start = bench_now();
+    for (size_t i = 0; i < accesses; i++)
+    {
+        const BenchPath &path = order[i];
+        EmberAfAttributeMetadata metadata = {(uint32_t) 0, path.attributeId, 0, 0, 0};
+        uint8_t value[2] = {(uint8_t) i, (uint8_t) (i >> 8)};
+
+        if (emberAfExternalAttributeWriteCallback(path.endpointId, path.clusterId, &metadata, value) != Status::Success)
+            failed = 1;
+        bench_advance(10);
+    }
+    // a failed commit keeps the values queued for the next flush
+    size_t pendingCount = AttributePersistenceQueue::getInstance().getPendingCount();
+    bench_commit_fails = true;
+    AttributePersistenceQueue::getInstance().flush();
+    bench_commit_fails = false;
+    if (pendingCount == 0 || AttributePersistenceQueue::getInstance().getPendingCount() != pendingCount)
+        failed = 1;
+    AttributePersistenceQueue::getInstance().flush();
+    if (AttributePersistenceQueue::getInstance().getPendingCount() != 0)
+        failed = 1;
+    result.write = (bench_now() - start) / accesses;
+    result.writeCalls = bench_calls;
+    result.writeLocks = platform.locks - locks;
+
+    bench_calls = BenchCalls();
+    locks = platform.locks;
+    start = bench_now();
+    node.disableEndpoints(ids);
+    result.disable = (bench_now() - start) / count;
+    result.disableCalls = bench_calls;
+    result.disableLocks = platform.locks - locks;
+
+    start = bench_now();
+    for (chip::EndpointId id : ids)
+        node.removeEndpoint(id);
+    result.remove = (bench_now() - start) / count;
+
+    if (node.getAttributeIndex().getCount() != 0 || !bench_dct.empty())
+        failed = 1;
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    static const size_t sizes[] = {2, 10, 50, 100, 200};
+    const size_t reads = 200000;
+    Node &node = Node::getInstance();
+    EndpointConfig light = bench_light_config();
+    std::vector<BenchPath> paths;
+    size_t endpoints = 0;
+    uint8_t buffer[ATTRIBUTE_LARGEST];
+    uint32_t checksum = 0;
+    int failed = 0;
+
+    srand(1);
+    printf("endpoints  attributes  index bytes  indexed read ns  linear walk ns\n");
+    for (size_t size : sizes)
+    {
+        while (endpoints < size)
+        {
+            chip::EndpointId id = node.addEndpoint(light, chip::Span<const EmberAfDeviceType>(bench_device_types));
+
+            for (const ClusterConfig &cluster : light.clusterConfigs)
+                for (const AttributeConfig &attribute : cluster.attributeConfigs)
+                    paths.push_back(BenchPath{id, cluster.clusterId, attribute.attributeId});
+            endpoints++;
+        }
+
+        std::vector<BenchPath> order(reads);
+        for (BenchPath &path : order)
+            path = paths[rand() % paths.size()];
+
+        double start = bench_now();
+        for (const BenchPath &path : order)
+        {
+            EmberAfAttributeMetadata metadata = {(uint32_t) 0, path.attributeId, 0, 0, 0};
+
+            if (emberAfExternalAttributeReadCallback(path.endpointId, path.clusterId, &metadata, buffer, sizeof(buffer)) != Status::Success)
+                failed = 1;
+            checksum += buffer[0];
+        }
+        double indexed = bench_now() - start;
+
+        start = bench_now();
+        for (const BenchPath &path : order)
+        {
+            Endpoint *endpoint = node.getEndpoint(path.endpointId);
+            Cluster *cluster = (endpoint != NULL) ? endpoint->getCluster(path.clusterId) : NULL;
+            Attribute *attribute = (cluster != NULL) ? cluster->getAttribute(path.attributeId) : NULL;
+
+            if (attribute == NULL)
+            {
+                failed = 1;
+                continue;
+            }
+            attribute->getValue(buffer);
+            checksum += buffer[0];
+        }
+        double linear = bench_now() - start;
+
+        printf("%9zu %11zu %12zu %16.1f %15.1f\n", endpoints, node.getAttributeIndex().getCount(),
+               node.getAttributeIndex().getMemoryUsage(), indexed * 1e9 / reads, linear * 1e9 / reads);
+    }
+
+    // take the bridge down, the life cycle starts from an empty node
+    std::vector<chip::EndpointId> ids;
+    for (const BenchPath &path : paths)
+        if (ids.empty() || ids.back() != path.endpointId)
+            ids.push_back(path.endpointId);
+    node.disableEndpoints(ids);
+    for (chip::EndpointId id : ids)
+        node.removeEndpoint(id);
+
+    static const size_t counts[] = {1, 10, 100, 250};
+    LifecycleResult results[sizeof(counts) / sizeof(counts[0])];
+
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+        results[i] = bench_lifecycle(counts[i], light, checksum, failed);
+
+    printf("\nendpoints  add us  enable us  disable us  remove us  read ns  write ns  heap peak\n");
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        const LifecycleResult &r = results[i];
+
+        printf("%9zu %7.2f %10.2f %11.2f %10.2f %8.1f %9.1f %10zu\n", counts[i], r.add * 1e6, r.enable * 1e6,
+               r.disable * 1e6, r.remove * 1e6, r.read * 1e9, r.write * 1e9, r.heapPeak);
+    }
+
+    printf("\n           add            enable  write                              disable\n");
+    printf("endpoints  DCT reads      locks   txn sets  commits  DCT sets  locks   txn deletes  commits  locks\n");
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        const LifecycleResult &r = results[i];
+
+        printf("%9zu %10u %10u %10u %8u %9u %6u %13u %8u %6u\n", counts[i], r.addCalls.prefGet, r.enableLocks,
+               r.writeCalls.txnSet, r.writeCalls.txnCommit, r.writeCalls.prefSet, r.writeLocks,
+               r.disableCalls.txnDelete, r.disableCalls.txnCommit, r.disableLocks);
+    }
+
+    printf("%s (checksum %u)\n", failed ? "FAILED" : "ok", checksum);
+    return failed;
+}
@@ -0,0 +1,4 @@
+/* Host stand-in, see chip_host.h, with the DCT API of common/port/matter_dcts.h */
+#pragma once
+#include "chip_host.h"
+#include <matter_dcts.h>
@@ -0,0 +1,9 @@
+/* Host stand-in with the SDK types matter_dcts.h uses */
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+typedef int32_t s32;
+typedef uint8_t u8;
+typedef uint32_t u32;
+typedef uint64_t u64;
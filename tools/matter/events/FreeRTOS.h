@@ -0,0 +1,132 @@
+/* Host stand-in for the FreeRTOS queue, task and critical section API, tasks run as std::threads */
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdFALSE             0
+#define pdTRUE              1
+#define pdPASS              pdTRUE
+#define portMAX_DELAY       ((TickType_t) 0xFFFFFFFF)
+#define portTICK_PERIOD_MS  1
+
+// one lock for every critical section, as on the single core target; never destroyed so that tasks still
+// blocked when the bench returns do not touch a dead mutex
+static inline std::recursive_mutex &hostCriticalLock()
+{
+    static std::recursive_mutex *lock = new std::recursive_mutex;
+    return *lock;
+}
+
+#define taskENTER_CRITICAL()    hostCriticalLock().lock()
+#define taskEXIT_CRITICAL()     hostCriticalLock().unlock()
+
+static inline TickType_t xTaskGetTickCount(void)
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return (TickType_t) std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static inline TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+static inline void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+// items are copied in and out by value, like xQueueGenericSend/xQueueReceive
+struct QueueDefinition
+{
+    std::mutex lock;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::vector<uint8_t> storage;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+typedef QueueDefinition *QueueHandle_t;
+
+static inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    QueueHandle_t queue = new QueueDefinition;
+    queue->storage.resize(length * itemSize);
+    queue->length = length;
+    queue->itemSize = itemSize;
+    queue->head = 0;
+    queue->count = 0;
+    return queue;
+}
+
+static inline void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+static inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t timeout)
+{
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if (queue->count == queue->length)
+    {
+        if (timeout == 0)
+        {
+            return pdFALSE;
+        }
+        queue->notFull.wait(guard, [queue] { return queue->count < queue->length; });
+    }
+    UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(&queue->storage[tail * queue->itemSize], item, queue->itemSize);
+    queue->count++;
+    queue->notEmpty.notify_one();
+    return pdTRUE;
+}
+
+static inline BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higherPriorityTaskWoken)
+{
+    return xQueueSend(queue, item, 0);
+}
+
+static inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t timeout)
+{
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if (queue->count == 0)
+    {
+        if (timeout == 0)
+        {
+            return pdFALSE;
+        }
+        queue->notEmpty.wait(guard, [queue] { return queue->count > 0; });
+    }
+    memcpy(item, &queue->storage[queue->head * queue->itemSize], queue->itemSize);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    queue->notFull.notify_one();
+    return pdTRUE;
+}
+
+typedef std::thread *TaskHandle_t;
+
+static inline BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint16_t stackDepth, void *parameters,
+                                     UBaseType_t priority, TaskHandle_t *createdTask)
+{
+    TaskHandle_t task = new std::thread(code, parameters);
+    task->detach();
+    if (createdTask != NULL)
+    {
+        *createdTask = task;
+    }
+    return pdPASS;
+}
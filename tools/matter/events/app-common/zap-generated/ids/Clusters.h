@@ -0,0 +1,15 @@
+/* Host stand-in, the cluster ids the lane assignment looks at */
+#pragma once
+#include <app/ConcreteAttributePath.h>
+
+namespace chip {
+namespace app {
+namespace Clusters {
+namespace Identify { static constexpr ClusterId Id = 0x0003; }
+namespace OnOff { static constexpr ClusterId Id = 0x0006; }
+namespace LevelControl { static constexpr ClusterId Id = 0x0008; }
+namespace BasicInformation { static constexpr ClusterId Id = 0x0028; }
+namespace ColorControl { static constexpr ClusterId Id = 0x0300; }
+} // namespace Clusters
+} // namespace app
+} // namespace chip
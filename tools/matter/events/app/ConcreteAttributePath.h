@@ -0,0 +1,26 @@
+/* Host stand-in, see platform/CHIPDeviceLayer.h */
+#pragma once
+#include <stdint.h>
+
+namespace chip {
+typedef uint16_t EndpointId;
+typedef uint32_t ClusterId;
+typedef uint32_t AttributeId;
+
+namespace app {
+struct ConcreteAttributePath
+{
+    ConcreteAttributePath() {}
+    ConcreteAttributePath(EndpointId endpointId, ClusterId clusterId, AttributeId attributeId) :
+        mAttributeId(attributeId), mClusterId(clusterId), mEndpointId(endpointId) {}
+    bool operator==(const ConcreteAttributePath &other) const
+    {
+        return mEndpointId == other.mEndpointId && mClusterId == other.mClusterId && mAttributeId == other.mAttributeId;
+    }
+
+    AttributeId mAttributeId = 0;
+    ClusterId mClusterId = 0;
+    EndpointId mEndpointId = 0;
+};
+} // namespace app
+} // namespace chip
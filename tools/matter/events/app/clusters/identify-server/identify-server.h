@@ -0,0 +1,3 @@
+/* Host stand-in, matter_drivers.h only names the Identify type */
+#pragma once
+struct Identify;
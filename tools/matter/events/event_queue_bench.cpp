@@ -0,0 +1,304 @@
+/*
+   Host benchmark of the Matter event queues (core/matter_interaction.cpp, core/matter_events.h).
+
+   g++ -O2 -std=c++17 -pthread -I. -I$CORE -I$APP -o event_queue_bench event_queue_bench.cpp $CORE/matter_interaction.cpp
+   ./event_queue_bench [events]
+   with CORE=component/common/application/matter/core and APP=component/common/application/matter/example/light
+
+   Events go through a copy-by-value queue like the FreeRTOS one (see FreeRTOS.h), once with the
+   AppEvent layout that embedded a 256 byte string buffer and once with the current AppEvent whose
+   strings live in the payload pool. "copy" sends and receives on one thread, which is the queue
+   cost a lane task pays per event; "handoff" passes the events to a second thread through a
+   queue of MATTER_EVENT_QUEUE_LENGTH events. Scalar events carry a level, string events a 32
+   byte label, allocated from and returned to the pool for the current layout. Event sizes are
+   those of the host, the pointer in the event makes them 4 bytes larger than on the RTL8710C.
+
+   Before timing, attribute changes are posted through MatterPostAttributeChangeCallback to the
+   real lanes, the OnOff, LevelControl and ColorControl paths through the realtime lane and the
+   Basic Information paths through the normal one: every path must see its values in the order
+   they were posted and end on the last one.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "matter_events.h"
+#include "matter_interaction.h"
+
+// AppEvent before the payload pool
+struct LegacyAppEvent
+{
+    uint16_t Type;
+    chip::app::ConcreteAttributePath path;
+    union
+    {
+       uint8_t _u8;
+       uint16_t _u16;
+       uint32_t _u32;
+       uint64_t _u64;
+       int8_t _i8;
+       int16_t _i16;
+       int32_t _i32;
+       int64_t _i64;
+       char _str[256];
+    } value;
+    EventHandler mHandler;
+};
+
+static const size_t kQueueLength = 16;
+static const char kLabel[32] = "Kitchen ceiling light, dimmable";
+
+// declared by the CHIP SDK, implemented by matter_interaction.cpp
+void MatterPostAttributeChangeCallback(const chip::app::ConcreteAttributePath & path, uint8_t type, uint16_t size, uint8_t * value);
+
+static const size_t kOrderPaths = 8;
+static const uint32_t kOrderChanges = 20000;
+static std::mutex orderLock;
+static uint32_t orderLast[kOrderPaths];
+static uint32_t orderDelivered;
+static bool orderBroken;
+
+static chip::app::ConcreteAttributePath OrderPath(size_t i)
+{
+    static const chip::ClusterId clusters[] = { 0x0006, 0x0008, 0x0300, 0x0028 };
+    return chip::app::ConcreteAttributePath((chip::EndpointId) (1 + i / 4), clusters[i % 4], 0);
+}
+
+void matter_driver_uplink_update_handler(AppEvent * event)
+{
+    std::lock_guard<std::mutex> guard(orderLock);
+    for (size_t i = 0; i < kOrderPaths; i++)
+    {
+        if (event->path == OrderPath(i))
+        {
+            // values are posted from 1 up, a coalesced batch may skip some but never go back
+            if (event->value._u32 <= orderLast[i])
+            {
+                orderBroken = true;
+            }
+            orderLast[i] = event->value._u32;
+            orderDelivered++;
+        }
+    }
+}
+
+static void CheckUplinkOrder()
+{
+    if (matter_interaction_start_uplink() != CHIP_NO_ERROR)
+    {
+        printf("FAIL: uplink lanes did not start\n");
+        exit(1);
+    }
+
+    for (uint32_t value = 1; value <= kOrderChanges; value++)
+    {
+        for (size_t i = 0; i < kOrderPaths; i++)
+        {
+            MatterPostAttributeChangeCallback(OrderPath(i), 0, sizeof(value), (uint8_t *) &value);
+        }
+    }
+
+    // the lanes drain the pending table on their own
+    for (int wait = 0; wait < 100; wait++)
+    {
+        bool done = true;
+        {
+            std::lock_guard<std::mutex> guard(orderLock);
+            for (size_t i = 0; i < kOrderPaths; i++)
+            {
+                done = done && orderLast[i] == kOrderChanges;
+            }
+        }
+        if (done)
+        {
+            break;
+        }
+        vTaskDelay(10);
+    }
+
+    UplinkDispatchStats stats;
+    GetUplinkDispatchStats(&stats);
+    std::lock_guard<std::mutex> guard(orderLock);
+    for (size_t i = 0; i < kOrderPaths; i++)
+    {
+        if (orderLast[i] != kOrderChanges)
+        {
+            printf("FAIL: path %zu ended on %u of %u\n", i, orderLast[i], kOrderChanges);
+            exit(1);
+        }
+    }
+    if (orderBroken || stats.dropped != 0)
+    {
+        printf("FAIL: uplink changes out of order or dropped (%u dropped)\n", stats.dropped);
+        exit(1);
+    }
+    printf("uplink: %u changes on %zu paths over the realtime and normal lanes, %u delivered in %u batches, in order\n\n",
+           stats.posted, kOrderPaths, orderDelivered, stats.batches);
+}
+
+static double Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// fill and drain the event the way MatterPostAttributeChangeCallback and the lane task do
+static void Fill(LegacyAppEvent & event, uint32_t i, bool string)
+{
+    event.Type = AppEvent::kEventType_Uplink;
+    event.path = chip::app::ConcreteAttributePath(1, string ? 0x0028 : 0x0008, string ? 5 : 0);
+    if (string)
+    {
+        memcpy(event.value._str, kLabel, sizeof(kLabel));
+    }
+    else
+    {
+        event.value._u8 = (uint8_t) i;
+    }
+}
+
+static uint32_t Drain(LegacyAppEvent & event, bool string)
+{
+    return string ? (uint8_t) event.value._str[sizeof(kLabel) - 2] : event.value._u8;
+}
+
+static void Fill(AppEvent & event, uint32_t i, bool string)
+{
+    event.Type = AppEvent::kEventType_Uplink;
+    event.path = chip::app::ConcreteAttributePath(1, string ? 0x0028 : 0x0008, string ? 5 : 0);
+    if (string)
+    {
+        event.payload = AppEventPayloadAlloc(kLabel, sizeof(kLabel));
+    }
+    else
+    {
+        event.value._u8 = (uint8_t) i;
+        event.payload = APP_EVENT_PAYLOAD_INVALID;
+    }
+}
+
+static uint32_t Drain(AppEvent & event, bool string)
+{
+    uint32_t result = event.value._u8;
+    if (string)
+    {
+        const uint8_t * label = AppEventPayloadGet(event.payload, NULL);
+        if (label == NULL)
+        {
+            printf("FAIL: payload pool ran dry\n");
+            exit(1);
+        }
+        result = label[sizeof(kLabel) - 2];
+        AppEventPayloadFree(event.payload);
+    }
+    return result;
+}
+
+template <class Event>
+static double Copy(uint32_t events, bool string, uint32_t & checksum)
+{
+    QueueHandle_t queue = xQueueCreate(kQueueLength, sizeof(Event));
+    Event in = {}, out = {};
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < events; i++)
+    {
+        Fill(in, i, string);
+        xQueueSend(queue, &in, portMAX_DELAY);
+        xQueueReceive(queue, &out, portMAX_DELAY);
+        checksum += Drain(out, string);
+    }
+    double seconds = Seconds(start);
+    vQueueDelete(queue);
+    return events / seconds;
+}
+
+template <class Event>
+static double Handoff(uint32_t events, bool string, uint32_t & checksum)
+{
+    QueueHandle_t queue = xQueueCreate(kQueueLength, sizeof(Event));
+    std::atomic<uint32_t> sum(0);
+    auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&] {
+        Event out;
+        uint32_t local = 0;
+        for (uint32_t i = 0; i < events; i++)
+        {
+            xQueueReceive(queue, &out, portMAX_DELAY);
+            local += Drain(out, string);
+        }
+        sum = local;
+    });
+    Event in = {};
+    for (uint32_t i = 0; i < events; i++)
+    {
+        Fill(in, i, string);
+        xQueueSend(queue, &in, portMAX_DELAY);
+    }
+    consumer.join();
+    double seconds = Seconds(start);
+    vQueueDelete(queue);
+    checksum += sum;
+    return events / seconds;
+}
+
+static void CheckPool()
+{
+    static uint8_t data[APP_EVENT_PAYLOAD_BLOCK_NUM * APP_EVENT_PAYLOAD_BLOCK_SIZE];
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t) (i * 7);
+    }
+
+    // the whole pool is one payload, then nothing fits until it is freed
+    AppEventPayloadHandle whole = AppEventPayloadAlloc(data, sizeof(data));
+    uint16_t size = 0;
+    const uint8_t * stored = AppEventPayloadGet(whole, &size);
+    if (stored == NULL || size != sizeof(data) || memcmp(stored, data, sizeof(data)) != 0 ||
+        AppEventPayloadAlloc(data, 1) != APP_EVENT_PAYLOAD_INVALID)
+    {
+        printf("FAIL: payload spanning the pool\n");
+        exit(1);
+    }
+    AppEventPayloadFree(whole);
+
+    // freed blocks are found again by the first fit
+    AppEventPayloadHandle first = AppEventPayloadAlloc(data, APP_EVENT_PAYLOAD_BLOCK_SIZE + 1);
+    AppEventPayloadHandle second = AppEventPayloadAlloc(data, 1);
+    AppEventPayloadFree(first);
+    AppEventPayloadHandle third = AppEventPayloadAlloc(data, 2 * APP_EVENT_PAYLOAD_BLOCK_SIZE);
+    if (first != 0 || second != 2 || third != 0 || AppEventPayloadGet(first, NULL) == NULL)
+    {
+        printf("FAIL: first fit reuse (%u %u %u)\n", first, second, third);
+        exit(1);
+    }
+    AppEventPayloadFree(second);
+    AppEventPayloadFree(third);
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t events = (argc > 1) ? (uint32_t) atoi(argv[1]) : 1000000;
+    uint32_t checksum = 0;
+
+    CheckPool();
+    CheckUplinkOrder();
+
+    printf("event bytes: legacy %zu, pooled %zu\n\n", sizeof(LegacyAppEvent), sizeof(AppEvent));
+    printf("%-8s %-8s %16s %16s\n", "", "value", "legacy events/s", "pooled events/s");
+    for (int string = 0; string <= 1; string++)
+    {
+        double legacy = Copy<LegacyAppEvent>(events, string, checksum);
+        double pooled = Copy<AppEvent>(events, string, checksum);
+        printf("%-8s %-8s %16.0f %16.0f\n", "copy", string ? "string" : "scalar", legacy, pooled);
+    }
+    for (int string = 0; string <= 1; string++)
+    {
+        double legacy = Handoff<LegacyAppEvent>(events, string, checksum);
+        double pooled = Handoff<AppEvent>(events, string, checksum);
+        printf("%-8s %-8s %16.0f %16.0f\n", "handoff", string ? "string" : "scalar", legacy, pooled);
+    }
+
+    printf("ok (checksum %u)\n", checksum);
+    return 0;
+}
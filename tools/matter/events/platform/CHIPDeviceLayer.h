@@ -0,0 +1,14 @@
+/* Host stand-in for the parts of the CHIP SDK the event executor (core/matter_interaction.*) builds against */
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "FreeRTOS.h"
+
+typedef int CHIP_ERROR;
+#define CHIP_NO_ERROR           0
+#define CHIP_ERROR_NO_MEMORY    11
+
+// the bench times the executor, not the console
+#define ChipLogError(module, ...)       do {} while (0)
+#define ChipLogProgress(module, ...)    do {} while (0)
@@ -0,0 +1,38 @@
+/* Host stand-in, the simulation is single threaded. The compaction task is entered from
+   sim_idle() in kvs_log_sim.c and handed back when it waits for a notification with none pending */
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+#include <stdint.h>
+typedef void *SemaphoreHandle_t;
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+typedef long BaseType_t;
+#define pdTRUE				1
+#define pdPASS				1
+#define portMAX_DELAY		0xffffffffu
+#define tskIDLE_PRIORITY	0
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+	return (SemaphoreHandle_t) 1;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, uint32_t ticks)
+{
+	(void) sem;
+	(void) ticks;
+	return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+	(void) sem;
+	return pdTRUE;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint16_t stack, void *param, unsigned long priority, TaskHandle_t *task);
+uint32_t ulTaskNotifyTake(BaseType_t clear, uint32_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+#endif
@@ -0,0 +1,16 @@
+/* Host stand-in with the error codes of file_system/dct/dct.h */
+#ifndef __RTK_DCT_H__
+#define __RTK_DCT_H__
+enum{
+	DCT_SUCCESS = 0,
+	DCT_ERROR = -1,
+	DCT_ERR_CRC = -2,
+	DCT_ERR_NO_SPACE = -3,
+	DCT_ERR_NO_MEMORY = -4,
+	DCT_ERR_FLASH_RW = -5,
+	DCT_ERR_NOT_FIND = -6,
+	DCT_ERR_INVALID = -7,
+	DCT_ERR_SIZE_OVER = -8,
+	DCT_ERR_MODULE_BUSY = -9,
+};
+#endif
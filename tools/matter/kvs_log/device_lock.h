@@ -0,0 +1,7 @@
+/* Host stand-in, the simulation is single threaded */
+#ifndef _DEVICE_LOCK_H_
+#define _DEVICE_LOCK_H_
+#define RT_DEV_LOCK_FLASH	0
+#define device_mutex_lock(device)
+#define device_mutex_unlock(device)
+#endif
@@ -0,0 +1,548 @@
+/*
+   Host simulation of the log-structured Matter KVS (matter/common/port/matter_kvs_log.c) on a
+   simulated NOR flash.
+
+   PORT=component/common/application/matter/common/port
+   gcc -O2 -I. -I$PORT -o kvs_log_sim kvs_log_sim.c $PORT/matter_kvs_log.c
+   ./kvs_log_sim [operations] [power cut step]
+
+   The workload is the one of a commissioned light: a few counters rewritten all the time, session
+   resumption entries saved and dropped, and now and then the certificates and ACL of one of five
+   fabrics rewritten. It runs on the 21 sector partition at DCT_BEGIN_ADDR2 once with the
+   compaction task getting idle time after every operation and once with the task starved, and
+   reports the wear of every sector and the latency of set and delete. Time comes from typical SPI
+   NOR figures kept on a simulated clock. The store is compared with a shadow copy after every run,
+   once as written and once more after it is brought up again from flash.
+
+   Now and then a fabric is rewritten as a whole through matter_kvs_log_commit. The power is then
+   cut at many points of the same workload. After every cut the store must come up with every
+   acknowledged value, the one operation in flight may have landed or not, a batch all of it or
+   none, and must take further writes. Last, the partition is filled with what the DCT modules left there, as
+   after switching CONFIG_ENABLE_MATTER_KVS_LOG on, to show that the log starts empty over it.
+*/
+#include <setjmp.h>
+#include "platform/platform_stdlib.h"
+#include "platform_opts.h"
+#include "FreeRTOS.h"
+#include "flash_api.h"
+#include "dct.h"
+#include "matter_kvs_log.h"
+
+#define SIM_BASE			DCT_BEGIN_ADDR2
+#define SIM_SECTORS			21
+#define SIM_UNIT_SIZE		4096
+#define SIM_ERASE_US		45000.0	// 4KB sector erase
+#define SIM_COMMAND_US		5.0		// per flash command
+#define SIM_PROGRAM_US		2.4		// per byte, 256 byte page in about 0.6 ms
+#define SIM_READ_US			0.05	// per byte
+#define SIM_ENDURANCE		100000	// erase cycles of a sector
+#define SIM_FABRICS			5
+#define SIM_SESSIONS		16
+#define SIM_VALUE_MAX		2048
+
+static uint8_t sim_flash[SIM_SECTORS * SIM_UNIT_SIZE];
+static uint32_t sim_erases[SIM_SECTORS];
+static uint32_t sim_overwrites;	// programmed bytes that needed an erase first
+static double sim_clock;
+static long sim_cut_after = -1;	// mutating flash operations left before the power goes, -1 never
+static int sim_dead;
+
+static TaskFunction_t sim_task;
+static void *sim_task_param;
+static uint32_t sim_notified;
+static jmp_buf sim_idle_return;
+
+// power on, and off again after cut_after mutating flash operations unless it is -1
+static void sim_power(long cut_after)
+{
+	sim_cut_after = cut_after;
+	sim_dead = 0;
+}
+
+// 1 with power, 0 for the operation the power goes in, -1 after it
+static int sim_powered(void)
+{
+	if (sim_dead)
+		return -1;
+	if (sim_cut_after < 0)
+		return 1;
+	if (sim_cut_after == 0) {
+		sim_dead = 1;
+		return 0;
+	}
+	sim_cut_after--;
+	return 1;
+}
+
+static uint8_t *sim_at(uint32_t address, uint32_t len)
+{
+	if (address < SIM_BASE || address + len > SIM_BASE + sizeof(sim_flash)) {
+		printf("access to 0x%x outside the partition\n", (unsigned int) address);
+		exit(1);
+	}
+	return sim_flash + (address - SIM_BASE);
+}
+
+void flash_erase_sector(flash_t *obj, uint32_t address)
+{
+	int powered = sim_powered();
+	uint8_t *sector = sim_at(address & ~(SIM_UNIT_SIZE - 1), SIM_UNIT_SIZE);
+
+	(void) obj;
+	if (powered < 0)
+		return;
+	sim_clock += SIM_ERASE_US;
+	if (powered == 0) {
+		// an erase cut short leaves part of the sector as it was
+		memset(sector, 0xFF, SIM_UNIT_SIZE / 2);
+		return;
+	}
+	memset(sector, 0xFF, SIM_UNIT_SIZE);
+	sim_erases[(sector - sim_flash) / SIM_UNIT_SIZE]++;
+}
+
+int flash_stream_read(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data)
+{
+	(void) obj;
+	memcpy(data, sim_at(address, len), len);
+	sim_clock += SIM_COMMAND_US + len * SIM_READ_US;
+	return 1;
+}
+
+int flash_stream_write(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data)
+{
+	uint8_t *dst = sim_at(address, len);
+	uint32_t i, done = len;
+	int powered = sim_powered();
+
+	(void) obj;
+	if (powered < 0)
+		return 0;
+	if (powered == 0)
+		done = len / 2;
+	// NOR programming only clears bits, writing over data that was not erased corrupts it
+	for (i = 0; i < done; i++) {
+		sim_overwrites += ((dst[i] & data[i]) != data[i]);
+		dst[i] &= data[i];
+	}
+	sim_clock += SIM_COMMAND_US * ((done + 255) / 256) + done * SIM_PROGRAM_US;
+	return 1;
+}
+
+/* The compaction task ----------------------------------------------------------------------*/
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint16_t stack, void *param, unsigned long priority, TaskHandle_t *task)
+{
+	(void) name;
+	(void) stack;
+	(void) priority;
+	sim_task = code;
+	sim_task_param = param;
+	*task = (TaskHandle_t) &sim_task;
+	return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+	(void) task;
+	sim_notified++;
+	return pdPASS;
+}
+
+// the task waits for work: with none pending it gives the time back to sim_idle()
+uint32_t ulTaskNotifyTake(BaseType_t clear, uint32_t ticks)
+{
+	uint32_t count = sim_notified;
+
+	(void) ticks;
+	if (count == 0)
+		longjmp(sim_idle_return, 1);
+	sim_notified = clear ? 0 : count - 1;
+	return count;
+}
+
+// idle time: run the compaction task until it waits again
+static void sim_idle(void)
+{
+	if (sim_task == NULL || sim_notified == 0)
+		return;
+	if (setjmp(sim_idle_return) == 0)
+		sim_task(sim_task_param);
+}
+
+/* Workload ----------------------------------------------------------------------------------*/
+#define SIM_COUNTERS		4
+#define SIM_FABRIC_KEYS		8
+#define SIM_KEYS			(SIM_COUNTERS + SIM_FABRICS * SIM_FABRIC_KEYS + SIM_SESSIONS)
+
+static uint32_t sim_version[SIM_KEYS];	// value of every key in the shadow copy, 0 when deleted
+static uint32_t sim_next_version;
+static uint32_t sim_seed;
+static uint64_t sim_payload;
+
+static uint32_t sim_rand(void)
+{
+	sim_seed = sim_seed * 1103515245 + 12345;
+	return sim_seed >> 8;
+}
+
+// keys and value sizes after what the Matter SDK stores for a light
+static void sim_key(int key, char *name, uint16_t *size)
+{
+	static const char *counters[SIM_COUNTERS] = {"g/gdc", "g/gcc", "g/lkgt", "g/gfl"};
+	static const char *fabric[SIM_FABRIC_KEYS] = {"n", "i", "r", "o", "m", "ac/0/0", "ac/0/1", "ac/0/2"};
+	static const uint16_t fabric_size[SIM_FABRIC_KEYS] = {400, 400, 400, 160, 40, 64, 64, 64};
+
+	if (key < SIM_COUNTERS) {
+		strcpy(name, counters[key]);
+		*size = 8;
+	} else if (key < SIM_COUNTERS + SIM_FABRICS * SIM_FABRIC_KEYS) {
+		key -= SIM_COUNTERS;
+		sprintf(name, "f/%x/%s", key / SIM_FABRIC_KEYS + 1, fabric[key % SIM_FABRIC_KEYS]);
+		*size = fabric_size[key % SIM_FABRIC_KEYS];
+	} else {
+		sprintf(name, "f/%x/s/%x", (key % SIM_FABRICS) + 1, key);
+		*size = 80;
+	}
+}
+
+static uint16_t sim_value(int key, uint32_t version, uint8_t *value)
+{
+	char name[32];
+	uint16_t size, i;
+	uint32_t x = version * 2654435761u + key;
+
+	sim_key(key, name, &size);
+	for (i = 0; i < size; i++) {
+		x = x * 1664525 + 1013904223;
+		value[i] = x >> 24;
+	}
+	return size;
+}
+
+static s32 sim_set(int key, uint32_t version)
+{
+	uint8_t value[SIM_VALUE_MAX];
+	char name[32];
+	uint16_t size;
+
+	sim_key(key, name, &size);
+	sim_value(key, version, value);
+	sim_payload += size;
+	return matter_kvs_log_set(name, value, size);
+}
+
+static s32 sim_delete(int key)
+{
+	char name[32];
+	uint16_t size;
+
+	sim_key(key, name, &size);
+	return matter_kvs_log_delete(name);
+}
+
+// count keys from key on set to version in one batch
+static s32 sim_commit(int key, int count, uint32_t version)
+{
+	static uint8_t values[SIM_FABRIC_KEYS][SIM_VALUE_MAX];
+	static char names[SIM_FABRIC_KEYS][32];
+	matter_kvs_log_op_t ops[SIM_FABRIC_KEYS];
+	uint16_t size;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		sim_key(key + i, names[i], &size);
+		ops[i].key = names[i];
+		ops[i].value = values[i];
+		ops[i].byteCount = sim_value(key + i, version, values[i]);
+		sim_payload += size;
+	}
+	return matter_kvs_log_commit(ops, count);
+}
+
+// one operation of the workload; the keys it changes and the version they get, 0 for a delete, are returned
+static s32 sim_op(int *key, int *count, uint32_t *version)
+{
+	uint32_t pick = sim_rand() % 100;
+
+	*count = 1;
+	if (pick < 70) {
+		*key = sim_rand() % SIM_COUNTERS;
+	} else if (pick < 90) {
+		*key = SIM_COUNTERS + SIM_FABRICS * SIM_FABRIC_KEYS + sim_rand() % SIM_SESSIONS;
+		if (sim_version[*key] && (sim_rand() & 1)) {
+			*version = 0;
+			return sim_delete(*key);
+		}
+	} else if (pick < 95) {
+		*key = SIM_COUNTERS + sim_rand() % (SIM_FABRICS * SIM_FABRIC_KEYS);
+	} else {
+		// a fabric updated as a whole, like its certificates and ACL after a commissioning
+		*key = SIM_COUNTERS + (sim_rand() % SIM_FABRICS) * SIM_FABRIC_KEYS;
+		*count = SIM_FABRIC_KEYS;
+		*version = ++sim_next_version;
+		return sim_commit(*key, *count, *version);
+	}
+	*version = ++sim_next_version;
+	return sim_set(*key, *version);
+}
+
+static void sim_commission(void)
+{
+	int key;
+
+	for (key = 0; key < SIM_COUNTERS + SIM_FABRICS * SIM_FABRIC_KEYS; key++) {
+		sim_version[key] = ++sim_next_version;
+		sim_set(key, sim_version[key]);
+	}
+}
+
+// 1 if the store holds the given version of key, version 0 meaning deleted
+static int sim_holds(int key, uint32_t version)
+{
+	uint8_t value[SIM_VALUE_MAX], expect[SIM_VALUE_MAX];
+	char name[32];
+	uint16_t size;
+	size_t len;
+	s32 ret;
+
+	sim_key(key, name, &size);
+	ret = matter_kvs_log_get(name, value, sizeof(value), &len);
+	if (version == 0)
+		return ret == DCT_ERR_NOT_FIND;
+	return ret == DCT_SUCCESS && len == sim_value(key, version, expect) && memcmp(value, expect, len) == 0;
+}
+
+// compares the store with the shadow copy; the count keys in flight from inflight on, -1 if none,
+// may also hold version, all of them or none
+static int sim_check(int inflight, int count, uint32_t version)
+{
+	char name[32];
+	uint16_t size;
+	int key, landed = 0, failed = 0;
+
+	for (key = 0; key < SIM_KEYS; key++) {
+		int in_flight = inflight >= 0 && key >= inflight && key < inflight + count;
+
+		if (in_flight && sim_holds(key, version)) {
+			landed++;
+			continue;
+		}
+		if (sim_holds(key, sim_version[key]))
+			continue;
+		sim_key(key, name, &size);
+		printf("%s: not as written\n", name);
+		failed++;
+	}
+	if (landed != 0 && landed != count) {
+		printf("batch of %d keys landed in part, %d of them\n", count, landed);
+		failed++;
+	}
+	return failed;
+}
+
+// power comes back: RAM is lost, the store is brought up from flash alone
+static int sim_reboot(void)
+{
+	sim_power(-1);
+	sim_notified = 0;
+	return matter_kvs_log_init();
+}
+
+static void sim_reset(uint32_t seed)
+{
+	memset(sim_flash, 0xFF, sizeof(sim_flash));
+	memset(sim_erases, 0, sizeof(sim_erases));
+	memset(sim_version, 0, sizeof(sim_version));
+	sim_next_version = 0;
+	sim_overwrites = 0;
+	sim_seed = seed;
+	sim_reboot();
+}
+
+static int sim_cmp_latency(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+static int sim_run(const char *name, int ops, int idle)
+{
+	uint32_t *latency = malloc(ops * sizeof(uint32_t));
+	uint32_t i, min = UINT32_MAX, max = 0, total = 0;
+	double foreground = 0, background = 0, start;
+	matter_kvs_log_stats_t stats;
+	int failed = 0;
+
+	sim_reset(1);
+	sim_commission();
+	memset(sim_erases, 0, sizeof(sim_erases));
+	sim_payload = 0;
+	matter_kvs_log_reset_stats();
+
+	for (i = 0; i < (uint32_t) ops && !failed; i++) {
+		uint32_t version;
+		int key, count, k;
+
+		start = sim_clock;
+		if (sim_op(&key, &count, &version) != DCT_SUCCESS) {
+			printf("%s: operation %u failed\n", name, i);
+			failed = 1;
+		}
+		for (k = 0; k < count; k++)
+			sim_version[key + k] = version;
+		latency[i] = (uint32_t) (sim_clock - start);
+		foreground += latency[i];
+
+		if (idle) {
+			start = sim_clock;
+			sim_idle();
+			background += sim_clock - start;
+		}
+	}
+
+	matter_kvs_log_get_stats(&stats);
+	for (i = 0; i < SIM_SECTORS; i++) {
+		total += sim_erases[i];
+		if (sim_erases[i] < min)
+			min = sim_erases[i];
+		if (sim_erases[i] > max)
+			max = sim_erases[i];
+	}
+	if (!failed) {
+		qsort(latency, ops, sizeof(uint32_t), sim_cmp_latency);
+		printf("%-12s mean %6.0f us  p50 %6u us  p99 %6u us  max %6u us  background %7.1f s\n",
+			   name, foreground / ops, latency[ops / 2], latency[ops * 99 / 100], latency[ops - 1], background / 1e6);
+		printf("%-12s erases %u, per sector %u to %u, %.2f bytes written per byte stored, %u collections, "
+			   "%.0f operations to %u erases\n", "", total, min, max, (double) stats.bytes_written / sim_payload,
+			   stats.gc_runs, max ? (double) ops * SIM_ENDURANCE / max : 0.0, SIM_ENDURANCE);
+	}
+
+	if (!failed && sim_check(-1, 0, 0)) {
+		printf("%s: data mismatch\n", name);
+		failed = 1;
+	}
+	start = sim_clock;
+	if (!failed && (sim_reboot() != DCT_SUCCESS || sim_check(-1, 0, 0))) {
+		printf("%s: data mismatch after init\n", name);
+		failed = 1;
+	}
+	if (!failed)
+		printf("%-12s init from flash %.1f ms\n", "", (sim_clock - start) / 1000);
+	if (sim_overwrites) {
+		printf("%s: %u bytes programmed without an erase\n", name, sim_overwrites);
+		failed = 1;
+	}
+
+	free(latency);
+	return failed;
+}
+
+// runs ops operations and as many idle slots, returns the first key in flight when the power went
+static int sim_cut_workload(int ops, int *inflight_count, uint32_t *inflight_version)
+{
+	int i, k;
+
+	for (i = 0; i < ops; i++) {
+		uint32_t version;
+		int key, count;
+		s32 ret = sim_op(&key, &count, &version);
+
+		if (sim_dead) {
+			if (inflight_version != NULL) {
+				*inflight_count = count;
+				*inflight_version = version;
+			}
+			return key;
+		}
+		if (ret == DCT_SUCCESS)
+			for (k = 0; k < count; k++)
+				sim_version[key + k] = version;
+		sim_idle();
+		if (sim_dead)
+			return -1;
+	}
+	return -1;
+}
+
+// cuts the power after every step-th flash operation of the workload and checks what survives
+static int sim_power_cuts(int ops, int step)
+{
+	long count, cut;
+	int cuts = 0, failed = 0;
+
+	// count the mutating operations of a full run
+	sim_reset(2);
+	sim_commission();
+	sim_power(1L << 30);
+	sim_cut_workload(ops, NULL, NULL);
+	count = (1L << 30) - sim_cut_after;
+
+	for (cut = 1; cut < count; cut += step) {
+		uint32_t version = 0;
+		int inflight, count = 0, bad, k;
+
+		sim_reset(2);
+		sim_commission();
+		sim_power(cut);
+		inflight = sim_cut_workload(ops, &count, &version);
+
+		bad = (sim_reboot() != DCT_SUCCESS) || sim_check(inflight, count, version);
+		if (!bad) {
+			// the check passed with either version of the keys in flight, take the one they hold
+			if (inflight >= 0 && sim_holds(inflight, version))
+				for (k = 0; k < count; k++)
+					sim_version[inflight + k] = version;
+			sim_cut_workload(ops / 10, NULL, NULL);
+			bad = sim_check(-1, 0, 0) || sim_reboot() != DCT_SUCCESS || sim_check(-1, 0, 0);
+		}
+
+		cuts++;
+		if (bad || sim_overwrites) {
+			printf("cut after %ld operations: %s\n", cut, bad ? "store lost data" : "programmed without an erase");
+			failed++;
+		}
+	}
+	printf("power cuts: %d of %d left the store inconsistent\n", failed, cuts);
+	return failed ? -1 : 0;
+}
+
+// the DCT modules leave their variables in the partition, the log ignores them and starts empty
+static int sim_over_dct(int ops)
+{
+	size_t i;
+	int failed;
+
+	sim_reset(3);
+	sim_seed = 3;
+	for (i = 0; i < sizeof(sim_flash); i++)
+		sim_flash[i] = sim_rand();
+	sim_reboot();
+
+	failed = sim_check(-1, 0, 0);
+	sim_commission();
+	sim_cut_workload(ops, NULL, NULL);
+	failed |= sim_check(-1, 0, 0) || sim_reboot() != DCT_SUCCESS || sim_check(-1, 0, 0) || sim_overwrites;
+	printf("over DCT contents: %s\n", failed ? "FAILED" : "started empty, DCT1 and DCT2 contents gone");
+	return failed ? -1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int ops = (argc > 1) ? atoi(argv[1]) : 20000;
+	int step = (argc > 2) ? atoi(argv[2]) : 13;
+	int ret = 0;
+
+	if (ops <= 0 || step <= 0) {
+		fprintf(stderr, "usage: %s [operations] [power cut step]\n", argv[0]);
+		return 2;
+	}
+
+	printf("partition 0x%x ~ 0x%x, %d keys, %d operations\n", SIM_BASE, SIM_BASE + (unsigned int) sizeof(sim_flash), SIM_KEYS, ops);
+	ret |= sim_run("idle", ops, 1);
+	ret |= sim_run("no idle", ops, 0);
+	ret |= sim_power_cuts(ops / 10, step);
+	ret |= sim_over_dct(ops / 10);
+	printf("%s\n", ret ? "FAILED" : "ok");
+	return ret ? 1 : 0;
+}
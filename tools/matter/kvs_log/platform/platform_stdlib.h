@@ -0,0 +1,14 @@
+/* Host stand-in */
+#ifndef _PLATFORM_STDLIB_H_
+#define _PLATFORM_STDLIB_H_
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int16_t s16;
+typedef int32_t s32;
+#endif
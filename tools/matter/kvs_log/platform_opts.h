@@ -0,0 +1,7 @@
+/* Host stand-in with the DCT settings of common/include/platform_opts_matter.h */
+#ifndef _PLATFORM_OPTS_H_
+#define _PLATFORM_OPTS_H_
+#define CONFIG_ENABLE_MATTER_KVS_LOG	1
+#define DCT_BEGIN_ADDR		(0x400000 - 0x13000)	// 0x3ED000 ~ 0x3FB000 : 56K
+#define DCT_BEGIN_ADDR2		(0x400000 - 0x1A000)	// 0x3E6000 ~ 0x3ED000 : 24K
+#endif
@@ -0,0 +1,194 @@
+/*
+   Host check and micro-benchmark of the MatterLED color pipeline (driver/led_color.cpp).
+
+   g++ -O2 -I$DRIVER -o led_color_bench led_color_bench.cpp $DRIVER/led_color.cpp
+   ./led_color_bench
+   with DRIVER=component/common/application/matter/driver
+
+   The reference vectors and the checksum over every hue, saturation and level hold for any
+   compiler and target, a mismatch means the pipeline output changed. The legacy float
+   pipeline is timed next to it for comparison.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <algorithm>
+#include "led_color.h"
+
+struct Vector
+{
+    uint8_t hue, saturation, level;
+    uint16_t colortemp;
+    MatterLEDChannels channels;
+};
+
+#if MATTER_LED_GAMMA_CORRECTION
+static const uint32_t kChecksum = 0x40d498cfu;
+#else
+static const uint32_t kChecksum = 0x32886d30u;
+// with the linear level table
+static const Vector kVectors[] =
+{
+    {0, 0, 254, 2708, {0, 0, 0, 0, 65536}},
+    {0, 254, 254, 2708, {65536, 0, 0, 0, 0}},
+    {42, 254, 254, 4000, {65536, 65020, 0, 0, 0}},
+    {85, 127, 200, 4000, {0, 25801, 203, 12954, 12848}},
+    {170, 200, 100, 6471, {319, 0, 20316, 5486, 0}},
+    {212, 100, 1, 3500, {101, 0, 100, 54, 103}},
+    {254, 254, 127, 5000, {32768, 0, 0, 0, 0}},
+};
+#endif
+
+static double bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t bench_fnv(uint32_t hash, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        hash ^= (value >> (8 * i)) & 0xFF;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// the float pipeline MatterLED used before, kept here as a baseline
+static void legacy_convert(uint16_t colortemp, uint8_t hue8, uint8_t sat8, uint8_t brightness, float duty[5])
+{
+    static const uint16_t white[11][3] = {{2708, 0, 100}, {2891, 10, 90}, {3110, 20, 80}, {3364, 30, 70}, {3656, 40, 60},
+        {3992, 50, 50}, {4376, 60, 40}, {4809, 70, 30}, {5304, 80, 20}, {5853, 90, 10}, {6471, 100, 0}};
+    uint16_t hue = hue8 * 360 / 254;
+    uint8_t sat = sat8 * 100 / 254;
+    uint16_t i = hue / 60;
+    uint16_t rgb_max = brightness;
+    uint16_t rgb_min = rgb_max * (100 - sat) / 100;
+    uint16_t rgb_adj = (rgb_max - rgb_min) * (hue % 60) / 60;
+    uint8_t r, g, b;
+
+    switch (i)
+    {
+    case 0: r = rgb_max; g = rgb_min + rgb_adj; b = rgb_min; break;
+    case 1: r = rgb_max - rgb_adj; g = rgb_max; b = rgb_min; break;
+    case 2: r = rgb_min; g = rgb_max; b = rgb_min + rgb_adj; break;
+    case 3: r = rgb_min; g = rgb_max - rgb_adj; b = rgb_max; break;
+    case 4: r = rgb_min + rgb_adj; g = rgb_min; b = rgb_max; break;
+    default: r = rgb_max; g = rgb_min; b = rgb_max - rgb_adj; break;
+    }
+
+    uint8_t w = std::min({r, g, b});
+    uint8_t row = 0;
+
+    r -= w;
+    g -= w;
+    b -= w;
+    while (row < 11 && colortemp >= white[row][0])
+        row++;
+    if (row != 0)
+        row--;
+
+    duty[0] = r / 254.0;
+    duty[1] = g / 254.0;
+    duty[2] = b / 254.0;
+    duty[3] = (uint8_t) (w * white[row][1] / 100) / 254.0;
+    duty[4] = (uint8_t) (w * white[row][2] / 100) / 254.0;
+}
+
+int main(void)
+{
+    MatterLEDColor color;
+    MatterLEDChannels channels;
+    uint32_t hash = 2166136261u;
+    uint32_t conversions = 0;
+    int failed = 0;
+    double start, elapsed;
+    volatile float sink;
+
+#if !MATTER_LED_GAMMA_CORRECTION
+    for (const Vector & vector : kVectors)
+    {
+        color.SetColor(vector.hue, vector.saturation);
+        color.SetColorTemp(vector.colortemp);
+        color.Convert(vector.level, true, channels);
+        if (channels.red != vector.channels.red || channels.green != vector.channels.green || channels.blue != vector.channels.blue ||
+            channels.cwhite != vector.channels.cwhite || channels.wwhite != vector.channels.wwhite)
+        {
+            printf("vector h %d s %d l %d ct %d: got %u %u %u %u %u\n", vector.hue, vector.saturation, vector.level, vector.colortemp,
+                   channels.red, channels.green, channels.blue, channels.cwhite, channels.wwhite);
+            failed = 1;
+        }
+    }
+#endif
+
+    color.SetColorTemp(4200);
+    for (int hue = 0; hue <= 254; hue++)
+    {
+        for (int saturation = 0; saturation <= 254; saturation += 2)
+        {
+            color.SetColor(hue, saturation);
+            for (int level = 0; level <= 254; level++)
+            {
+                color.Convert(level, true, channels);
+                hash = bench_fnv(hash, MatterLEDColor::PulseWidth(channels.red, 20000));
+                hash = bench_fnv(hash, MatterLEDColor::PulseWidth(channels.green, 20000));
+                hash = bench_fnv(hash, MatterLEDColor::PulseWidth(channels.blue, 20000));
+                hash = bench_fnv(hash, MatterLEDColor::PulseWidth(channels.cwhite, 20000));
+                hash = bench_fnv(hash, MatterLEDColor::PulseWidth(channels.wwhite, 20000));
+            }
+        }
+    }
+    printf("checksum %08x %s\n", hash, (hash == kChecksum) ? "ok" : "MISMATCH");
+    failed |= (hash != kChecksum);
+
+    start = bench_now();
+    do
+    {
+        for (int i = 0; i < 65536; i++)
+        {
+            color.SetColor(i & 0xFF, (i >> 8) & 0xFF);
+            color.Convert(i * 7, true, channels);
+            sink = channels.red + channels.green + channels.blue + channels.cwhite + channels.wwhite;
+        }
+        conversions += 65536;
+        elapsed = bench_now() - start;
+    } while (elapsed < 1.0);
+    printf("fixed-point, color change: %.1f M conversions/s\n", conversions / elapsed / 1e6);
+
+    // dimming only changes the level, the hue and saturation weights stay cached
+    conversions = 0;
+    start = bench_now();
+    do
+    {
+        for (int i = 0; i < 65536; i++)
+        {
+            color.Convert(i & 0xFF, true, channels);
+            sink = channels.red + channels.green + channels.blue + channels.cwhite + channels.wwhite;
+        }
+        conversions += 65536;
+        elapsed = bench_now() - start;
+    } while (elapsed < 1.0);
+    printf("fixed-point, level change: %.1f M conversions/s\n", conversions / elapsed / 1e6);
+
+    conversions = 0;
+    start = bench_now();
+    do
+    {
+        for (int i = 0; i < 65536; i++)
+        {
+            float duty[5];
+
+            legacy_convert(4200, i & 0xFF, (i >> 8) & 0xFF, i * 7, duty);
+            sink = duty[0] + duty[1] + duty[2] + duty[3] + duty[4];
+        }
+        conversions += 65536;
+        elapsed = bench_now() - start;
+    } while (elapsed < 1.0);
+    printf("legacy float: %.1f M conversions/s\n", conversions / elapsed / 1e6);
+
+    (void) sink;
+    return failed;
+}
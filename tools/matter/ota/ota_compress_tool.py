@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+
+"""
+Compressed payload utility for Matter OTA on AmebaZ2.
+
+A compressed payload is decompressed on the device while it streams in, with a fixed 4 KB
+window, and replaces a full image or a delta payload (see ota_delta_tool.py) as payload of
+the Matter OTA file:
+
+Creating a compressed payload and the OTA image serving it:
+./ota_compress_tool.py compress firmware_is.bin firmware_is.lz
+./ota_image_tool.py create -v 0xDEAD -p 0xBEEF -vn 2 -vs "2.0" -da sha256 firmware_is.lz firmware.ota
+
+Measuring compression ratio and device decoder throughput on a Linux host:
+gcc -O2 -DMATTER_OTA_LZ_HOST -I$PORT -o ota_lz_bench ota_lz_bench.c $PORT/matter_ota_lz.c
+./ota_lz_bench firmware_is.bin firmware_is.lz
+with PORT=component/common/application/matter/common/port
+
+Payload layout, little endian:
+    header   magic "RLZS", version, method (1 = LZSS), window bits (12), flags, uncompressed size,
+             compressed size after the header, 16 reserved bytes, SHA-256 of the uncompressed
+             content (64 bytes)
+    tokens   groups of eight tokens behind a flag byte, LSB first. A clear bit is a literal byte,
+             a set bit a match of two bytes: distance - 1 (12 bits, low byte first) and
+             length - 3 (4 bits, high nibble of the second byte). Length nibble 0xF adds one
+             more byte to a length of 18.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+import time
+
+LZ_MAGIC = b'RLZS'
+LZ_VERSION = 1
+LZ_METHOD_LZSS = 1
+LZ_WINDOW_BITS = 12
+LZ_HEADER_FORMAT = '<4sBBBBII16s32s'
+
+WINDOW = 1 << LZ_WINDOW_BITS
+MATCH_MIN = 3
+MATCH_EXT = 18          # lengths from here on take an extra byte
+MATCH_MAX = MATCH_EXT + 255
+MAX_CHAIN = 48          # match candidates tried per position
+
+
+def error(message: str):
+    sys.stderr.write(f'error: {message}\n')
+    sys.exit(1)
+
+
+def find_match(data: bytes, pos: int, chain: list) -> tuple:
+    best_len = 0
+    best_dist = 0
+    limit = min(MATCH_MAX, len(data) - pos)
+    for candidate in reversed(chain[-MAX_CHAIN:]):
+        dist = pos - candidate
+        if dist > WINDOW:
+            break
+        # a candidate can only win if it also matches the byte after the best match so far
+        if data[candidate + best_len] != data[pos + best_len]:
+            continue
+        length = 0
+        while length < limit and data[candidate + length] == data[pos + length]:
+            length += 1
+        if length > best_len:
+            best_len = length
+            best_dist = dist
+            if length == limit:
+                break
+    return best_len, best_dist
+
+
+def compress(data: bytes) -> bytes:
+    chains = {}
+    tokens = bytearray()
+    group = bytearray()
+    flags = 0
+    count = 0
+    pos = 0
+
+    def insert(at: int):
+        if at + MATCH_MIN <= len(data):
+            key = data[at:at + MATCH_MIN]
+            chain = chains.setdefault(key, [])
+            chain.append(at)
+            if len(chain) > 2 * MAX_CHAIN:
+                del chain[:MAX_CHAIN]
+
+    while pos < len(data):
+        chain = chains.get(data[pos:pos + MATCH_MIN], [])
+        length, dist = find_match(data, pos, chain) if chain else (0, 0)
+
+        # lazy matching: emit a literal when the next position has a longer match
+        if MATCH_MIN <= length < MATCH_EXT and pos + 1 < len(data):
+            insert(pos)
+            next_chain = chains.get(data[pos + 1:pos + 1 + MATCH_MIN], [])
+            next_length, _ = find_match(data, pos + 1, next_chain) if next_chain else (0, 0)
+            if next_length > length + 1:
+                length = 0
+            inserted = True
+        else:
+            inserted = False
+
+        if length >= MATCH_MIN:
+            flags |= 1 << count
+            code = length - MATCH_MIN if length < MATCH_EXT else 0xF
+            group.append((dist - 1) & 0xFF)
+            group.append(((dist - 1) >> 8) | (code << 4))
+            if length >= MATCH_EXT:
+                group.append(length - MATCH_EXT)
+            for at in range(pos + (1 if inserted else 0), pos + length):
+                insert(at)
+            pos += length
+        else:
+            group.append(data[pos])
+            if not inserted:
+                insert(pos)
+            pos += 1
+
+        count += 1
+        if count == 8:
+            tokens.append(flags)
+            tokens += group
+            group.clear()
+            flags = 0
+            count = 0
+
+    if count > 0:
+        tokens.append(flags)
+        tokens += group
+
+    header = struct.pack(LZ_HEADER_FORMAT, LZ_MAGIC, LZ_VERSION, LZ_METHOD_LZSS, LZ_WINDOW_BITS, 0,
+                         len(data), len(tokens), bytes(16), hashlib.sha256(data).digest())
+    return header + bytes(tokens)
+
+
+def decompress(payload: bytes) -> bytes:
+    header_size = struct.calcsize(LZ_HEADER_FORMAT)
+    if len(payload) < header_size:
+        error('payload is shorter than its header')
+
+    magic, version, method, window_bits, _flags, size, stream_size, _pad, digest = \
+        struct.unpack(LZ_HEADER_FORMAT, payload[:header_size])
+    if magic != LZ_MAGIC or version != LZ_VERSION or method != LZ_METHOD_LZSS or window_bits != LZ_WINDOW_BITS:
+        error('not a compressed payload')
+    if len(payload) != header_size + stream_size:
+        error('compressed size does not match the header')
+
+    out = bytearray()
+    pos = header_size
+    while len(out) < size:
+        flags = payload[pos]
+        pos += 1
+        for bit in range(8):
+            if len(out) == size:
+                break
+            if not flags & (1 << bit):
+                out.append(payload[pos])
+                pos += 1
+                continue
+            dist = (payload[pos] | ((payload[pos + 1] & 0x0F) << 8)) + 1
+            length = (payload[pos + 1] >> 4) + MATCH_MIN
+            pos += 2
+            if length == MATCH_EXT:
+                length += payload[pos]
+                pos += 1
+            if dist > len(out):
+                error('match reaches before the start of the content')
+            for _ in range(length):
+                out.append(out[-dist])
+
+    if pos != len(payload) or len(out) != size or hashlib.sha256(out).digest() != digest:
+        error('decompressed content does not match the header')
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Matter OTA compressed payload utility')
+    subcommands = parser.add_subparsers(dest='subcommand', title='valid subcommands', required=True)
+
+    compress_parser = subcommands.add_parser('compress', help='Create a compressed payload')
+    compress_parser.add_argument('input_file', help='Image or delta payload to compress')
+    compress_parser.add_argument('output_file', help='Path to output compressed payload')
+
+    decompress_parser = subcommands.add_parser('decompress', help='Restore the content of a compressed payload')
+    decompress_parser.add_argument('input_file', help='Compressed payload')
+    decompress_parser.add_argument('output_file', help='Path to restored content')
+
+    args = parser.parse_args()
+
+    with open(args.input_file, 'rb') as file:
+        data = file.read()
+
+    if args.subcommand == 'compress':
+        start = time.time()
+        result = compress(data)
+        sys.stderr.write(f'{len(data)} bytes compressed to {len(result)} '
+                         f'({100 * len(result) / max(len(data), 1):.1f}%) in {time.time() - start:.1f} s\n')
+    else:
+        result = decompress(data)
+
+    with open(args.output_file, 'wb') as file:
+        file.write(result)
+
+
+if __name__ == "__main__":
+    main()
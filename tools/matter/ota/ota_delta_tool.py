@@ -0,0 +1,279 @@
+#!/usr/bin/env python3
+
+"""
+Delta (binary diff) payload utility for Matter OTA on AmebaZ2.
+
+A delta payload rebuilds the new firmware_is.bin from the image running in the active
+slot. It replaces the full image as payload of the Matter OTA file:
+
+Creating a delta payload and the OTA image serving it:
+./ota_delta_tool.py create old/firmware_is.bin new/firmware_is.bin delta.bin
+./ota_image_tool.py create -v 0xDEAD -p 0xBEEF -vn 2 -vs "2.0" -da sha256 delta.bin delta.ota
+
+Rebuilding the new image on the host, the same way the device does:
+./ota_delta_tool.py apply old/firmware_is.bin delta.bin rebuilt.bin
+
+Payload layout, little endian:
+    header   magic "RDLT", version, flags, reserved, old size, new size,
+             CRC-32 of the old image, 12 reserved bytes, SHA-256 of the new image (64 bytes)
+    ops      0x01 DIFF   len, seek    copy len old bytes from old cursor + seek, adding diff bytes
+                                      encoded as (zero run, literal run, literals) pairs
+             0x02 INSERT len, bytes   new bytes with no counterpart in the old image
+             0x00 END
+Lengths are LEB128, seek is a zigzag LEB128 relative to the end of the previous DIFF.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+import zlib
+
+DELTA_MAGIC = b'RDLT'
+DELTA_VERSION = 1
+DELTA_HEADER_FORMAT = '<4sBBHIII12s32s'
+
+OP_END = 0x00
+OP_DIFF = 0x01
+OP_INSERT = 0x02
+
+SEED_SIZE = 8           # bytes hashed to find match candidates in the old image
+SEED_STEP = 4           # old image positions indexed, every SEED_STEP bytes
+GIVE_UP = 128           # stop extending a match after this many bytes without improvement
+MIN_ZERO_RUN = 3        # shorter zero runs stay inside a literal run
+
+
+def error(message: str):
+    sys.stderr.write(f'error: {message}\n')
+    sys.exit(1)
+
+
+def put_varint(out: bytearray, value: int):
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def get_varint(data: bytes, pos: int):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            error('truncated or malformed varint')
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def zigzag(value: int) -> int:
+    return (value << 1) if value >= 0 else ((-value << 1) - 1)
+
+
+def unzigzag(value: int) -> int:
+    return (value >> 1) if not value & 1 else -((value + 1) >> 1)
+
+
+def index_old(old: bytes):
+    """
+    Map seeds of the old image to their last position
+    """
+    index = {}
+    for pos in range(0, len(old) - SEED_SIZE + 1, SEED_STEP):
+        index[old[pos:pos + SEED_SIZE]] = pos
+    return index
+
+
+def extend(old: bytes, new: bytes, old_pos: int, new_pos: int) -> int:
+    """
+    Extend a match forward, tolerating mismatches as long as at least half of the bytes match
+    """
+    limit = min(len(old) - old_pos, len(new) - new_pos)
+    score = best_score = 0
+    best = 0
+    i = 0
+    while i < limit and i - best < GIVE_UP:
+        score += 1 if old[old_pos + i] == new[new_pos + i] else -1
+        i += 1
+        if score > best_score:
+            best_score = score
+            best = i
+    return best
+
+
+def encode_diff(out: bytearray, old: bytes, new: bytes, old_pos: int, new_pos: int, length: int):
+    diff = bytes((new[new_pos + i] - old[old_pos + i]) & 0xFF for i in range(length))
+    pos = 0
+    while pos < length:
+        zeros = pos
+        while zeros < length and diff[zeros] == 0:
+            zeros += 1
+        put_varint(out, zeros - pos)
+        pos = zeros
+        if pos == length:
+            break
+
+        end = pos
+        while end < length:
+            if diff[end] != 0:
+                end += 1
+                continue
+            run = end
+            while run < length and diff[run] == 0:
+                run += 1
+            if run - end >= MIN_ZERO_RUN or run == length:
+                break
+            end = run
+        put_varint(out, end - pos)
+        out += diff[pos:end]
+        pos = end
+
+
+def create_delta(old: bytes, new: bytes) -> bytes:
+    index = index_old(old)
+    ops = bytearray()
+    pending = bytearray()
+    new_pos = 0
+    cursor = 0
+    diffs = inserted = 0
+
+    def flush_insert():
+        nonlocal inserted
+        if pending:
+            ops.append(OP_INSERT)
+            put_varint(ops, len(pending))
+            ops.extend(pending)
+            inserted += len(pending)
+            pending.clear()
+
+    while new_pos < len(new):
+        seed = new[new_pos:new_pos + SEED_SIZE]
+        old_pos = None
+
+        # code that only moved keeps following the old cursor, try that before a lookup
+        follow = cursor + len(pending)
+        if len(seed) == SEED_SIZE and old[follow:follow + SEED_SIZE] == seed:
+            old_pos = follow
+        elif len(seed) == SEED_SIZE:
+            old_pos = index.get(seed)
+
+        if old_pos is None:
+            pending.append(new[new_pos])
+            new_pos += 1
+            continue
+
+        while pending and old_pos > 0 and old[old_pos - 1] == pending[-1]:
+            pending.pop()
+            old_pos -= 1
+            new_pos -= 1
+
+        length = extend(old, new, old_pos, new_pos)
+        flush_insert()
+        ops.append(OP_DIFF)
+        put_varint(ops, length)
+        put_varint(ops, zigzag(old_pos - cursor))
+        encode_diff(ops, old, new, old_pos, new_pos, length)
+        diffs += length
+        cursor = old_pos + length
+        new_pos += length
+
+    flush_insert()
+    ops.append(OP_END)
+
+    header = struct.pack(DELTA_HEADER_FORMAT, DELTA_MAGIC, DELTA_VERSION, 0, 0,
+                         len(old), len(new), zlib.crc32(old), bytes(12), hashlib.sha256(new).digest())
+    sys.stderr.write(f'{len(new)} bytes: {diffs} from the old image, {inserted} inserted, '
+                     f'delta {len(header) + len(ops)} bytes ({100 * (len(header) + len(ops)) / max(len(new), 1):.1f}%)\n')
+    return header + bytes(ops)
+
+
+def apply_delta(old: bytes, delta: bytes) -> bytes:
+    header_size = struct.calcsize(DELTA_HEADER_FORMAT)
+    if len(delta) < header_size:
+        error('delta is shorter than its header')
+
+    magic, version, _flags, _reserved, old_size, new_size, old_crc, _pad, new_digest = \
+        struct.unpack(DELTA_HEADER_FORMAT, delta[:header_size])
+    if magic != DELTA_MAGIC or version != DELTA_VERSION:
+        error('not a delta payload')
+    if len(old) < old_size or zlib.crc32(old[:old_size]) != old_crc:
+        error('delta was not created against this old image')
+    old = old[:old_size]
+
+    new = bytearray()
+    pos = header_size
+    cursor = 0
+    while True:
+        if pos >= len(delta):
+            error('delta has no END op')
+        op = delta[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        length, pos = get_varint(delta, pos)
+        if op == OP_INSERT:
+            new += delta[pos:pos + length]
+            pos += length
+        elif op == OP_DIFF:
+            seek, pos = get_varint(delta, pos)
+            cursor += unzigzag(seek)
+            if cursor < 0 or cursor + length > old_size:
+                error('DIFF reads outside the old image')
+            done = 0
+            while done < length:
+                zeros, pos = get_varint(delta, pos)
+                new += old[cursor + done:cursor + done + zeros]
+                done += zeros
+                if done >= length:
+                    break
+                literals, pos = get_varint(delta, pos)
+                new += bytes((old[cursor + done + i] + delta[pos + i]) & 0xFF for i in range(literals))
+                done += literals
+                pos += literals
+            if done != length:
+                error('DIFF runs exceed their op length')
+            cursor += length
+        else:
+            error(f'unknown op 0x{op:02x}')
+
+    if pos != len(delta) or len(new) != new_size or hashlib.sha256(new).digest() != new_digest:
+        error('rebuilt image does not match the delta header')
+    return bytes(new)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Matter OTA delta payload utility')
+    subcommands = parser.add_subparsers(dest='subcommand', title='valid subcommands', required=True)
+
+    create_parser = subcommands.add_parser('create', help='Create a delta payload')
+    create_parser.add_argument('old_file', help='Image running on the device')
+    create_parser.add_argument('new_file', help='Image to update to')
+    create_parser.add_argument('output_file', help='Path to output delta payload')
+
+    apply_parser = subcommands.add_parser('apply', help='Rebuild the new image from a delta payload')
+    apply_parser.add_argument('old_file', help='Image the delta was created against')
+    apply_parser.add_argument('delta_file', help='Path to delta payload')
+    apply_parser.add_argument('output_file', help='Path to rebuilt image')
+
+    args = parser.parse_args()
+
+    with open(args.old_file, 'rb') as file:
+        old = file.read()
+
+    if args.subcommand == 'create':
+        with open(args.new_file, 'rb') as file:
+            new = file.read()
+        result = create_delta(old, new)
+    else:
+        with open(args.delta_file, 'rb') as file:
+            result = apply_delta(old, file.read())
+
+    with open(args.output_file, 'wb') as file:
+        file.write(result)
+
+
+if __name__ == "__main__":
+    main()
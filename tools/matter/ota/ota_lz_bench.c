@@ -0,0 +1,132 @@
+/*
+   Host benchmark of the Matter OTA LZSS decoder, see ota_compress_tool.py for building it.
+   Feeds a compressed payload to matter_ota_lz.c in BDX sized blocks, checks the result against
+   the original image and reports compression ratio and decode throughput.
+
+   ./ota_lz_bench firmware_is.bin firmware_is.lz [more image/payload pairs]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "matter_ota_lz.h"
+
+#define BENCH_BLOCK_SIZE    1024        // BDX block size used by the OTA requestor
+#define BENCH_MIN_SECONDS   1.0
+
+static const uint8_t *bench_image;
+static uint32_t bench_image_len;
+static uint32_t bench_offset;
+static int bench_verify;
+
+static int8_t bench_sink(const uint8_t *data, uint32_t size)
+{
+    if (bench_offset + size > bench_image_len ||
+        (bench_verify && memcmp(bench_image + bench_offset, data, size) != 0))
+        return -1;
+    bench_offset += size;
+    return 1;
+}
+
+static uint8_t *bench_load(const char *path, uint32_t *len)
+{
+    FILE *file = fopen(path, "rb");
+    uint8_t *data;
+    long size;
+
+    if (file == NULL)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    rewind(file);
+    data = malloc(size > 0 ? size : 1);
+    if (data != NULL && fread(data, 1, size, file) != (size_t) size)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *len = size;
+    return data;
+}
+
+static double bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int bench_decode(matter_ota_lz_t *lz, const uint8_t *payload, uint32_t payload_len)
+{
+    matter_ota_lz_init(lz, bench_sink, NULL);
+    bench_offset = 0;
+
+    for (uint32_t pos = 0; pos < payload_len; pos += BENCH_BLOCK_SIZE)
+    {
+        uint32_t size = payload_len - pos;
+
+        if (size > BENCH_BLOCK_SIZE)
+            size = BENCH_BLOCK_SIZE;
+        if (matter_ota_lz_feed(lz, payload + pos, size) < 0)
+            return -1;
+    }
+    return (matter_ota_lz_finish(lz) < 0 || bench_offset != bench_image_len) ? -1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    static matter_ota_lz_t lz;
+    int ret = 0;
+
+    if (argc < 3 || (argc - 1) % 2 != 0)
+    {
+        fprintf(stderr, "usage: %s image payload [image payload ...]\n", argv[0]);
+        return 2;
+    }
+
+    printf("%-32s %10s %10s %7s %10s\n", "image", "size", "payload", "ratio", "decode");
+    for (int i = 1; i < argc; i += 2)
+    {
+        uint32_t payload_len;
+        uint8_t *image = bench_load(argv[i], &bench_image_len);
+        uint8_t *payload = bench_load(argv[i + 1], &payload_len);
+        uint32_t runs = 0;
+        double start, elapsed;
+
+        if (image == NULL || payload == NULL)
+        {
+            fprintf(stderr, "cannot read %s or %s\n", argv[i], argv[i + 1]);
+            ret = 1;
+            goto next;
+        }
+
+        bench_image = image;
+        bench_verify = 1;
+        if (bench_decode(&lz, payload, payload_len) < 0)
+        {
+            fprintf(stderr, "%s does not decode to %s\n", argv[i + 1], argv[i]);
+            ret = 1;
+            goto next;
+        }
+
+        bench_verify = 0;
+        start = bench_now();
+        do
+        {
+            bench_decode(&lz, payload, payload_len);
+            runs++;
+            elapsed = bench_now() - start;
+        } while (elapsed < BENCH_MIN_SECONDS);
+
+        printf("%-32s %10u %10u %6.1f%% %6.1f MB/s\n", argv[i], bench_image_len, payload_len,
+               100.0 * payload_len / (bench_image_len ? bench_image_len : 1),
+               (double) bench_image_len * runs / elapsed / 1e6);
+
+next:
+        free(image);
+        free(payload);
+    }
+    return ret;
+}